@@ -0,0 +1,440 @@
+#!/usr/bin/env python3
+#
+# Compiles the default user-agent stylesheet into the static rule tables
+# that bemCSSNew() links as the bottom cascade layer.  Re-run and paste the
+# output into parser.c whenever default.css or the element list changes:
+#
+#   python3 parser/css-default.py parser/parser.h parser/default.css
+#
+# Only the selector syntax used by default.css is supported: type, class,
+# id, attribute and pseudo-class selectors joined by descendant, child and
+# sibling combinators.
+#
+# The presentational attribute mappings (bgcolor, align, width, ...) are
+# compiled into the same output as a table sorted by element and attribute
+# with a per-element index.
+#
+
+import hashlib
+import re
+import sys
+
+
+def enum_names(header, name):
+    body = re.search(r"typedef enum\s*\{([^}]*)\}\s*%s;" % name, header).group(1)
+
+    return re.findall(r"^\s*(\w+)", body, re.M)
+
+
+def element_names(header):
+    # Same mapping as element-hash.py, returning enum identifiers too
+    body = header[header.index("ELEMENT_WILDCARD,"):header.index("ELEMENT_MAX")]
+    special = {"WILDCARD": "*", "COMMENT": "!--", "DOCTYPE": "!DOCTYPE"}
+
+    return [(special.get(name, name.lower()), "ELEMENT_" + name) for name in re.findall(r"ELEMENT_(\w+),", body)]
+
+
+# (element, attribute, property, value): a value of None copies the attribute
+# value, "<length>" and "<font-size>" convert it, anything else is used as is
+MAPPINGS = [
+    ("body", "bgcolor", "background-color", None),
+    ("body", "text", "color", None),
+    ("canvas", "height", "height", "<length>"),
+    ("canvas", "width", "width", "<length>"),
+    ("col", "align", "text-align", None),
+    ("col", "valign", "vertical-align", None),
+    ("col", "width", "width", "<length>"),
+    ("colgroup", "align", "text-align", None),
+    ("colgroup", "valign", "vertical-align", None),
+    ("colgroup", "width", "width", "<length>"),
+    ("div", "align", "text-align", None),
+    ("embed", "height", "height", "<length>"),
+    ("embed", "width", "width", "<length>"),
+    ("font", "color", "color", None),
+    ("font", "face", "font-family", None),
+    ("font", "size", "font-size", "<font-size>"),
+    ("h1", "align", "text-align", None),
+    ("h2", "align", "text-align", None),
+    ("h3", "align", "text-align", None),
+    ("h4", "align", "text-align", None),
+    ("h5", "align", "text-align", None),
+    ("h6", "align", "text-align", None),
+    ("hr", "color", "color", None),
+    ("hr", "size", "height", "<length>"),
+    ("hr", "width", "width", "<length>"),
+    ("iframe", "height", "height", "<length>"),
+    ("iframe", "width", "width", "<length>"),
+    ("img", "border", "border-bottom-style", "solid"),
+    ("img", "border", "border-left-style", "solid"),
+    ("img", "border", "border-right-style", "solid"),
+    ("img", "border", "border-top-style", "solid"),
+    ("img", "border", "border-bottom-width", "<length>"),
+    ("img", "border", "border-left-width", "<length>"),
+    ("img", "border", "border-right-width", "<length>"),
+    ("img", "border", "border-top-width", "<length>"),
+    ("img", "height", "height", "<length>"),
+    ("img", "hspace", "margin-left", "<length>"),
+    ("img", "hspace", "margin-right", "<length>"),
+    ("img", "vspace", "margin-bottom", "<length>"),
+    ("img", "vspace", "margin-top", "<length>"),
+    ("img", "width", "width", "<length>"),
+    ("object", "height", "height", "<length>"),
+    ("object", "width", "width", "<length>"),
+    ("p", "align", "text-align", None),
+    ("table", "bgcolor", "background-color", None),
+    ("table", "border", "border-bottom-style", "outset"),
+    ("table", "border", "border-left-style", "outset"),
+    ("table", "border", "border-right-style", "outset"),
+    ("table", "border", "border-top-style", "outset"),
+    ("table", "border", "border-bottom-width", "<length>"),
+    ("table", "border", "border-left-width", "<length>"),
+    ("table", "border", "border-right-width", "<length>"),
+    ("table", "border", "border-top-width", "<length>"),
+    ("table", "cellspacing", "border-spacing", "<length>"),
+    ("table", "height", "height", "<length>"),
+    ("table", "width", "width", "<length>"),
+    ("tbody", "align", "text-align", None),
+    ("tbody", "valign", "vertical-align", None),
+    ("td", "align", "text-align", None),
+    ("td", "bgcolor", "background-color", None),
+    ("td", "height", "height", "<length>"),
+    ("td", "nowrap", "white-space", "nowrap"),
+    ("td", "valign", "vertical-align", None),
+    ("td", "width", "width", "<length>"),
+    ("tfoot", "align", "text-align", None),
+    ("tfoot", "valign", "vertical-align", None),
+    ("th", "align", "text-align", None),
+    ("th", "bgcolor", "background-color", None),
+    ("th", "height", "height", "<length>"),
+    ("th", "nowrap", "white-space", "nowrap"),
+    ("th", "valign", "vertical-align", None),
+    ("th", "width", "width", "<length>"),
+    ("thead", "align", "text-align", None),
+    ("thead", "valign", "vertical-align", None),
+    ("tr", "align", "text-align", None),
+    ("tr", "bgcolor", "background-color", None),
+    ("tr", "height", "height", "<length>"),
+    ("tr", "valign", "vertical-align", None),
+    ("video", "height", "height", "<length>"),
+    ("video", "width", "width", "<length>"),
+]
+
+
+# Shorthands are compiled as their longhands, see bemSetProperty()
+SIDES = ("top", "right", "bottom", "left")
+BORDER_PARTS = ("color", "style", "width")
+BORDER_INITIAL = ("currentcolor", "none", "medium")
+BORDER_STYLES = ("none", "hidden", "dotted", "dashed", "solid", "double", "groove", "ridge", "inset", "outset")
+SHORTHAND = ((0, 0, 0, 0), (0, 1, 0, 1), (0, 1, 2, 1), (0, 1, 2, 3))
+
+
+class Selector:
+    def __init__(self, element, relation):
+        self.element = element
+        self.relation = relation
+        self.statements = []
+        self.previous = None
+
+
+def parse_compound(text, elements, matches):
+    match = re.match(r"(\*|[a-zA-Z][a-zA-Z0-9]*)?(.*)$", text)
+    name = (match.group(1) or "*").lower()
+
+    if name not in elements:
+        sys.exit("unknown element '%s'" % name)
+
+    selector = Selector(elements[name], 0)
+    rest = match.group(2)
+
+    while rest:
+        if rest[0] == ".":
+            match = re.match(r"\.([-\w]+)", rest)
+            selector.statements.append((matches["MATCH_CLASS"], match.group(1), None))
+        elif rest[0] == "#":
+            match = re.match(r"#([-\w]+)", rest)
+            selector.statements.append((matches["MATCH_ID"], match.group(1), None))
+        elif rest[0] == ":":
+            match = re.match(r"::?([-\w]+)", rest)
+            selector.statements.append((matches["MATCH_PSEUDO_CLASS"], match.group(1).lower(), None))
+        elif rest[0] == "[":
+            match = re.match(r"\[\s*([-\w]+)\s*(?:([~|^$*]?=)\s*(\"[^\"]*\"|'[^']*'|[-\w]+)\s*)?\]", rest)
+            operators = {None: "MATCH_ATTRIBUTE_EXIST", "=": "MATCH_ATTRIBUTE_EQUALS", "*=": "MATCH_ATTRIBUTE_CONTAINS", "^=": "MATCH_ATTRIBUTE_BEGINS",
+                         "$=": "MATCH_ATTRIBUTE_ENDS", "|=": "MATCH_ATTRIBUTE_LANGUAGE", "~=": "MATCH_ATTRIBUTE_SPACE"}
+            value = match.group(3)
+
+            if value and value[0] in "\"'":
+                value = value[1:-1]
+
+            selector.statements.append((matches[operators[match.group(2)]], match.group(1).lower(), value))
+        else:
+            match = None
+
+        if not match:
+            sys.exit("bad selector '%s'" % text)
+
+        rest = rest[match.end():]
+
+    return selector
+
+
+def parse_selector(text, elements, matches, relations):
+    combinators = {" ": relations["RELATION_CHILD"], ">": relations["RELATION_IMMEDIATE_CHILD"], "~": relations["RELATION_SIBLING"],
+                   "+": relations["RELATION_IMMEDIATE_SIBLING"]}
+    tokens = re.split(r"\s*([>~+])\s*|\s+", text.strip())
+    selector = None
+    relation = combinators[" "]
+
+    for i, token in enumerate(tokens):
+        if token is None:
+            continue
+        elif i % 2:
+            relation = combinators[token]
+        else:
+            current = parse_compound(token, elements, matches)
+            current.previous = selector
+
+            if selector:
+                current.relation = relation
+
+            selector = current
+            relation = combinators[" "]
+
+    return selector
+
+
+def selector_hash(selector):
+    # Must match bemCSSSelectorHash()
+    context = hashlib.sha3_256()
+
+    while selector:
+        context.update(b"%d %d %d\0" % (selector.element, selector.relation, len(selector.statements)))
+
+        for match, name, value in selector.statements:
+            context.update(b"%d\0%s\0%s\0" % (match, name.encode(), (value or "").encode()))
+
+        selector = selector.previous
+
+    return context.digest()
+
+
+def split_value(value):
+    # Same as bemLayoutTokens(), white space inside parenthesis doesn't split
+    tokens, depth, current = [], 0, ""
+
+    for ch in value:
+        if ch.isspace() and depth == 0:
+            if current:
+                tokens.append(current)
+
+            current = ""
+            continue
+
+        depth += 1 if ch == "(" else -1 if ch == ")" and depth > 0 else 0
+        current += ch
+
+    return tokens + [current] if current else tokens
+
+
+def expand_property(name, value):
+    # Must match bemSetProperty()
+    tokens = split_value(value)
+    part = BORDER_PARTS.index(name[7:]) if name[7:] in BORDER_PARTS and name.startswith("border-") else None
+    side = SIDES.index(name[7:]) if name[7:] in SIDES and name.startswith("border-") else None
+
+    if name in ("margin", "padding") or part is not None:
+        if not 1 <= len(tokens) <= 4:
+            return []
+
+        return [("border-%s-%s" % (SIDES[index], BORDER_PARTS[part]) if part is not None else "%s-%s" % (name, SIDES[index]), tokens[SHORTHAND[len(tokens) - 1][index]]) for index in range(4)]
+
+    if name == "border" or side is not None:
+        if not 1 <= len(tokens) <= 3:
+            return []
+
+        if len(tokens) == 1 and tokens[0].lower() in ("inherit", "initial"):
+            values = [tokens[0]] * 3
+        else:
+            values = [None] * 3
+
+            for token in tokens:
+                if token.lower() in BORDER_STYLES:
+                    index = 1
+                elif token[0].isdigit() or token[0] == "." or token.lower() in ("thin", "medium", "thick"):
+                    index = 2
+                else:
+                    index = 0
+
+                if values[index] is not None:
+                    return []
+
+                values[index] = token
+
+            values = [value if value is not None else initial for value, initial in zip(values, BORDER_INITIAL)]
+
+        return [("border-%s-%s" % (SIDES[index], BORDER_PARTS[part]), values[part]) for index in (range(4) if side is None else [side]) for part in range(3)]
+
+    return [(name, value)]
+
+
+def parse(css, elements, matches, relations):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    rules = {}
+    order = 0
+
+    for selectors, block in re.findall(r"([^{}]+)\{([^}]*)\}", css):
+        properties = []
+
+        for declaration in block.split(";"):
+            if declaration.strip():
+                name, value = declaration.split(":", 1)
+                properties.extend(expand_property(name.strip().lower(), " ".join(value.split())))
+
+        for text in selectors.split(","):
+            selector = parse_selector(text, elements, matches, relations)
+            key = selector_hash(selector)
+
+            # Later declarations for the same selector as the rule just before win and move its order, as in bemAddRule()
+            if key in rules and rules[key][2][0] + 1 != order:
+                key = hashlib.sha3_256(key + b"@order %d" % order).digest()
+
+            if key not in rules:
+                rules[key] = (selector, {}, [0])
+
+            rules[key][1].update(properties)
+            rules[key][2][0] = order
+            order += 1
+
+    return rules
+
+
+def cstring(value):
+    return "NULL" if value is None else '"' + value.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def generate_mappings(elements, element_enums):
+    mappings = sorted((elements[element], attribute, name, value) for element, attribute, name, value in MAPPINGS)
+    ranges = {}
+
+    for index, mapping in enumerate(mappings):
+        ranges.setdefault(mapping[0], [index, 0])[1] += 1
+
+    lines = ["static const bem_attribute_mapping bem_default_mappings[%d] = {" % len(mappings)]
+    lines.extend("    {%s, %s, %s, %s}," % (element_enums[element], cstring(attribute), cstring(name), cstring(value)) for element, attribute, name, value in mappings)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_attribute_range bem_default_mapping_ranges[ELEMENT_MAX] = {")
+    lines.extend("    [%s] = {%d, %d}," % (element_enums[element], start, amount) for element, (start, amount) in sorted(ranges.items()))
+    lines.append("};")
+    lines.append("")
+
+    return lines
+
+
+def generate(rules, element_enums, mappings):
+    pairs, dictionaries, statements, selectors, rule_sets = [], [], [], [], []
+    selector_index = {}
+
+    def add_selector(selector):
+        if id(selector) in selector_index:
+            return selector_index[id(selector)]
+
+        previous = add_selector(selector.previous) if selector.previous else None
+        statement = len(statements)
+
+        statements.extend(selector.statements)
+        selectors.append("    {%s, %s, %s, %d, %s}," % ("(struct bem_stylesheet_selector *)bem_default_selectors + %d" % previous if previous is not None else "NULL",
+                                                         element_enums[selector.element], relation_enums[selector.relation], len(selector.statements),
+                                                         "(bem_stylesheet_selector_statement *)bem_default_statements + %d" % statement if selector.statements else "NULL"))
+        selector_index[id(selector)] = len(selectors) - 1
+
+        return len(selectors) - 1
+
+    dictionary_index = {}
+
+    for key in sorted(rules):
+        selector, properties, order = rules[key]
+        head = add_selector(selector)
+        items = tuple(sorted(properties.items(), key=lambda item: item[0].lower()))
+
+        # Rules with identical declarations share one dictionary
+        if items not in dictionary_index:
+            dictionary_index[items] = len(dictionaries)
+            dictionaries.append("    {NULL, %d, %d, (bem_pair *)bem_default_pairs + %d}," % (len(items), len(items), len(pairs)))
+            pairs.extend(items)
+
+        rule_sets.append("    {{%s}, (bem_stylesheet_selector *)bem_default_selectors + %d, (struct bem_dictionary *)bem_default_properties + %d, %d, 0}," %
+                         (", ".join("0x%02x" % byte for byte in key), head, dictionary_index[items], order[0]))
+
+    # Rules are already in hash order, so every collection is born sorted, and a rules_size of 0 marks the arrays as borrowed
+    by_element = {}
+
+    for index, key in enumerate(sorted(rules)):
+        by_element.setdefault(rules[key][0].element, []).append(index)
+
+    element_rules, collections = [], []
+
+    for element in sorted(by_element):
+        collections.append("        [%s] = {0, 0, %d, (bem_rule_set **)bem_default_element_rules + %d}," % (element_enums[element], len(by_element[element]),
+                                                                                                       len(element_rules)))
+        element_rules.extend(by_element[element])
+
+    lines = ["// Generated by css-default.py from default.css, do not edit", ""]
+    lines.append("static const bem_pair bem_default_pairs[%d] = {" % len(pairs))
+    lines.extend("    {%s, %s}," % (cstring(name), cstring(value)) for name, value in pairs)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_dictionary bem_default_properties[%d] = {" % len(dictionaries))
+    lines.extend(dictionaries)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_stylesheet_selector_statement bem_default_statements[%d] = {" % max(len(statements), 1))
+    lines.extend("    {%s, %s, %s}," % (match_enums[match], cstring(name), cstring(value)) for match, name, value in statements)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_stylesheet_selector bem_default_selectors[%d] = {" % len(selectors))
+    lines.extend(selectors)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_rule_set bem_default_rules[%d] = {" % len(rule_sets))
+    lines.extend(rule_sets)
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_rule_set *const bem_default_all_rules[%d] = {" % len(rule_sets))
+    lines.extend("    bem_default_rules + %d," % index for index in range(len(rule_sets)))
+    lines.append("};")
+    lines.append("")
+    lines.append("static const bem_rule_set *const bem_default_element_rules[%d] = {" % len(element_rules))
+    lines.extend("    bem_default_rules + %d," % index for index in element_rules)
+    lines.append("};")
+    lines.append("")
+    lines.extend(mappings)
+    lines.append("static const bem_stylesheet bem_default_css = {")
+    lines.append("    .all_rules = {0, 0, %d, (bem_rule_set **)bem_default_all_rules}," % len(rule_sets))
+    lines.append("    .rules = {")
+    lines.extend(collections)
+    lines.append("    }};")
+
+    return "\n".join(lines)
+
+
+def main():
+    global match_enums, relation_enums
+
+    header = open(sys.argv[1] if len(sys.argv) > 1 else "parser/parser.h").read()
+    css = open(sys.argv[2] if len(sys.argv) > 2 else "parser/default.css").read()
+    names = element_names(header)
+    elements = {name: index for index, (name, _) in enumerate(names)}
+
+    match_enums = enum_names(header, "bem_match")
+    relation_enums = enum_names(header, "bem_relation")
+
+    rules = parse(css, elements, {name: index for index, name in enumerate(match_enums)},
+                  {name: index for index, name in enumerate(relation_enums)})
+
+    element_enums = [enum for _, enum in names]
+
+    print(generate(rules, element_enums, generate_mappings(elements, element_enums)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Generates the perfect hash tables used by bemElementValueN() from the
+# bem_element enum in parser.h.  Re-run and paste the output into parser.c
+# whenever elements are added or removed:
+#
+#   python3 parser/element-hash.py parser/parser.h
+#
+
+import re
+import sys
+
+BUCKETS = 64
+SLOTS = 256
+
+
+def element_names(header):
+    body = header[header.index("ELEMENT_WILDCARD,"):header.index("ELEMENT_MAX")]
+    special = {"WILDCARD": "*", "COMMENT": "!--", "DOCTYPE": "!DOCTYPE"}
+
+    return [special.get(name, name.lower()) for name in re.findall(r"ELEMENT_(\w+),", body)]
+
+
+def element_hash(name):
+    # Must match bemElementValueN(): FNV-1a seeded with the length, ASCII case folded with | 0x20
+    value = 2166136261 ^ len(name)
+
+    for ch in name.encode():
+        value = ((value ^ (ch | 0x20)) * 16777619) & 0xffffffff
+
+    return value
+
+
+def build(names):
+    buckets = [[] for _ in range(BUCKETS)]
+
+    for element, name in enumerate(names):
+        buckets[(element_hash(name) >> 8) % BUCKETS].append(element)
+
+    displacements = [0] * BUCKETS
+    slots = [255] * SLOTS
+
+    for bucket in sorted(range(BUCKETS), key=lambda b: -len(buckets[b])):
+        for displacement in range(256):
+            wanted = [(element_hash(names[e]) ^ displacement) % SLOTS for e in buckets[bucket]]
+
+            if len(set(wanted)) == len(wanted) and all(slots[w] == 255 for w in wanted):
+                break
+        else:
+            sys.exit("no displacement found for bucket %d" % bucket)
+
+        displacements[bucket] = displacement
+
+        for element, slot in zip(buckets[bucket], wanted):
+            slots[slot] = element
+
+    return displacements, slots
+
+
+def table(name, values, count):
+    lines = ["static const unsigned char %s[%s] = {" % (name, count)]
+
+    for i in range(0, len(values), 16):
+        lines.append("    " + ", ".join("%3d" % v for v in values[i:i + 16]) + ",")
+
+    lines[-1] = lines[-1].rstrip(",") + "};"
+
+    return "\n".join(lines)
+
+
+def main():
+    names = element_names(open(sys.argv[1] if len(sys.argv) > 1 else "parser/parser.h").read())
+    displacements, slots = build(names)
+
+    print("#define BEM_ELEMENT_NAME_MAX %d\n" % max(len(name) for name in names))
+    print(table("bem_element_displacements", displacements, BUCKETS))
+    print()
+    print(table("bem_element_slots", slots, SLOTS))
+
+
+if __name__ == "__main__":
+    main()
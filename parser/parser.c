@@ -103,760 +103,13333 @@ char *bemDefaultURLCallback(void *context, const char *url, char *buffer, size_t
     return buffer;
 }
 
-bem_dictionary *bemDictionaryCopy(const bem_dictionary *dictionary)
+const bem_dictionary *bemCSSGetInlineProperties(bem_stylesheet *css, const char *str)
 {
-    bem_dictionary *new_dictionary;
+    bem_inline_style *style;
 
-    if (!dictionary)
+    if (!css || !str)
         return NULL;
-    if ((new_dictionary = calloc(1, sizeof(bem_dictionary))) == NULL)
+
+    // Identical style attributes are common, so each distinct string is only parsed once per pool
+    if ((style = bemFindInlineStyle(css->pool, bemPoolGetString(css->pool, str))) == NULL)
         return NULL;
 
-    new_dictionary->pool = dictionary->pool;
-    new_dictionary->pair_amount = dictionary->pair_amount;
-    new_dictionary->pairs_size = dictionary->pairs_size;
+    if (!style->properties && (style->properties = bemDictionaryNew(css->pool)) != NULL)
+        bemParseInlineStyle(css->pool, style->text, style->properties);
 
-    if ((new_dictionary->pairs = calloc(new_dictionary->pair_amount, sizeof(bem_pair))) == NULL)
+    return style->properties;
+}
+
+void bemCSSImportString(bem_stylesheet *css, bem_dictionary *properties, const char *str)
+{
+    const bem_dictionary *style;
+    bem_pair *pairs;
+    size_t i, j, k;
+    int result;
+
+    if (!css || !properties || (style = bemCSSGetInlineProperties(css, str)) == NULL || style->pair_amount == 0)
+        return;
+
+    if (properties->pool != style->pool || (pairs = (bem_pair *)malloc((properties->pair_amount + style->pair_amount) * sizeof(bem_pair))) == NULL)
     {
-        free(new_dictionary);
-        return NULL;
+        for (i = 0; i < style->pair_amount; i++)
+            bemDictionarySetKeyValue(properties, style->pairs[i].key, style->pairs[i].value);
+
+        return;
     }
 
-    memcpy(new_dictionary->pairs, dictionary->pairs, new_dictionary->pair_amount * sizeof(bem_pair));
+    // Both sides are sorted and interned in the same pool, so merge them instead of inserting one pair at a time
+    for (i = j = k = 0; i < properties->pair_amount || j < style->pair_amount; k++)
+    {
+        if (j >= style->pair_amount)
+            result = -1;
+        else if (i >= properties->pair_amount)
+            result = 1;
+        else
+            result = strcasecmp(properties->pairs[i].key, style->pairs[j].key);
 
-    return new_dictionary;
+        if (result < 0)
+        {
+            pairs[k] = properties->pairs[i++];
+        }
+        else
+        {
+            if (result == 0)
+                i++;
+
+            pairs[k] = style->pairs[j++];
+        }
+    }
+
+    free(properties->pairs);
+
+    properties->pairs = pairs;
+    properties->pairs_size = properties->pair_amount + style->pair_amount;
+    properties->pair_amount = k;
 }
 
-void bemDictionaryDelete(bem_dictionary *dictionary)
+void bemCSSSelectorAddStatement(bem_stylesheet *css, bem_stylesheet_selector *selector, bem_match match, const char *name, const char *value)
 {
-    if (dictionary)
+    bem_stylesheet_selector_statement *statement;
+
+    if (!css || !selector)
+        return;
+
+    if ((statement = (bem_stylesheet_selector_statement *)realloc(selector->statements, (selector->statement_amount + 1) * sizeof(bem_stylesheet_selector_statement))) == NULL)
     {
-        if (dictionary->pairs)
-            free(dictionary->pairs);
-        free(dictionary);
+        bemPoolError(css->pool, 0, "Unable to allocate memory for selector statements.");
+        return;
     }
+
+    selector->statements = statement;
+    statement += selector->statement_amount++;
+
+    statement->match = match;
+    statement->name = bemPoolGetString(css->pool, name);
+    statement->value = bemPoolGetString(css->pool, value);
 }
 
-size_t bemDictionaryGetCount(const bem_dictionary *dictionary)
+void bemCSSSelectorDelete(bem_stylesheet_selector *selector)
 {
-    return (dictionary ? dictionary->pair_amount : 0);
+    bem_stylesheet_selector *previous;
+
+    for (; selector; selector = previous)
+    {
+        previous = selector->previous;
+
+        free(selector->statements);
+        free(selector);
+    }
 }
 
-const char *bemDictionaryGetIndexKeyValue(const bem_dictionary *dictionary, size_t index, const char **key)
+void bemCSSSelectorHash(bem_stylesheet_selector *selector, bem_sha3_256 hash)
 {
-    if (!dictionary || index >= dictionary->pair_amount || !key)
-        return NULL;
+    bem_sha3 context;
+    char buffer[64];
+    size_t i;
 
-    *key = dictionary->pairs[index].key;
+    // css-default.py hashes the same byte sequence for the built-in rules
+    bemSHA3Init(&context);
 
-    return dictionary->pairs[index].value;
+    for (; selector; selector = selector->previous)
+    {
+        snprintf(buffer, sizeof(buffer), "%d %d %u", (int)selector->element, (int)selector->relation, (unsigned)selector->statement_amount);
+        bemSHA3Update(&context, buffer, strlen(buffer) + 1);
+
+        for (i = 0; i < selector->statement_amount; i++)
+        {
+            snprintf(buffer, sizeof(buffer), "%d", (int)selector->statements[i].match);
+            bemSHA3Update(&context, buffer, strlen(buffer) + 1);
+            bemSHA3Update(&context, selector->statements[i].name, strlen(selector->statements[i].name) + 1);
+
+            if (selector->statements[i].value)
+                bemSHA3Update(&context, selector->statements[i].value, strlen(selector->statements[i].value) + 1);
+            else
+                bemSHA3Update(&context, "", 1);
+        }
+    }
+
+    bemSHA3Final(&context, hash, BEM_SHA3_256_SIZE);
 }
 
-const char *bemDictionaryGetKeyValue(const bem_dictionary *dictionary, const char *key)
+bem_stylesheet_selector *bemCSSSelectorNew(bem_stylesheet *css, bem_stylesheet_selector *previous, bem_element element, bem_relation relation)
 {
-    bem_pair temp, *ptr;
+    bem_stylesheet_selector *selector;
 
-    if (!dictionary || dictionary->pair_amount == 0)
+    if (!css)
         return NULL;
 
-    temp.key = key;
-    temp.value = NULL;
-
-    if ((ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs)) != NULL)
+    if ((selector = (bem_stylesheet_selector *)calloc(1, sizeof(bem_stylesheet_selector))) == NULL)
     {
-        return ptr->value;
+        bemPoolError(css->pool, 0, "Unable to allocate memory for selector.");
+        return NULL;
     }
 
-    return NULL;
+    selector->previous = previous;
+    selector->element = element;
+    selector->relation = relation;
+
+    return (selector);
 }
 
-bem_dictionary *bemDictionaryNew(bem_memory_pool *pool)
+void bemRuleCollectionAdd(bem_stylesheet *css, bem_rule_collection *collection, bem_rule_set *rule)
 {
-    bem_dictionary *dictionary;
+    bem_rule_set **rules;
+    size_t left, right, middle, rules_size;
 
-    if ((dictionary = (bem_dictionary *)calloc(1, sizeof(bem_dictionary))) != NULL)
-        dictionary->pool = pool;
+    // Loaded stylesheets are copied to the heap before their first change
+    if (css->mapping)
+        bemUnmapCSS(css);
 
-    return dictionary;
-}
+    if (collection->rules_amount >= collection->rules_size)
+    {
+        rules_size = collection->rules_amount ? 2 * collection->rules_amount : 16;
 
-void bemDictionaryRemoveKey(bem_dictionary *dictionary, const char *key)
-{
-    bem_pair temp, *ptr;
-    size_t index;
+        // A rules_size of 0 means the array is borrowed from a shared table, so copy it on the first write
+        if (collection->rules_size)
+        {
+            rules = (bem_rule_set **)realloc(collection->rules, rules_size * sizeof(bem_rule_set *));
+        }
+        else if ((rules = (bem_rule_set **)malloc(rules_size * sizeof(bem_rule_set *))) != NULL && collection->rules_amount)
+        {
+            memcpy(rules, collection->rules, collection->rules_amount * sizeof(bem_rule_set *));
+        }
 
-    if (!dictionary || dictionary->pair_amount == 0)
-        return;
+        if (!rules)
+        {
+            bemPoolError(css->pool, 0, "Unable to allocate memory for stylesheet rules.");
+            return;
+        }
 
-    temp.key = key;
-    temp.value = NULL;
+        collection->rules = rules;
+        collection->rules_size = rules_size;
+    }
 
-    if ((ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs)) != NULL)
+    if (collection->needs_sorting)
     {
-        dictionary->pair_amount--;
+        collection->rules[collection->rules_amount++] = rule;
+        return;
+    }
 
-        index = (size_t)(ptr - dictionary->pairs);
+    // Insert in hash order so lookups while importing never have to re-sort the collection
+    for (left = 0, right = collection->rules_amount; left < right;)
+    {
+        middle = (left + right) / 2;
 
-        if (index < dictionary->pair_amount)
-            memmove(ptr, ptr + 1, (dictionary->pair_amount - index) * sizeof(bem_pair));
+        if (bemCompareRules(collection->rules + middle, &rule) <= 0)
+            left = middle + 1;
+        else
+            right = middle;
     }
+
+    if (left < collection->rules_amount)
+        memmove(collection->rules + left + 1, collection->rules + left, (collection->rules_amount - left) * sizeof(bem_rule_set *));
+
+    collection->rules[left] = rule;
+    collection->rules_amount++;
 }
 
-void bemDictionarySetKeyValue(bem_dictionary *dictionary, const char *key, const char *value)
+void bemRuleCollectionClear(bem_rule_collection *collection, int delete_rules)
 {
-    bem_pair temp, *ptr = NULL;
+    size_t i;
 
-    if (!dictionary)
+    if (delete_rules)
     {
-        return;
+        for (i = 0; i < collection->rules_amount; i++)
+            bemRuleDelete(collection->rules[i]);
     }
-    else if (dictionary->pair_amount == 1 && !strcmp(dictionary->pairs[0].key, key))
+
+    if (collection->rules_size)
+        free(collection->rules);
+
+    memset(collection, 0, sizeof(bem_rule_collection));
+}
+
+bem_rule_set *bemRuleCollectionFindHash(bem_rule_collection *collection, const bem_sha3_256 hash)
+{
+    bem_rule_set temp, *pointer, **match;
+
+    if (collection->rules_amount == 0)
+        return NULL;
+
+    // Collections are kept in hash order unless rules were appended out of order
+    if (collection->needs_sorting)
     {
-        ptr = dictionary->pairs;
+        qsort(collection->rules, collection->rules_amount, sizeof(bem_rule_set *), (bem_comparison_function)bemCompareRules);
+        collection->needs_sorting = 0;
     }
-    else if (dictionary->pair_amount > 1)
+
+    memcpy(temp.hash, hash, sizeof(temp.hash));
+    pointer = &temp;
+
+    if ((match = (bem_rule_set **)bsearch(&pointer, collection->rules, collection->rules_amount, sizeof(bem_rule_set *), (bem_comparison_function)bemCompareRules)) != NULL)
+        return *match;
+
+    return NULL;
+}
+
+void bemRuleDelete(bem_rule_set *rule)
+{
+    if (rule)
     {
-        temp.key = key;
-        ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs);
+        bemCSSSelectorDelete(rule->selector);
+        bemDictionaryDelete(rule->properties);
+        free(rule);
     }
+}
 
-    if (ptr)
+bem_rule_set *bemRuleNew(bem_stylesheet *css, const bem_sha3_256 hash, bem_stylesheet_selector *selector, bem_dictionary *properties)
+{
+    bem_rule_set *rule;
+
+    // The rule takes ownership of the selector and properties
+    if ((rule = (bem_rule_set *)calloc(1, sizeof(bem_rule_set))) == NULL)
     {
-        ptr->value = bemPoolGetString(dictionary->pool, value);
-        return;
+        bemPoolError(css->pool, 0, "Unable to allocate memory for stylesheet rule.");
+        return NULL;
     }
 
-    if (dictionary->pair_amount >= dictionary->pairs_size)
+    memcpy(rule->hash, hash, sizeof(rule->hash));
+    rule->selector = selector;
+    rule->properties = properties;
+    rule->order = css->rule_order++;
+
+    return (rule);
+}
+
+// Generated by css-default.py from default.css, do not edit
+
+static const bem_pair bem_default_pairs[144] = {
+    {"border-bottom-style", "inset"},
+    {"border-bottom-width", "1px"},
+    {"border-left-style", "inset"},
+    {"border-left-width", "1px"},
+    {"border-right-style", "inset"},
+    {"border-right-width", "1px"},
+    {"border-top-style", "inset"},
+    {"border-top-width", "1px"},
+    {"color", "gray"},
+    {"margin-bottom", "0.5em"},
+    {"margin-left", "auto"},
+    {"margin-right", "auto"},
+    {"margin-top", "0.5em"},
+    {"list-style-type", "square"},
+    {"list-style-type", "circle"},
+    {"display", "block"},
+    {"background-color", "yellow"},
+    {"color", "black"},
+    {"text-decoration", "underline"},
+    {"outline", "auto"},
+    {"display", "none"},
+    {"margin-bottom", "0"},
+    {"margin-top", "0"},
+    {"font-size", "smaller"},
+    {"vertical-align", "sub"},
+    {"font-size", "larger"},
+    {"font-style", "italic"},
+    {"display", "table-header-group"},
+    {"vertical-align", "middle"},
+    {"font-family", "monospace"},
+    {"margin-bottom", "8px"},
+    {"margin-left", "8px"},
+    {"margin-right", "8px"},
+    {"margin-top", "8px"},
+    {"font-family", "serif"},
+    {"font-size", "12pt"},
+    {"line-height", "1.2"},
+    {"margin-bottom", "1em"},
+    {"margin-top", "1em"},
+    {"text-decoration", "line-through"},
+    {"display", "table-cell"},
+    {"padding-bottom", "1px"},
+    {"padding-left", "1px"},
+    {"padding-right", "1px"},
+    {"padding-top", "1px"},
+    {"vertical-align", "inherit"},
+    {"border-bottom-color", "gray"},
+    {"border-bottom-style", "inset"},
+    {"border-bottom-width", "1px"},
+    {"border-left-color", "gray"},
+    {"border-left-style", "inset"},
+    {"border-left-width", "1px"},
+    {"border-right-color", "gray"},
+    {"border-right-style", "inset"},
+    {"border-right-width", "1px"},
+    {"border-top-color", "gray"},
+    {"border-top-style", "inset"},
+    {"border-top-width", "1px"},
+    {"display", "table-row"},
+    {"vertical-align", "inherit"},
+    {"font-size", "0.67em"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "2.33em"},
+    {"margin-top", "2.33em"},
+    {"content", "\"\\200B\""},
+    {"list-style-type", "upper-alpha"},
+    {"text-decoration", "underline dotted"},
+    {"font-size", "0.83em"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "1.67em"},
+    {"margin-top", "1.67em"},
+    {"font-size", "1.5em"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "0.83em"},
+    {"margin-top", "0.83em"},
+    {"font-size", "smaller"},
+    {"vertical-align", "super"},
+    {"padding-left", "40px"},
+    {"list-style-type", "disc"},
+    {"font-size", "smaller"},
+    {"display", "inline-block"},
+    {"border-bottom-color", "gray"},
+    {"border-bottom-style", "groove"},
+    {"border-bottom-width", "2px"},
+    {"border-left-color", "gray"},
+    {"border-left-style", "groove"},
+    {"border-left-width", "2px"},
+    {"border-right-color", "gray"},
+    {"border-right-style", "groove"},
+    {"border-right-width", "2px"},
+    {"border-top-color", "gray"},
+    {"border-top-style", "groove"},
+    {"border-top-width", "2px"},
+    {"margin-left", "2px"},
+    {"margin-right", "2px"},
+    {"padding-bottom", "0.625em"},
+    {"padding-left", "0.75em"},
+    {"padding-right", "0.75em"},
+    {"padding-top", "0.35em"},
+    {"content", "close-quote"},
+    {"display", "table-column-group"},
+    {"list-style-type", "decimal"},
+    {"list-style-type", "lower-roman"},
+    {"font-weight", "bold"},
+    {"margin-left", "40px"},
+    {"margin-right", "40px"},
+    {"font-weight", "bold"},
+    {"text-align", "center"},
+    {"padding-left", "2px"},
+    {"padding-right", "2px"},
+    {"color", "blue"},
+    {"text-decoration", "underline"},
+    {"font-family", "monospace"},
+    {"white-space", "pre"},
+    {"content", "open-quote"},
+    {"font-size", "1.17em"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "1em"},
+    {"margin-top", "1em"},
+    {"display", "table-caption"},
+    {"text-align", "center"},
+    {"list-style-type", "lower-alpha"},
+    {"white-space", "pre"},
+    {"white-space", "nowrap"},
+    {"border-collapse", "separate"},
+    {"border-spacing", "2px"},
+    {"display", "table"},
+    {"text-indent", "0"},
+    {"margin-left", "40px"},
+    {"display", "table-column"},
+    {"display", "table-footer-group"},
+    {"vertical-align", "middle"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "1.33em"},
+    {"margin-top", "1.33em"},
+    {"list-style-type", "upper-roman"},
+    {"display", "table-row-group"},
+    {"vertical-align", "middle"},
+    {"display", "list-item"},
+    {"font-size", "2em"},
+    {"font-weight", "bold"},
+    {"margin-bottom", "0.67em"},
+    {"margin-top", "0.67em"},
+    {"text-align", "center"},
+};
+
+static const bem_dictionary bem_default_properties[59] = {
+    {NULL, 13, 13, (bem_pair *)bem_default_pairs + 0},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 13},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 14},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 15},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 16},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 18},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 19},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 20},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 21},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 23},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 25},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 26},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 27},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 29},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 30},
+    {NULL, 3, 3, (bem_pair *)bem_default_pairs + 34},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 37},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 39},
+    {NULL, 6, 6, (bem_pair *)bem_default_pairs + 40},
+    {NULL, 12, 12, (bem_pair *)bem_default_pairs + 46},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 58},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 60},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 64},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 65},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 66},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 67},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 71},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 75},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 77},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 78},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 79},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 80},
+    {NULL, 18, 18, (bem_pair *)bem_default_pairs + 81},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 99},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 100},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 101},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 102},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 103},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 104},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 106},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 108},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 110},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 112},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 114},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 115},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 119},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 121},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 122},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 123},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 124},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 128},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 129},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 130},
+    {NULL, 3, 3, (bem_pair *)bem_default_pairs + 132},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 135},
+    {NULL, 2, 2, (bem_pair *)bem_default_pairs + 136},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 138},
+    {NULL, 4, 4, (bem_pair *)bem_default_pairs + 139},
+    {NULL, 1, 1, (bem_pair *)bem_default_pairs + 143},
+};
+
+static const bem_stylesheet_selector_statement bem_default_statements[19] = {
+    {MATCH_PSEUDO_CLASS, "focus", NULL},
+    {MATCH_ATTRIBUTE_EXIST, "border", NULL},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "A"},
+    {MATCH_ATTRIBUTE_EXIST, "title", NULL},
+    {MATCH_ATTRIBUTE_EXIST, "border", NULL},
+    {MATCH_PSEUDO_CLASS, "after", NULL},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "1"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "i"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "1"},
+    {MATCH_PSEUDO_CLASS, "link", NULL},
+    {MATCH_ATTRIBUTE_EXIST, "title", NULL},
+    {MATCH_PSEUDO_CLASS, "before", NULL},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "a"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "a"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "I"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "i"},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "I"},
+    {MATCH_PSEUDO_CLASS, "visited", NULL},
+    {MATCH_ATTRIBUTE_EQUALS, "type", "A"},
+};
+
+static const bem_stylesheet_selector bem_default_selectors[270] = {
+    {NULL, ELEMENT_HR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 1, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 2, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 4, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_HR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MARK, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_INS, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_WILDCARD, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 0},
+    {NULL, ELEMENT_TEMPLATE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 11, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 12, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 14, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SUB, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_CENTER, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BIG, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_EM, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 21, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 23, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 24, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 26, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 27, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BASE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_THEAD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BASEFONT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_CODE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BODY, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_HTML, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_HTML, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SECTION, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FIELDSET, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DEL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 40, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_STRIKE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TH, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TABLE, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 1},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 44, ELEMENT_TD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_PARAM, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 47, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 49, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 53, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DFN, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H6, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_WBR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_HEAD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 2},
+    {NULL, ELEMENT_AREA, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 61, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 62, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_ABBR, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 3},
+    {NULL, ELEMENT_H5, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H2, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SUP, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FIELDSET, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 70, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 71, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SUMMARY, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 75, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 77, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DETAILS, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_S, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 81, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 82, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 85, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 86, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H6, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_HEADER, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DATALIST, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MAIN, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 95, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_META, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 99, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_P, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TABLE, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 4},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 102, ELEMENT_TH, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 104, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 105, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 107, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 108, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 110, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 111, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H5, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_P, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 116, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_PRE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SMALL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 120, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TEXTAREA, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 123, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BUTTON, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FIELDSET, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 129, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 131, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_Q, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 5},
+    {NULL, ELEMENT_ADDRESS, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_U, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_COLGROUP, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_INPUT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 138, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SAMP, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TITLE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_ARTICLE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 6},
+    {NULL, ELEMENT_FIGCAPTION, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 7},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BLOCKQUOTE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_KBD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 8},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 152, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_B, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_STYLE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIV, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 157, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FIGURE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 160, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TH, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LEGEND, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H1, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_A, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 9},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_NAV, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 170, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_ADDRESS, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 173, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_I, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LINK, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_PRE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H4, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_NOFRAMES, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 180, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_ACRONYM, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 10},
+    {NULL, ELEMENT_BODY, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 184, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FORM, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_Q, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 11},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 188, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 190, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 192, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H3, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H2, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_CITE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_CAPTION, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LEGEND, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BLOCKQUOTE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BLOCKQUOTE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 201, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 202, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 12},
+    {NULL, ELEMENT_FIGURE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 206, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FIGURE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 209, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 210, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_BR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 213, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_ASIDE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 216, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_NOBR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TABLE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FRAMESET, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 221, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SCRIPT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DD, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 225, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_COL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 229, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TFOOT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_SELECT, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 233, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 234, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 236, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_STRONG, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H4, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 240, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 241, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 13},
+    {NULL, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 244, ELEMENT_DIR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 14},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 15},
+    {NULL, ELEMENT_DIALOG, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 251, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 252, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_TBODY, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_MENU, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 255, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_FOOTER, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_PRE, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_VAR, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 16},
+    {NULL, ELEMENT_A, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 17},
+    {NULL, ELEMENT_OL, RELATION_CHILD, 0, NULL},
+    {(struct bem_stylesheet_selector *)bem_default_selectors + 264, ELEMENT_UL, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H3, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_H1, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_CENTER, RELATION_CHILD, 0, NULL},
+    {NULL, ELEMENT_LI, RELATION_CHILD, 1, (bem_stylesheet_selector_statement *)bem_default_statements + 18},
+};
+
+static const bem_rule_set bem_default_rules[199] = {
+    {{0x00, 0xe8, 0x88, 0xaf, 0x38, 0x6f, 0xb8, 0xb0, 0x90, 0x99, 0x39, 0xb6, 0xfa, 0x0e, 0xd4, 0x6c, 0xf5, 0x0e, 0xbb, 0x43, 0xfb, 0xfc, 0xd4, 0xe4, 0x08, 0xfb, 0xdb, 0xf2, 0x7d, 0x49, 0x2d, 0x77}, (bem_stylesheet_selector *)bem_default_selectors + 0, (struct bem_dictionary *)bem_default_properties + 0, 162, 0},
+    {{0x02, 0x8b, 0xdc, 0x05, 0x09, 0x45, 0x00, 0xd8, 0xa7, 0x21, 0x5d, 0x8e, 0x4e, 0xf7, 0x69, 0xaa, 0x01, 0x0b, 0xbf, 0x74, 0x13, 0x0b, 0x68, 0x2d, 0x3a, 0x8d, 0x77, 0x7d, 0x02, 0x2d, 0x88, 0xad}, (bem_stylesheet_selector *)bem_default_selectors + 3, (struct bem_dictionary *)bem_default_properties + 1, 119, 0},
+    {{0x03, 0x24, 0x79, 0xc0, 0x8d, 0x18, 0xab, 0xf9, 0xa9, 0xf7, 0xe3, 0xc5, 0x2a, 0x4b, 0x4d, 0x41, 0xd3, 0xa4, 0xc0, 0xec, 0x3e, 0x00, 0x92, 0x1d, 0xc8, 0xa1, 0x96, 0xe6, 0x97, 0xc8, 0x34, 0x93}, (bem_stylesheet_selector *)bem_default_selectors + 5, (struct bem_dictionary *)bem_default_properties + 2, 102, 0},
+    {{0x03, 0x38, 0x25, 0xf4, 0x6f, 0xa1, 0x5d, 0xc2, 0x4c, 0x43, 0x08, 0x54, 0xec, 0x9e, 0xdd, 0x8b, 0x24, 0xa9, 0x96, 0x53, 0x32, 0x8d, 0xa0, 0xbf, 0x5e, 0x40, 0x38, 0x08, 0x8d, 0x8f, 0x86, 0x33}, (bem_stylesheet_selector *)bem_default_selectors + 6, (struct bem_dictionary *)bem_default_properties + 3, 28, 0},
+    {{0x05, 0xdf, 0x17, 0xec, 0x8d, 0x80, 0x69, 0x9f, 0xb2, 0xac, 0xae, 0x1f, 0x3a, 0x18, 0x42, 0x42, 0x02, 0xdf, 0x66, 0xcf, 0x77, 0x40, 0xd5, 0x5c, 0x60, 0xe0, 0xb1, 0xfa, 0x0e, 0x9b, 0xc6, 0x35}, (bem_stylesheet_selector *)bem_default_selectors + 7, (struct bem_dictionary *)bem_default_properties + 4, 168, 0},
+    {{0x06, 0x8d, 0xc2, 0x36, 0x8e, 0x7c, 0x62, 0x79, 0x04, 0x0f, 0x63, 0x8e, 0x4e, 0xb9, 0xcd, 0x25, 0x8c, 0x34, 0x6b, 0xbb, 0xe9, 0x1d, 0xd6, 0x3d, 0xfc, 0x82, 0xcb, 0xbe, 0xcd, 0x52, 0x64, 0xb2}, (bem_stylesheet_selector *)bem_default_selectors + 8, (struct bem_dictionary *)bem_default_properties + 5, 164, 0},
+    {{0x0b, 0xc4, 0x69, 0x61, 0xaf, 0xf1, 0xed, 0x81, 0x08, 0xcc, 0x8e, 0x7b, 0x23, 0x2d, 0x06, 0x45, 0xb6, 0xe1, 0xc7, 0x5c, 0x4b, 0xe7, 0x34, 0xb3, 0xae, 0xb4, 0x19, 0x2e, 0x01, 0xdf, 0x79, 0x41}, (bem_stylesheet_selector *)bem_default_selectors + 9, (struct bem_dictionary *)bem_default_properties + 6, 198, 0},
+    {{0x0d, 0x06, 0x35, 0x40, 0x8e, 0x2c, 0x15, 0x15, 0xa1, 0x16, 0x1b, 0xef, 0x62, 0x9d, 0x6e, 0xfb, 0x75, 0x73, 0x71, 0xd1, 0xeb, 0xe5, 0x50, 0x0c, 0x68, 0x72, 0xdd, 0x3c, 0x39, 0xc0, 0xaa, 0xb4}, (bem_stylesheet_selector *)bem_default_selectors + 10, (struct bem_dictionary *)bem_default_properties + 7, 52, 0},
+    {{0x0f, 0x0a, 0x9f, 0x83, 0x7e, 0x7e, 0x77, 0x34, 0x35, 0x1b, 0xd6, 0x9f, 0x6e, 0x62, 0xc7, 0x0a, 0xc2, 0x95, 0x13, 0x04, 0xef, 0x33, 0x17, 0xcc, 0xaf, 0x3c, 0xfd, 0xa3, 0x28, 0xff, 0xac, 0xa1}, (bem_stylesheet_selector *)bem_default_selectors + 13, (struct bem_dictionary *)bem_default_properties + 1, 115, 0},
+    {{0x11, 0x32, 0x9f, 0x37, 0xdd, 0x65, 0xec, 0x33, 0xc0, 0x49, 0x12, 0xb1, 0x5e, 0x1b, 0xf0, 0x71, 0xe2, 0xa0, 0xb4, 0xa0, 0x34, 0x59, 0xf8, 0x15, 0xcb, 0xa2, 0x94, 0x36, 0xba, 0xdb, 0x90, 0x40}, (bem_stylesheet_selector *)bem_default_selectors + 15, (struct bem_dictionary *)bem_default_properties + 8, 138, 0},
+    {{0x13, 0x34, 0x47, 0x30, 0x7d, 0x56, 0x63, 0x0c, 0x2a, 0xf7, 0xa6, 0x1c, 0x36, 0x53, 0xa1, 0x71, 0x32, 0x2a, 0xa8, 0xcc, 0xe5, 0xd2, 0x76, 0x5b, 0xea, 0x0b, 0xe9, 0xa9, 0x4f, 0x04, 0x7c, 0x83}, (bem_stylesheet_selector *)bem_default_selectors + 16, (struct bem_dictionary *)bem_default_properties + 3, 8, 0},
+    {{0x14, 0x14, 0x5f, 0x9f, 0xca, 0xc1, 0xcd, 0xa1, 0x67, 0x00, 0xdb, 0x75, 0xf1, 0xb1, 0xec, 0x62, 0xc7, 0x4e, 0x0c, 0x09, 0x82, 0x0f, 0x1c, 0x16, 0x88, 0x53, 0xfd, 0xfc, 0x97, 0x83, 0xfa, 0xff}, (bem_stylesheet_selector *)bem_default_selectors + 17, (struct bem_dictionary *)bem_default_properties + 9, 185, 0},
+    {{0x14, 0xd6, 0xc7, 0xf5, 0xc5, 0x7a, 0xd6, 0x08, 0x51, 0xea, 0x5e, 0x2e, 0xba, 0x36, 0xec, 0x8c, 0xc9, 0xd5, 0x74, 0x69, 0xa2, 0x66, 0x9d, 0xa7, 0xc9, 0xfa, 0xea, 0x73, 0xf1, 0xec, 0xc1, 0x73}, (bem_stylesheet_selector *)bem_default_selectors + 18, (struct bem_dictionary *)bem_default_properties + 3, 7, 0},
+    {{0x16, 0x58, 0x11, 0xb5, 0x70, 0x20, 0x2d, 0x65, 0xcf, 0x8b, 0xd4, 0xb5, 0xfe, 0xb0, 0x62, 0x5e, 0xea, 0x59, 0x27, 0x84, 0x7c, 0x22, 0xad, 0xa5, 0xc6, 0xec, 0xb1, 0x7a, 0x83, 0xfb, 0x9a, 0xea}, (bem_stylesheet_selector *)bem_default_selectors + 19, (struct bem_dictionary *)bem_default_properties + 10, 64, 0},
+    {{0x18, 0x01, 0x71, 0xbd, 0x17, 0xd4, 0x7d, 0xb3, 0xcb, 0x28, 0x7e, 0x8e, 0xe7, 0x93, 0x4e, 0x62, 0x8b, 0x15, 0xc4, 0xd7, 0x4b, 0xc8, 0xe0, 0xc5, 0xe5, 0x48, 0x56, 0xa8, 0x44, 0xfb, 0x26, 0x75}, (bem_stylesheet_selector *)bem_default_selectors + 20, (struct bem_dictionary *)bem_default_properties + 11, 59, 0},
+    {{0x18, 0x91, 0xcd, 0xd6, 0xfe, 0x1b, 0xfb, 0xc9, 0xb5, 0xe9, 0xc2, 0xc8, 0x56, 0xef, 0x15, 0xfa, 0x99, 0xa2, 0x4b, 0x28, 0x27, 0xc2, 0x6e, 0x80, 0x76, 0x73, 0xad, 0xc4, 0x40, 0x05, 0x63, 0x9a}, (bem_stylesheet_selector *)bem_default_selectors + 22, (struct bem_dictionary *)bem_default_properties + 8, 154, 0},
+    {{0x1a, 0x0d, 0x06, 0xfa, 0x10, 0x4f, 0xb7, 0x16, 0xbf, 0xae, 0xdd, 0x9f, 0x3e, 0xaa, 0x43, 0x42, 0x7d, 0x1c, 0xee, 0x5e, 0xc9, 0xf4, 0x29, 0x4b, 0xa4, 0x41, 0x26, 0xbb, 0xbc, 0xf4, 0xd9, 0x97}, (bem_stylesheet_selector *)bem_default_selectors + 25, (struct bem_dictionary *)bem_default_properties + 1, 122, 0},
+    {{0x1a, 0xae, 0x32, 0xd3, 0xa2, 0x00, 0x27, 0xdb, 0x5d, 0x53, 0x40, 0x09, 0x78, 0x9e, 0x40, 0xdc, 0x39, 0xa1, 0xf0, 0x33, 0x2e, 0xf1, 0x22, 0x1b, 0x92, 0x49, 0x62, 0x69, 0x30, 0x71, 0x12, 0xce}, (bem_stylesheet_selector *)bem_default_selectors + 28, (struct bem_dictionary *)bem_default_properties + 1, 126, 0},
+    {{0x1b, 0xc7, 0x69, 0xa1, 0x5e, 0x48, 0xc6, 0x8a, 0x02, 0x89, 0xfb, 0xe3, 0xaa, 0x07, 0x22, 0x37, 0xac, 0x52, 0x52, 0xfc, 0xc8, 0x64, 0xd1, 0xfb, 0xa4, 0x97, 0x8e, 0xac, 0x4a, 0x7e, 0xf5, 0x45}, (bem_stylesheet_selector *)bem_default_selectors + 29, (struct bem_dictionary *)bem_default_properties + 7, 42, 0},
+    {{0x1c, 0x71, 0x88, 0xa0, 0xea, 0x6b, 0x01, 0x89, 0x38, 0x10, 0x62, 0x75, 0x23, 0x6b, 0xcd, 0x15, 0x91, 0xd7, 0xa2, 0x3c, 0x68, 0x9f, 0xc3, 0x9e, 0xba, 0x1b, 0xd2, 0xfd, 0x3a, 0x27, 0x6d, 0xd3}, (bem_stylesheet_selector *)bem_default_selectors + 30, (struct bem_dictionary *)bem_default_properties + 3, 33, 0},
+    {{0x1e, 0x50, 0xb9, 0xd2, 0x0d, 0x28, 0x22, 0xbb, 0x3e, 0x14, 0xd2, 0xe1, 0x68, 0x5b, 0xbf, 0x7d, 0x4f, 0x0a, 0xa9, 0xce, 0xc0, 0x69, 0x63, 0x41, 0x55, 0x6a, 0x8c, 0x56, 0x36, 0x68, 0xc7, 0x56}, (bem_stylesheet_selector *)bem_default_selectors + 31, (struct bem_dictionary *)bem_default_properties + 12, 195, 0},
+    {{0x1f, 0x7f, 0x14, 0x3f, 0x19, 0xa0, 0xf7, 0x0c, 0x00, 0x06, 0x4b, 0xb1, 0x23, 0x33, 0x29, 0x99, 0x0b, 0xcd, 0x8f, 0xa8, 0x71, 0x39, 0x53, 0xe1, 0xd3, 0xf4, 0x45, 0x70, 0xf4, 0x2d, 0xaf, 0x85}, (bem_stylesheet_selector *)bem_default_selectors + 32, (struct bem_dictionary *)bem_default_properties + 7, 43, 0},
+    {{0x1f, 0xbc, 0xb0, 0x91, 0x3f, 0x7e, 0x01, 0xfe, 0xbb, 0x64, 0xfc, 0xd4, 0xd3, 0xf5, 0x17, 0x34, 0x59, 0xd4, 0x71, 0xf5, 0xb6, 0xfb, 0x07, 0x74, 0xbb, 0x21, 0x79, 0x7a, 0xeb, 0x36, 0xed, 0xee}, (bem_stylesheet_selector *)bem_default_selectors + 33, (struct bem_dictionary *)bem_default_properties + 13, 85, 0},
+    {{0x1f, 0xc9, 0xa0, 0x79, 0xcf, 0x27, 0x77, 0x7b, 0x3d, 0xdb, 0x8d, 0x24, 0x49, 0xec, 0x3f, 0xee, 0x5b, 0xed, 0x91, 0xe4, 0xf8, 0xba, 0x4a, 0x5b, 0x45, 0xbd, 0xf5, 0xd8, 0x91, 0x4b, 0x63, 0xe8}, (bem_stylesheet_selector *)bem_default_selectors + 34, (struct bem_dictionary *)bem_default_properties + 14, 77, 0},
+    {{0x24, 0x7f, 0x2f, 0x6e, 0x93, 0xea, 0x0c, 0x75, 0xff, 0x44, 0xd2, 0xab, 0x78, 0xb6, 0x36, 0x64, 0x7f, 0x39, 0x1c, 0xd3, 0xf9, 0xb7, 0xfb, 0x17, 0x99, 0x73, 0x46, 0x9b, 0x76, 0x63, 0xa2, 0x7f}, (bem_stylesheet_selector *)bem_default_selectors + 35, (struct bem_dictionary *)bem_default_properties + 15, 163, 0},
+    {{0x26, 0xd2, 0xde, 0xe9, 0xda, 0xf7, 0x84, 0x80, 0x1c, 0x65, 0xe8, 0x60, 0xfe, 0x87, 0xc3, 0xb8, 0x6b, 0x8d, 0xd9, 0xff, 0xbf, 0x68, 0xda, 0xc6, 0x28, 0xc1, 0xfd, 0x4e, 0x3c, 0x66, 0xf7, 0xb0}, (bem_stylesheet_selector *)bem_default_selectors + 36, (struct bem_dictionary *)bem_default_properties + 3, 29, 0},
+    {{0x27, 0x37, 0x5d, 0xb6, 0x96, 0x57, 0xde, 0x14, 0x63, 0x91, 0x9e, 0x52, 0x4f, 0xc5, 0xeb, 0x1d, 0xb9, 0xf8, 0x70, 0x1d, 0xc3, 0xff, 0x09, 0xfc, 0xd5, 0xb1, 0x3a, 0x86, 0xdb, 0x72, 0xdf, 0x80}, (bem_stylesheet_selector *)bem_default_selectors + 37, (struct bem_dictionary *)bem_default_properties + 3, 38, 0},
+    {{0x28, 0x88, 0x62, 0xce, 0xe7, 0xa7, 0xe8, 0xd0, 0x1b, 0x14, 0x08, 0x3a, 0x9a, 0x01, 0x2a, 0xe8, 0xe2, 0xd1, 0xcd, 0xb2, 0xb0, 0x4c, 0xca, 0xaf, 0x5e, 0xe9, 0xdb, 0x22, 0x66, 0x6a, 0x43, 0x66}, (bem_stylesheet_selector *)bem_default_selectors + 38, (struct bem_dictionary *)bem_default_properties + 16, 70, 0},
+    {{0x2a, 0x8f, 0x60, 0x7e, 0x5d, 0x4c, 0x7c, 0xdf, 0xd4, 0x0c, 0x15, 0xcf, 0x27, 0xdf, 0xe9, 0xdf, 0xdb, 0xd1, 0x87, 0xa5, 0xba, 0xee, 0x03, 0x0e, 0xf7, 0x8c, 0x06, 0x6b, 0x8a, 0xf3, 0x18, 0x01}, (bem_stylesheet_selector *)bem_default_selectors + 39, (struct bem_dictionary *)bem_default_properties + 17, 92, 0},
+    {{0x2a, 0xef, 0x8c, 0x35, 0xcc, 0x35, 0x02, 0xb1, 0x01, 0xe3, 0x58, 0x0b, 0xa3, 0xdf, 0x37, 0x04, 0x28, 0x76, 0xf7, 0x1f, 0xa2, 0x2a, 0x06, 0xe8, 0xf7, 0x4f, 0x9f, 0xd2, 0x2e, 0x20, 0xa0, 0xa5}, (bem_stylesheet_selector *)bem_default_selectors + 41, (struct bem_dictionary *)bem_default_properties + 8, 139, 0},
+    {{0x2b, 0xb9, 0x2d, 0x04, 0x37, 0x29, 0x3b, 0xfa, 0xf6, 0x67, 0x18, 0xd8, 0xec, 0x9d, 0x12, 0x69, 0x92, 0x14, 0x14, 0x6d, 0x38, 0x2d, 0xbe, 0x04, 0x08, 0xeb, 0x9e, 0x6f, 0x60, 0xce, 0x13, 0x62}, (bem_stylesheet_selector *)bem_default_selectors + 42, (struct bem_dictionary *)bem_default_properties + 17, 94, 0},
+    {{0x2c, 0x00, 0x4d, 0xea, 0x82, 0x54, 0x18, 0x60, 0x08, 0x79, 0xe5, 0x1a, 0x14, 0x2d, 0x15, 0xdc, 0x8c, 0x81, 0xf9, 0x68, 0x7d, 0x7e, 0x34, 0x3a, 0x87, 0x42, 0x6c, 0xb3, 0xd3, 0x3d, 0x88, 0x28}, (bem_stylesheet_selector *)bem_default_selectors + 43, (struct bem_dictionary *)bem_default_properties + 18, 192, 0},
+    {{0x2c, 0x86, 0x97, 0xe4, 0x9d, 0x9f, 0xe6, 0xc7, 0x8f, 0xf9, 0x2e, 0x1e, 0xbe, 0x77, 0xf0, 0x1e, 0x07, 0x71, 0xd9, 0x82, 0x68, 0x54, 0x65, 0x6e, 0x0f, 0x7f, 0xde, 0x5a, 0xca, 0x69, 0xce, 0xb5}, (bem_stylesheet_selector *)bem_default_selectors + 45, (struct bem_dictionary *)bem_default_properties + 19, 188, 0},
+    {{0x2f, 0xf3, 0x76, 0x96, 0x2a, 0x7a, 0xb6, 0x8d, 0x87, 0xc1, 0x40, 0xce, 0x92, 0x47, 0x64, 0xe4, 0x5d, 0xf6, 0x3e, 0x74, 0x1d, 0xa6, 0x26, 0x0b, 0xc9, 0xb4, 0xcc, 0x28, 0x7d, 0x80, 0x0d, 0xb2}, (bem_stylesheet_selector *)bem_default_selectors + 46, (struct bem_dictionary *)bem_default_properties + 7, 49, 0},
+    {{0x31, 0xe9, 0x3a, 0x3e, 0x9c, 0xd7, 0x7c, 0x22, 0xc8, 0x02, 0x78, 0xf5, 0x4b, 0x1a, 0x3b, 0x5d, 0x31, 0x51, 0x6b, 0x6d, 0xa8, 0x08, 0x40, 0x07, 0xd5, 0x52, 0xc4, 0x04, 0xd7, 0x65, 0x7f, 0x79}, (bem_stylesheet_selector *)bem_default_selectors + 48, (struct bem_dictionary *)bem_default_properties + 2, 113, 0},
+    {{0x33, 0xe0, 0x60, 0x5a, 0xe3, 0x40, 0x66, 0x25, 0x7c, 0x86, 0x7b, 0x44, 0x96, 0xd1, 0x2e, 0xca, 0x2a, 0x32, 0xfa, 0x4b, 0x0e, 0x03, 0x4e, 0x28, 0xc0, 0xd8, 0xe7, 0xf1, 0x9c, 0x46, 0xe1, 0xb9}, (bem_stylesheet_selector *)bem_default_selectors + 50, (struct bem_dictionary *)bem_default_properties + 8, 134, 0},
+    {{0x34, 0x6c, 0x8c, 0x10, 0x5a, 0x55, 0x5f, 0x81, 0x17, 0x81, 0xb2, 0x3e, 0xa1, 0xbb, 0x99, 0xed, 0x84, 0x05, 0x03, 0x07, 0x08, 0xd6, 0x76, 0x41, 0x00, 0xea, 0x35, 0x4b, 0x7e, 0xd7, 0x11, 0x76}, (bem_stylesheet_selector *)bem_default_selectors + 51, (struct bem_dictionary *)bem_default_properties + 3, 14, 0},
+    {{0x35, 0x85, 0x1f, 0xec, 0xd9, 0x10, 0xed, 0x95, 0xdb, 0x3b, 0xfa, 0x6d, 0x40, 0x8e, 0xe7, 0xaf, 0x5a, 0x40, 0xce, 0xd8, 0xfb, 0x3c, 0x53, 0xfb, 0xa7, 0x72, 0xa6, 0xe2, 0x18, 0x8f, 0x85, 0x89}, (bem_stylesheet_selector *)bem_default_selectors + 52, (struct bem_dictionary *)bem_default_properties + 20, 196, 0},
+    {{0x39, 0x85, 0x0e, 0xe5, 0xce, 0x14, 0x2c, 0xa9, 0xdf, 0x8a, 0x16, 0xbc, 0x03, 0x7d, 0x74, 0x85, 0x04, 0xc8, 0x21, 0xd0, 0x49, 0x09, 0xe4, 0x42, 0x85, 0x72, 0x77, 0x9f, 0xc5, 0x3c, 0xcb, 0x72}, (bem_stylesheet_selector *)bem_default_selectors + 54, (struct bem_dictionary *)bem_default_properties + 2, 108, 0},
+    {{0x3a, 0x70, 0xa4, 0x68, 0x03, 0xaf, 0xe8, 0xb9, 0xe3, 0x03, 0x64, 0x70, 0x4a, 0xf2, 0xdd, 0x48, 0xb4, 0x66, 0xf8, 0x62, 0x79, 0xa7, 0xbd, 0x8c, 0x5a, 0x44, 0x50, 0x03, 0x06, 0x40, 0xf2, 0xbb}, (bem_stylesheet_selector *)bem_default_selectors + 55, (struct bem_dictionary *)bem_default_properties + 11, 58, 0},
+    {{0x3b, 0x17, 0x6f, 0x17, 0x29, 0x3d, 0x7a, 0xda, 0xcb, 0x36, 0xc8, 0x7c, 0xe5, 0x44, 0x8b, 0x5c, 0xbc, 0xd3, 0x10, 0xb0, 0xb8, 0x99, 0x3c, 0x08, 0xb9, 0x6b, 0xd5, 0x74, 0x42, 0xa0, 0x4b, 0x35}, (bem_stylesheet_selector *)bem_default_selectors + 56, (struct bem_dictionary *)bem_default_properties + 21, 161, 0},
+    {{0x3b, 0x77, 0x98, 0x3b, 0x15, 0x9c, 0xd2, 0xb7, 0x35, 0xc4, 0x32, 0x8c, 0xad, 0x1a, 0x52, 0x55, 0x9c, 0x4f, 0x56, 0x93, 0x82, 0x34, 0x79, 0xdd, 0x58, 0x71, 0x95, 0x35, 0x61, 0x90, 0xab, 0xee}, (bem_stylesheet_selector *)bem_default_selectors + 57, (struct bem_dictionary *)bem_default_properties + 22, 197, 0},
+    {{0x3c, 0x3d, 0x09, 0xac, 0x06, 0x9d, 0x7c, 0xd5, 0x67, 0xa1, 0xb4, 0xff, 0x60, 0x38, 0x3c, 0xcb, 0x41, 0xfa, 0x3a, 0x9c, 0x2e, 0x3e, 0x29, 0x34, 0x37, 0x2b, 0xe8, 0x75, 0xb6, 0xfe, 0xb4, 0x02}, (bem_stylesheet_selector *)bem_default_selectors + 58, (struct bem_dictionary *)bem_default_properties + 7, 45, 0},
+    {{0x3d, 0x23, 0xef, 0x7d, 0xaf, 0x63, 0xcd, 0xa1, 0x6d, 0x6b, 0x07, 0x47, 0x8f, 0xaf, 0xc7, 0x31, 0xf1, 0x2c, 0x2f, 0xee, 0x93, 0x0f, 0x58, 0x40, 0x3e, 0x53, 0x02, 0x0d, 0xfd, 0x5d, 0xf9, 0x5d}, (bem_stylesheet_selector *)bem_default_selectors + 59, (struct bem_dictionary *)bem_default_properties + 23, 175, 0},
+    {{0x3e, 0x43, 0x83, 0x60, 0xaf, 0xeb, 0x57, 0xdc, 0x91, 0xaa, 0x29, 0x79, 0xd5, 0xe3, 0x2a, 0x0d, 0x93, 0xac, 0xa2, 0xb4, 0x15, 0xaa, 0x63, 0x8d, 0x09, 0x1f, 0xe0, 0x97, 0xf2, 0x50, 0x67, 0x36}, (bem_stylesheet_selector *)bem_default_selectors + 60, (struct bem_dictionary *)bem_default_properties + 7, 41, 0},
+    {{0x41, 0x08, 0xd3, 0x12, 0x31, 0xe3, 0xa2, 0x9f, 0x61, 0xbe, 0xf0, 0x2b, 0xe3, 0x23, 0x36, 0xe1, 0x8e, 0xc9, 0x7c, 0xe0, 0x94, 0x89, 0x4b, 0x4a, 0xa1, 0xd9, 0x91, 0xcd, 0xf5, 0x80, 0xd8, 0xb1}, (bem_stylesheet_selector *)bem_default_selectors + 63, (struct bem_dictionary *)bem_default_properties + 1, 114, 0},
+    {{0x41, 0xae, 0x02, 0xbe, 0x3a, 0x9d, 0xa7, 0x48, 0x62, 0x73, 0x9e, 0x12, 0x73, 0x0b, 0x7e, 0x2f, 0x15, 0x7e, 0xad, 0x5b, 0xf9, 0xba, 0xd6, 0xe3, 0xf8, 0x89, 0xe8, 0x31, 0x6e, 0xa5, 0x8f, 0x00}, (bem_stylesheet_selector *)bem_default_selectors + 64, (struct bem_dictionary *)bem_default_properties + 24, 54, 0},
+    {{0x42, 0xc8, 0x3e, 0x45, 0x0c, 0x8b, 0x26, 0xda, 0x2d, 0xe5, 0xa8, 0x6c, 0x87, 0x0a, 0x33, 0x1a, 0x84, 0x8d, 0x7b, 0xbc, 0xfd, 0xfa, 0xc2, 0x28, 0x04, 0x71, 0x85, 0xaa, 0x2d, 0x5f, 0x28, 0xb8}, (bem_stylesheet_selector *)bem_default_selectors + 65, (struct bem_dictionary *)bem_default_properties + 25, 160, 0},
+    {{0x43, 0x6b, 0xf7, 0x44, 0x5e, 0x23, 0x41, 0xec, 0x15, 0x10, 0x4a, 0x15, 0x93, 0x25, 0x19, 0xcf, 0xd3, 0xf3, 0x53, 0x4b, 0xfb, 0xec, 0x1f, 0x80, 0xd9, 0xe6, 0xb7, 0xec, 0x46, 0x6b, 0x59, 0xe6}, (bem_stylesheet_selector *)bem_default_selectors + 66, (struct bem_dictionary *)bem_default_properties + 26, 157, 0},
+    {{0x43, 0x7e, 0xc0, 0x2b, 0x48, 0xfc, 0xac, 0x1b, 0xb2, 0x33, 0xe0, 0xeb, 0x5d, 0x4b, 0x1c, 0x70, 0x18, 0xa9, 0x27, 0xe4, 0x1f, 0xe6, 0xdd, 0x09, 0x4b, 0x3b, 0x66, 0xde, 0xdc, 0x8d, 0x8f, 0x82}, (bem_stylesheet_selector *)bem_default_selectors + 67, (struct bem_dictionary *)bem_default_properties + 27, 186, 0},
+    {{0x46, 0x37, 0xaf, 0xe0, 0x5d, 0xf9, 0xa7, 0xf6, 0xb5, 0x87, 0x84, 0xa4, 0x4a, 0xda, 0x88, 0x4c, 0xdf, 0x72, 0x3f, 0xdc, 0xbf, 0x10, 0x32, 0xea, 0xed, 0xab, 0x7e, 0x49, 0x7b, 0x2f, 0xf6, 0x5f}, (bem_stylesheet_selector *)bem_default_selectors + 68, (struct bem_dictionary *)bem_default_properties + 3, 15, 0},
+    {{0x48, 0x4a, 0x17, 0x32, 0x2a, 0x41, 0x15, 0x0e, 0x8e, 0x23, 0x81, 0x7e, 0xe8, 0xa7, 0xe4, 0x5d, 0xab, 0xf2, 0xbf, 0xc6, 0xc3, 0xbc, 0xb1, 0x3f, 0xbd, 0x71, 0x4b, 0xd6, 0xbb, 0x27, 0xd6, 0xe9}, (bem_stylesheet_selector *)bem_default_selectors + 69, (struct bem_dictionary *)bem_default_properties + 28, 96, 0},
+    {{0x4b, 0x4f, 0xba, 0xed, 0xf7, 0x94, 0x24, 0x14, 0x1b, 0xaa, 0xfa, 0xd5, 0xbf, 0x48, 0x08, 0x9e, 0x43, 0xf6, 0x8c, 0xec, 0x4e, 0xdb, 0x7a, 0xbf, 0xc4, 0xaa, 0x3f, 0x2b, 0x3d, 0x46, 0x2e, 0x5c}, (bem_stylesheet_selector *)bem_default_selectors + 72, (struct bem_dictionary *)bem_default_properties + 1, 117, 0},
+    {{0x4c, 0xb5, 0xdf, 0xce, 0x9f, 0xe9, 0xec, 0x6a, 0x55, 0x09, 0xd5, 0x50, 0xd6, 0xe6, 0x28, 0xcc, 0xfc, 0xff, 0x9a, 0xf4, 0x57, 0xa6, 0x3b, 0x44, 0x33, 0x88, 0xfe, 0x97, 0xc5, 0x10, 0x6d, 0x00}, (bem_stylesheet_selector *)bem_default_selectors + 73, (struct bem_dictionary *)bem_default_properties + 18, 191, 0},
+    {{0x4f, 0x21, 0xb7, 0xa3, 0x31, 0x45, 0x8d, 0xcf, 0x9f, 0x10, 0x15, 0x0d, 0x44, 0x0a, 0x4a, 0x13, 0x60, 0xd6, 0x14, 0x52, 0xa8, 0xa2, 0x0f, 0x48, 0xce, 0x0d, 0x65, 0x88, 0xf4, 0x5a, 0x02, 0xb7}, (bem_stylesheet_selector *)bem_default_selectors + 74, (struct bem_dictionary *)bem_default_properties + 3, 39, 0},
+    {{0x50, 0x1c, 0x51, 0x60, 0x30, 0xed, 0xc7, 0xf3, 0x99, 0x67, 0x10, 0x1b, 0x74, 0x52, 0xf6, 0xe9, 0x3d, 0xac, 0xb1, 0x63, 0x67, 0x71, 0x6f, 0xa4, 0x38, 0x0a, 0xa3, 0x6b, 0x2c, 0xc7, 0xba, 0xd5}, (bem_stylesheet_selector *)bem_default_selectors + 76, (struct bem_dictionary *)bem_default_properties + 2, 111, 0},
+    {{0x50, 0x4b, 0x23, 0x88, 0x13, 0xe5, 0x20, 0xd4, 0x0f, 0xa8, 0xb9, 0x32, 0xeb, 0xff, 0x2f, 0x68, 0x58, 0xea, 0x88, 0xe2, 0x9c, 0xb1, 0xb5, 0x0a, 0xe7, 0x27, 0xd7, 0x2f, 0xf7, 0x42, 0xb4, 0x4d}, (bem_stylesheet_selector *)bem_default_selectors + 78, (struct bem_dictionary *)bem_default_properties + 8, 143, 0},
+    {{0x50, 0xa7, 0x77, 0xf8, 0xc8, 0xb0, 0x5b, 0x2c, 0x53, 0x42, 0xf8, 0x8c, 0x1c, 0x94, 0x03, 0xf7, 0xb6, 0x63, 0x4f, 0x04, 0x42, 0x3b, 0x0c, 0x19, 0x8b, 0xf2, 0x2b, 0x63, 0xb0, 0x17, 0x86, 0x99}, (bem_stylesheet_selector *)bem_default_selectors + 79, (struct bem_dictionary *)bem_default_properties + 3, 9, 0},
+    {{0x51, 0x4c, 0x12, 0x38, 0x45, 0x67, 0x7e, 0x64, 0x6e, 0x3f, 0x56, 0x63, 0x09, 0xb3, 0x4c, 0x34, 0xbd, 0x57, 0x10, 0x5d, 0xf3, 0x87, 0x8e, 0xf8, 0x59, 0x90, 0x99, 0x75, 0x42, 0x10, 0xfc, 0x71}, (bem_stylesheet_selector *)bem_default_selectors + 80, (struct bem_dictionary *)bem_default_properties + 17, 93, 0},
+    {{0x53, 0x77, 0x1a, 0x4b, 0xd3, 0x03, 0x7f, 0x2e, 0xcf, 0x03, 0x03, 0xeb, 0x9e, 0x28, 0xab, 0x10, 0x42, 0xff, 0xd5, 0x84, 0x8c, 0xca, 0xf6, 0xa2, 0xb5, 0x4c, 0xe9, 0x85, 0xd5, 0x17, 0x49, 0xae}, (bem_stylesheet_selector *)bem_default_selectors + 83, (struct bem_dictionary *)bem_default_properties + 1, 120, 0},
+    {{0x53, 0xcc, 0xf5, 0x1e, 0xe9, 0xd1, 0x1c, 0x15, 0x64, 0x8f, 0x2d, 0xe5, 0x44, 0x0e, 0x05, 0xe3, 0x49, 0x48, 0x9e, 0x5e, 0xc7, 0x41, 0x21, 0xd4, 0x1c, 0x67, 0x0b, 0x2a, 0xed, 0xe4, 0x8a, 0xed}, (bem_stylesheet_selector *)bem_default_selectors + 84, (struct bem_dictionary *)bem_default_properties + 29, 100, 0},
+    {{0x55, 0xe8, 0x67, 0x40, 0x18, 0x64, 0xde, 0x20, 0x19, 0x43, 0x0a, 0x4b, 0x8f, 0x43, 0xc0, 0x2b, 0xde, 0x2e, 0x50, 0x0d, 0x75, 0xcd, 0x36, 0xdb, 0x3d, 0x6b, 0x97, 0x81, 0x1c, 0x49, 0xac, 0x71}, (bem_stylesheet_selector *)bem_default_selectors + 87, (struct bem_dictionary *)bem_default_properties + 1, 129, 0},
+    {{0x57, 0x1d, 0x05, 0xd9, 0xb5, 0xf9, 0x0e, 0xe9, 0x56, 0x47, 0x7e, 0x19, 0xaf, 0x00, 0xb5, 0xb6, 0x46, 0x42, 0xfe, 0x6a, 0x04, 0xfc, 0x8f, 0x6f, 0x61, 0xac, 0xc1, 0xa7, 0x63, 0xa5, 0xa0, 0xf4}, (bem_stylesheet_selector *)bem_default_selectors + 88, (struct bem_dictionary *)bem_default_properties + 3, 35, 0},
+    {{0x57, 0x7b, 0x13, 0x76, 0x64, 0x82, 0xc7, 0x3e, 0x29, 0xa2, 0xa0, 0x10, 0x10, 0x58, 0x30, 0xc8, 0xd6, 0xfb, 0x96, 0x19, 0xec, 0xb4, 0x93, 0x92, 0xb4, 0xf1, 0xbc, 0xfe, 0x88, 0x63, 0x4e, 0x79}, (bem_stylesheet_selector *)bem_default_selectors + 89, (struct bem_dictionary *)bem_default_properties + 16, 69, 0},
+    {{0x58, 0x1f, 0xbd, 0x7a, 0x24, 0x81, 0x94, 0x1c, 0xb7, 0x64, 0x0a, 0xd6, 0xe7, 0xef, 0x84, 0x3e, 0x28, 0x31, 0xb2, 0x44, 0x25, 0xe9, 0xe6, 0x2d, 0x7f, 0x82, 0xdc, 0x07, 0x8b, 0x4f, 0xb5, 0x46}, (bem_stylesheet_selector *)bem_default_selectors + 90, (struct bem_dictionary *)bem_default_properties + 3, 26, 0},
+    {{0x59, 0x76, 0x05, 0x17, 0xbf, 0x74, 0x31, 0x2f, 0xca, 0x4e, 0x8b, 0xb0, 0x87, 0xf3, 0x10, 0xd8, 0x30, 0xbb, 0x23, 0xb2, 0x6d, 0xf1, 0xd0, 0x9d, 0x8b, 0x6f, 0xc2, 0xf4, 0xd6, 0x36, 0x97, 0x57}, (bem_stylesheet_selector *)bem_default_selectors + 91, (struct bem_dictionary *)bem_default_properties + 3, 27, 0},
+    {{0x5a, 0x8b, 0x8d, 0x48, 0x2b, 0x1c, 0x85, 0x29, 0x26, 0xa1, 0xe8, 0x6c, 0xc1, 0xf7, 0xa3, 0x6e, 0x7c, 0x1f, 0x4e, 0x18, 0xe2, 0x6d, 0xc3, 0xe7, 0xeb, 0xf2, 0xcf, 0x09, 0x27, 0xad, 0xfa, 0xc1}, (bem_stylesheet_selector *)bem_default_selectors + 92, (struct bem_dictionary *)bem_default_properties + 28, 98, 0},
+    {{0x5b, 0xf6, 0x99, 0xc4, 0x55, 0xd7, 0x83, 0x0e, 0x42, 0x37, 0x20, 0xfa, 0x43, 0xde, 0xf8, 0x08, 0x8b, 0xdf, 0x0c, 0x2c, 0x60, 0x57, 0x07, 0x6f, 0xba, 0x05, 0x53, 0xc6, 0x1d, 0x61, 0x97, 0xdd}, (bem_stylesheet_selector *)bem_default_selectors + 93, (struct bem_dictionary *)bem_default_properties + 7, 44, 0},
+    {{0x5e, 0x8e, 0x16, 0xb1, 0xb9, 0x5a, 0xba, 0x43, 0xd3, 0x27, 0x06, 0xc3, 0x32, 0x12, 0xba, 0xfa, 0xe4, 0x8b, 0xf3, 0xe4, 0x9a, 0xd6, 0xfd, 0x8d, 0x81, 0x61, 0xd5, 0xb7, 0xd8, 0xf6, 0xed, 0x22}, (bem_stylesheet_selector *)bem_default_selectors + 94, (struct bem_dictionary *)bem_default_properties + 3, 32, 0},
+    {{0x64, 0x84, 0x9a, 0x8d, 0x18, 0xed, 0x03, 0x78, 0x5d, 0xb2, 0x11, 0x94, 0xd0, 0x75, 0x3a, 0x5d, 0x7a, 0x32, 0x14, 0xf0, 0xbd, 0x63, 0x52, 0xea, 0xec, 0xa6, 0x9d, 0x67, 0x75, 0x5b, 0xb9, 0x7d}, (bem_stylesheet_selector *)bem_default_selectors + 96, (struct bem_dictionary *)bem_default_properties + 8, 151, 0},
+    {{0x65, 0x90, 0x30, 0x75, 0x48, 0xda, 0xda, 0x82, 0x40, 0x88, 0x14, 0xfe, 0x0c, 0xee, 0xa2, 0x1d, 0x32, 0xf3, 0xa1, 0x21, 0x15, 0xe0, 0xc8, 0xe5, 0x9b, 0x34, 0x27, 0x88, 0x00, 0xe4, 0xec, 0xaf}, (bem_stylesheet_selector *)bem_default_selectors + 97, (struct bem_dictionary *)bem_default_properties + 13, 88, 0},
+    {{0x65, 0xf8, 0xed, 0x97, 0xd6, 0x3d, 0x61, 0x36, 0x88, 0x85, 0x6d, 0xf5, 0xbe, 0x94, 0xc7, 0x06, 0x84, 0xdc, 0x06, 0xc5, 0xb3, 0x42, 0xb3, 0x2a, 0xe0, 0x24, 0x61, 0x5f, 0x4a, 0xa1, 0x93, 0xed}, (bem_stylesheet_selector *)bem_default_selectors + 98, (struct bem_dictionary *)bem_default_properties + 7, 47, 0},
+    {{0x66, 0xd0, 0x36, 0x3f, 0x86, 0xce, 0x3c, 0x4c, 0xff, 0x41, 0x88, 0x95, 0x57, 0x6c, 0xe0, 0x9f, 0xae, 0xdb, 0xe1, 0xad, 0xc2, 0xf5, 0x45, 0x57, 0x57, 0xee, 0x73, 0xf2, 0x00, 0xa2, 0x29, 0xf2}, (bem_stylesheet_selector *)bem_default_selectors + 100, (struct bem_dictionary *)bem_default_properties + 2, 104, 0},
+    {{0x66, 0xdf, 0xaf, 0xa6, 0xe3, 0x45, 0x8a, 0xe2, 0xfa, 0x3d, 0xab, 0x4c, 0x20, 0xdc, 0xc6, 0x3d, 0x37, 0x3d, 0x76, 0x45, 0xba, 0x96, 0x18, 0x82, 0x76, 0x44, 0x75, 0x4d, 0xee, 0x9c, 0x78, 0x34}, (bem_stylesheet_selector *)bem_default_selectors + 101, (struct bem_dictionary *)bem_default_properties + 3, 36, 0},
+    {{0x67, 0xb6, 0x5f, 0x23, 0x3f, 0x39, 0x71, 0x34, 0x12, 0x8f, 0x79, 0x92, 0x91, 0x3b, 0x0b, 0xc0, 0x38, 0xcf, 0x36, 0xea, 0x44, 0xc0, 0x15, 0xa7, 0x36, 0x91, 0x07, 0x8f, 0xb0, 0x26, 0x0e, 0x7c}, (bem_stylesheet_selector *)bem_default_selectors + 103, (struct bem_dictionary *)bem_default_properties + 19, 189, 0},
+    {{0x67, 0xed, 0x0b, 0x42, 0x9f, 0x76, 0xd1, 0x9b, 0x1c, 0x5b, 0x29, 0xb8, 0xea, 0x8d, 0xc8, 0xe7, 0x91, 0x07, 0x37, 0x3f, 0xb5, 0x87, 0xbe, 0x88, 0xf1, 0x86, 0x47, 0x40, 0x95, 0x45, 0xca, 0xf7}, (bem_stylesheet_selector *)bem_default_selectors + 106, (struct bem_dictionary *)bem_default_properties + 1, 124, 0},
+    {{0x69, 0x23, 0xbc, 0x8a, 0x99, 0x6e, 0x06, 0x8d, 0x26, 0xc2, 0x73, 0x0c, 0x9d, 0x94, 0xca, 0x34, 0xde, 0x5b, 0x07, 0x83, 0x02, 0x42, 0xde, 0x1c, 0x15, 0x91, 0x9d, 0x20, 0xb9, 0x53, 0x12, 0x71}, (bem_stylesheet_selector *)bem_default_selectors + 109, (struct bem_dictionary *)bem_default_properties + 1, 128, 0},
+    {{0x69, 0xd5, 0xd2, 0x7d, 0x61, 0xbd, 0x34, 0x46, 0xc6, 0x02, 0x01, 0x80, 0x98, 0xca, 0x5e, 0x2d, 0xbf, 0xc8, 0x16, 0x83, 0x5f, 0xa9, 0x1f, 0x29, 0xaf, 0xef, 0x0d, 0x73, 0x32, 0x73, 0x21, 0x0d}, (bem_stylesheet_selector *)bem_default_selectors + 112, (struct bem_dictionary *)bem_default_properties + 1, 118, 0},
+    {{0x6c, 0xce, 0x0b, 0xda, 0xba, 0xca, 0xfd, 0x44, 0x17, 0xb6, 0x95, 0x5d, 0x85, 0x14, 0x8c, 0x3a, 0xaa, 0x5e, 0x86, 0x4e, 0x09, 0x00, 0xc9, 0x12, 0x15, 0xdd, 0x6b, 0xf4, 0x10, 0xff, 0xed, 0x03}, (bem_stylesheet_selector *)bem_default_selectors + 113, (struct bem_dictionary *)bem_default_properties + 3, 25, 0},
+    {{0x6e, 0xa3, 0x54, 0x86, 0x6d, 0xf4, 0x53, 0x4f, 0x4f, 0xc5, 0x78, 0x78, 0x9f, 0x68, 0x2b, 0x6a, 0x06, 0x61, 0x90, 0x3c, 0xb1, 0x55, 0x60, 0xc1, 0x66, 0x40, 0xc8, 0xd1, 0x35, 0x30, 0x9a, 0x43}, (bem_stylesheet_selector *)bem_default_selectors + 114, (struct bem_dictionary *)bem_default_properties + 16, 74, 0},
+    {{0x6f, 0xe3, 0x83, 0x5d, 0x30, 0x16, 0x97, 0xe0, 0xc1, 0xe6, 0x65, 0x89, 0xc8, 0x4e, 0xb5, 0x54, 0xfa, 0xff, 0x0e, 0xa9, 0x04, 0x16, 0xc9, 0xf1, 0xaa, 0x7d, 0x10, 0x0b, 0x2f, 0xd7, 0xc6, 0x21}, (bem_stylesheet_selector *)bem_default_selectors + 115, (struct bem_dictionary *)bem_default_properties + 29, 99, 0},
+    {{0x70, 0xec, 0x8c, 0xad, 0xbd, 0x83, 0x09, 0x54, 0x9d, 0xa9, 0x3b, 0xda, 0xb7, 0xe8, 0xbf, 0x7f, 0x5f, 0xe2, 0x37, 0xde, 0x65, 0x06, 0x71, 0xaf, 0x5f, 0xbb, 0x82, 0xda, 0xf8, 0x9e, 0xb3, 0x53}, (bem_stylesheet_selector *)bem_default_selectors + 117, (struct bem_dictionary *)bem_default_properties + 8, 150, 0},
+    {{0x71, 0x32, 0xfc, 0xa8, 0x75, 0xef, 0x12, 0xc4, 0x14, 0x7d, 0xf1, 0x3e, 0x9d, 0xdd, 0xe6, 0x0a, 0xb0, 0x73, 0xfa, 0x16, 0xf5, 0x07, 0x5e, 0x91, 0x3c, 0x7d, 0x18, 0x39, 0xd0, 0x48, 0x83, 0xfa}, (bem_stylesheet_selector *)bem_default_selectors + 118, (struct bem_dictionary *)bem_default_properties + 16, 75, 0},
+    {{0x71, 0xca, 0xe6, 0x2d, 0x7c, 0x27, 0x42, 0x50, 0xf7, 0x23, 0xd4, 0xc1, 0xee, 0x19, 0x5e, 0xc8, 0x61, 0x37, 0x12, 0xe4, 0x2d, 0x7a, 0x22, 0x3e, 0xaf, 0xfc, 0xfd, 0x82, 0xb7, 0x24, 0xd7, 0x3f}, (bem_stylesheet_selector *)bem_default_selectors + 119, (struct bem_dictionary *)bem_default_properties + 30, 184, 0},
+    {{0x72, 0xbe, 0xc3, 0x40, 0x4a, 0x04, 0xa7, 0xfa, 0xb5, 0x70, 0xea, 0x28, 0xea, 0x3e, 0x84, 0x9f, 0xf8, 0x56, 0xb4, 0xf9, 0xff, 0xdc, 0x83, 0x13, 0x06, 0x5f, 0xdf, 0xea, 0x78, 0x79, 0x7c, 0x9d}, (bem_stylesheet_selector *)bem_default_selectors + 121, (struct bem_dictionary *)bem_default_properties + 8, 146, 0},
+    {{0x73, 0xa3, 0xf7, 0xd6, 0xf7, 0x93, 0xcb, 0xad, 0x1f, 0x19, 0x69, 0x48, 0x77, 0xc5, 0x0a, 0xe9, 0xa8, 0x41, 0x3d, 0x8c, 0x9f, 0x3d, 0x2d, 0xde, 0xf5, 0x97, 0x9f, 0x2f, 0x7f, 0x8b, 0xc6, 0xc7}, (bem_stylesheet_selector *)bem_default_selectors + 122, (struct bem_dictionary *)bem_default_properties + 31, 82, 0},
+    {{0x73, 0xf1, 0xf4, 0x7d, 0xc9, 0x1e, 0xbd, 0x82, 0xa6, 0x02, 0x1c, 0x06, 0x94, 0xc3, 0x7a, 0x7d, 0xc0, 0x9d, 0x3b, 0x5a, 0x3d, 0xd1, 0x7f, 0xc9, 0xd9, 0x39, 0x53, 0xd7, 0x47, 0x4d, 0xa8, 0x63}, (bem_stylesheet_selector *)bem_default_selectors + 124, (struct bem_dictionary *)bem_default_properties + 8, 140, 0},
+    {{0x75, 0x32, 0xae, 0xe2, 0xdf, 0xf7, 0x46, 0xd1, 0xb3, 0xab, 0x6b, 0x72, 0x43, 0x49, 0xca, 0x63, 0x74, 0x44, 0xa8, 0x2f, 0xd4, 0x87, 0x9f, 0x7d, 0x88, 0xd1, 0x3d, 0x29, 0xb8, 0x54, 0x6b, 0xbb}, (bem_stylesheet_selector *)bem_default_selectors + 125, (struct bem_dictionary *)bem_default_properties + 28, 97, 0},
+    {{0x76, 0x2d, 0xff, 0xdb, 0x2a, 0x1f, 0xad, 0xfd, 0x34, 0x63, 0x42, 0xe6, 0xef, 0xa5, 0x58, 0xe5, 0x51, 0x4e, 0x6b, 0xb7, 0x46, 0x73, 0xd1, 0x2c, 0xdf, 0x6c, 0xbb, 0x06, 0x07, 0x62, 0x13, 0x17}, (bem_stylesheet_selector *)bem_default_selectors + 126, (struct bem_dictionary *)bem_default_properties + 16, 68, 0},
+    {{0x76, 0x3d, 0xad, 0x8e, 0x3d, 0x3b, 0xb2, 0x20, 0x62, 0xe0, 0xfd, 0xab, 0xff, 0xd4, 0x6a, 0xad, 0xfe, 0x62, 0xaf, 0x63, 0xa5, 0x17, 0x59, 0xea, 0x82, 0x12, 0x7b, 0x27, 0x6e, 0x22, 0xe2, 0x0f}, (bem_stylesheet_selector *)bem_default_selectors + 127, (struct bem_dictionary *)bem_default_properties + 31, 79, 0},
+    {{0x76, 0x68, 0x1f, 0xa1, 0x2b, 0xa6, 0xfc, 0x12, 0xd6, 0xa2, 0x50, 0x4a, 0x9b, 0xfd, 0xdd, 0xb4, 0xa7, 0xc7, 0x1d, 0xd5, 0x32, 0xe9, 0x2b, 0x35, 0xb4, 0x73, 0x83, 0xf9, 0x19, 0x12, 0x11, 0x0d}, (bem_stylesheet_selector *)bem_default_selectors + 128, (struct bem_dictionary *)bem_default_properties + 32, 155, 0},
+    {{0x78, 0xa1, 0xe3, 0x19, 0x28, 0x9a, 0xcf, 0xdc, 0x8a, 0x23, 0x4f, 0x56, 0x21, 0x23, 0x3a, 0x15, 0xab, 0x9a, 0x85, 0xd3, 0xa8, 0x5c, 0x88, 0x6b, 0xef, 0x86, 0x3f, 0x03, 0xb0, 0x4e, 0xd4, 0x08}, (bem_stylesheet_selector *)bem_default_selectors + 130, (struct bem_dictionary *)bem_default_properties + 8, 147, 0},
+    {{0x79, 0x6b, 0x46, 0xd9, 0xb0, 0x68, 0xf9, 0x74, 0xcb, 0x89, 0x84, 0xe1, 0x48, 0x5f, 0xcd, 0xb5, 0x27, 0xbf, 0xb3, 0xe2, 0xe0, 0x4e, 0x7f, 0x6d, 0x9f, 0xa8, 0x02, 0x10, 0x07, 0x19, 0xae, 0x78}, (bem_stylesheet_selector *)bem_default_selectors + 132, (struct bem_dictionary *)bem_default_properties + 2, 112, 0},
+    {{0x7b, 0x2b, 0x0a, 0xc6, 0x8b, 0x69, 0xde, 0xe4, 0x11, 0xc5, 0x21, 0xce, 0x47, 0x2e, 0x4d, 0x6a, 0x14, 0x1d, 0x9f, 0x71, 0xfb, 0xef, 0x8d, 0x09, 0x50, 0xc5, 0x55, 0x86, 0xe1, 0xea, 0x7c, 0x74}, (bem_stylesheet_selector *)bem_default_selectors + 133, (struct bem_dictionary *)bem_default_properties + 33, 183, 0},
+    {{0x7c, 0x0b, 0xfb, 0x8b, 0x96, 0x9e, 0x44, 0x72, 0xe2, 0x64, 0x45, 0x9b, 0x3e, 0x93, 0x2f, 0x04, 0xcd, 0x55, 0x3b, 0xf3, 0x5e, 0xc7, 0xa1, 0xeb, 0x80, 0xe3, 0x1e, 0x51, 0x4d, 0x03, 0xa0, 0x7b}, (bem_stylesheet_selector *)bem_default_selectors + 134, (struct bem_dictionary *)bem_default_properties + 11, 56, 0},
+    {{0x7c, 0x44, 0x76, 0xa6, 0xf4, 0xe5, 0x49, 0x16, 0x79, 0x2b, 0x89, 0x2a, 0x80, 0x38, 0xa2, 0x66, 0xe2, 0x09, 0xd8, 0xa1, 0x39, 0xe9, 0x67, 0x85, 0xd5, 0x2c, 0x10, 0x64, 0x6c, 0xaf, 0x1f, 0x99}, (bem_stylesheet_selector *)bem_default_selectors + 135, (struct bem_dictionary *)bem_default_properties + 5, 165, 0},
+    {{0x7c, 0xfc, 0x49, 0x1d, 0x30, 0x98, 0xc5, 0x3b, 0xe0, 0x03, 0xce, 0x2d, 0xbf, 0x0d, 0xf9, 0x39, 0xcd, 0xa9, 0x3b, 0x72, 0x6b, 0xc7, 0x64, 0xe1, 0x42, 0xa1, 0x94, 0x9a, 0x4a, 0xc3, 0x88, 0x3a}, (bem_stylesheet_selector *)bem_default_selectors + 136, (struct bem_dictionary *)bem_default_properties + 34, 90, 0},
+    {{0x7d, 0x57, 0x1b, 0xa4, 0x0b, 0x8c, 0x83, 0x72, 0x36, 0x2f, 0xc1, 0x75, 0xe9, 0xaa, 0xe7, 0x9e, 0x80, 0xe1, 0xce, 0xf7, 0x9a, 0x41, 0x3b, 0x43, 0x6c, 0x3d, 0xab, 0x02, 0x8e, 0x80, 0x24, 0xc1}, (bem_stylesheet_selector *)bem_default_selectors + 137, (struct bem_dictionary *)bem_default_properties + 31, 80, 0},
+    {{0x7e, 0x7c, 0x7b, 0x6e, 0x38, 0x99, 0x11, 0xdd, 0x8e, 0xdd, 0x37, 0xc1, 0xdd, 0x0d, 0xee, 0x4a, 0x7b, 0x65, 0x22, 0x36, 0x25, 0x5a, 0xf9, 0x95, 0x6e, 0x36, 0xb7, 0x5c, 0x8e, 0xd3, 0x3c, 0x4a}, (bem_stylesheet_selector *)bem_default_selectors + 139, (struct bem_dictionary *)bem_default_properties + 8, 136, 0},
+    {{0x81, 0xd5, 0x17, 0xa6, 0xd2, 0x5c, 0x68, 0x18, 0x89, 0x83, 0x27, 0x19, 0x5f, 0xfb, 0x1e, 0xf3, 0x8a, 0x15, 0x5b, 0x4c, 0x4a, 0x49, 0x12, 0xbf, 0x86, 0x4a, 0xcc, 0x6a, 0x94, 0x99, 0xcd, 0x67}, (bem_stylesheet_selector *)bem_default_selectors + 140, (struct bem_dictionary *)bem_default_properties + 13, 87, 0},
+    {{0x83, 0x60, 0xbf, 0x8f, 0xf5, 0xc3, 0xc6, 0xa4, 0xa8, 0x86, 0xf5, 0x0b, 0x2b, 0xcf, 0x81, 0x59, 0x93, 0x83, 0xff, 0x6c, 0x9c, 0x85, 0xc5, 0x20, 0x61, 0x19, 0xb5, 0x91, 0x01, 0x75, 0xa9, 0xac}, (bem_stylesheet_selector *)bem_default_selectors + 141, (struct bem_dictionary *)bem_default_properties + 7, 53, 0},
+    {{0x86, 0x8c, 0xe6, 0x8a, 0xf2, 0xb9, 0x2b, 0x24, 0x12, 0xb7, 0x12, 0x59, 0xc7, 0x88, 0x66, 0xd3, 0xe7, 0x9b, 0x4e, 0x79, 0x97, 0x3d, 0xd2, 0x31, 0x97, 0x5f, 0x28, 0xb0, 0xe6, 0x8d, 0x8d, 0x6f}, (bem_stylesheet_selector *)bem_default_selectors + 142, (struct bem_dictionary *)bem_default_properties + 3, 3, 0},
+    {{0x86, 0xe8, 0x9d, 0xed, 0x26, 0x68, 0x0b, 0x6c, 0x01, 0xae, 0xc5, 0xae, 0xf8, 0x15, 0xe3, 0x05, 0x06, 0x06, 0xb6, 0x71, 0x1e, 0x53, 0x42, 0xa1, 0xe5, 0x83, 0xc8, 0xdb, 0x69, 0xcd, 0xb7, 0x87}, (bem_stylesheet_selector *)bem_default_selectors + 143, (struct bem_dictionary *)bem_default_properties + 28, 95, 0},
+    {{0x87, 0x26, 0x38, 0x90, 0xce, 0xf2, 0xf7, 0xdd, 0x63, 0x0e, 0xbb, 0x95, 0xc4, 0x95, 0x9f, 0x7b, 0x2f, 0xdd, 0x0b, 0x9e, 0xfa, 0x5f, 0xb5, 0xd6, 0xf3, 0xb1, 0x1f, 0x40, 0x77, 0xe7, 0x9c, 0x6a}, (bem_stylesheet_selector *)bem_default_selectors + 144, (struct bem_dictionary *)bem_default_properties + 35, 171, 0},
+    {{0x87, 0x34, 0x89, 0xac, 0xc9, 0x71, 0x7f, 0x4d, 0x95, 0x5d, 0x49, 0x36, 0x50, 0xd8, 0x9e, 0x2e, 0xae, 0x40, 0x01, 0x5b, 0x87, 0xb4, 0x90, 0x00, 0x7f, 0xea, 0xbf, 0x0e, 0x90, 0x93, 0x86, 0x94}, (bem_stylesheet_selector *)bem_default_selectors + 145, (struct bem_dictionary *)bem_default_properties + 3, 16, 0},
+    {{0x87, 0x37, 0x9d, 0xad, 0x01, 0x67, 0x80, 0x16, 0x01, 0x57, 0xce, 0xa4, 0xb2, 0xf9, 0x9e, 0x9e, 0xe4, 0xeb, 0x81, 0xc9, 0x8d, 0xe4, 0xf6, 0x56, 0x6c, 0xa3, 0x88, 0xed, 0xbc, 0x35, 0xe9, 0x0e}, (bem_stylesheet_selector *)bem_default_selectors + 146, (struct bem_dictionary *)bem_default_properties + 36, 177, 0},
+    {{0x87, 0x50, 0xe4, 0xcd, 0x1b, 0x30, 0xa2, 0x6a, 0xf8, 0x0c, 0x1c, 0xa4, 0x11, 0xff, 0xf7, 0xce, 0xe3, 0x09, 0xdb, 0xf9, 0x37, 0x7d, 0x91, 0x8c, 0x66, 0xaa, 0xa5, 0xa3, 0x49, 0x8f, 0x9c, 0x10}, (bem_stylesheet_selector *)bem_default_selectors + 147, (struct bem_dictionary *)bem_default_properties + 3, 40, 0},
+    {{0x88, 0x00, 0x43, 0x03, 0x69, 0x2f, 0xac, 0x48, 0xbe, 0x16, 0x9e, 0x17, 0x1a, 0xb9, 0x33, 0x57, 0x55, 0xae, 0xa2, 0x20, 0x96, 0x25, 0x92, 0x69, 0x2e, 0xd9, 0x31, 0x83, 0xe5, 0x8c, 0x9e, 0x43}, (bem_stylesheet_selector *)bem_default_selectors + 148, (struct bem_dictionary *)bem_default_properties + 3, 5, 0},
+    {{0x89, 0x2e, 0x20, 0xab, 0xc5, 0x3a, 0xf6, 0x2d, 0xcc, 0x6c, 0x72, 0x8b, 0x40, 0xc6, 0xb0, 0x08, 0xce, 0xd2, 0x1f, 0x95, 0x28, 0x35, 0x75, 0x5f, 0x31, 0xb3, 0x73, 0xb3, 0xa3, 0x34, 0x1f, 0x8e}, (bem_stylesheet_selector *)bem_default_selectors + 149, (struct bem_dictionary *)bem_default_properties + 13, 86, 0},
+    {{0x8a, 0x45, 0x95, 0xd2, 0xa0, 0x9e, 0x79, 0x30, 0x4a, 0x59, 0x94, 0xc0, 0x9c, 0xd3, 0xfe, 0xab, 0xdd, 0xe9, 0xf0, 0x63, 0x3c, 0x0d, 0x77, 0xd4, 0xee, 0x48, 0x53, 0x95, 0x7c, 0xf6, 0x43, 0xff}, (bem_stylesheet_selector *)bem_default_selectors + 150, (struct bem_dictionary *)bem_default_properties + 35, 172, 0},
+    {{0x8a, 0xd9, 0x97, 0x1f, 0x26, 0x9b, 0x49, 0xe3, 0xb7, 0x9c, 0x6a, 0x62, 0xeb, 0x33, 0x29, 0x04, 0x65, 0x30, 0x33, 0xcc, 0x9c, 0x8f, 0xcf, 0x8a, 0x50, 0xad, 0x83, 0x51, 0xda, 0xbc, 0x45, 0xfa}, (bem_stylesheet_selector *)bem_default_selectors + 151, (struct bem_dictionary *)bem_default_properties + 29, 101, 0},
+    {{0x8b, 0x9f, 0x4f, 0x57, 0x01, 0x84, 0x65, 0xfa, 0xfd, 0xde, 0xcd, 0xb2, 0xd0, 0x30, 0x05, 0xe0, 0xed, 0x88, 0xfc, 0xfc, 0xc8, 0xc4, 0x4c, 0xc7, 0x86, 0x57, 0xad, 0xac, 0x84, 0x54, 0x38, 0xeb}, (bem_stylesheet_selector *)bem_default_selectors + 153, (struct bem_dictionary *)bem_default_properties + 8, 133, 0},
+    {{0x8e, 0xc4, 0x1a, 0x63, 0x4b, 0x3a, 0x99, 0x89, 0xf3, 0x4b, 0xde, 0x6b, 0xa8, 0xd7, 0x2a, 0xc2, 0x66, 0x54, 0xe0, 0x1a, 0x29, 0xf6, 0x04, 0x8e, 0x48, 0x2e, 0x90, 0x4c, 0xa8, 0x5e, 0x7e, 0xd1}, (bem_stylesheet_selector *)bem_default_selectors + 154, (struct bem_dictionary *)bem_default_properties + 37, 62, 0},
+    {{0x90, 0x34, 0x44, 0x84, 0xd7, 0x6b, 0x13, 0x16, 0x48, 0x25, 0x9a, 0x56, 0x4f, 0x75, 0x7e, 0x67, 0x41, 0x63, 0x65, 0x75, 0xf9, 0xb3, 0x5c, 0x6a, 0xb3, 0xa4, 0xbf, 0xe8, 0x2a, 0xac, 0x1b, 0xf6}, (bem_stylesheet_selector *)bem_default_selectors + 155, (struct bem_dictionary *)bem_default_properties + 7, 51, 0},
+    {{0x90, 0x74, 0x2d, 0x6a, 0x40, 0xd1, 0xa3, 0xe7, 0xc7, 0x5f, 0xe2, 0x7c, 0x69, 0x89, 0xb4, 0x0e, 0xa5, 0xa5, 0x4a, 0x08, 0x92, 0xf2, 0xbc, 0xb8, 0xc1, 0xed, 0xbb, 0xc1, 0x67, 0xdf, 0x37, 0xd8}, (bem_stylesheet_selector *)bem_default_selectors + 156, (struct bem_dictionary *)bem_default_properties + 3, 12, 0},
+    {{0x90, 0xb2, 0xca, 0x20, 0xc3, 0x57, 0x8f, 0xb6, 0xd0, 0xc4, 0xc5, 0xd2, 0xf2, 0x8e, 0xcc, 0xf4, 0xdf, 0xbf, 0x6a, 0x78, 0x8b, 0x0e, 0x60, 0x9f, 0x71, 0x6d, 0xda, 0x41, 0xa2, 0x6f, 0x67, 0xef}, (bem_stylesheet_selector *)bem_default_selectors + 158, (struct bem_dictionary *)bem_default_properties + 2, 109, 0},
+    {{0x92, 0x16, 0x57, 0xac, 0xe4, 0x05, 0x79, 0xd9, 0x6a, 0xfb, 0xa5, 0x6e, 0x26, 0x8f, 0xf6, 0x0c, 0xd3, 0xc4, 0xba, 0xe5, 0x12, 0x47, 0xdc, 0x10, 0x44, 0xfe, 0x6c, 0xc9, 0x37, 0x11, 0xf2, 0xc2}, (bem_stylesheet_selector *)bem_default_selectors + 159, (struct bem_dictionary *)bem_default_properties + 38, 66, 0},
+    {{0x92, 0x58, 0x52, 0xe1, 0xea, 0xd7, 0x33, 0x3e, 0xe6, 0xf8, 0x6f, 0x02, 0xc4, 0x34, 0x3d, 0x04, 0x87, 0x6d, 0x80, 0xaa, 0xcc, 0x15, 0xd3, 0xc3, 0xb4, 0x33, 0x2c, 0xd7, 0x3b, 0x33, 0x64, 0x51}, (bem_stylesheet_selector *)bem_default_selectors + 161, (struct bem_dictionary *)bem_default_properties + 8, 142, 0},
+    {{0x92, 0xb0, 0x30, 0x01, 0x19, 0x7e, 0xcd, 0xe2, 0x53, 0x4c, 0x1b, 0x3c, 0xd7, 0xfe, 0x92, 0x68, 0x6d, 0xdc, 0xf8, 0xd8, 0x13, 0x50, 0x78, 0xf5, 0x96, 0x23, 0x45, 0xb1, 0xef, 0x2b, 0xae, 0xee}, (bem_stylesheet_selector *)bem_default_selectors + 162, (struct bem_dictionary *)bem_default_properties + 39, 194, 0},
+    {{0x96, 0x1f, 0x65, 0x82, 0x85, 0xc3, 0xe5, 0x0c, 0xd6, 0x9a, 0x46, 0x18, 0x9f, 0xaa, 0xe6, 0x5f, 0xd5, 0x48, 0xc0, 0x5c, 0x51, 0xc5, 0x67, 0x49, 0xf2, 0x9b, 0x67, 0x13, 0x6d, 0x09, 0x02, 0x8d}, (bem_stylesheet_selector *)bem_default_selectors + 163, (struct bem_dictionary *)bem_default_properties + 40, 166, 0},
+    {{0x96, 0xb2, 0x7c, 0x83, 0x10, 0x50, 0xc1, 0x7e, 0x03, 0x99, 0xb4, 0x69, 0x62, 0x3e, 0xe9, 0xf5, 0xb0, 0xc2, 0xa4, 0x38, 0xd2, 0x11, 0xf6, 0x5a, 0xd0, 0xee, 0xa3, 0x18, 0x74, 0xfb, 0x9d, 0x3e}, (bem_stylesheet_selector *)bem_default_selectors + 164, (struct bem_dictionary *)bem_default_properties + 3, 21, 0},
+    {{0x97, 0x00, 0x2f, 0xa8, 0x48, 0xe7, 0x86, 0x92, 0x75, 0xd5, 0xf0, 0x06, 0x96, 0x16, 0x76, 0x0b, 0xf0, 0x34, 0x8e, 0xfd, 0x2b, 0xa2, 0x64, 0x01, 0x1a, 0x60, 0xb7, 0x01, 0x62, 0x88, 0x11, 0x66}, (bem_stylesheet_selector *)bem_default_selectors + 165, (struct bem_dictionary *)bem_default_properties + 16, 76, 0},
+    {{0x97, 0xac, 0x6d, 0x6a, 0xf5, 0x77, 0x93, 0x23, 0x98, 0xeb, 0xc6, 0x6f, 0x9e, 0x42, 0x20, 0xc8, 0x9e, 0xeb, 0x37, 0x17, 0x46, 0xe8, 0xa9, 0xba, 0xf3, 0x45, 0xfd, 0x8c, 0x92, 0x2b, 0x29, 0x64}, (bem_stylesheet_selector *)bem_default_selectors + 166, (struct bem_dictionary *)bem_default_properties + 41, 0, 0},
+    {{0x98, 0x52, 0x71, 0x4e, 0x97, 0x10, 0xb5, 0x93, 0xef, 0xac, 0xe9, 0x9a, 0x3d, 0x3e, 0xf6, 0xee, 0x6c, 0xf5, 0xb6, 0xac, 0x50, 0x47, 0xbd, 0x89, 0xfe, 0xca, 0x75, 0x68, 0x21, 0x82, 0xc0, 0x45}, (bem_stylesheet_selector *)bem_default_selectors + 167, (struct bem_dictionary *)bem_default_properties + 3, 13, 0},
+    {{0x99, 0xcf, 0xba, 0x8a, 0xe0, 0xbe, 0xa7, 0x9d, 0x1a, 0xc5, 0x9d, 0x66, 0xc4, 0x8a, 0xc5, 0x89, 0xe1, 0x91, 0x4c, 0x72, 0x10, 0x81, 0xfd, 0x18, 0xa9, 0xce, 0x07, 0x63, 0xe0, 0x04, 0x10, 0x5a}, (bem_stylesheet_selector *)bem_default_selectors + 168, (struct bem_dictionary *)bem_default_properties + 3, 34, 0},
+    {{0x99, 0xe3, 0x79, 0x43, 0x1a, 0x86, 0xaa, 0x90, 0xca, 0x7f, 0x44, 0x94, 0x37, 0x5f, 0x4b, 0x6d, 0x38, 0x51, 0xa4, 0x87, 0x22, 0xd7, 0x24, 0xd8, 0x1c, 0x69, 0x05, 0xfb, 0x26, 0x71, 0xdb, 0x03}, (bem_stylesheet_selector *)bem_default_selectors + 169, (struct bem_dictionary *)bem_default_properties + 3, 11, 0},
+    {{0x9b, 0x0d, 0x9e, 0x71, 0x46, 0x9d, 0x1e, 0x96, 0xee, 0x47, 0xd1, 0x4c, 0xa1, 0x5c, 0x0d, 0xfd, 0x80, 0x5e, 0x6b, 0x02, 0x0d, 0xec, 0x3f, 0x9f, 0xde, 0x91, 0xfc, 0x2c, 0x2e, 0x94, 0x24, 0xbb}, (bem_stylesheet_selector *)bem_default_selectors + 171, (struct bem_dictionary *)bem_default_properties + 8, 132, 0},
+    {{0x9b, 0x38, 0x64, 0xeb, 0xfd, 0x1e, 0x94, 0xab, 0xc6, 0x70, 0xc4, 0x82, 0x62, 0xbf, 0x12, 0x8f, 0xc8, 0xab, 0xe5, 0x30, 0xbd, 0x0e, 0xd5, 0x30, 0x8a, 0x25, 0x63, 0x4d, 0xf2, 0x89, 0x67, 0x1a}, (bem_stylesheet_selector *)bem_default_selectors + 172, (struct bem_dictionary *)bem_default_properties + 3, 2, 0},
+    {{0x9d, 0x7e, 0x14, 0xb7, 0xab, 0x35, 0xc3, 0x97, 0xc2, 0xdb, 0x86, 0xca, 0xbf, 0xd6, 0x1d, 0xb4, 0xf3, 0x3c, 0xf6, 0x0f, 0xa0, 0x42, 0x21, 0x8a, 0x52, 0x28, 0x63, 0xab, 0x5c, 0x5a, 0xf5, 0xfe}, (bem_stylesheet_selector *)bem_default_selectors + 174, (struct bem_dictionary *)bem_default_properties + 8, 145, 0},
+    {{0x9e, 0x8c, 0xe3, 0x70, 0x66, 0xab, 0x6c, 0xf0, 0x79, 0x09, 0xa8, 0x58, 0x04, 0x7b, 0x63, 0x90, 0xb8, 0x32, 0xe6, 0x42, 0x0a, 0xe3, 0xf7, 0x5c, 0x83, 0x7a, 0x69, 0xab, 0x5d, 0x0b, 0x80, 0xb8}, (bem_stylesheet_selector *)bem_default_selectors + 175, (struct bem_dictionary *)bem_default_properties + 11, 60, 0},
+    {{0x9f, 0x58, 0x3b, 0x54, 0x11, 0xe2, 0xcd, 0xbd, 0x84, 0x6b, 0xe3, 0x03, 0xf4, 0x57, 0xae, 0xd2, 0x24, 0x81, 0xfd, 0xc6, 0xe8, 0x73, 0xe0, 0xfc, 0xb2, 0xf1, 0x78, 0xa1, 0xb7, 0xd8, 0xcf, 0x84}, (bem_stylesheet_selector *)bem_default_selectors + 176, (struct bem_dictionary *)bem_default_properties + 7, 46, 0},
+    {{0x9f, 0x59, 0x44, 0x3e, 0xe1, 0x5e, 0xb0, 0x44, 0xce, 0xa8, 0x59, 0x14, 0xe5, 0xc2, 0x80, 0xcf, 0x6b, 0xd8, 0xcf, 0x7d, 0xdd, 0xf1, 0xbf, 0x7c, 0x55, 0x03, 0xf4, 0xda, 0xe7, 0x36, 0xa2, 0xf0}, (bem_stylesheet_selector *)bem_default_selectors + 177, (struct bem_dictionary *)bem_default_properties + 42, 181, 0},
+    {{0xa0, 0x8d, 0xc8, 0x35, 0x5e, 0x89, 0x76, 0x4f, 0x20, 0x28, 0xf6, 0x75, 0x8e, 0x51, 0xa3, 0x40, 0x68, 0x94, 0x33, 0xa9, 0x36, 0xc5, 0x29, 0x56, 0x08, 0xc8, 0xff, 0xe0, 0x65, 0xcc, 0x72, 0x32}, (bem_stylesheet_selector *)bem_default_selectors + 178, (struct bem_dictionary *)bem_default_properties + 3, 24, 0},
+    {{0xa2, 0xdd, 0x95, 0x61, 0x31, 0x98, 0x9a, 0x44, 0x7c, 0xe7, 0xcc, 0x23, 0x8f, 0x35, 0x95, 0x08, 0x21, 0xc0, 0x79, 0x3e, 0x05, 0xa1, 0xe9, 0xe1, 0x34, 0xc2, 0xfe, 0x36, 0x78, 0xcc, 0x9b, 0x05}, (bem_stylesheet_selector *)bem_default_selectors + 179, (struct bem_dictionary *)bem_default_properties + 7, 48, 0},
+    {{0xa4, 0x39, 0x75, 0xb8, 0xa5, 0x25, 0x4e, 0x5e, 0xf3, 0x3c, 0x7c, 0x3a, 0xcc, 0x14, 0x30, 0x48, 0x39, 0x35, 0xc5, 0xd9, 0x3f, 0x03, 0x3f, 0x91, 0x1e, 0x34, 0x60, 0x8e, 0xac, 0xbd, 0xd7, 0x54}, (bem_stylesheet_selector *)bem_default_selectors + 181, (struct bem_dictionary *)bem_default_properties + 8, 153, 0},
+    {{0xa5, 0x07, 0x38, 0xed, 0x40, 0xe2, 0x86, 0xd5, 0x37, 0x62, 0x58, 0x54, 0xca, 0x66, 0x01, 0xd8, 0x77, 0xdd, 0xe0, 0x29, 0x63, 0x40, 0x06, 0x02, 0xf1, 0xcc, 0xa8, 0xc2, 0xb7, 0xdc, 0x29, 0xb6}, (bem_stylesheet_selector *)bem_default_selectors + 182, (struct bem_dictionary *)bem_default_properties + 24, 55, 0},
+    {{0xa5, 0x59, 0x74, 0x3c, 0xf3, 0x99, 0xd7, 0x0d, 0xa7, 0xa3, 0xe4, 0x9f, 0x71, 0x0a, 0xfd, 0x5a, 0x74, 0x3e, 0x7a, 0x4c, 0x0e, 0xc1, 0xe9, 0x6c, 0xcd, 0x45, 0x9e, 0xf1, 0xec, 0xf0, 0xa5, 0x16}, (bem_stylesheet_selector *)bem_default_selectors + 183, (struct bem_dictionary *)bem_default_properties + 3, 6, 0},
+    {{0xa5, 0x77, 0xce, 0xdd, 0x9a, 0x10, 0x8a, 0xde, 0xd6, 0x6c, 0xb9, 0xdc, 0xef, 0xb8, 0x0c, 0x2c, 0x03, 0xc2, 0xed, 0x85, 0x30, 0x5c, 0x69, 0x7b, 0x25, 0xf3, 0x78, 0x35, 0xfc, 0x9a, 0x6a, 0x36}, (bem_stylesheet_selector *)bem_default_selectors + 185, (struct bem_dictionary *)bem_default_properties + 2, 107, 0},
+    {{0xa6, 0x24, 0x9a, 0x16, 0xba, 0xe6, 0x17, 0x6a, 0xdd, 0x5e, 0xb9, 0xd3, 0x95, 0xb7, 0xd8, 0xc7, 0x71, 0xdf, 0x6a, 0x35, 0x42, 0x39, 0x65, 0x6d, 0xd3, 0xc6, 0xfe, 0xd0, 0x40, 0x37, 0xb6, 0x57}, (bem_stylesheet_selector *)bem_default_selectors + 186, (struct bem_dictionary *)bem_default_properties + 3, 19, 0},
+    {{0xa7, 0x5b, 0x62, 0xe2, 0x40, 0x3d, 0xad, 0xfe, 0xe3, 0x88, 0x82, 0x70, 0x9e, 0x50, 0xa7, 0xc3, 0x17, 0x38, 0xbb, 0xfe, 0x8a, 0xe4, 0x97, 0xa4, 0xf3, 0xfa, 0x3c, 0xdb, 0x30, 0x0c, 0xd5, 0x97}, (bem_stylesheet_selector *)bem_default_selectors + 187, (struct bem_dictionary *)bem_default_properties + 43, 182, 0},
+    {{0xa8, 0xf6, 0x7e, 0x6a, 0x61, 0xc7, 0xf2, 0x4f, 0xe9, 0x9f, 0xab, 0x24, 0x07, 0xce, 0x9e, 0x47, 0xb7, 0xa6, 0x34, 0xb9, 0xd9, 0x74, 0xb2, 0xde, 0x06, 0x56, 0xe6, 0x0d, 0x06, 0x82, 0xf8, 0xd3}, (bem_stylesheet_selector *)bem_default_selectors + 189, (struct bem_dictionary *)bem_default_properties + 8, 137, 0},
+    {{0xab, 0x71, 0xc8, 0x7c, 0xa9, 0x7d, 0x1f, 0xa2, 0xdb, 0xe3, 0xe5, 0x3c, 0x2a, 0x8e, 0xbd, 0x2c, 0x65, 0xae, 0x54, 0xbc, 0xfe, 0x34, 0x2a, 0x17, 0x26, 0xb3, 0xee, 0x5e, 0xa0, 0xf9, 0x10, 0xa5}, (bem_stylesheet_selector *)bem_default_selectors + 191, (struct bem_dictionary *)bem_default_properties + 2, 106, 0},
+    {{0xac, 0x2b, 0xe6, 0xd9, 0xe5, 0xa3, 0x3f, 0x41, 0x8f, 0x25, 0xc0, 0xad, 0x79, 0x0e, 0x88, 0x6d, 0x0f, 0xee, 0x3d, 0x01, 0x2d, 0x07, 0x79, 0x5a, 0x9d, 0x55, 0x48, 0x0b, 0x95, 0x33, 0xcb, 0xc8}, (bem_stylesheet_selector *)bem_default_selectors + 193, (struct bem_dictionary *)bem_default_properties + 8, 152, 0},
+    {{0xad, 0x8f, 0x32, 0xdb, 0x31, 0x57, 0x43, 0x61, 0xa5, 0xe5, 0xaf, 0xae, 0x8b, 0xb8, 0xc2, 0x51, 0x39, 0x0d, 0xf3, 0x6c, 0xbd, 0x95, 0x35, 0xd5, 0x86, 0xc9, 0xa3, 0x1d, 0x5b, 0xa9, 0x75, 0x6c}, (bem_stylesheet_selector *)bem_default_selectors + 194, (struct bem_dictionary *)bem_default_properties + 44, 158, 0},
+    {{0xaf, 0x99, 0x8e, 0xb3, 0x2f, 0x05, 0x24, 0x54, 0x42, 0xd7, 0x89, 0xf1, 0xc0, 0x5e, 0x10, 0x3a, 0x26, 0x48, 0x09, 0x4c, 0x65, 0xf7, 0x6a, 0x09, 0x77, 0x2f, 0xc6, 0x7b, 0x16, 0xbb, 0xb7, 0x7e}, (bem_stylesheet_selector *)bem_default_selectors + 195, (struct bem_dictionary *)bem_default_properties + 3, 22, 0},
+    {{0xb1, 0xf5, 0xf1, 0x3c, 0xf3, 0xd7, 0x6a, 0x42, 0xc4, 0x46, 0x03, 0x88, 0x73, 0xce, 0xd4, 0x66, 0xe7, 0xf8, 0x4c, 0xcc, 0x7f, 0x28, 0x85, 0x05, 0x89, 0x18, 0x5c, 0x89, 0x8e, 0x5b, 0x80, 0x5d}, (bem_stylesheet_selector *)bem_default_selectors + 196, (struct bem_dictionary *)bem_default_properties + 11, 57, 0},
+    {{0xb3, 0x2a, 0x92, 0xae, 0xb3, 0xaf, 0x93, 0x98, 0x75, 0xae, 0x18, 0x59, 0x41, 0x38, 0xef, 0x53, 0xa5, 0x86, 0xd3, 0x4f, 0xa1, 0x2d, 0xcb, 0xcb, 0x70, 0xaa, 0xbf, 0xaf, 0xcd, 0x30, 0xce, 0x95}, (bem_stylesheet_selector *)bem_default_selectors + 197, (struct bem_dictionary *)bem_default_properties + 45, 83, 0},
+    {{0xb4, 0x51, 0x5b, 0xa0, 0xbc, 0xb0, 0xc9, 0x49, 0xa3, 0x66, 0x0c, 0x45, 0x2f, 0x42, 0x6b, 0x73, 0xd3, 0x06, 0x4e, 0x0f, 0x53, 0x31, 0xcd, 0xea, 0x84, 0xf3, 0x1a, 0x33, 0xe2, 0x6b, 0x97, 0xd3}, (bem_stylesheet_selector *)bem_default_selectors + 198, (struct bem_dictionary *)bem_default_properties + 3, 30, 0},
+    {{0xb7, 0x26, 0x76, 0x3a, 0x5d, 0x92, 0x79, 0x94, 0x2b, 0xdc, 0x55, 0x89, 0x5f, 0x33, 0x20, 0xc3, 0xd0, 0x18, 0x20, 0xb2, 0x92, 0xfc, 0x47, 0x8a, 0x60, 0x54, 0xec, 0x5c, 0x4e, 0xa0, 0x7d, 0xfe}, (bem_stylesheet_selector *)bem_default_selectors + 199, (struct bem_dictionary *)bem_default_properties + 38, 65, 0},
+    {{0xb7, 0xf6, 0x7e, 0xc5, 0xd9, 0xb5, 0x61, 0x07, 0xf1, 0xcb, 0x10, 0x2e, 0x1f, 0x3c, 0x38, 0xb6, 0xe6, 0xa7, 0x04, 0x47, 0x85, 0x89, 0xfa, 0xbe, 0xc4, 0x6c, 0xf3, 0x5a, 0xf7, 0x5e, 0x1e, 0x40}, (bem_stylesheet_selector *)bem_default_selectors + 200, (struct bem_dictionary *)bem_default_properties + 16, 67, 0},
+    {{0xb8, 0xc5, 0x2c, 0x18, 0x77, 0xfc, 0x28, 0x5a, 0x18, 0x29, 0x51, 0xa6, 0x57, 0xb7, 0x4e, 0x23, 0xa1, 0x58, 0xa2, 0xf6, 0xac, 0x7d, 0x7b, 0xe1, 0x4c, 0xad, 0x17, 0xa8, 0xa3, 0x10, 0x85, 0xf1}, (bem_stylesheet_selector *)bem_default_selectors + 203, (struct bem_dictionary *)bem_default_properties + 1, 125, 0},
+    {{0xbb, 0xf2, 0x56, 0x6b, 0x6c, 0xf4, 0x06, 0x1e, 0x86, 0xd9, 0x84, 0x43, 0xfe, 0x5e, 0x63, 0x7c, 0x98, 0x43, 0x73, 0x32, 0x16, 0x84, 0xfb, 0xc1, 0x8e, 0x2d, 0x05, 0xba, 0xa6, 0x93, 0x64, 0xeb}, (bem_stylesheet_selector *)bem_default_selectors + 204, (struct bem_dictionary *)bem_default_properties + 46, 173, 0},
+    {{0xbc, 0xb3, 0x13, 0xde, 0xc6, 0x6b, 0x99, 0x1c, 0x7a, 0x02, 0x84, 0xc0, 0x28, 0xf1, 0x4d, 0x3b, 0x02, 0x12, 0x00, 0xf3, 0x14, 0x67, 0x7d, 0xfe, 0xb3, 0x43, 0x61, 0x4f, 0x9a, 0x54, 0x80, 0xb4}, (bem_stylesheet_selector *)bem_default_selectors + 205, (struct bem_dictionary *)bem_default_properties + 3, 17, 0},
+    {{0xbd, 0x2b, 0xdd, 0xae, 0x75, 0xd6, 0x13, 0x48, 0x42, 0x1d, 0xfa, 0x42, 0xc6, 0xa8, 0x95, 0x00, 0xb1, 0x5b, 0x81, 0x31, 0xdb, 0x88, 0xdc, 0xad, 0x60, 0x46, 0x4c, 0xb0, 0x06, 0xd4, 0x3e, 0x82}, (bem_stylesheet_selector *)bem_default_selectors + 207, (struct bem_dictionary *)bem_default_properties + 8, 141, 0},
+    {{0xc0, 0x9c, 0x44, 0x97, 0x8b, 0x67, 0xc0, 0xea, 0xb8, 0x1b, 0x8a, 0x5b, 0x1a, 0x9f, 0x93, 0xa7, 0x50, 0xfd, 0x27, 0xb8, 0x5b, 0x9b, 0x2c, 0xfc, 0x67, 0x7c, 0xda, 0x02, 0x61, 0x29, 0xf7, 0x60}, (bem_stylesheet_selector *)bem_default_selectors + 208, (struct bem_dictionary *)bem_default_properties + 16, 71, 0},
+    {{0xc6, 0x70, 0x11, 0x6a, 0x6b, 0xf7, 0x58, 0x38, 0xbe, 0x29, 0xbb, 0x3d, 0x39, 0xbb, 0x29, 0x12, 0xf6, 0x8f, 0x89, 0x38, 0x46, 0x4a, 0x7b, 0x53, 0xb5, 0xc8, 0xff, 0xfa, 0x18, 0x50, 0x95, 0xe8}, (bem_stylesheet_selector *)bem_default_selectors + 211, (struct bem_dictionary *)bem_default_properties + 1, 123, 0},
+    {{0xc7, 0x08, 0x9e, 0xab, 0x8b, 0xcf, 0xa3, 0x34, 0xd8, 0x7f, 0x0b, 0xb2, 0x8c, 0xeb, 0x46, 0x59, 0x49, 0x7c, 0x1b, 0xcc, 0xf4, 0x2d, 0xaa, 0x13, 0x7a, 0xc7, 0xeb, 0x8c, 0x5b, 0xb4, 0x1e, 0x4e}, (bem_stylesheet_selector *)bem_default_selectors + 212, (struct bem_dictionary *)bem_default_properties + 47, 78, 0},
+    {{0xc7, 0xb4, 0x8c, 0x00, 0x06, 0xc6, 0xf0, 0x81, 0x95, 0x07, 0x7a, 0x8f, 0x4b, 0x36, 0xeb, 0xc1, 0x0a, 0x47, 0x87, 0x53, 0x89, 0xad, 0x40, 0xff, 0xbf, 0x71, 0x66, 0x18, 0x64, 0x84, 0x1d, 0xaa}, (bem_stylesheet_selector *)bem_default_selectors + 214, (struct bem_dictionary *)bem_default_properties + 8, 148, 0},
+    {{0xcb, 0x1b, 0x8a, 0x69, 0x3f, 0x65, 0x8e, 0x5d, 0xa3, 0xd1, 0xaf, 0xbc, 0x3e, 0x39, 0x74, 0x4a, 0x9a, 0xbb, 0x20, 0xb3, 0x4d, 0x4e, 0xcd, 0xc8, 0x8d, 0x80, 0xda, 0xea, 0xed, 0x2f, 0xf2, 0x73}, (bem_stylesheet_selector *)bem_default_selectors + 215, (struct bem_dictionary *)bem_default_properties + 3, 4, 0},
+    {{0xcb, 0xf4, 0x73, 0x39, 0xa7, 0x26, 0xfc, 0x3c, 0x4d, 0xd9, 0x6c, 0xa7, 0xfe, 0xad, 0x21, 0x74, 0xc4, 0x8b, 0x71, 0x7c, 0xe4, 0x7d, 0xf2, 0x0b, 0xc4, 0xe8, 0x2a, 0xaf, 0xeb, 0x86, 0x6f, 0x49}, (bem_stylesheet_selector *)bem_default_selectors + 217, (struct bem_dictionary *)bem_default_properties + 8, 149, 0},
+    {{0xcc, 0x4a, 0xef, 0xe4, 0x31, 0x28, 0x94, 0x2a, 0xaf, 0x3a, 0x9a, 0x8e, 0x0a, 0x54, 0xc8, 0xb7, 0x0a, 0x90, 0x6f, 0x22, 0xa4, 0x57, 0x34, 0xda, 0x75, 0x9e, 0x71, 0x99, 0x65, 0xff, 0x04, 0x69}, (bem_stylesheet_selector *)bem_default_selectors + 218, (struct bem_dictionary *)bem_default_properties + 48, 169, 0},
+    {{0xcd, 0x74, 0x84, 0x5e, 0xd8, 0x51, 0xfc, 0x2b, 0xf5, 0x80, 0x96, 0xba, 0x1d, 0x7e, 0xff, 0x49, 0xd3, 0xea, 0xc7, 0x7c, 0xa8, 0xf5, 0x66, 0x4c, 0x13, 0x31, 0x7c, 0x41, 0x0d, 0x3e, 0x33, 0x71}, (bem_stylesheet_selector *)bem_default_selectors + 219, (struct bem_dictionary *)bem_default_properties + 49, 187, 0},
+    {{0xcd, 0xf5, 0x44, 0x5e, 0x55, 0x70, 0xdb, 0x59, 0x55, 0x23, 0x17, 0xdb, 0x46, 0xfe, 0x2e, 0x8f, 0x6a, 0x70, 0xa4, 0x50, 0xad, 0x93, 0x50, 0x6c, 0xdc, 0xb6, 0x51, 0x27, 0xae, 0xb7, 0xca, 0x37}, (bem_stylesheet_selector *)bem_default_selectors + 220, (struct bem_dictionary *)bem_default_properties + 3, 20, 0},
+    {{0xd0, 0x6e, 0x1b, 0x2d, 0xb9, 0xe5, 0x90, 0xf2, 0xc7, 0xb7, 0x37, 0x46, 0xb9, 0xf6, 0x89, 0x14, 0x7e, 0x62, 0xe7, 0xa1, 0x3c, 0x3b, 0xf8, 0x93, 0x84, 0x7a, 0xc1, 0x9d, 0xc1, 0x21, 0x72, 0xad}, (bem_stylesheet_selector *)bem_default_selectors + 222, (struct bem_dictionary *)bem_default_properties + 2, 105, 0},
+    {{0xd2, 0x6c, 0xb3, 0xec, 0x94, 0xe3, 0xd3, 0x2e, 0x76, 0xf0, 0xfc, 0x4c, 0x5a, 0x54, 0x6b, 0x34, 0x46, 0x3c, 0xad, 0x73, 0xf8, 0xe2, 0x44, 0x2d, 0x88, 0x26, 0xc7, 0xe3, 0xa5, 0x87, 0x92, 0x4d}, (bem_stylesheet_selector *)bem_default_selectors + 223, (struct bem_dictionary *)bem_default_properties + 7, 50, 0},
+    {{0xd6, 0x20, 0x6e, 0x0b, 0xad, 0x9e, 0x73, 0xa8, 0x4c, 0xb5, 0x84, 0x89, 0xdc, 0x18, 0xdb, 0x0d, 0x47, 0x9a, 0x8a, 0xe3, 0xd8, 0xb9, 0x2b, 0x25, 0x98, 0xdb, 0x12, 0x43, 0x4c, 0xa3, 0xc9, 0xc5}, (bem_stylesheet_selector *)bem_default_selectors + 224, (struct bem_dictionary *)bem_default_properties + 50, 91, 0},
+    {{0xd6, 0x4e, 0xdd, 0x45, 0x26, 0xab, 0x12, 0x7e, 0xab, 0x0c, 0x64, 0x5e, 0x04, 0x61, 0x0f, 0x9f, 0x31, 0x23, 0x6e, 0x62, 0x3d, 0x7c, 0x8c, 0x6a, 0x47, 0xb4, 0xd9, 0xdb, 0x94, 0xe5, 0xdf, 0x80}, (bem_stylesheet_selector *)bem_default_selectors + 226, (struct bem_dictionary *)bem_default_properties + 2, 103, 0},
+    {{0xd6, 0x8e, 0xcc, 0x0b, 0x7c, 0x1f, 0x55, 0x50, 0x67, 0x29, 0x2b, 0x04, 0x9d, 0xf1, 0xbc, 0xe5, 0xa1, 0xc9, 0xb1, 0x75, 0x8d, 0xb9, 0xd0, 0xee, 0x7e, 0xbc, 0x90, 0x56, 0x82, 0x8a, 0xbf, 0x95}, (bem_stylesheet_selector *)bem_default_selectors + 227, (struct bem_dictionary *)bem_default_properties + 35, 170, 0},
+    {{0xd8, 0x47, 0x83, 0xdd, 0xe7, 0x42, 0xc8, 0xbb, 0x02, 0x5c, 0xdf, 0xe4, 0x60, 0x6b, 0x3e, 0xe7, 0x9c, 0x84, 0x12, 0xa9, 0x2b, 0x3b, 0xac, 0xbe, 0xd2, 0x90, 0x46, 0x8b, 0xc5, 0x88, 0x19, 0xba}, (bem_stylesheet_selector *)bem_default_selectors + 228, (struct bem_dictionary *)bem_default_properties + 51, 89, 0},
+    {{0xda, 0x23, 0xfa, 0xc3, 0x62, 0x9c, 0x2b, 0xeb, 0x91, 0x46, 0x61, 0x44, 0xf6, 0x23, 0x33, 0xdc, 0x83, 0x88, 0xf3, 0x54, 0xeb, 0x49, 0x29, 0xc1, 0x02, 0x0a, 0xfc, 0xc6, 0x56, 0x17, 0x14, 0x7d}, (bem_stylesheet_selector *)bem_default_selectors + 230, (struct bem_dictionary *)bem_default_properties + 8, 131, 0},
+    {{0xdb, 0x87, 0xfc, 0x64, 0x45, 0x2f, 0x28, 0x21, 0xa4, 0x78, 0x60, 0xe7, 0x20, 0xd9, 0x5a, 0xb8, 0x98, 0x19, 0x4d, 0x9a, 0xcc, 0x69, 0x0a, 0x10, 0xe7, 0x28, 0x57, 0xed, 0x3a, 0x5b, 0x1b, 0x45}, (bem_stylesheet_selector *)bem_default_selectors + 231, (struct bem_dictionary *)bem_default_properties + 52, 193, 0},
+    {{0xdd, 0x22, 0x38, 0xfb, 0x08, 0xe1, 0xd7, 0xa7, 0x3f, 0x36, 0xff, 0xe1, 0x8b, 0xe4, 0xc3, 0x26, 0x37, 0xc1, 0x74, 0x45, 0x42, 0x86, 0x07, 0x99, 0x1f, 0x66, 0x8c, 0x5e, 0x73, 0x2d, 0xba, 0x4e}, (bem_stylesheet_selector *)bem_default_selectors + 232, (struct bem_dictionary *)bem_default_properties + 31, 81, 0},
+    {{0xdf, 0xe9, 0xbb, 0xac, 0x96, 0x02, 0xf2, 0xde, 0x77, 0x24, 0x80, 0xc0, 0xfb, 0xc5, 0xfe, 0x6e, 0x4f, 0x08, 0xbc, 0x8c, 0x38, 0x8d, 0x55, 0xa0, 0x8d, 0x91, 0x5e, 0x63, 0x34, 0x47, 0x99, 0xdc}, (bem_stylesheet_selector *)bem_default_selectors + 235, (struct bem_dictionary *)bem_default_properties + 1, 127, 0},
+    {{0xe3, 0x0b, 0xf0, 0xf9, 0x00, 0xa1, 0x41, 0xd2, 0x14, 0x23, 0x0c, 0xbf, 0x9d, 0x7d, 0xb0, 0x50, 0x24, 0x4b, 0x1f, 0x2b, 0xac, 0x23, 0x3a, 0xe8, 0xce, 0xa1, 0xba, 0x36, 0x3c, 0xf6, 0xb4, 0x9f}, (bem_stylesheet_selector *)bem_default_selectors + 237, (struct bem_dictionary *)bem_default_properties + 8, 135, 0},
+    {{0xe3, 0x4f, 0xc0, 0xf6, 0x30, 0x32, 0xd6, 0xe5, 0x10, 0x17, 0x1f, 0xd6, 0x82, 0xb5, 0x0d, 0x7e, 0x3a, 0x2d, 0xa6, 0x5c, 0xd3, 0x66, 0xf5, 0x95, 0xeb, 0x78, 0xe3, 0xb0, 0x4f, 0x49, 0x5e, 0xa4}, (bem_stylesheet_selector *)bem_default_selectors + 238, (struct bem_dictionary *)bem_default_properties + 37, 63, 0},
+    {{0xe4, 0xdb, 0x3d, 0x87, 0x0b, 0xb7, 0xcf, 0x0f, 0xde, 0x94, 0xec, 0xbc, 0x36, 0x12, 0x9c, 0x2a, 0xcf, 0xce, 0x15, 0x05, 0x70, 0x7c, 0xb1, 0xbc, 0x36, 0xe9, 0xd1, 0x0c, 0x2c, 0x14, 0xcf, 0xc0}, (bem_stylesheet_selector *)bem_default_selectors + 239, (struct bem_dictionary *)bem_default_properties + 53, 159, 0},
+    {{0xe6, 0x3c, 0x34, 0x4e, 0x38, 0xa5, 0xd9, 0x97, 0xa4, 0x0e, 0xd4, 0xc0, 0x6d, 0x81, 0x60, 0xbd, 0xa9, 0x18, 0x9b, 0xf3, 0x84, 0xa0, 0x63, 0xbf, 0x83, 0xe2, 0x13, 0x05, 0x2f, 0x8b, 0xb5, 0x01}, (bem_stylesheet_selector *)bem_default_selectors + 242, (struct bem_dictionary *)bem_default_properties + 1, 116, 0},
+    {{0xe7, 0x81, 0xd8, 0x67, 0xc4, 0xd5, 0x9b, 0xa6, 0xfb, 0xd6, 0x97, 0xc7, 0xa8, 0xb8, 0x8e, 0xc2, 0xd5, 0x8d, 0xb7, 0x5c, 0x6c, 0xf5, 0x72, 0x8d, 0xc7, 0xbb, 0x9e, 0x78, 0xbf, 0xc8, 0xa1, 0x3d}, (bem_stylesheet_selector *)bem_default_selectors + 243, (struct bem_dictionary *)bem_default_properties + 46, 174, 0},
+    {{0xe9, 0x62, 0x50, 0x66, 0x2d, 0x16, 0x26, 0x04, 0x61, 0xb8, 0x51, 0x72, 0xc0, 0x33, 0x10, 0xc3, 0x77, 0xcd, 0x20, 0xae, 0xc9, 0x96, 0x1b, 0x05, 0x91, 0x8e, 0xf4, 0x91, 0x27, 0x5b, 0x10, 0xda}, (bem_stylesheet_selector *)bem_default_selectors + 245, (struct bem_dictionary *)bem_default_properties + 8, 130, 0},
+    {{0xe9, 0xc6, 0x65, 0xc0, 0x66, 0x62, 0x54, 0x6c, 0xf3, 0xd8, 0x21, 0x8f, 0x06, 0xd8, 0x43, 0xd0, 0xf4, 0x72, 0xd2, 0x06, 0x7b, 0xd5, 0xaf, 0xe1, 0x94, 0x1f, 0x43, 0x1b, 0x9e, 0x51, 0xe9, 0xe1}, (bem_stylesheet_selector *)bem_default_selectors + 246, (struct bem_dictionary *)bem_default_properties + 54, 180, 0},
+    {{0xea, 0x14, 0x02, 0x9d, 0xd6, 0x58, 0x1d, 0x62, 0x44, 0x04, 0x2f, 0x88, 0xf6, 0x79, 0x06, 0x03, 0x26, 0x7b, 0x1d, 0x93, 0x11, 0x1b, 0x00, 0x1e, 0x30, 0x92, 0x43, 0xd9, 0xab, 0x4c, 0xde, 0xb5}, (bem_stylesheet_selector *)bem_default_selectors + 247, (struct bem_dictionary *)bem_default_properties + 16, 72, 0},
+    {{0xed, 0x3b, 0xe0, 0x09, 0x0e, 0x99, 0xe2, 0x6d, 0xe2, 0x42, 0x30, 0x4a, 0xed, 0xe4, 0x5d, 0xe1, 0x94, 0x6b, 0xc4, 0xf6, 0xe2, 0xc1, 0x2f, 0xad, 0x74, 0xaa, 0x85, 0x3d, 0xd1, 0x6d, 0xd2, 0x6a}, (bem_stylesheet_selector *)bem_default_selectors + 248, (struct bem_dictionary *)bem_default_properties + 36, 178, 0},
+    {{0xed, 0xe4, 0xb7, 0x4a, 0x1a, 0xc5, 0x77, 0xb6, 0x95, 0x62, 0x6b, 0x27, 0x22, 0xed, 0xfc, 0xf8, 0x58, 0x83, 0x64, 0x4b, 0xb3, 0x0a, 0xdd, 0xe2, 0xc9, 0xfe, 0xde, 0xfa, 0x65, 0x19, 0x79, 0xe4}, (bem_stylesheet_selector *)bem_default_selectors + 249, (struct bem_dictionary *)bem_default_properties + 3, 10, 0},
+    {{0xef, 0x61, 0x06, 0x85, 0x5e, 0xc3, 0xbb, 0x83, 0x06, 0xb7, 0xed, 0xd3, 0x41, 0xbd, 0xf4, 0x3e, 0x2f, 0x14, 0x96, 0x23, 0x21, 0xf9, 0x63, 0xd4, 0xc0, 0x6a, 0x8a, 0x2b, 0xd1, 0x40, 0xb8, 0xad}, (bem_stylesheet_selector *)bem_default_selectors + 250, (struct bem_dictionary *)bem_default_properties + 16, 73, 0},
+    {{0xef, 0xc3, 0xa9, 0x1e, 0x55, 0x2c, 0x63, 0xd3, 0x41, 0x83, 0x5e, 0x66, 0xac, 0xe4, 0x16, 0x06, 0x47, 0x79, 0x46, 0x74, 0x0e, 0x51, 0x33, 0xf3, 0xc9, 0x0a, 0x23, 0x05, 0xaf, 0x57, 0x00, 0xf5}, (bem_stylesheet_selector *)bem_default_selectors + 253, (struct bem_dictionary *)bem_default_properties + 1, 121, 0},
+    {{0xf1, 0xd9, 0x4b, 0x9a, 0xdf, 0x90, 0xff, 0x38, 0x4d, 0x58, 0x16, 0x40, 0xc1, 0x6e, 0xe4, 0x89, 0x53, 0xfc, 0xe7, 0xc5, 0x7a, 0x35, 0x63, 0x22, 0x89, 0xa1, 0x4b, 0x7d, 0xca, 0xd3, 0x95, 0x17}, (bem_stylesheet_selector *)bem_default_selectors + 254, (struct bem_dictionary *)bem_default_properties + 55, 190, 0},
+    {{0xf2, 0x0a, 0x2c, 0xa6, 0x6f, 0xe4, 0x27, 0x01, 0xba, 0xa0, 0x45, 0x24, 0x88, 0x0e, 0x21, 0x42, 0xc1, 0xaf, 0x26, 0xfb, 0x73, 0x17, 0x86, 0x8b, 0xc0, 0x3c, 0xdb, 0x8d, 0xbd, 0xf9, 0xba, 0xca}, (bem_stylesheet_selector *)bem_default_selectors + 256, (struct bem_dictionary *)bem_default_properties + 8, 144, 0},
+    {{0xf3, 0x7a, 0x8d, 0x38, 0x91, 0xed, 0xe5, 0xec, 0x20, 0x5e, 0x28, 0x51, 0xc8, 0x80, 0x74, 0x61, 0x9f, 0xfc, 0xaa, 0x39, 0xfc, 0x34, 0x6b, 0xc9, 0xe8, 0x7c, 0x83, 0x5d, 0x74, 0x12, 0xd9, 0x11}, (bem_stylesheet_selector *)bem_default_selectors + 257, (struct bem_dictionary *)bem_default_properties + 56, 167, 0},
+    {{0xf4, 0x28, 0x74, 0xc8, 0xba, 0x0d, 0x01, 0xdd, 0x59, 0xa7, 0xe7, 0xfe, 0x5f, 0x30, 0x00, 0xb4, 0x2b, 0xb9, 0xcd, 0xa6, 0xf9, 0x1d, 0x30, 0x13, 0x36, 0x81, 0x69, 0xed, 0xa2, 0x1e, 0x6e, 0x03}, (bem_stylesheet_selector *)bem_default_selectors + 258, (struct bem_dictionary *)bem_default_properties + 3, 18, 0},
+    {{0xf4, 0x79, 0xc2, 0x04, 0x8c, 0xba, 0x05, 0x8c, 0x2f, 0xc1, 0xd7, 0x6f, 0xdd, 0x67, 0x14, 0x5a, 0xbf, 0x42, 0x55, 0xef, 0xb3, 0x29, 0xb3, 0xf3, 0x57, 0xa9, 0xc6, 0xc3, 0xdf, 0x49, 0x2a, 0x94}, (bem_stylesheet_selector *)bem_default_selectors + 259, (struct bem_dictionary *)bem_default_properties + 3, 37, 0},
+    {{0xf6, 0x57, 0xd5, 0x41, 0x21, 0xd7, 0xcb, 0x3a, 0x90, 0x63, 0x81, 0xaf, 0xbb, 0xbc, 0x69, 0x5b, 0x94, 0x45, 0x47, 0x48, 0x99, 0x2f, 0x34, 0x9b, 0xa1, 0xb6, 0xf2, 0x90, 0xe5, 0xb9, 0x4a, 0x57}, (bem_stylesheet_selector *)bem_default_selectors + 260, (struct bem_dictionary *)bem_default_properties + 11, 61, 0},
+    {{0xf7, 0xae, 0x61, 0xc6, 0x36, 0xea, 0x57, 0x7a, 0x5c, 0x89, 0x3c, 0xc7, 0x0c, 0x44, 0x4d, 0xe3, 0x2c, 0xe4, 0xf9, 0xdc, 0xb5, 0x5a, 0xf9, 0x77, 0xe9, 0x7a, 0x5e, 0x7f, 0xfd, 0x49, 0x05, 0xd4}, (bem_stylesheet_selector *)bem_default_selectors + 261, (struct bem_dictionary *)bem_default_properties + 3, 31, 0},
+    {{0xf7, 0xb1, 0xe8, 0xa7, 0x20, 0xf0, 0xf4, 0x1d, 0x6d, 0xfc, 0x7b, 0xe1, 0x3c, 0xd7, 0x24, 0xb2, 0x8d, 0x1b, 0x4e, 0x88, 0xd3, 0x89, 0x79, 0x2f, 0x25, 0x6a, 0x0f, 0xb7, 0xf6, 0xd0, 0x2f, 0x4e}, (bem_stylesheet_selector *)bem_default_selectors + 262, (struct bem_dictionary *)bem_default_properties + 54, 179, 0},
+    {{0xf7, 0xd6, 0xc7, 0x1d, 0x8b, 0xc1, 0x7c, 0x5c, 0x1d, 0x42, 0x12, 0x7d, 0x5b, 0xa9, 0x3e, 0xe8, 0x34, 0x3f, 0x03, 0xa9, 0x07, 0x1c, 0x1f, 0xc8, 0xa2, 0xc0, 0x61, 0xe8, 0xd1, 0xe7, 0x51, 0x35}, (bem_stylesheet_selector *)bem_default_selectors + 263, (struct bem_dictionary *)bem_default_properties + 41, 1, 0},
+    {{0xfa, 0x38, 0xbc, 0x24, 0xff, 0x21, 0xa9, 0x7e, 0x2f, 0x37, 0x3f, 0x62, 0x38, 0xed, 0x79, 0x65, 0xaa, 0x5c, 0x7d, 0xbe, 0xc3, 0xad, 0x4c, 0xfe, 0x26, 0x78, 0xf9, 0x1f, 0xf1, 0x4f, 0x73, 0xfa}, (bem_stylesheet_selector *)bem_default_selectors + 265, (struct bem_dictionary *)bem_default_properties + 2, 110, 0},
+    {{0xfb, 0x3e, 0x5f, 0x70, 0x1d, 0x14, 0x77, 0x9e, 0xbe, 0x3b, 0x5b, 0x8b, 0x47, 0xc2, 0xd9, 0xe0, 0x2e, 0xdd, 0x31, 0x9d, 0x53, 0x3f, 0xba, 0x27, 0xb0, 0x31, 0xd9, 0xc4, 0xf3, 0xf4, 0x9f, 0x11}, (bem_stylesheet_selector *)bem_default_selectors + 266, (struct bem_dictionary *)bem_default_properties + 3, 23, 0},
+    {{0xfb, 0xa5, 0xd8, 0x46, 0xd7, 0xd3, 0xed, 0xae, 0xb9, 0xb5, 0x0f, 0x65, 0xdb, 0x9c, 0x79, 0xd2, 0x73, 0xe4, 0xe4, 0x61, 0xc8, 0xce, 0x66, 0x54, 0xbc, 0xca, 0x5c, 0xf0, 0x2c, 0xee, 0x7c, 0x49}, (bem_stylesheet_selector *)bem_default_selectors + 267, (struct bem_dictionary *)bem_default_properties + 57, 156, 0},
+    {{0xfd, 0x3d, 0xd7, 0x66, 0xc9, 0xdf, 0x81, 0x4e, 0x6c, 0x71, 0x23, 0xb9, 0xbe, 0x4f, 0x9a, 0xe7, 0x72, 0xe1, 0x69, 0xfc, 0x9e, 0x37, 0x78, 0x8e, 0xa3, 0x51, 0x86, 0xa5, 0x34, 0xc3, 0x89, 0x25}, (bem_stylesheet_selector *)bem_default_selectors + 268, (struct bem_dictionary *)bem_default_properties + 58, 84, 0},
+    {{0xfd, 0xc2, 0x7b, 0x40, 0x9a, 0xac, 0x0a, 0xa7, 0x7b, 0x34, 0xae, 0xd4, 0x66, 0x57, 0x91, 0x7e, 0x50, 0x8f, 0x6a, 0x32, 0x19, 0x1b, 0x1f, 0xb4, 0x09, 0xb5, 0x4a, 0x65, 0x7f, 0xd1, 0xd9, 0xac}, (bem_stylesheet_selector *)bem_default_selectors + 269, (struct bem_dictionary *)bem_default_properties + 23, 176, 0},
+};
+
+static const bem_rule_set *const bem_default_all_rules[199] = {
+    bem_default_rules + 0,
+    bem_default_rules + 1,
+    bem_default_rules + 2,
+    bem_default_rules + 3,
+    bem_default_rules + 4,
+    bem_default_rules + 5,
+    bem_default_rules + 6,
+    bem_default_rules + 7,
+    bem_default_rules + 8,
+    bem_default_rules + 9,
+    bem_default_rules + 10,
+    bem_default_rules + 11,
+    bem_default_rules + 12,
+    bem_default_rules + 13,
+    bem_default_rules + 14,
+    bem_default_rules + 15,
+    bem_default_rules + 16,
+    bem_default_rules + 17,
+    bem_default_rules + 18,
+    bem_default_rules + 19,
+    bem_default_rules + 20,
+    bem_default_rules + 21,
+    bem_default_rules + 22,
+    bem_default_rules + 23,
+    bem_default_rules + 24,
+    bem_default_rules + 25,
+    bem_default_rules + 26,
+    bem_default_rules + 27,
+    bem_default_rules + 28,
+    bem_default_rules + 29,
+    bem_default_rules + 30,
+    bem_default_rules + 31,
+    bem_default_rules + 32,
+    bem_default_rules + 33,
+    bem_default_rules + 34,
+    bem_default_rules + 35,
+    bem_default_rules + 36,
+    bem_default_rules + 37,
+    bem_default_rules + 38,
+    bem_default_rules + 39,
+    bem_default_rules + 40,
+    bem_default_rules + 41,
+    bem_default_rules + 42,
+    bem_default_rules + 43,
+    bem_default_rules + 44,
+    bem_default_rules + 45,
+    bem_default_rules + 46,
+    bem_default_rules + 47,
+    bem_default_rules + 48,
+    bem_default_rules + 49,
+    bem_default_rules + 50,
+    bem_default_rules + 51,
+    bem_default_rules + 52,
+    bem_default_rules + 53,
+    bem_default_rules + 54,
+    bem_default_rules + 55,
+    bem_default_rules + 56,
+    bem_default_rules + 57,
+    bem_default_rules + 58,
+    bem_default_rules + 59,
+    bem_default_rules + 60,
+    bem_default_rules + 61,
+    bem_default_rules + 62,
+    bem_default_rules + 63,
+    bem_default_rules + 64,
+    bem_default_rules + 65,
+    bem_default_rules + 66,
+    bem_default_rules + 67,
+    bem_default_rules + 68,
+    bem_default_rules + 69,
+    bem_default_rules + 70,
+    bem_default_rules + 71,
+    bem_default_rules + 72,
+    bem_default_rules + 73,
+    bem_default_rules + 74,
+    bem_default_rules + 75,
+    bem_default_rules + 76,
+    bem_default_rules + 77,
+    bem_default_rules + 78,
+    bem_default_rules + 79,
+    bem_default_rules + 80,
+    bem_default_rules + 81,
+    bem_default_rules + 82,
+    bem_default_rules + 83,
+    bem_default_rules + 84,
+    bem_default_rules + 85,
+    bem_default_rules + 86,
+    bem_default_rules + 87,
+    bem_default_rules + 88,
+    bem_default_rules + 89,
+    bem_default_rules + 90,
+    bem_default_rules + 91,
+    bem_default_rules + 92,
+    bem_default_rules + 93,
+    bem_default_rules + 94,
+    bem_default_rules + 95,
+    bem_default_rules + 96,
+    bem_default_rules + 97,
+    bem_default_rules + 98,
+    bem_default_rules + 99,
+    bem_default_rules + 100,
+    bem_default_rules + 101,
+    bem_default_rules + 102,
+    bem_default_rules + 103,
+    bem_default_rules + 104,
+    bem_default_rules + 105,
+    bem_default_rules + 106,
+    bem_default_rules + 107,
+    bem_default_rules + 108,
+    bem_default_rules + 109,
+    bem_default_rules + 110,
+    bem_default_rules + 111,
+    bem_default_rules + 112,
+    bem_default_rules + 113,
+    bem_default_rules + 114,
+    bem_default_rules + 115,
+    bem_default_rules + 116,
+    bem_default_rules + 117,
+    bem_default_rules + 118,
+    bem_default_rules + 119,
+    bem_default_rules + 120,
+    bem_default_rules + 121,
+    bem_default_rules + 122,
+    bem_default_rules + 123,
+    bem_default_rules + 124,
+    bem_default_rules + 125,
+    bem_default_rules + 126,
+    bem_default_rules + 127,
+    bem_default_rules + 128,
+    bem_default_rules + 129,
+    bem_default_rules + 130,
+    bem_default_rules + 131,
+    bem_default_rules + 132,
+    bem_default_rules + 133,
+    bem_default_rules + 134,
+    bem_default_rules + 135,
+    bem_default_rules + 136,
+    bem_default_rules + 137,
+    bem_default_rules + 138,
+    bem_default_rules + 139,
+    bem_default_rules + 140,
+    bem_default_rules + 141,
+    bem_default_rules + 142,
+    bem_default_rules + 143,
+    bem_default_rules + 144,
+    bem_default_rules + 145,
+    bem_default_rules + 146,
+    bem_default_rules + 147,
+    bem_default_rules + 148,
+    bem_default_rules + 149,
+    bem_default_rules + 150,
+    bem_default_rules + 151,
+    bem_default_rules + 152,
+    bem_default_rules + 153,
+    bem_default_rules + 154,
+    bem_default_rules + 155,
+    bem_default_rules + 156,
+    bem_default_rules + 157,
+    bem_default_rules + 158,
+    bem_default_rules + 159,
+    bem_default_rules + 160,
+    bem_default_rules + 161,
+    bem_default_rules + 162,
+    bem_default_rules + 163,
+    bem_default_rules + 164,
+    bem_default_rules + 165,
+    bem_default_rules + 166,
+    bem_default_rules + 167,
+    bem_default_rules + 168,
+    bem_default_rules + 169,
+    bem_default_rules + 170,
+    bem_default_rules + 171,
+    bem_default_rules + 172,
+    bem_default_rules + 173,
+    bem_default_rules + 174,
+    bem_default_rules + 175,
+    bem_default_rules + 176,
+    bem_default_rules + 177,
+    bem_default_rules + 178,
+    bem_default_rules + 179,
+    bem_default_rules + 180,
+    bem_default_rules + 181,
+    bem_default_rules + 182,
+    bem_default_rules + 183,
+    bem_default_rules + 184,
+    bem_default_rules + 185,
+    bem_default_rules + 186,
+    bem_default_rules + 187,
+    bem_default_rules + 188,
+    bem_default_rules + 189,
+    bem_default_rules + 190,
+    bem_default_rules + 191,
+    bem_default_rules + 192,
+    bem_default_rules + 193,
+    bem_default_rules + 194,
+    bem_default_rules + 195,
+    bem_default_rules + 196,
+    bem_default_rules + 197,
+    bem_default_rules + 198,
+};
+
+static const bem_rule_set *const bem_default_element_rules[199] = {
+    bem_default_rules + 6,
+    bem_default_rules + 122,
+    bem_default_rules + 193,
+    bem_default_rules + 46,
+    bem_default_rules + 135,
+    bem_default_rules + 94,
+    bem_default_rules + 127,
+    bem_default_rules + 44,
+    bem_default_rules + 101,
+    bem_default_rules + 158,
+    bem_default_rules + 112,
+    bem_default_rules + 18,
+    bem_default_rules + 21,
+    bem_default_rules + 13,
+    bem_default_rules + 107,
+    bem_default_rules + 148,
+    bem_default_rules + 149,
+    bem_default_rules + 23,
+    bem_default_rules + 136,
+    bem_default_rules + 156,
+    bem_default_rules + 89,
+    bem_default_rules + 146,
+    bem_default_rules + 12,
+    bem_default_rules + 197,
+    bem_default_rules + 145,
+    bem_default_rules + 22,
+    bem_default_rules + 168,
+    bem_default_rules + 96,
+    bem_default_rules + 67,
+    bem_default_rules + 10,
+    bem_default_rules + 165,
+    bem_default_rules + 28,
+    bem_default_rules + 57,
+    bem_default_rules + 39,
+    bem_default_rules + 182,
+    bem_default_rules + 2,
+    bem_default_rules + 38,
+    bem_default_rules + 55,
+    bem_default_rules + 80,
+    bem_default_rules + 81,
+    bem_default_rules + 86,
+    bem_default_rules + 88,
+    bem_default_rules + 102,
+    bem_default_rules + 125,
+    bem_default_rules + 128,
+    bem_default_rules + 163,
+    bem_default_rules + 173,
+    bem_default_rules + 178,
+    bem_default_rules + 114,
+    bem_default_rules + 63,
+    bem_default_rules + 69,
+    bem_default_rules + 84,
+    bem_default_rules + 98,
+    bem_default_rules + 123,
+    bem_default_rules + 153,
+    bem_default_rules + 169,
+    bem_default_rules + 36,
+    bem_default_rules + 14,
+    bem_default_rules + 27,
+    bem_default_rules + 50,
+    bem_default_rules + 90,
+    bem_default_rules + 104,
+    bem_default_rules + 116,
+    bem_default_rules + 152,
+    bem_default_rules + 154,
+    bem_default_rules + 188,
+    bem_default_rules + 138,
+    bem_default_rules + 162,
+    bem_default_rules + 120,
+    bem_default_rules + 196,
+    bem_default_rules + 48,
+    bem_default_rules + 144,
+    bem_default_rules + 143,
+    bem_default_rules + 195,
+    bem_default_rules + 132,
+    bem_default_rules + 175,
+    bem_default_rules + 47,
+    bem_default_rules + 78,
+    bem_default_rules + 40,
+    bem_default_rules + 64,
+    bem_default_rules + 42,
+    bem_default_rules + 65,
+    bem_default_rules + 0,
+    bem_default_rules + 3,
+    bem_default_rules + 24,
+    bem_default_rules + 25,
+    bem_default_rules + 129,
+    bem_default_rules + 97,
+    bem_default_rules + 5,
+    bem_default_rules + 108,
+    bem_default_rules + 119,
+    bem_default_rules + 147,
+    bem_default_rules + 109,
+    bem_default_rules + 177,
+    bem_default_rules + 179,
+    bem_default_rules + 181,
+    bem_default_rules + 187,
+    bem_default_rules + 191,
+    bem_default_rules + 198,
+    bem_default_rules + 130,
+    bem_default_rules + 68,
+    bem_default_rules + 4,
+    bem_default_rules + 19,
+    bem_default_rules + 51,
+    bem_default_rules + 60,
+    bem_default_rules + 91,
+    bem_default_rules + 92,
+    bem_default_rules + 115,
+    bem_default_rules + 117,
+    bem_default_rules + 126,
+    bem_default_rules + 140,
+    bem_default_rules + 141,
+    bem_default_rules + 142,
+    bem_default_rules + 166,
+    bem_default_rules + 180,
+    bem_default_rules + 71,
+    bem_default_rules + 124,
+    bem_default_rules + 160,
+    bem_default_rules + 133,
+    bem_default_rules + 9,
+    bem_default_rules + 43,
+    bem_default_rules + 56,
+    bem_default_rules + 62,
+    bem_default_rules + 87,
+    bem_default_rules + 103,
+    bem_default_rules + 105,
+    bem_default_rules + 111,
+    bem_default_rules + 134,
+    bem_default_rules + 151,
+    bem_default_rules + 157,
+    bem_default_rules + 167,
+    bem_default_rules + 183,
+    bem_default_rules + 192,
+    bem_default_rules + 73,
+    bem_default_rules + 79,
+    bem_default_rules + 33,
+    bem_default_rules + 82,
+    bem_default_rules + 131,
+    bem_default_rules + 189,
+    bem_default_rules + 93,
+    bem_default_rules + 139,
+    bem_default_rules + 58,
+    bem_default_rules + 99,
+    bem_default_rules + 164,
+    bem_default_rules + 26,
+    bem_default_rules + 171,
+    bem_default_rules + 83,
+    bem_default_rules + 30,
+    bem_default_rules + 174,
+    bem_default_rules + 113,
+    bem_default_rules + 11,
+    bem_default_rules + 54,
+    bem_default_rules + 49,
+    bem_default_rules + 161,
+    bem_default_rules + 185,
+    bem_default_rules + 32,
+    bem_default_rules + 53,
+    bem_default_rules + 7,
+    bem_default_rules + 85,
+    bem_default_rules + 170,
+    bem_default_rules + 31,
+    bem_default_rules + 74,
+    bem_default_rules + 118,
+    bem_default_rules + 20,
+    bem_default_rules + 100,
+    bem_default_rules + 37,
+    bem_default_rules + 70,
+    bem_default_rules + 95,
+    bem_default_rules + 1,
+    bem_default_rules + 8,
+    bem_default_rules + 15,
+    bem_default_rules + 16,
+    bem_default_rules + 17,
+    bem_default_rules + 29,
+    bem_default_rules + 34,
+    bem_default_rules + 35,
+    bem_default_rules + 45,
+    bem_default_rules + 52,
+    bem_default_rules + 59,
+    bem_default_rules + 61,
+    bem_default_rules + 66,
+    bem_default_rules + 72,
+    bem_default_rules + 75,
+    bem_default_rules + 76,
+    bem_default_rules + 77,
+    bem_default_rules + 106,
+    bem_default_rules + 110,
+    bem_default_rules + 121,
+    bem_default_rules + 137,
+    bem_default_rules + 150,
+    bem_default_rules + 155,
+    bem_default_rules + 159,
+    bem_default_rules + 172,
+    bem_default_rules + 176,
+    bem_default_rules + 184,
+    bem_default_rules + 186,
+    bem_default_rules + 194,
+    bem_default_rules + 190,
+    bem_default_rules + 41,
+};
+
+static const bem_attribute_mapping bem_default_mappings[80] = {
+    {ELEMENT_BODY, "bgcolor", "background-color", NULL},
+    {ELEMENT_BODY, "text", "color", NULL},
+    {ELEMENT_CANVAS, "height", "height", "<length>"},
+    {ELEMENT_CANVAS, "width", "width", "<length>"},
+    {ELEMENT_COL, "align", "text-align", NULL},
+    {ELEMENT_COL, "valign", "vertical-align", NULL},
+    {ELEMENT_COL, "width", "width", "<length>"},
+    {ELEMENT_COLGROUP, "align", "text-align", NULL},
+    {ELEMENT_COLGROUP, "valign", "vertical-align", NULL},
+    {ELEMENT_COLGROUP, "width", "width", "<length>"},
+    {ELEMENT_DIV, "align", "text-align", NULL},
+    {ELEMENT_EMBED, "height", "height", "<length>"},
+    {ELEMENT_EMBED, "width", "width", "<length>"},
+    {ELEMENT_FONT, "color", "color", NULL},
+    {ELEMENT_FONT, "face", "font-family", NULL},
+    {ELEMENT_FONT, "size", "font-size", "<font-size>"},
+    {ELEMENT_H1, "align", "text-align", NULL},
+    {ELEMENT_H2, "align", "text-align", NULL},
+    {ELEMENT_H3, "align", "text-align", NULL},
+    {ELEMENT_H4, "align", "text-align", NULL},
+    {ELEMENT_H5, "align", "text-align", NULL},
+    {ELEMENT_H6, "align", "text-align", NULL},
+    {ELEMENT_HR, "color", "color", NULL},
+    {ELEMENT_HR, "size", "height", "<length>"},
+    {ELEMENT_HR, "width", "width", "<length>"},
+    {ELEMENT_IFRAME, "height", "height", "<length>"},
+    {ELEMENT_IFRAME, "width", "width", "<length>"},
+    {ELEMENT_IMG, "border", "border-bottom-style", "solid"},
+    {ELEMENT_IMG, "border", "border-bottom-width", "<length>"},
+    {ELEMENT_IMG, "border", "border-left-style", "solid"},
+    {ELEMENT_IMG, "border", "border-left-width", "<length>"},
+    {ELEMENT_IMG, "border", "border-right-style", "solid"},
+    {ELEMENT_IMG, "border", "border-right-width", "<length>"},
+    {ELEMENT_IMG, "border", "border-top-style", "solid"},
+    {ELEMENT_IMG, "border", "border-top-width", "<length>"},
+    {ELEMENT_IMG, "height", "height", "<length>"},
+    {ELEMENT_IMG, "hspace", "margin-left", "<length>"},
+    {ELEMENT_IMG, "hspace", "margin-right", "<length>"},
+    {ELEMENT_IMG, "vspace", "margin-bottom", "<length>"},
+    {ELEMENT_IMG, "vspace", "margin-top", "<length>"},
+    {ELEMENT_IMG, "width", "width", "<length>"},
+    {ELEMENT_OBJECT, "height", "height", "<length>"},
+    {ELEMENT_OBJECT, "width", "width", "<length>"},
+    {ELEMENT_P, "align", "text-align", NULL},
+    {ELEMENT_TABLE, "bgcolor", "background-color", NULL},
+    {ELEMENT_TABLE, "border", "border-bottom-style", "outset"},
+    {ELEMENT_TABLE, "border", "border-bottom-width", "<length>"},
+    {ELEMENT_TABLE, "border", "border-left-style", "outset"},
+    {ELEMENT_TABLE, "border", "border-left-width", "<length>"},
+    {ELEMENT_TABLE, "border", "border-right-style", "outset"},
+    {ELEMENT_TABLE, "border", "border-right-width", "<length>"},
+    {ELEMENT_TABLE, "border", "border-top-style", "outset"},
+    {ELEMENT_TABLE, "border", "border-top-width", "<length>"},
+    {ELEMENT_TABLE, "cellspacing", "border-spacing", "<length>"},
+    {ELEMENT_TABLE, "height", "height", "<length>"},
+    {ELEMENT_TABLE, "width", "width", "<length>"},
+    {ELEMENT_TBODY, "align", "text-align", NULL},
+    {ELEMENT_TBODY, "valign", "vertical-align", NULL},
+    {ELEMENT_TD, "align", "text-align", NULL},
+    {ELEMENT_TD, "bgcolor", "background-color", NULL},
+    {ELEMENT_TD, "height", "height", "<length>"},
+    {ELEMENT_TD, "nowrap", "white-space", "nowrap"},
+    {ELEMENT_TD, "valign", "vertical-align", NULL},
+    {ELEMENT_TD, "width", "width", "<length>"},
+    {ELEMENT_TFOOT, "align", "text-align", NULL},
+    {ELEMENT_TFOOT, "valign", "vertical-align", NULL},
+    {ELEMENT_TH, "align", "text-align", NULL},
+    {ELEMENT_TH, "bgcolor", "background-color", NULL},
+    {ELEMENT_TH, "height", "height", "<length>"},
+    {ELEMENT_TH, "nowrap", "white-space", "nowrap"},
+    {ELEMENT_TH, "valign", "vertical-align", NULL},
+    {ELEMENT_TH, "width", "width", "<length>"},
+    {ELEMENT_THEAD, "align", "text-align", NULL},
+    {ELEMENT_THEAD, "valign", "vertical-align", NULL},
+    {ELEMENT_TR, "align", "text-align", NULL},
+    {ELEMENT_TR, "bgcolor", "background-color", NULL},
+    {ELEMENT_TR, "height", "height", "<length>"},
+    {ELEMENT_TR, "valign", "vertical-align", NULL},
+    {ELEMENT_VIDEO, "height", "height", "<length>"},
+    {ELEMENT_VIDEO, "width", "width", "<length>"},
+};
+
+static const bem_attribute_range bem_default_mapping_ranges[ELEMENT_MAX] = {
+    [ELEMENT_BODY] = {0, 2},
+    [ELEMENT_CANVAS] = {2, 2},
+    [ELEMENT_COL] = {4, 3},
+    [ELEMENT_COLGROUP] = {7, 3},
+    [ELEMENT_DIV] = {10, 1},
+    [ELEMENT_EMBED] = {11, 2},
+    [ELEMENT_FONT] = {13, 3},
+    [ELEMENT_H1] = {16, 1},
+    [ELEMENT_H2] = {17, 1},
+    [ELEMENT_H3] = {18, 1},
+    [ELEMENT_H4] = {19, 1},
+    [ELEMENT_H5] = {20, 1},
+    [ELEMENT_H6] = {21, 1},
+    [ELEMENT_HR] = {22, 3},
+    [ELEMENT_IFRAME] = {25, 2},
+    [ELEMENT_IMG] = {27, 14},
+    [ELEMENT_OBJECT] = {41, 2},
+    [ELEMENT_P] = {43, 1},
+    [ELEMENT_TABLE] = {44, 12},
+    [ELEMENT_TBODY] = {56, 2},
+    [ELEMENT_TD] = {58, 6},
+    [ELEMENT_TFOOT] = {64, 2},
+    [ELEMENT_TH] = {66, 6},
+    [ELEMENT_THEAD] = {72, 2},
+    [ELEMENT_TR] = {74, 4},
+    [ELEMENT_VIDEO] = {78, 2},
+};
+
+static const bem_stylesheet bem_default_css = {
+    .all_rules = {0, 0, 199, (bem_rule_set **)bem_default_all_rules},
+    .rules = {
+        [ELEMENT_WILDCARD] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 0},
+        [ELEMENT_A] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 1},
+        [ELEMENT_ABBR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 3},
+        [ELEMENT_ACRONYM] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 4},
+        [ELEMENT_ADDRESS] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 5},
+        [ELEMENT_AREA] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 7},
+        [ELEMENT_ARTICLE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 8},
+        [ELEMENT_ASIDE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 9},
+        [ELEMENT_B] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 10},
+        [ELEMENT_BASE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 11},
+        [ELEMENT_BASEFONT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 12},
+        [ELEMENT_BIG] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 13},
+        [ELEMENT_BLOCKQUOTE] = {0, 0, 3, (bem_rule_set **)bem_default_element_rules + 14},
+        [ELEMENT_BODY] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 17},
+        [ELEMENT_BR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 19},
+        [ELEMENT_BUTTON] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 20},
+        [ELEMENT_CAPTION] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 21},
+        [ELEMENT_CENTER] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 22},
+        [ELEMENT_CITE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 24},
+        [ELEMENT_CODE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 25},
+        [ELEMENT_COL] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 26},
+        [ELEMENT_COLGROUP] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 27},
+        [ELEMENT_DATALIST] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 28},
+        [ELEMENT_DD] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 29},
+        [ELEMENT_DEL] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 31},
+        [ELEMENT_DETAILS] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 32},
+        [ELEMENT_DFN] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 33},
+        [ELEMENT_DIALOG] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 34},
+        [ELEMENT_DIR] = {0, 0, 13, (bem_rule_set **)bem_default_element_rules + 35},
+        [ELEMENT_DIV] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 48},
+        [ELEMENT_DL] = {0, 0, 7, (bem_rule_set **)bem_default_element_rules + 49},
+        [ELEMENT_DT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 56},
+        [ELEMENT_EM] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 57},
+        [ELEMENT_FIELDSET] = {0, 0, 3, (bem_rule_set **)bem_default_element_rules + 58},
+        [ELEMENT_FIGCAPTION] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 61},
+        [ELEMENT_FIGURE] = {0, 0, 3, (bem_rule_set **)bem_default_element_rules + 62},
+        [ELEMENT_FOOTER] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 65},
+        [ELEMENT_FORM] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 66},
+        [ELEMENT_FRAMESET] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 67},
+        [ELEMENT_H1] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 68},
+        [ELEMENT_H2] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 70},
+        [ELEMENT_H3] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 72},
+        [ELEMENT_H4] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 74},
+        [ELEMENT_H5] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 76},
+        [ELEMENT_H6] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 78},
+        [ELEMENT_HEAD] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 80},
+        [ELEMENT_HEADER] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 81},
+        [ELEMENT_HR] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 82},
+        [ELEMENT_HTML] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 84},
+        [ELEMENT_I] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 86},
+        [ELEMENT_INPUT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 87},
+        [ELEMENT_INS] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 88},
+        [ELEMENT_KBD] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 89},
+        [ELEMENT_LEGEND] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 90},
+        [ELEMENT_LI] = {0, 0, 7, (bem_rule_set **)bem_default_element_rules + 92},
+        [ELEMENT_LINK] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 99},
+        [ELEMENT_MAIN] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 100},
+        [ELEMENT_MARK] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 101},
+        [ELEMENT_MENU] = {0, 0, 13, (bem_rule_set **)bem_default_element_rules + 102},
+        [ELEMENT_META] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 115},
+        [ELEMENT_NAV] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 116},
+        [ELEMENT_NOBR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 117},
+        [ELEMENT_NOFRAMES] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 118},
+        [ELEMENT_OL] = {0, 0, 14, (bem_rule_set **)bem_default_element_rules + 119},
+        [ELEMENT_P] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 133},
+        [ELEMENT_PARAM] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 135},
+        [ELEMENT_PRE] = {0, 0, 3, (bem_rule_set **)bem_default_element_rules + 136},
+        [ELEMENT_Q] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 139},
+        [ELEMENT_S] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 141},
+        [ELEMENT_SAMP] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 142},
+        [ELEMENT_SCRIPT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 143},
+        [ELEMENT_SECTION] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 144},
+        [ELEMENT_SELECT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 145},
+        [ELEMENT_SMALL] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 146},
+        [ELEMENT_STRIKE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 147},
+        [ELEMENT_STRONG] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 148},
+        [ELEMENT_STYLE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 149},
+        [ELEMENT_SUB] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 150},
+        [ELEMENT_SUMMARY] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 151},
+        [ELEMENT_SUP] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 152},
+        [ELEMENT_TABLE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 153},
+        [ELEMENT_TBODY] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 154},
+        [ELEMENT_TD] = {0, 0, 2, (bem_rule_set **)bem_default_element_rules + 155},
+        [ELEMENT_TEMPLATE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 157},
+        [ELEMENT_TEXTAREA] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 158},
+        [ELEMENT_TFOOT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 159},
+        [ELEMENT_TH] = {0, 0, 3, (bem_rule_set **)bem_default_element_rules + 160},
+        [ELEMENT_THEAD] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 163},
+        [ELEMENT_TITLE] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 164},
+        [ELEMENT_TR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 165},
+        [ELEMENT_TT] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 166},
+        [ELEMENT_U] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 167},
+        [ELEMENT_UL] = {0, 0, 29, (bem_rule_set **)bem_default_element_rules + 168},
+        [ELEMENT_VAR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 197},
+        [ELEMENT_WBR] = {0, 0, 1, (bem_rule_set **)bem_default_element_rules + 198},
+    }};
+
+
+void bemCSSDelete(bem_stylesheet *css)
+{
+    size_t i;
+    int element;
+
+    // Layers keep their parents alive, so the last reference frees the stylesheet
+    if (!css || --css->references > 0)
+        return;
+
+    if (css->mapping)
     {
-        if ((ptr = realloc(dictionary->pairs, (dictionary->pairs_size + 4) * sizeof(bem_pair))) == NULL)
-            return;
+        // Rules and collections all live in the mapping
+        munmap(css->mapping, css->mapping_size);
+    }
+    else
+    {
+        // all_rules owns every rule, the per-element collections only point at them
+        bemRuleCollectionClear(&css->all_rules, 1);
 
-        dictionary->pairs_size += 4;
-        dictionary->pairs = ptr;
+        for (element = 0; element < ELEMENT_MAX; element++)
+            bemRuleCollectionClear(css->rules + element, 0);
     }
 
-    ptr = dictionary->pairs + dictionary->pair_amount;
-    dictionary->pair_amount++;
+    for (i = 0; i < css->condition_amount; i++)
+        bemClearMedia(css->conditions + i);
 
-    ptr->key = bemPoolGetString(dictionary->pool, key);
-    ptr->value = bemPoolGetString(dictionary->pool, value);
+    free(css->conditions);
+    free(css->media_active);
 
-    qsort(dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs);
-}
+    if (css->parent && css->parent != &bem_default_css)
+        bemCSSDelete((bem_stylesheet *)css->parent);
 
-static int bemComparePairs(bem_pair *a, bem_pair *b)
-{
-    return strcasecmp(a->key, b->key);
+    free(css);
 }
 
-void bemPoolDelete(bem_memory_pool *pool)
+bool bemCSSImport(bem_stylesheet *css, bem_file *file)
 {
-    if (pool)
+    if (!css || !file)
+        return false;
+
+    // Layers on top rely on their parents never changing
+    if (css->references > 1)
     {
-        // TODO: if (pool->font_amount > 0) bemPoolDeleteFonts(pool);
+        bemPoolError(css->pool, 0, "Unable to import into a stylesheet that other layers use.");
+        return false;
+    }
 
-        if (pool->font_amount > 0)
-        {
-            size_t i;
-            char **temp;
+    return bemImportStylesheet(css, file, 0, 0);
+}
 
-            for (i = pool->string_amount, temp = pool->strings; i > 0; i--, temp++)
-                free(*temp);
+bool bemCSSImportDefault(bem_stylesheet *css)
+{
+    if (!css)
+        return false;
 
-            free(pool->strings);
-        }
+    // The defaults are compiled into bem_default_css, so importing them only links the shared layer
+    if (!css->parent)
+        css->parent = &bem_default_css;
 
-        free(pool->last_error);
-        free(pool);
-    }
+    return true;
 }
 
-bool bemPoolError(bem_memory_pool *pool, int line_number, const char *message, ...)
+bem_stylesheet *bemCSSLoad(bem_memory_pool *pool, const char *filename, const bem_sha3_256 hash)
 {
-    bool result;
+    bem_stylesheet *css;
 
-    va_list ap;
-    va_start(ap, message);
-    result = bemPoolErrorv(pool, line_number, message, ap);
-    va_end(ap);
+    if (!pool || !filename)
+        return NULL;
 
-    return result;
+    if ((css = bemCSSNew(pool)) != NULL && !bemMapCSS(css, filename, hash))
+    {
+        bemCSSDelete(css);
+        css = NULL;
+    }
+
+    return (css);
 }
 
-bool bemPoolErrorv(bem_memory_pool *pool, int line_number, const char *message, va_list ap)
+bem_stylesheet *bemCSSNew(bem_memory_pool *pool)
 {
-    char buffer[8192];
+    bem_stylesheet *css;
 
-    vsnprintf(buffer, sizeof(buffer), message, ap);
-    free(pool->last_error);
-    pool->last_error = strdup(buffer);
+    if (!pool)
+        return NULL;
 
-    return (pool->error_callback)(pool->error_context, buffer, line_number);
-}
+    if ((css = (bem_stylesheet *)calloc(1, sizeof(bem_stylesheet))) != NULL)
+    {
+        css->pool = pool;
+        css->parent = &bem_default_css;
+        css->references = 1;
+        css->media_pruning = true;
+        css->generation = 1;
 
-const char *bemPoolGetLastError(bem_memory_pool *pool)
-{
-    return pool ? pool->last_error : NULL;
+        bemCSSSetMedia(css, "print", 8, 2, 612.0f, 792.0f);
+    }
+
+    return (css);
 }
 
-const char *bemPoolGetString(bem_memory_pool *pool, const char *str)
+bem_stylesheet *bemCSSNewLayer(bem_stylesheet *parent)
 {
-    char *news, **temp;
+    bem_stylesheet *css;
 
-    if (!pool || !str)
-    {
+    if (!parent)
         return NULL;
-    }
-    else if (!*str)
+
+    // The new layer only holds its own rules, matching falls through to the parent's
+    if ((css = bemCSSNew(parent->pool)) != NULL)
     {
-        return "";
+        css->parent = parent;
+        css->media = parent->media;
+        parent->references++;
     }
 
-    if (pool->string_amount == 1 && !strcmp(pool->strings[0], str))
+    return (css);
+}
+
+bool bemCSSSave(bem_stylesheet *css, const char *filename)
+{
+    bem_css_file_header header;
+    bem_css_strings strings;
+    bem_uchar *data;
+    bem_rule_set *rule, *rules;
+    bem_stylesheet_selector *selectors, *selector;
+    const bem_stylesheet_selector *current;
+    bem_stylesheet_selector_statement *statements;
+    bem_dictionary *dictionaries;
+    bem_pair *pairs;
+    size_t i, j, k, depth, selector_index = 0, statement_index = 0, pair_index = 0, element_index[ELEMENT_MAX];
+    size_t *all_rules, *element_rules, *conditions;
+    bem_write_span spans[3];
+    bool written;
+
+    if (!css || !filename)
+        return false;
+
+    if (css->all_rules.needs_sorting)
     {
-        return pool->strings[0];
+        qsort(css->all_rules.rules, css->all_rules.rules_amount, sizeof(bem_rule_set *), (bem_comparison_function)bemCompareRules);
+        css->all_rules.needs_sorting = 0;
     }
-    else if (pool->string_amount > 1)
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "BEMCSS\0\0", 8);
+    header.version = BEM_CSS_FILE_VERSION;
+    header.sizes[0] = sizeof(void *);
+    header.sizes[1] = sizeof(bem_rule_set);
+    header.sizes[2] = sizeof(bem_stylesheet_selector);
+    header.sizes[3] = sizeof(bem_stylesheet_selector_statement);
+    header.sizes[4] = sizeof(bem_dictionary);
+    header.sizes[5] = sizeof(bem_pair);
+    memcpy(header.hash, css->hash, sizeof(header.hash));
+    header.rule_amount = css->all_rules.rules_amount;
+    header.condition_amount = css->condition_amount;
+
+    for (i = 0; i < header.rule_amount; i++)
     {
-        if ((temp = bsearch(&str, pool->strings, pool->string_amount, sizeof(char *), (bem_comparison_function)bemCompareStrings)) != NULL)
+        rule = css->all_rules.rules[i];
+
+        for (current = rule->selector; current; current = current->previous)
         {
-            return *temp;
+            header.selector_amount++;
+            header.statement_amount += current->statement_amount;
         }
+
+        header.pair_amount += bemDictionaryGetCount(rule->properties);
+        header.element_starts[rule->selector->element + 1]++;
     }
 
-    if (pool->string_amount >= pool->strings_size)
+    for (i = 0; i < ELEMENT_MAX; i++)
+        header.element_starts[i + 1] += header.element_starts[i];
+
+    // Every table starts on a 16-byte boundary and the strings come last
+    header.rules = (sizeof(header) + 15) & ~(size_t)15;
+    header.selectors = (header.rules + header.rule_amount * sizeof(bem_rule_set) + 15) & ~(size_t)15;
+    header.statements = (header.selectors + header.selector_amount * sizeof(bem_stylesheet_selector) + 15) & ~(size_t)15;
+    header.dictionaries = (header.statements + header.statement_amount * sizeof(bem_stylesheet_selector_statement) + 15) & ~(size_t)15;
+    header.pairs = (header.dictionaries + header.rule_amount * sizeof(bem_dictionary) + 15) & ~(size_t)15;
+    header.all_rules = (header.pairs + header.pair_amount * sizeof(bem_pair) + 15) & ~(size_t)15;
+    header.element_rules = header.all_rules + header.rule_amount * sizeof(size_t);
+    header.conditions = header.element_rules + header.rule_amount * sizeof(size_t);
+    header.strings = header.conditions + 2 * header.condition_amount * sizeof(size_t);
+
+    if ((data = (bem_uchar *)calloc(1, header.strings)) == NULL)
+        return false;
+
+    rules = (bem_rule_set *)(data + header.rules);
+    selectors = (bem_stylesheet_selector *)(data + header.selectors);
+    statements = (bem_stylesheet_selector_statement *)(data + header.statements);
+    dictionaries = (bem_dictionary *)(data + header.dictionaries);
+    pairs = (bem_pair *)(data + header.pairs);
+    all_rules = (size_t *)(data + header.all_rules);
+    element_rules = (size_t *)(data + header.element_rules);
+    conditions = (size_t *)(data + header.conditions);
+
+    memset(&strings, 0, sizeof(strings));
+    memcpy(element_index, header.element_starts, sizeof(element_index));
+
+    // Pointers are written as file offsets and fixed up by bemMapCSS(), strings are offset by header.strings
+    bemAddString(&strings, "");
+
+    // Media conditions are stored as their text and compiled again when mapped
+    for (i = 0; i < header.condition_amount; i++)
     {
-        if ((temp = realloc(pool->strings, (pool->strings_size + 32) * sizeof(char *))) == NULL)
-            return NULL;
-
-        pool->strings_size += 32;
-        pool->strings = temp;
+        conditions[2 * i] = header.strings + bemAddString(&strings, css->conditions[i].text);
+        conditions[2 * i + 1] = css->conditions[i].parent;
     }
 
-    temp = pool->strings + pool->string_amount;
-    *temp = news = strdup(str);
-    pool->string_amount++;
+    for (i = 0; i < header.rule_amount; i++)
+    {
+        rule = css->all_rules.rules[i];
 
-    if (pool->string_amount > 1)
-        qsort(pool->strings, pool->string_amount, sizeof(char *), (bem_comparison_function)bemCompareStrings);
+        for (depth = 0, current = rule->selector; current; current = current->previous)
+            depth++;
 
-    return news;
-}
+        // Chains are stored leftmost first, so previous always points backwards in the table
+        for (j = 0, current = rule->selector; current; current = current->previous, j++)
+        {
+            selector = selectors + selector_index + depth - 1 - j;
+            selector->previous = current->previous ? (struct bem_stylesheet_selector *)(uintptr_t)(header.selectors + (selector_index + depth - 2 - j) * sizeof(bem_stylesheet_selector)) : NULL;
+            selector->element = current->element;
+            selector->relation = current->relation;
+            selector->statement_amount = current->statement_amount;
+            selector->statements = current->statement_amount ? (bem_stylesheet_selector_statement *)(uintptr_t)(header.statements + statement_index * sizeof(bem_stylesheet_selector_statement)) : NULL;
+
+            for (k = 0; k < current->statement_amount; k++, statement_index++)
+            {
+                statements[statement_index].match = current->statements[k].match;
+                statements[statement_index].name = (const char *)(uintptr_t)(header.strings + bemAddString(&strings, current->statements[k].name));
+                statements[statement_index].value = current->statements[k].value ? (const char *)(uintptr_t)(header.strings + bemAddString(&strings, current->statements[k].value)) : NULL;
+            }
+        }
 
-const char *bemPoolGetURL(bem_memory_pool *pool, const char *url, const char *base_url)
-{
-    const char *mapped;
-    char *ptr, temp[1024], new_url[1024];
+        memcpy(rules[i].hash, rule->hash, sizeof(rules[i].hash));
+        rules[i].order = rule->order;
+        rules[i].condition = rule->condition;
+        rules[i].selector = (bem_stylesheet_selector *)(uintptr_t)(header.selectors + (selector_index + depth - 1) * sizeof(bem_stylesheet_selector));
+        rules[i].properties = (struct bem_dictionary *)(uintptr_t)(header.dictionaries + i * sizeof(bem_dictionary));
+        selector_index += depth;
 
-    if (*url == '/')
-    {
-        if (!base_url)
+        dictionaries[i].pair_amount = dictionaries[i].pairs_size = bemDictionaryGetCount(rule->properties);
+        dictionaries[i].pairs = dictionaries[i].pair_amount ? (bem_pair *)(uintptr_t)(header.pairs + pair_index * sizeof(bem_pair)) : NULL;
+
+        for (k = 0; k < dictionaries[i].pair_amount; k++, pair_index++)
         {
-            return bemPoolGetString(pool, url);
+            pairs[pair_index].key = (const char *)(uintptr_t)(header.strings + bemAddString(&strings, rule->properties->pairs[k].key));
+            pairs[pair_index].value = (const char *)(uintptr_t)(header.strings + bemAddString(&strings, rule->properties->pairs[k].value));
         }
-        else if (!strncmp(base_url, "http://", 7))
-        {
-            strncpy(temp, base_url, sizeof(temp) - 1);
-            temp[sizeof(temp) - 1] = '\0';
 
-            if ((ptr = strchr(temp + 7, '/')) != NULL)
-                *ptr = '\0';
+        // all_rules is in hash order, so every per-element range is too
+        all_rules[i] = header.rules + i * sizeof(bem_rule_set);
+        element_rules[element_index[rule->selector->element]++] = all_rules[i];
+    }
 
-            snprintf(new_url, sizeof(new_url), "%s%s", temp, url);
-            url = new_url;
-        }
-        else if (!strncmp(base_url, "https://", 8))
-        {
-            strncpy(temp, base_url, sizeof(temp) - 1);
-            temp[sizeof(temp) - 1] = '\0';
+    header.size = header.strings + strings.length;
+    memcpy(data, &header, sizeof(header));
 
-            if ((ptr = strchr(temp + 8, '/')) != NULL)
-                *ptr = '\0';
-
-            snprintf(new_url, sizeof(new_url), "%s%s", temp, url);
-            url = new_url;
-        }
-        else
-        {
-            return bemPoolGetString(pool, url);
-        }
-    }
-    else if (strncmp(url, "http://", 7) && strncmp(url, "https://", 8))
-    {
-        if (!base_url)
-        {
-            getcwd(temp, sizeof(temp));
-            snprintf(new_url, sizeof(new_url), "%s/%s", temp, url);
-
-            return bemPoolGetString(pool, new_url);
-        }
-        else
-        {
-            strncpy(temp, base_url, sizeof(temp) - 1);
-            temp[sizeof(temp) - 1] = '\0';
-
-            if ((ptr = strrchr(temp, '/')) != NULL)
-                *ptr = '\0';
-
-            snprintf(new_url, sizeof(new_url), "%s/%s", temp, url);
-
-            if (new_url[0] == '/')
-                return (bemPoolGetString(pool, new_url));
-
-            url = new_url;
-        }
-    }
+    spans[0].data = data;
+    spans[0].length = header.strings;
+    spans[1].data = strings.data;
+    spans[1].length = strings.length;
+    spans[2].data = NULL;
 
-    if ((mapped = (pool->url_callback)(pool->url_context, url, temp, sizeof(temp))) != NULL)
-    {
-        if (!pool->urls)
-            pool->urls = bemDictionaryNew(pool);
+    written = !strings.failed && bemWriteFile(filename, (bem_write_function)bemWriteSpans, spans);
 
-        bemDictionarySetKeyValue(pool->urls, url, temp);
-        mapped = bemPoolGetString(pool, temp);
-    }
+    free(data);
+    free(strings.data);
+    free(strings.keys);
+    free(strings.offsets);
 
-    return (mapped);
+    return written;
 }
 
-bem_memory_pool *bemPoolNew(void)
+int bemCSSSetMedia(bem_stylesheet *css, const char *type, int color_bits, int grayscale_bits, float width, float height)
 {
-    bem_memory_pool *pool = (bem_memory_pool *)calloc(1, sizeof(bem_memory_pool));
-
-    if (pool)
-    {
-        if ((pool->locale = localeconv()) != NULL)
-        {
-            if (!pool->locale->decimal_point || !strcmp(pool->locale->decimal_point, "."))
-            {
-                pool->locale = NULL;
-            }
-            else
-            {
-                pool->locale_decimal_length = strlen(pool->locale->decimal_point);
-            }
-        }
+    if (!css || !type || color_bits < 1 || grayscale_bits < 1 || width <= 0.0f || height <= 0.0f)
+        return 0;
 
-        pool->error_callback = bemDefaultErrorCallback;
-        pool->url_callback = bemDefaultURLCallback;
-    }
+    css->media.type = bemPoolGetString(css->pool, type);
+    css->media.color_bits = color_bits;
+    css->media.monochrome_bits = grayscale_bits;
+    css->media.size.width = width;
+    css->media.size.height = height;
+    css->generation++;
 
-    return (pool);
+    return 1;
 }
 
-void bemPoolSetErrorCallback(bem_memory_pool *pool, bem_error_callback callback, void *context)
+void bemCSSSetMediaPruning(bem_stylesheet *css, bool prune)
 {
-    if (!pool)
+    if (!css)
         return;
 
-    pool->error_callback = callback ? callback : bemDefaultErrorCallback;
-    pool->error_context = context;
+    // Without pruning every @media block is kept and re-evaluated whenever the media changes
+    css->media_pruning = prune;
 }
 
-void bemPoolSetURLCallback(bem_memory_pool *pool, bem_url_callback callback, void *context)
+static void bemApplyMappings(bem_node *node, bem_dictionary *properties)
 {
-    if (!pool)
-        return;
+    static const char *const font_sizes[] = {"x-small", "small", "medium", "large", "x-large", "xx-large", "xxx-large"};
+    const bem_attribute_range *range = bem_default_mapping_ranges + node->element;
+    const bem_attribute_mapping *mapping, *end;
+    const char *attribute = NULL, *value;
+    char temp[64], *pointer;
+    long size;
+
+    // The element's mappings are sorted by attribute, so every attribute is looked up once
+    for (mapping = bem_default_mappings + range->start, end = mapping + range->amount; mapping < end; mapping++)
+    {
+        if (mapping == bem_default_mappings + range->start || strcmp(mapping->attribute_name, mapping[-1].attribute_name))
+            attribute = bemDictionaryGetKeyValue(node->value.element.attributes, mapping->attribute_name);
 
-    pool->url_callback = callback ? callback : bemDefaultURLCallback;
-    pool->url_context = context;
-}
+        if ((value = attribute) == NULL)
+            continue;
 
-static int bemCompareStrings(char **a, char **b)
-{
-    return (strcmp(*a, *b));
-}
+        if (!mapping->property_value)
+        {
+            if (!*value)
+                continue;
+        }
+        else if (!strcmp(mapping->property_value, "<length>"))
+        {
+            // HTML lengths are pixels or percentages, anything after the number is ignored
+            while (isspace(*value & 255))
+                value++;
 
-void bemImageDelete(bem_image *image)
-{
-    free(image);
-}
+            if (!isdigit(*value & 255))
+                continue;
 
-const char *bemImageGetFormat(bem_image *image)
-{
-    return (image ? image->format : NULL);
-}
+            for (pointer = temp; (isdigit(*value & 255) || *value == '.') && pointer < temp + sizeof(temp) - 3; value++)
+                *pointer++ = *value;
 
-int bemImageGetHeight(bem_image *image)
-{
-    return (image ? image->height : 0);
-}
+            strcpy(pointer, *value == '%' ? "%" : "px");
+            value = temp;
+        }
+        else if (!strcmp(mapping->property_value, "<font-size>"))
+        {
+            // 1 to 7 with 3 being the default size, or relative to it with a sign
+            while (isspace(*value & 255))
+                value++;
 
-bem_size bemImageGetSize(bem_image *image)
-{
-    bem_size size;
+            size = strtol(value, &pointer, 10);
 
-    if (image)
-    {
-        if (image->x_resolution > 0 && image->y_resolution > 0 && image->units != RESOLUTION_NONE)
-        {
-            if (image->units == RESOLUTION_PER_INCH)
-            {
-                size.width = 72.0f * image->width / image->x_resolution;
-                size.height = 72.0f * image->height / image->y_resolution;
-            }
-            else
-            {
-                size.width = 72.0f / 2.54f * image->width / image->x_resolution;
-                size.height = 72.0f / 2.54f * image->height / image->y_resolution;
-            }
+            if (pointer == value)
+                continue;
+            else if (*value == '+' || *value == '-')
+                size += 3;
+
+            value = font_sizes[size < 1 ? 0 : size > 7 ? 6 : size - 1];
         }
         else
         {
-            size.width = 0.72f * image->width;
-            size.height = 0.72f * image->height;
+            value = mapping->property_value;
         }
-    }
-    else
-    {
-        size.width = 0.0f;
-        size.height = 0.0f;
-    }
 
-    return (size);
+        bemDictionarySetKeyValue(properties, mapping->property_name, value);
+    }
 }
 
-int bemImageGetWidth(bem_image *image)
+static int bemCompareRules(bem_rule_set **a, bem_rule_set **b)
 {
-    return (image ? image->width : 0);
+    return memcmp((*a)->hash, (*b)->hash, sizeof((*a)->hash));
 }
 
-bem_image *bemImageNew(bem_memory_pool *pool, bem_file *file)
+static int bemCompareMatches(bem_stylesheet_match *a, bem_stylesheet_match *b)
 {
-    bem_image *image;
-    unsigned char buffer[2048];
-    size_t bytes;
+    // Lowest priority first, so applying them in order lets the winners overwrite
+    if (a->score != b->score)
+        return a->score < b->score ? -1 : 1;
+    else if (a->layer != b->layer)
+        return a->layer < b->layer ? -1 : 1;
+    else if (a->order != b->order)
+        return a->order < b->order ? -1 : 1;
+    else
+        return 0;
+}
 
-    if (!pool || !file)
-        return NULL;
+// Properties an element takes from its parent unless its own rules set them, at most 64
+static const char *const bem_inherited_properties[] = {"border-collapse", "border-spacing", "caption-side", "color", "cursor", "direction", "empty-cells", "font", "font-family", "font-size", "font-stretch", "font-style", "font-variant", "font-weight", "letter-spacing", "line-height", "list-style", "list-style-image", "list-style-position", "list-style-type", "orphans", "quotes", "tab-size", "text-align", "text-indent", "text-transform", "visibility", "white-space", "widows", "word-break", "word-spacing", "word-wrap"};
 
-    if ((image = (bem_image *)calloc(1, sizeof(bem_image))) == NULL)
+static const bem_dictionary *bemCreateProperties(bem_node *node, bem_compute compute)
+{
+    static const char *const pseudo_elements[] = {NULL, "before", "after", "first-line", "first-letter"};
+    bem_document *html = node->value.element.html;
+    const bem_stylesheet *layer;
+    const bem_rule_collection *collection;
+    const bem_dictionary *parent_properties = NULL;
+    const char *pseudo_class = pseudo_elements[compute], *key, *value;
+    bem_stylesheet_match *matches = NULL, *temp;
+    bem_dictionary *properties;
+    const bool *active;
+    size_t i, j, match_amount = 0, matches_size = 0, base;
+    int depth, layer_number, score;
+    unsigned long long inherited = 0;
+    bool hints;
+
+    if ((properties = bemDictionaryNew(html->pool)) == NULL)
         return NULL;
 
-    image->pool = pool;
+    // Pseudo-elements inherit from their element, elements from their parent
+    if (compute != COMPUTE_BASE)
+        parent_properties = bemNodeComputeCSSProperties(node, COMPUTE_BASE);
+    else if (node->parent && node->parent->element > ELEMENT_DOCTYPE)
+        parent_properties = bemNodeComputeCSSProperties(node->parent, COMPUTE_BASE);
 
-    // TODO: bytes = bemFileRead(file, buffer, sizeof(buffer));
+    // Gather matching rules from every layer, the bottom layer without a parent is the user agent's
+    for (depth = 0, layer = html->css; layer; layer = layer->parent)
+        depth++;
 
-    if (bytes > 27 && !memcmp(buffer, "\211PNG\015\012\032\012\000\000\000\015IHDR", 16))
-    {
-        image->format = "image/png";
-        image->width = (buffer[16] << 24) | (buffer[17] << 16) | (buffer[18] << 8) | buffer[19];
-        image->height = (buffer[20] << 24) | (buffer[21] << 16) | (buffer[22] << 8) | buffer[23];
-    }
-    else if (bytes > 12 && (!memcmp(buffer, "GIF87a", 6) || !memcmp(buffer, "GIF89a", 6)))
-    {
-        image->format = "image/gif";
-        image->width = (buffer[7] << 8) | buffer[6];
-        image->height = (buffer[9] << 8) | buffer[8];
-    }
-    else if (bytes > 3 && !memcmp(buffer, "\377\330\377", 3))
-    {
-        unsigned char *buffer_ptr = buffer + 2, *buffer_end = buffer + bytes;
-        size_t length;
+    if (html->css->media_generation != html->css->generation)
+        bemUpdateMedia(html->css);
 
-        image->format = "image/jpeg";
+    active = html->css->media_generation == html->css->generation ? html->css->media_active : NULL;
 
-        while (buffer_ptr < buffer_end)
+    for (layer_number = depth - 1, layer = html->css, base = 0; layer; base += layer->condition_amount, layer = layer->parent, layer_number--)
+    {
+        for (collection = layer->rules + node->element; collection; collection = collection == layer->rules + ELEMENT_WILDCARD ? NULL : layer->rules + ELEMENT_WILDCARD)
         {
-            if (*buffer_ptr == 0xff)
+            for (i = 0; i < collection->rules_amount; i++)
             {
-                buffer_ptr++;
+                if (collection->rules[i]->condition && (!active || !active[base + collection->rules[i]->condition - 1]))
+                    continue;
+
+                if ((score = bemMatchRule(node, collection->rules[i], pseudo_class)) < 0)
+                    continue;
 
-                if (buffer_ptr >= buffer_end)
+                if (match_amount >= matches_size)
                 {
-                    /*
-                    TODO:
-                    if ((bytes = bemFileRead(file, buffer, sizeof(buffer))) == 0)
+                    if ((temp = (bem_stylesheet_match *)realloc(matches, (matches_size + 32) * sizeof(bem_stylesheet_match))) == NULL)
                         break;
-                    */
 
-                    buffer_ptr = buffer;
-                    buffer_end = buffer + bytes;
+                    matches = temp;
+                    matches_size += 32;
                 }
 
-                if (*buffer_ptr == 0xff)
-                    continue;
+                matches[match_amount].score = layer->parent ? score | (1 << 24) : score;
+                matches[match_amount].layer = layer_number;
+                matches[match_amount].order = (int)collection->rules[i]->order;
+                matches[match_amount++].rule = collection->rules[i];
+            }
+        }
+    }
 
-                if ((buffer_ptr + 16) >= buffer_end)
-                {
-                    bytes = (size_t)(buffer_end - buffer_ptr);
+    if (match_amount > 1)
+        qsort(matches, match_amount, sizeof(bem_stylesheet_match), (bem_comparison_function)bemCompareMatches);
 
-                    memmove(buffer, buffer_ptr, bytes);
-                    buffer_ptr = buffer;
-                    buffer_end = buffer + bytes;
+    // Presentational attributes override the user agent's rules and lose to every author rule
+    for (i = 0, hints = compute != COMPUTE_BASE; i <= match_amount; i++)
+    {
+        if (!hints && (i == match_amount || matches[i].score >= (1 << 24)))
+        {
+            bemApplyMappings(node, properties);
+            hints = true;
+        }
 
-                    /*
-                    TODO:
-                    if ((bytes = bemFileRead(file, buffer_end, sizeof(buffer) - bytes)) == 0)
-                        break;
-                    */
+        for (j = 0; i < match_amount && j < bemDictionaryGetCount(matches[i].rule->properties); j++)
+            bemDictionarySetKeyValue(properties, matches[i].rule->properties->pairs[j].key, matches[i].rule->properties->pairs[j].value);
+    }
 
-                    buffer_end += bytes;
-                }
-                length = (size_t)((buffer_ptr[1] << 8) | buffer_ptr[2]);
+    free(matches);
 
-                if (*buffer_ptr == 0xe0 && length >= 16 && !memcmp(buffer_ptr + 3, "JFIF", 5))
-                {
-                    if (buffer_ptr[10] == 1)
-                    {
-                        image->units = RESOLUTION_PER_INCH;
-                        image->x_resolution = (buffer_ptr[11] << 8) | buffer_ptr[12];
-                        image->y_resolution = (buffer_ptr[13] << 8) | buffer_ptr[14];
-                    }
-                    else if (buffer_ptr[10] == 2)
-                    {
-                        image->units = RESOLUTION_PER_CM;
-                        image->x_resolution = (buffer_ptr[11] << 8) | buffer_ptr[12];
-                        image->y_resolution = (buffer_ptr[13] << 8) | buffer_ptr[14];
-                    }
-                }
-                else if ((*buffer_ptr >= 0xc0 && *buffer_ptr <= 0xc3) ||
-                         (*buffer_ptr >= 0xc5 && *buffer_ptr <= 0xc7) ||
-                         (*buffer_ptr >= 0xc9 && *buffer_ptr <= 0xcb) ||
-                         (*buffer_ptr >= 0xcd && *buffer_ptr <= 0xcf))
-                {
+    // Inline styles beat every stylesheet rule
+    if (compute == COMPUTE_BASE && (value = bemDictionaryGetKeyValue(node->value.element.attributes, "style")) != NULL)
+        bemCSSImportString(html->css, properties, value);
 
-                    image->width = (buffer_ptr[6] << 8) | buffer_ptr[7];
-                    image->height = (buffer_ptr[4] << 8) | buffer_ptr[5];
-                    break;
-                }
+    // Inherited properties the element's own rules left out or set to "inherit" come from the parent, and remember which ones did
+    for (i = 0; i < bemDictionaryGetCount(parent_properties); i++)
+    {
+        key = parent_properties->pairs[i].key;
 
-                buffer_ptr++;
-                bytes = (size_t)(buffer_end - buffer_ptr);
+        for (j = 0; j < (sizeof(bem_inherited_properties) / sizeof(bem_inherited_properties[0])) && strcmp(key, bem_inherited_properties[j]); j++)
+            ;
 
-                while (length >= bytes)
-                {
-                    length -= bytes;
+        if (j == (sizeof(bem_inherited_properties) / sizeof(bem_inherited_properties[0])) && strncmp(key, "--", 2))
+            continue;
 
-                    /*
-                    TODO:
-                    if ((bytes = bemFileRead(file, buffer, sizeof(buffer))) == 0)
-                        break;
-                    */
+        if ((value = bemDictionaryGetKeyValue(properties, key)) != NULL && strcasecmp(value, "inherit"))
+            continue;
 
-                    buffer_ptr = buffer;
-                    buffer_end = buffer + bytes;
-                }
+        bemDictionarySetKeyValue(properties, key, parent_properties->pairs[i].value);
 
-                if (length > bytes)
-                    break;
+        if (j < (sizeof(bem_inherited_properties) / sizeof(bem_inherited_properties[0])))
+            inherited |= 1ULL << j;
+    }
 
-                buffer_ptr += length;
-            }
-        }
+    if (compute == COMPUTE_BASE)
+        node->value.element.inherited = inherited;
 
-        if (image->width == 0 || image->height == 0)
-        {
-            free(image);
-            return NULL;
-        }
-    }
-    else
+    // Resolve "inherit" last so it sees the parent's final values, going backwards so removals don't skip pairs
+    for (i = bemDictionaryGetCount(properties); i > 0; i--)
     {
-        free(image);
-        return NULL;
+        key = properties->pairs[i - 1].key;
+
+        if (strcasecmp(properties->pairs[i - 1].value, "inherit"))
+            continue;
+
+        if ((value = bemDictionaryGetKeyValue(parent_properties, key)) != NULL)
+            bemDictionarySetKeyValue(properties, key, value);
+        else
+            bemDictionaryRemoveKey(properties, key);
     }
 
-    return (image);
+    return (properties);
 }
 
-void bemFileDelete(bem_file *file)
+static void bemGetBorder(bem_memory_pool *pool, bem_stylesheet *css, const char *value, const bem_color *current, bem_border_properties *border, int which)
 {
-    if (!file)
-        return;
+    static const char *const styles[] = {"hidden", "none", "dotted", "dashed", "solid", "double", "groove", "ridge", "inset", "outset"};
+    size_t i;
 
-    if (file->file_pointer)
-        gzclose(file->file_pointer);
+    // which is 0 for a color, 1 for a style and 2 for a width
+    for (i = 0; i < sizeof(styles) / sizeof(styles[0]) && strcasecmp(value, styles[i]); i++)
+        ;
 
-    free(file);
+    if (i < sizeof(styles) / sizeof(styles[0]))
+    {
+        if (which == 1)
+            border->style = (bem_border_style)i;
+    }
+    else if (isdigit(*value & 255) || *value == '.' || !strcasecmp(value, "thin") || !strcasecmp(value, "medium") || !strcasecmp(value, "thick"))
+    {
+        if (which == 2)
+            border->width = bemGetLength(pool, value, 0.0f, 0.75f, css, NULL);
+    }
+    else if (which == 0)
+    {
+        if (!strcasecmp(value, "currentcolor"))
+            border->color = *current;
+        else
+            bemGetColor(pool, value, &border->color);
+    }
 }
 
-bool bemFileError(bem_file *file, const char *message, ...)
+static bool bemGetColor(bem_memory_pool *pool, const char *value, bem_color *color)
 {
-    bool result;
-    char sane_url[1024], *sane_pointer, temp[1024];
-    const char *url_pointer;
-    va_list ap;
+    static const struct
+    {
+        const char *name;
+        unsigned rgb;
+    } names[] = {
+        {"aliceblue", 0xf0f8ff}, {"antiquewhite", 0xfaebd7}, {"aqua", 0x00ffff}, {"aquamarine", 0x7fffd4}, {"azure", 0xf0ffff}, {"beige", 0xf5f5dc},
+        {"bisque", 0xffe4c4}, {"black", 0x000000}, {"blanchedalmond", 0xffebcd}, {"blue", 0x0000ff}, {"blueviolet", 0x8a2be2}, {"brown", 0xa52a2a},
+        {"burlywood", 0xdeb887}, {"cadetblue", 0x5f9ea0}, {"chartreuse", 0x7fff00}, {"chocolate", 0xd2691e}, {"coral", 0xff7f50}, {"cornflowerblue", 0x6495ed},
+        {"cornsilk", 0xfff8dc}, {"crimson", 0xdc143c}, {"cyan", 0x00ffff}, {"darkblue", 0x00008b}, {"darkcyan", 0x008b8b}, {"darkgoldenrod", 0xb8860b},
+        {"darkgray", 0xa9a9a9}, {"darkgreen", 0x006400}, {"darkgrey", 0xa9a9a9}, {"darkkhaki", 0xbdb76b}, {"darkmagenta", 0x8b008b}, {"darkolivegreen", 0x556b2f},
+        {"darkorange", 0xff8c00}, {"darkorchid", 0x9932cc}, {"darkred", 0x8b0000}, {"darksalmon", 0xe9967a}, {"darkseagreen", 0x8fbc8f}, {"darkslateblue", 0x483d8b},
+        {"darkslategray", 0x2f4f4f}, {"darkslategrey", 0x2f4f4f}, {"darkturquoise", 0x00ced1}, {"darkviolet", 0x9400d3}, {"deeppink", 0xff1493}, {"deepskyblue", 0x00bfff},
+        {"dimgray", 0x696969}, {"dimgrey", 0x696969}, {"dodgerblue", 0x1e90ff}, {"firebrick", 0xb22222}, {"floralwhite", 0xfffaf0}, {"forestgreen", 0x228b22},
+        {"fuchsia", 0xff00ff}, {"gainsboro", 0xdcdcdc}, {"ghostwhite", 0xf8f8ff}, {"gold", 0xffd700}, {"goldenrod", 0xdaa520}, {"gray", 0x808080},
+        {"green", 0x008000}, {"greenyellow", 0xadff2f}, {"grey", 0x808080}, {"honeydew", 0xf0fff0}, {"hotpink", 0xff69b4}, {"indianred", 0xcd5c5c},
+        {"indigo", 0x4b0082}, {"ivory", 0xfffff0}, {"khaki", 0xf0e68c}, {"lavender", 0xe6e6fa}, {"lavenderblush", 0xfff0f5}, {"lawngreen", 0x7cfc00},
+        {"lemonchiffon", 0xfffacd}, {"lightblue", 0xadd8e6}, {"lightcoral", 0xf08080}, {"lightcyan", 0xe0ffff}, {"lightgoldenrodyellow", 0xfafad2}, {"lightgray", 0xd3d3d3},
+        {"lightgreen", 0x90ee90}, {"lightgrey", 0xd3d3d3}, {"lightpink", 0xffb6c1}, {"lightsalmon", 0xffa07a}, {"lightseagreen", 0x20b2aa}, {"lightskyblue", 0x87cefa},
+        {"lightslategray", 0x778899}, {"lightslategrey", 0x778899}, {"lightsteelblue", 0xb0c4de}, {"lightyellow", 0xffffe0}, {"lime", 0x00ff00}, {"limegreen", 0x32cd32},
+        {"linen", 0xfaf0e6}, {"magenta", 0xff00ff}, {"maroon", 0x800000}, {"mediumaquamarine", 0x66cdaa}, {"mediumblue", 0x0000cd}, {"mediumorchid", 0xba55d3},
+        {"mediumpurple", 0x9370db}, {"mediumseagreen", 0x3cb371}, {"mediumslateblue", 0x7b68ee}, {"mediumspringgreen", 0x00fa9a}, {"mediumturquoise", 0x48d1cc}, {"mediumvioletred", 0xc71585},
+        {"midnightblue", 0x191970}, {"mintcream", 0xf5fffa}, {"mistyrose", 0xffe4e1}, {"moccasin", 0xffe4b5}, {"navajowhite", 0xffdead}, {"navy", 0x000080},
+        {"oldlace", 0xfdf5e6}, {"olive", 0x808000}, {"olivedrab", 0x6b8e23}, {"orange", 0xffa500}, {"orangered", 0xff4500}, {"orchid", 0xda70d6},
+        {"palegoldenrod", 0xeee8aa}, {"palegreen", 0x98fb98}, {"paleturquoise", 0xafeeee}, {"palevioletred", 0xdb7093}, {"papayawhip", 0xffefd5}, {"peachpuff", 0xffdab9},
+        {"peru", 0xcd853f}, {"pink", 0xffc0cb}, {"plum", 0xdda0dd}, {"powderblue", 0xb0e0e6}, {"purple", 0x800080}, {"rebeccapurple", 0x663399},
+        {"red", 0xff0000}, {"rosybrown", 0xbc8f8f}, {"royalblue", 0x4169e1}, {"saddlebrown", 0x8b4513}, {"salmon", 0xfa8072}, {"sandybrown", 0xf4a460},
+        {"seagreen", 0x2e8b57}, {"seashell", 0xfff5ee}, {"sienna", 0xa0522d}, {"silver", 0xc0c0c0}, {"skyblue", 0x87ceeb}, {"slateblue", 0x6a5acd},
+        {"slategray", 0x708090}, {"slategrey", 0x708090}, {"snow", 0xfffafa}, {"springgreen", 0x00ff7f}, {"steelblue", 0x4682b4}, {"tan", 0xd2b48c},
+        {"teal", 0x008080}, {"thistle", 0xd8bfd8}, {"tomato", 0xff6347}, {"turquoise", 0x40e0d0}, {"violet", 0xee82ee}, {"wheat", 0xf5deb3},
+        {"white", 0xffffff}, {"whitesmoke", 0xf5f5f5}, {"yellow", 0xffff00}, {"yellowgreen", 0x9acd32}};
+    double components[4] = {0.0, 0.0, 0.0, 1.0}, hue, p, q, t;
+    char *ptr;
+    const char *digits;
+    size_t i, length, count, left, right, middle;
+    int result;
+    unsigned rgb, bits;
+    bool hsl;
+
+    if (!value)
+        return false;
+
+    // "currentcolor" and "inherit" depend on the element, the caller resolves them
+    if (*value == '#')
+    {
+        for (digits = value + 1, length = 0; isxdigit(digits[length] & 255); length++)
+            ;
 
-    if (file->url)
+        if (digits[length] || (length != 3 && length != 4 && length != 6 && length != 8))
+            return false;
+
+        // #rgb and #rgba digits are doubled, #rrggbb and #rrggbbaa are used as is
+        rgb = (unsigned)strtoul(digits, NULL, 16);
+        count = length > 4 ? length / 2 : length;
+        bits = length > 4 ? 8 : 4;
+
+        for (i = 0; i < count; i++)
+            components[i] = (double)(((rgb >> (bits * (count - 1 - i))) & ((1u << bits) - 1)) * (bits == 4 ? 17 : 1)) / 255.0;
+    }
+    else if (!strncasecmp(value, "rgb", 3) || !strncasecmp(value, "hsl", 3))
     {
-        for (sane_pointer = sane_url, url_pointer = file->url; *url_pointer && sane_pointer < (sane_url + sizeof(sane_url) - 1); url_pointer++)
+        // rgb(), rgba(), hsl() and hsla() with commas or spaces and an optional "/ alpha"
+        hsl = tolower(*value & 255) == 'h';
+
+        if ((ptr = strchr(value, '(')) == NULL)
+            return false;
+
+        for (i = 0, ptr++; i < 4; i++)
         {
-            if (*url_pointer < ' ' || *url_pointer == '%')
+            while (isspace(*ptr & 255) || *ptr == ',' || *ptr == '/')
+                ptr++;
+
+            if (*ptr == ')' && i == 3)
+                break;
+
+            digits = ptr;
+            components[i] = bemStrtod(pool, digits, &ptr);
+
+            if (ptr == digits)
+                return false;
+
+            if (*ptr == '%')
             {
-                *sane_pointer++ = '_';
+                components[i] /= 100.0;
+                ptr++;
             }
-            else
+            else if (hsl && i == 0)
             {
-                *sane_pointer++ = *url_pointer;
+                if (!strncasecmp(ptr, "deg", 3))
+                    ptr += 3;
+
+                components[i] /= 360.0;
+            }
+            else if (i < 3 && !hsl)
+            {
+                components[i] /= 255.0;
             }
         }
-        *sane_pointer = '\0';
 
-        if (file->line_number)
+        if (hsl)
         {
-            snprintf(temp, sizeof(temp), "%s:%d: %s", sane_url, file->line_number, message);
-        }
-        else if (file->url)
-        {
-            snprintf(temp, sizeof(temp), "%s: %s", sane_url, message);
+            // HSL to RGB, components are hue, saturation and lightness from 0 to 1
+            if ((hue = components[0] - (int)components[0]) < 0.0)
+                hue += 1.0;
+
+            q = components[2] < 0.5 ? components[2] * (1.0 + components[1]) : components[2] + components[1] - components[2] * components[1];
+            p = 2.0 * components[2] - q;
+
+            for (i = 0; i < 3; i++)
+            {
+                if ((t = hue + (1.0 - (double)i) / 3.0) < 0.0)
+                    t += 1.0;
+                else if (t > 1.0)
+                    t -= 1.0;
+
+                if (t < 1.0 / 6.0)
+                    components[i] = p + (q - p) * 6.0 * t;
+                else if (t < 0.5)
+                    components[i] = q;
+                else if (t < 2.0 / 3.0)
+                    components[i] = p + (q - p) * (2.0 / 3.0 - t) * 6.0;
+                else
+                    components[i] = p;
+            }
         }
-        message = temp;
     }
-    else if (file->line_number)
+    else if (!strcasecmp(value, "transparent"))
     {
-        snprintf(temp, sizeof(temp), "%d: %s", file->line_number, message);
-        message = temp;
+        components[3] = 0.0;
+    }
+    else
+    {
+        for (left = 0, right = sizeof(names) / sizeof(names[0]); left < right;)
+        {
+            middle = (left + right) / 2;
+
+            if ((result = strcasecmp(value, names[middle].name)) == 0)
+                break;
+            else if (result < 0)
+                right = middle;
+            else
+                left = middle + 1;
+        }
+
+        if (left >= right)
+            return false;
+
+        rgb = names[middle].rgb;
+        components[0] = (double)((rgb >> 16) & 255) / 255.0;
+        components[1] = (double)((rgb >> 8) & 255) / 255.0;
+        components[2] = (double)(rgb & 255) / 255.0;
     }
 
-    va_start(ap, message);
-    result = bemPoolErrorv(file->pool, file->line_number, message, ap);
-    va_end(ap);
+    for (i = 0; i < 4; i++)
+        components[i] = components[i] < 0.0 ? 0.0 : components[i] > 1.0 ? 1.0 : components[i];
 
-    return result;
+    color->red = (float)components[0];
+    color->green = (float)components[1];
+    color->blue = (float)components[2];
+    color->alpha = (float)components[3];
+
+    return (true);
 }
 
-int bemFileGetc(bem_file *file)
+static const char *bemGetImageURL(bem_memory_pool *pool, const char *value)
 {
-    int ch;
+    const char *start, *end;
+    char buffer[1024];
 
-    if (file->buffer_pointer)
-    {
-        if (file->buffer_pointer < file->buffer_end)
+    // "url(...)" with or without quotes, anything else including "none" is no image
+    if (!value || strncasecmp(value, "url(", 4))
+        return NULL;
+
+    for (start = value + 4; isspace(*start & 255) || *start == '\"' || *start == '\''; start++)
+        ;
+
+    for (end = start + strlen(start); end > start && (isspace(end[-1] & 255) || end[-1] == ')' || end[-1] == '\"' || end[-1] == '\''); end--)
+        ;
+
+    if (end == start)
+        return NULL;
+
+    snprintf(buffer, sizeof(buffer), "%.*s", (int)(end - start), start);
+
+    return (bemPoolGetString(pool, buffer));
+}
+
+static float bemGetLength(bem_memory_pool *pool, const char *value, float max_value, float multiplier, bem_stylesheet *css, const bem_text *text)
+{
+    double number;
+    char *units;
+    float font_size = text ? text->font_size : 12.0f;
+
+    if (!value)
+        return 0.0f;
+
+    // Lengths are in points, numbers without units are multiplied by the caller's multiplier
+    if (!strcasecmp(value, "thin"))
+        return 0.75f;
+    else if (!strcasecmp(value, "medium"))
+        return 2.25f;
+    else if (!strcasecmp(value, "thick"))
+        return 3.75f;
+
+    number = bemStrtod(pool, value, &units);
+
+    if (units == value)
+        return 0.0f;
+    else if (!*units)
+        return (float)(number * multiplier);
+    else if (*units == '%')
+        return (float)(number * max_value / 100.0);
+    else if (!strcasecmp(units, "px"))
+        return (float)(number * 0.75);
+    else if (!strcasecmp(units, "pt"))
+        return (float)number;
+    else if (!strcasecmp(units, "pc"))
+        return (float)(number * 12.0);
+    else if (!strcasecmp(units, "in"))
+        return (float)(number * 72.0);
+    else if (!strcasecmp(units, "cm"))
+        return (float)(number * 72.0 / 2.54);
+    else if (!strcasecmp(units, "mm"))
+        return (float)(number * 72.0 / 25.4);
+    else if (!strcasecmp(units, "q"))
+        return (float)(number * 72.0 / 101.6);
+    else if (!strcasecmp(units, "em"))
+        return (float)(number * font_size);
+    else if (!strcasecmp(units, "ex") || !strcasecmp(units, "ch"))
+        return (float)(number * font_size / 2.0);
+    else if (!strcasecmp(units, "rem"))
+        return (float)(number * 12.0);
+    else if (css && !strcasecmp(units, "vw"))
+        return (float)(number * css->media.size.width / 100.0);
+    else if (css && !strcasecmp(units, "vh"))
+        return (float)(number * css->media.size.height / 100.0);
+    else if (css && !strcasecmp(units, "vmin"))
+        return (float)(number * (css->media.size.width < css->media.size.height ? css->media.size.width : css->media.size.height) / 100.0);
+    else if (css && !strcasecmp(units, "vmax"))
+        return (float)(number * (css->media.size.width > css->media.size.height ? css->media.size.width : css->media.size.height) / 100.0);
+    else
+        return 0.0f;
+}
+
+static bool bemMatchMedia(bem_stylesheet *css, const bem_media_condition *condition)
+{
+    const bem_media_query *query;
+    size_t i, j;
+    bool match;
+
+    // A list matches when any of its queries do
+    for (i = 0, query = condition->queries; i < condition->query_amount; i++, query++)
+    {
+        match = !query->type || !strcasecmp(query->type, css->media.type);
+
+        for (j = 0; match && j < query->feature_amount; j++)
+            match = bemEvaluateMediaFeature(css, query->features[j].name, query->features[j].value);
+
+        if (match != query->negate)
+            return true;
+    }
+
+    return condition->query_amount == 0;
+}
+
+static int bemMatchNode(bem_node *node, bem_stylesheet_selector *selector, const char *pseudo_class)
+{
+    const bem_dictionary *attributes = node->value.element.attributes;
+    const bem_stylesheet_selector_statement *statement;
+    const char *value;
+    bem_node *current;
+    size_t i, length;
+    int position, count;
+    bool pseudo_element = false, from_end, of_type;
+
+    if (selector->element != ELEMENT_WILDCARD && selector->element != node->element)
+        return 0;
+
+    for (i = 0, statement = selector->statements; i < selector->statement_amount; i++, statement++)
+    {
+        switch (statement->match)
         {
-            ch = (int)*(file->buffer_pointer)++;
+        case MATCH_ATTRIBUTE_EXIST:
+            if (!bemDictionaryGetKeyValue(attributes, statement->name))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_EQUALS:
+            if ((value = bemDictionaryGetKeyValue(attributes, statement->name)) == NULL || strcmp(value, statement->value))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_CONTAINS:
+            if ((value = bemDictionaryGetKeyValue(attributes, statement->name)) == NULL || !*statement->value || !strstr(value, statement->value))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_BEGINS:
+            if ((value = bemDictionaryGetKeyValue(attributes, statement->name)) == NULL || !*statement->value || strncmp(value, statement->value, strlen(statement->value)))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_ENDS:
+            length = strlen(statement->value);
+
+            if ((value = bemDictionaryGetKeyValue(attributes, statement->name)) == NULL || !length || strlen(value) < length || strcmp(value + strlen(value) - length, statement->value))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_LANGUAGE:
+            length = strlen(statement->value);
+
+            if ((value = bemDictionaryGetKeyValue(attributes, statement->name)) == NULL || strncasecmp(value, statement->value, length) || (value[length] && value[length] != '-'))
+                return 0;
+            break;
+
+        case MATCH_ATTRIBUTE_SPACE:
+            if (!bemMatchWord(bemDictionaryGetKeyValue(attributes, statement->name), statement->value))
+                return 0;
+            break;
+
+        case MATCH_CLASS:
+            if (!bemMatchWord(bemDictionaryGetKeyValue(attributes, "class"), statement->name))
+                return 0;
+            break;
+
+        case MATCH_ID:
+            if ((value = bemDictionaryGetKeyValue(attributes, "id")) == NULL || strcmp(value, statement->name))
+                return 0;
+            break;
+
+        case MATCH_PSEUDO_CLASS:
+            if (!strcmp(statement->name, "before") || !strcmp(statement->name, "after") || !strcmp(statement->name, "first-line") || !strcmp(statement->name, "first-letter"))
+            {
+                if (!pseudo_class || strcmp(statement->name, pseudo_class))
+                    return 0;
+
+                pseudo_element = true;
+            }
+            else if (!strcmp(statement->name, "link"))
+            {
+                if (node->element != ELEMENT_A || !bemDictionaryGetKeyValue(attributes, "href"))
+                    return 0;
+            }
+            else if (!strcmp(statement->name, "root"))
+            {
+                if (node->parent && node->parent->element > ELEMENT_DOCTYPE)
+                    return 0;
+            }
+            else if (!strcmp(statement->name, "empty"))
+            {
+                for (current = node->value.element.first_child; current && current->element == ELEMENT_COMMENT; current = current->next)
+                    ;
+
+                if (current)
+                    return 0;
+            }
+            else if (!strcmp(statement->name, "checked") || !strcmp(statement->name, "disabled"))
+            {
+                if (!bemDictionaryGetKeyValue(attributes, statement->name))
+                    return 0;
+            }
+            else if (!strcmp(statement->name, "first-child") || !strcmp(statement->name, "last-child") || !strcmp(statement->name, "only-child") ||
+                     !strcmp(statement->name, "first-of-type") || !strcmp(statement->name, "last-of-type") || !strcmp(statement->name, "only-of-type") ||
+                     (statement->value && !strncmp(statement->name, "nth-", 4)))
+            {
+                // Structural pseudo-classes count element siblings, from the end for the "last" and "nth-last" forms
+                of_type = strstr(statement->name, "of-type") != NULL;
+                from_end = strstr(statement->name, "last") != NULL;
+
+                for (position = 1, current = from_end ? node->next : node->previous; current; current = from_end ? current->next : current->previous)
+                {
+                    if (current->element > ELEMENT_DOCTYPE && (!of_type || current->element == node->element))
+                        position++;
+                }
+
+                if (!strncmp(statement->name, "only-", 5))
+                {
+                    for (count = position, current = node->next; current; current = current->next)
+                    {
+                        if (current->element > ELEMENT_DOCTYPE && (!of_type || current->element == node->element))
+                            count++;
+                    }
+
+                    if (count != 1)
+                        return 0;
+                }
+                else if (!strncmp(statement->name, "nth-", 4))
+                {
+                    if (!bemMatchNth(statement->value, position))
+                        return 0;
+                }
+                else if (position != 1)
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                // Dynamic states like :hover never apply to printed output, unknown ones never match
+                return 0;
+            }
+            break;
         }
-        else
+    }
+
+    // Plain rules don't style pseudo-elements
+    if (pseudo_class && !pseudo_element)
+        return 0;
+
+    if (!selector->previous)
+        return 1;
+
+    switch (selector->relation)
+    {
+    case RELATION_CHILD:
+        for (current = node->parent; current && current->element > ELEMENT_DOCTYPE; current = current->parent)
         {
-            ch = EOF;
+            if (bemMatchNode(current, selector->previous, NULL))
+                return 1;
+        }
+        break;
+
+    case RELATION_IMMEDIATE_CHILD:
+        if ((current = node->parent) != NULL && current->element > ELEMENT_DOCTYPE)
+            return bemMatchNode(current, selector->previous, NULL);
+        break;
+
+    case RELATION_SIBLING:
+        for (current = node->previous; current; current = current->previous)
+        {
+            if (current->element > ELEMENT_DOCTYPE && bemMatchNode(current, selector->previous, NULL))
+                return 1;
         }
+        break;
+
+    case RELATION_IMMEDIATE_SIBLING:
+        for (current = node->previous; current && current->element <= ELEMENT_DOCTYPE; current = current->previous)
+            ;
+
+        if (current)
+            return bemMatchNode(current, selector->previous, NULL);
+        break;
+    }
+
+    return 0;
+}
+
+static bool bemMatchNth(const char *expression, int position)
+{
+    char *end;
+    long a = 0, b = 0;
+    int sign;
+
+    // "odd", "even", "b", "an", "an+b" and "an-b", with spaces already collapsed by the selector reader
+    if (!strcasecmp(expression, "odd"))
+    {
+        a = 2;
+        b = 1;
+    }
+    else if (!strcasecmp(expression, "even"))
+    {
+        a = 2;
     }
     else
     {
-        ch = gzgetc(file->file_pointer);
+        if (*expression == 'n' || *expression == 'N' || ((*expression == '+' || *expression == '-') && (expression[1] == 'n' || expression[1] == 'N')))
+        {
+            a = *expression == '-' ? -1 : 1;
+            end = (char *)expression + (*expression == 'n' || *expression == 'N' ? 1 : 2);
+        }
+        else
+        {
+            a = strtol(expression, &end, 10);
+
+            if (end == expression)
+                return false;
+
+            if (*end != 'n' && *end != 'N')
+            {
+                // Just "b"
+                return *end == '\0' && position == a;
+            }
+
+            end++;
+        }
+
+        while (*end == ' ')
+            end++;
+
+        if (*end == '+' || *end == '-')
+        {
+            for (sign = *end++ == '-' ? -1 : 1; *end == ' '; end++)
+                ;
+
+            if (!isdigit(*end & 255))
+                return false;
+
+            b = sign * strtol(end, &end, 10);
+        }
+
+        if (*end)
+            return false;
     }
 
-    if (ch == '\n')
-        file->line_number++;
+    // position = a*k + b for some k >= 0
+    if (a == 0)
+        return position == b;
 
-    return ch;
+    return (position - b) % a == 0 && (position - b) / a >= 0;
 }
 
-bem_file *bemFileNewBuffer(bem_memory_pool *pool, const void *buffer, size_t bytes)
+static int bemMatchRule(bem_node *node, bem_rule_set *rule, const char *pseudo_class)
 {
-    bem_file *file;
+    const bem_stylesheet_selector *selector;
+    size_t i;
+    int ids = 0, classes = 0, elements = 0;
 
-    if ((file = calloc(1, sizeof(bem_file))) != NULL)
+    if (!bemMatchNode(node, rule->selector, pseudo_class))
+        return -1;
+
+    // Specificity packed as ids, then classes, attributes and pseudo-classes, then elements and pseudo-elements
+    for (selector = rule->selector; selector; selector = selector->previous)
     {
-        file->pool = pool;
-        file->buffer = buffer;
-        file->buffer_pointer = file->buffer;
-        file->buffer_end = file->buffer + bytes;
-        file->line_number = 1;
+        if (selector->element != ELEMENT_WILDCARD)
+            elements++;
+
+        for (i = 0; i < selector->statement_amount; i++)
+        {
+            if (selector->statements[i].match == MATCH_ID)
+                ids++;
+            else if (selector->statements[i].match == MATCH_PSEUDO_CLASS && pseudo_class && !strcmp(selector->statements[i].name, pseudo_class))
+                elements++;
+            else
+                classes++;
+        }
     }
 
-    return file;
+    return (ids > 255 ? 255 : ids) << 16 | (classes > 255 ? 255 : classes) << 8 | (elements > 255 ? 255 : elements);
 }
 
-bem_file *bemFileNewString(bem_memory_pool *pool, const char *str)
+static bool bemMatchWord(const char *list, const char *word)
 {
-    return bemFileNewBuffer(pool, str, strlen(str));
+    const char *start;
+    size_t length;
+
+    if (!list || !word || (length = strlen(word)) == 0)
+        return false;
+
+    // Whitespace-separated lists like "class"
+    for (start = list; (start = strstr(start, word)) != NULL; start += length)
+    {
+        if ((start == list || isspace(start[-1] & 255)) && (!start[length] || isspace(start[length] & 255)))
+            return true;
+    }
+
+    return false;
 }
 
-bem_file *bemFileNewURL(bem_memory_pool *pool, const char *url, const char *base_url)
+static double bemStrtod(bem_memory_pool *pool, const char *str, char **end)
 {
-    bem_file *file;
-    const char *file_name;
+    char temp[256], *pointer, *temp_end;
+    const char *source;
+    double value;
 
-    if ((file_name = bemPoolGetURL(pool, url, base_url)) == NULL)
-        return NULL;
+    if (!pool->locale)
+        return strtod(str, end);
 
-    if ((file = calloc(1, sizeof(bem_file))) != NULL)
+    // strtod() wants the locale's decimal point, so copy the number and swap it in
+    for (source = str, pointer = temp; *source && pointer < (temp + sizeof(temp) - 1 - pool->locale_decimal_length); source++)
     {
-        file->pool = pool;
-        file->url = file_name;
-        file->file_pointer = gzopen(file_name, "rb");
-        file->line_number = 1;
-
-        if (!file->file_pointer)
+        if (*source == '.')
         {
-            perror(file_name);
-            free(file);
-            file = NULL;
+            memcpy(pointer, pool->locale->decimal_point, pool->locale_decimal_length);
+            pointer += pool->locale_decimal_length;
+        }
+        else if (isdigit(*source & 255) || strchr("+-eE", *source))
+        {
+            *pointer++ = *source;
+        }
+        else
+        {
+            break;
         }
     }
 
-    return file;
+    *pointer = '\0';
+    value = strtod(temp, &temp_end);
+
+    if (end)
+    {
+        // Map the end of the converted text back onto the original string
+        for (source = str, pointer = temp; pointer < temp_end; source++)
+            pointer += *source == '.' ? pool->locale_decimal_length : 1;
+
+        *end = (char *)source;
+    }
+
+    return value;
 }
 
-size_t bemFileRead(bem_file *file, void *buffer, size_t bytes)
+static void bemUpdateMedia(bem_stylesheet *css)
 {
-    ssize_t read_bytes;
+    const bem_stylesheet *layer;
+    bool *active;
+    size_t i, amount;
 
-    if (!file || !buffer || bytes == 0)
-        return 0;
+    // Every layer's conditions are evaluated against this stylesheet's media, parents come before nested blocks
+    for (amount = 0, layer = css; layer; layer = layer->parent)
+        amount += layer->condition_amount;
 
-    if (file->buffer_pointer)
+    if (amount > 0)
     {
-        if ((size_t)(file->buffer_end - file->buffer_pointer) < bytes)
-            bytes = (size_t)(file->buffer_end - file->buffer_pointer);
+        // Left stale on failure, bemCreateProperties() then skips every conditional rule
+        if ((active = (bool *)realloc(css->media_active, amount * sizeof(bool))) == NULL)
+            return;
 
-        if (bytes > 0)
+        css->media_active = active;
+
+        for (layer = css; layer; active += layer->condition_amount, layer = layer->parent)
         {
-            memcpy(buffer, file->buffer_pointer, bytes);
-            file->buffer_pointer += bytes;
+            for (i = 0; i < layer->condition_amount; i++)
+                active[i] = (!layer->conditions[i].parent || active[layer->conditions[i].parent - 1]) && bemMatchMedia(css, layer->conditions + i);
         }
+    }
 
-        return bytes;
+    css->media_generation = css->generation;
+}
+
+static unsigned bemAddMedia(bem_stylesheet *css, bem_media_condition *condition)
+{
+    bem_media_condition *conditions;
+    size_t i, conditions_size;
+
+    // Identical blocks share one condition, the text is interned so pointers compare
+    for (i = 0; i < css->condition_amount; i++)
+    {
+        if (css->conditions[i].text == condition->text && css->conditions[i].parent == condition->parent)
+        {
+            bemClearMedia(condition);
+            return (unsigned)(i + 1);
+        }
     }
-    else if ((read_bytes = gzread(file->file_pointer, buffer, (unsigned)bytes)) < 0)
+
+    if (css->condition_amount >= css->conditions_size)
     {
-        return 0;
+        conditions_size = css->conditions_size ? 2 * css->conditions_size : 16;
+
+        if ((conditions = (bem_media_condition *)realloc(css->conditions, conditions_size * sizeof(bem_media_condition))) == NULL)
+        {
+            bemPoolError(css->pool, 0, "Unable to allocate memory for media conditions.");
+            bemClearMedia(condition);
+            return 0;
+        }
+
+        css->conditions = conditions;
+        css->conditions_size = conditions_size;
     }
 
-    return (size_t)read_bytes;
+    css->conditions[css->condition_amount++] = *condition;
+    css->generation++;
+
+    return (unsigned)css->condition_amount;
 }
 
-size_t bemFileSeek(bem_file *file, size_t offset)
+static void bemAddRule(bem_stylesheet *css, bem_stylesheet_selector *selector, bem_dictionary *properties, unsigned condition)
 {
-    ssize_t seek_offset;
+    bem_sha3 context;
+    bem_sha3_256 hash;
+    bem_rule_set *rule;
+    char temp[32];
+    size_t i;
 
-    if (!file)
-        return 0;
+    bemCSSSelectorHash(selector, hash);
 
-    if (file->buffer_pointer)
+    if (condition)
     {
-        if (offset > (size_t)(file->buffer_end - file->buffer))
-            offset = (size_t)(file->buffer_end - file->buffer);
+        // Rules in @media blocks must not merge with the same selector outside of them
+        snprintf(temp, sizeof(temp), "@media %u", condition);
 
-        file->buffer_pointer = file->buffer + offset;
+        bemSHA3Init(&context);
+        bemSHA3Update(&context, hash, sizeof(hash));
+        bemSHA3Update(&context, temp, strlen(temp));
+        bemSHA3Final(&context, hash, sizeof(hash));
+    }
 
-        return offset;
+    if ((rule = bemRuleCollectionFindHash(&css->all_rules, hash)) != NULL && rule->order + 1 != css->rule_order)
+    {
+        // Rules in between may override some of the earlier declarations, so this one keeps its own place in the cascade
+        snprintf(temp, sizeof(temp), "@order %u", css->rule_order);
+
+        bemSHA3Init(&context);
+        bemSHA3Update(&context, hash, sizeof(hash));
+        bemSHA3Update(&context, temp, strlen(temp));
+        bemSHA3Final(&context, hash, sizeof(hash));
+
+        rule = NULL;
     }
 
-    if ((seek_offset = gzseek(file->file_pointer, (long)offset, SEEK_SET)) < 0)
-        return 0;
+    if (rule)
+    {
+        // Same selector as the rule just before, later declarations win
+        bemCSSSelectorDelete(selector);
+        rule->order = css->rule_order++;
 
-    return (size_t)seek_offset;
+        if (!rule->properties)
+        {
+            rule->properties = bemDictionaryCopy(properties);
+        }
+        else
+        {
+            for (i = 0; i < bemDictionaryGetCount(properties); i++)
+                bemDictionarySetKeyValue(rule->properties, properties->pairs[i].key, properties->pairs[i].value);
+        }
+    }
+    else if ((rule = bemRuleNew(css, hash, selector, bemDictionaryCopy(properties))) != NULL)
+    {
+        rule->condition = condition;
+        bemRuleCollectionAdd(css, &css->all_rules, rule);
+        bemRuleCollectionAdd(css, css->rules + selector->element, rule);
+    }
+    else
+    {
+        bemCSSSelectorDelete(selector);
+    }
 }
 
-void bemFileUngetc(bem_file *file, int ch)
+static size_t bemAddString(bem_css_strings *strings, const char *str)
 {
-    if (file->buffer_pointer && file->buffer_pointer > file->buffer)
+    const char **keys;
+    size_t i, hash, length, keys_size, *offsets;
+    char *data;
+
+    if (strings->amount >= strings->keys_size / 2)
     {
-        file->buffer_pointer--;
+        keys_size = strings->keys_size ? 2 * strings->keys_size : 256;
+        keys = (const char **)calloc(keys_size, sizeof(const char *));
+        offsets = (size_t *)calloc(keys_size, sizeof(size_t));
+
+        if (!keys || !offsets)
+        {
+            free(keys);
+            free(offsets);
+            strings->failed = true;
+            return 0;
+        }
+
+        for (i = 0; i < strings->keys_size; i++)
+        {
+            if (!strings->keys[i])
+                continue;
+
+            for (hash = ((size_t)strings->keys[i] >> 4) & (keys_size - 1); keys[hash]; hash = (hash + 1) & (keys_size - 1))
+                ;
+
+            keys[hash] = strings->keys[i];
+            offsets[hash] = strings->offsets[i];
+        }
+
+        free(strings->keys);
+        free(strings->offsets);
+        strings->keys = keys;
+        strings->offsets = offsets;
+        strings->keys_size = keys_size;
     }
-    else if (file->file_pointer)
+
+    // Pool strings are interned, so the pointer identifies the string
+    for (hash = ((size_t)str >> 4) & (strings->keys_size - 1); strings->keys[hash]; hash = (hash + 1) & (strings->keys_size - 1))
     {
-        gzungetc(ch, file->file_pointer);
+        if (strings->keys[hash] == str)
+            return strings->offsets[hash];
     }
 
-    if (ch == '\n')
-        file->line_number--;
+    length = strlen(str) + 1;
+
+    if (strings->length + length > strings->data_size)
+    {
+        if ((data = (char *)realloc(strings->data, 2 * (strings->length + length) + 4096)) == NULL)
+        {
+            strings->failed = true;
+            return 0;
+        }
+
+        strings->data = data;
+        strings->data_size = 2 * (strings->length + length) + 4096;
+    }
+
+    memcpy(strings->data + strings->length, str, length);
+
+    strings->keys[hash] = str;
+    strings->offsets[hash] = strings->length;
+    strings->amount++;
+    strings->length += length;
+
+    return strings->offsets[hash];
 }
 
-int main(int argc, char *argv[])
+static void bemClearMedia(bem_media_condition *condition)
 {
-    // TODO: Fix compiler warnings
+    size_t i;
+
+    for (i = 0; i < condition->query_amount; i++)
+        free(condition->queries[i].features);
+
+    free(condition->queries);
+    memset(condition, 0, sizeof(bem_media_condition));
+}
+
+static bem_stylesheet_selector *bemCopySelector(bem_stylesheet *css, const bem_stylesheet_selector *selector)
+{
+    bem_stylesheet_selector *previous = NULL, *copy;
+    size_t i;
+
+    if (selector->previous && (previous = bemCopySelector(css, selector->previous)) == NULL)
+        return NULL;
+
+    if ((copy = bemCSSSelectorNew(css, previous, selector->element, selector->relation)) == NULL)
+    {
+        bemCSSSelectorDelete(previous);
+        return NULL;
+    }
+
+    for (i = 0; i < selector->statement_amount; i++)
+        bemCSSSelectorAddStatement(css, copy, selector->statements[i].match, selector->statements[i].name, selector->statements[i].value);
+
+    return (copy);
+}
+
+static bool bemEvaluateMediaFeature(bem_stylesheet *css, const char *name, const char *value)
+{
+    double number, denominator, actual;
+    char *units;
+    int compare = 0;
+
+    if (!strncasecmp(name, "min-", 4))
+    {
+        compare = 1;
+        name += 4;
+    }
+    else if (!strncasecmp(name, "max-", 4))
+    {
+        compare = -1;
+        name += 4;
+    }
+
+    if (!strncasecmp(name, "device-", 7))
+        name += 7;
+
+    if (!strcasecmp(name, "orientation"))
+        return !strcasecmp(value, css->media.size.width > css->media.size.height ? "landscape" : "portrait");
+
+    number = bemStrtod(css->pool, value, &units);
+
+    if (!strcasecmp(name, "width") || !strcasecmp(name, "height"))
+    {
+        // Media sizes are in points
+        if (!strcasecmp(units, "px") || !*units)
+            number *= 0.75;
+        else if (!strcasecmp(units, "pc"))
+            number *= 12.0;
+        else if (!strcasecmp(units, "in"))
+            number *= 72.0;
+        else if (!strcasecmp(units, "cm"))
+            number *= 72.0 / 2.54;
+        else if (!strcasecmp(units, "mm"))
+            number *= 72.0 / 25.4;
+        else if (!strcasecmp(units, "em") || !strcasecmp(units, "rem"))
+            number *= 12.0;
+        else if (strcasecmp(units, "pt"))
+            return false;
+
+        actual = tolower(*name) == 'w' ? css->media.size.width : css->media.size.height;
+    }
+    else if (!strcasecmp(name, "aspect-ratio"))
+    {
+        while (isspace(*units & 255))
+            units++;
+
+        if (*units != '/' || (denominator = bemStrtod(css->pool, units + 1, NULL)) <= 0.0)
+            return false;
+
+        number /= denominator;
+        actual = (double)css->media.size.width / (double)css->media.size.height;
+    }
+    else if (!strcasecmp(name, "color"))
+    {
+        if (!*value)
+            return css->media.color_bits > 0;
+
+        actual = css->media.color_bits;
+    }
+    else if (!strcasecmp(name, "monochrome"))
+    {
+        if (!*value)
+            return css->media.monochrome_bits > 0;
+
+        actual = css->media.monochrome_bits;
+    }
+    else if (!strcasecmp(name, "prefers-color-scheme"))
+    {
+        return !strcasecmp(value, "light");
+    }
+    else
+    {
+        // Interactive and unknown features never match
+        return false;
+    }
+
+    if (compare > 0)
+        return actual >= number;
+    else if (compare < 0)
+        return actual <= number;
+    else
+        return actual == number;
+}
+
+static bem_inline_style *bemFindInlineStyle(bem_memory_pool *pool, const char *text)
+{
+    bem_inline_style *inlines, *style;
+    size_t i, hash, inlines_size;
+
+    if (!text)
+        return NULL;
+
+    if (pool->inline_amount >= pool->inlines_size / 2)
+    {
+        inlines_size = pool->inlines_size ? 2 * pool->inlines_size : 64;
+
+        if ((inlines = (bem_inline_style *)calloc(inlines_size, sizeof(bem_inline_style))) == NULL)
+            return NULL;
+
+        for (i = 0, style = pool->inlines; i < pool->inlines_size; i++, style++)
+        {
+            if (!style->text)
+                continue;
+
+            hash = ((size_t)style->text >> 4) & (inlines_size - 1);
+
+            while (inlines[hash].text)
+                hash = (hash + 1) & (inlines_size - 1);
+
+            inlines[hash] = *style;
+        }
+
+        free(pool->inlines);
+        pool->inlines = inlines;
+        pool->inlines_size = inlines_size;
+    }
+
+    // Strings are interned, so the pointer is the key
+    for (i = ((size_t)text >> 4) & (pool->inlines_size - 1); pool->inlines[i].text; i = (i + 1) & (pool->inlines_size - 1))
+    {
+        if (pool->inlines[i].text == text)
+            return pool->inlines + i;
+    }
+
+    pool->inlines[i].text = text;
+    pool->inline_amount++;
+
+    return pool->inlines + i;
+}
+
+static bool bemImportStylesheet(bem_stylesheet *css, bem_file *file, int depth, unsigned condition)
+{
+    bem_file *source = file;
+    bem_sha3 context;
+    bem_sha3_256 hash;
+    bem_uchar *data = NULL, *temp;
+    const bem_uchar *content;
+    const char *directory;
+    size_t i, length = 0, data_size = 0, bytes;
+    char cname[1024], hex[2 * BEM_SHA3_256_SIZE + 1], media[1024];
+    bool cacheable, result;
+
+    // Tokenize from memory, so read compressed and plain files completely first
+    if (file->buffer_pointer)
+    {
+        content = file->buffer_pointer;
+        length = (size_t)(file->buffer_end - file->buffer_pointer);
+    }
+    else if (file->file_pointer)
+    {
+        do
+        {
+            if (length == data_size)
+            {
+                if ((temp = (bem_uchar *)realloc(data, data_size ? 2 * data_size : 65536)) == NULL)
+                {
+                    free(data);
+                    return bemFileError(file, "Unable to allocate memory for stylesheet.");
+                }
+
+                data = temp;
+                data_size = data_size ? 2 * data_size : 65536;
+            }
+
+            length += (bytes = bemFileRead(file, data + length, data_size - length));
+        } while (bytes > 0);
+
+        content = data;
+    }
+    else
+    {
+        return false;
+    }
+
+    // The stylesheet hash chains every import, so an empty stylesheet's hash only depends on this content and, when pruning, the media
+    if (css->media_pruning)
+        snprintf(media, sizeof(media), "%s %d %d %g %g", css->media.type, css->media.color_bits, css->media.monochrome_bits, css->media.size.width, css->media.size.height);
+    else
+        strncpy(media, "all", sizeof(media));
+
+    bemSHA3Init(&context);
+    bemSHA3Update(&context, css->hash, sizeof(css->hash));
+    bemSHA3Update(&context, media, strlen(media) + 1);
+    bemSHA3Update(&context, content, length);
+    bemSHA3Final(&context, hash, sizeof(hash));
+
+    if ((directory = css->pool->css_cache) == NULL)
+        directory = getenv("BEM_CSS_CACHE");
+
+    cacheable = directory && depth == 0 && condition == 0 && !css->mapping && css->all_rules.rules_amount == 0 && css->condition_amount == 0;
+
+    if (cacheable)
+    {
+        for (i = 0; i < sizeof(hash); i++)
+            snprintf(hex + 2 * i, 3, "%02x", hash[i]);
+
+        snprintf(cname, sizeof(cname), "%s/%s.css", directory, hex);
+
+        if (bemMapCSS(css, cname, hash))
+        {
+            if (file->buffer_pointer)
+                file->buffer_pointer = file->buffer_end;
+
+            free(data);
+            css->generation++;
+            return true;
+        }
+    }
+
+    if (css->mapping)
+        bemUnmapCSS(css);
+
+    memcpy(css->hash, hash, sizeof(css->hash));
+
+    if (data)
+    {
+        if ((source = bemFileNewBuffer(css->pool, data, length)) == NULL)
+        {
+            free(data);
+            return false;
+        }
+
+        source->url = file->url;
+        source->line_number = file->line_number;
+    }
+
+    result = length == 0 || bemReadRules(css, source, depth, condition);
+    css->generation++;
+
+    if (source != file)
+        bemFileDelete(source);
+
+    free(data);
+
+    // Stylesheets that pulled in other files through @import changed the hash and are not cached
+    if (result && cacheable && !memcmp(css->hash, hash, sizeof(hash)))
+    {
+        mkdir(directory, 0755);
+        bemCSSSave(css, cname);
+    }
+
+    return result;
+}
+
+static bool bemMapCSS(bem_stylesheet *css, const char *filename, const bem_uchar *hash)
+{
+    bem_css_file_header *header;
+    bem_uchar *map;
+    bem_rule_set *rules, **all_rules, **element_rules;
+    bem_stylesheet_selector *selectors;
+    bem_stylesheet_selector_statement *statements;
+    bem_dictionary *dictionaries;
+    bem_pair *pairs;
+    bem_media_condition condition;
+    bem_file *file;
+    bem_type type;
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    const char *text;
+    char buffer[256];
+    size_t i, size = 0, strings, *conditions;
+    bool valid;
+    int fd;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return false;
+
+    // A private mapping: relocating dirties the tables, the strings stay shared with other processes
+    if (!fstat(fd, &info) && (size_t)info.st_size > sizeof(bem_css_file_header))
+        mapping = mmap(NULL, (size = (size_t)info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    map = (bem_uchar *)mapping;
+    header = (bem_css_file_header *)mapping;
+    strings = size - header->strings;
+
+    // Tables must be aligned, in order and inside the file, and the string table must end with a nul
+    valid = !memcmp(header->magic, "BEMCSS\0\0", 8) && header->version == BEM_CSS_FILE_VERSION && header->sizes[0] == sizeof(void *) &&
+            header->sizes[1] == sizeof(bem_rule_set) && header->sizes[2] == sizeof(bem_stylesheet_selector) &&
+            header->sizes[3] == sizeof(bem_stylesheet_selector_statement) && header->sizes[4] == sizeof(bem_dictionary) &&
+            header->sizes[5] == sizeof(bem_pair) && header->size == size && (!hash || !memcmp(header->hash, hash, sizeof(header->hash))) &&
+            header->rules >= sizeof(bem_css_file_header) && !(header->rules & 15) && !(header->selectors & 15) && !(header->statements & 15) &&
+            !(header->dictionaries & 15) && !(header->pairs & 15) && !(header->all_rules & 15) && header->strings < size && !map[size - 1] &&
+            header->rule_amount <= (size - header->rules) / sizeof(bem_rule_set) && header->rules + header->rule_amount * sizeof(bem_rule_set) <= header->selectors &&
+            header->selector_amount <= (size - header->selectors) / sizeof(bem_stylesheet_selector) &&
+            header->selectors + header->selector_amount * sizeof(bem_stylesheet_selector) <= header->statements &&
+            header->statement_amount <= (size - header->statements) / sizeof(bem_stylesheet_selector_statement) &&
+            header->statements + header->statement_amount * sizeof(bem_stylesheet_selector_statement) <= header->dictionaries &&
+            header->rule_amount <= (size - header->dictionaries) / sizeof(bem_dictionary) &&
+            header->dictionaries + header->rule_amount * sizeof(bem_dictionary) <= header->pairs &&
+            header->pair_amount <= (size - header->pairs) / sizeof(bem_pair) && header->pairs + header->pair_amount * sizeof(bem_pair) <= header->all_rules &&
+            header->all_rules + header->rule_amount * sizeof(bem_rule_set *) == header->element_rules &&
+            header->element_rules + header->rule_amount * sizeof(bem_rule_set *) == header->conditions &&
+            header->condition_amount <= (size - header->conditions) / (2 * sizeof(size_t)) &&
+            header->conditions + 2 * header->condition_amount * sizeof(size_t) == header->strings && header->element_starts[0] == 0 &&
+            header->element_starts[ELEMENT_MAX] == header->rule_amount;
+
+    for (i = 0; valid && i < ELEMENT_MAX; i++)
+        valid = header->element_starts[i] <= header->element_starts[i + 1];
+
+    if (!valid)
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    rules = (bem_rule_set *)(map + header->rules);
+    selectors = (bem_stylesheet_selector *)(map + header->selectors);
+    statements = (bem_stylesheet_selector_statement *)(map + header->statements);
+    dictionaries = (bem_dictionary *)(map + header->dictionaries);
+    pairs = (bem_pair *)(map + header->pairs);
+    all_rules = (bem_rule_set **)(map + header->all_rules);
+    element_rules = (bem_rule_set **)(map + header->element_rules);
+    conditions = (size_t *)(map + header->conditions);
+
+    // Turn every stored offset into a pointer, checking it lands on an entry of the right table
+    for (i = 0; valid && i < header->statement_amount; i++)
+    {
+        statements[i].name = (const char *)bemRelocateCSS(map, statements[i].name, header->strings, strings, 1, &valid);
+        statements[i].value = (const char *)bemRelocateCSS(map, statements[i].value, header->strings, strings, 1, &valid);
+        valid = valid && statements[i].name && (unsigned)statements[i].match <= MATCH_PSEUDO_CLASS;
+    }
+
+    for (i = 0; valid && i < header->selector_amount; i++)
+    {
+        selectors[i].previous = (struct bem_stylesheet_selector *)bemRelocateCSS(map, selectors[i].previous, header->selectors, header->selector_amount, sizeof(bem_stylesheet_selector), &valid);
+        selectors[i].statements = (bem_stylesheet_selector_statement *)bemRelocateCSS(map, selectors[i].statements, header->statements, header->statement_amount, sizeof(bem_stylesheet_selector_statement), &valid);
+        valid = valid && (!selectors[i].previous || selectors[i].previous < selectors + i) && (unsigned)selectors[i].element < ELEMENT_MAX &&
+                (unsigned)selectors[i].relation <= RELATION_IMMEDIATE_SIBLING && (selectors[i].statements || !selectors[i].statement_amount) &&
+                (!selectors[i].statements || selectors[i].statement_amount <= header->statement_amount - (size_t)(selectors[i].statements - statements));
+    }
+
+    for (i = 0; valid && i < header->rule_amount; i++)
+    {
+        dictionaries[i].pool = css->pool;
+        dictionaries[i].pairs = (bem_pair *)bemRelocateCSS(map, dictionaries[i].pairs, header->pairs, header->pair_amount, sizeof(bem_pair), &valid);
+        valid = valid && (dictionaries[i].pairs || !dictionaries[i].pair_amount) &&
+                (!dictionaries[i].pairs || dictionaries[i].pair_amount <= header->pair_amount - (size_t)(dictionaries[i].pairs - pairs));
+    }
+
+    for (i = 0; valid && i < header->pair_amount; i++)
+    {
+        pairs[i].key = (const char *)bemRelocateCSS(map, pairs[i].key, header->strings, strings, 1, &valid);
+        pairs[i].value = (const char *)bemRelocateCSS(map, pairs[i].value, header->strings, strings, 1, &valid);
+        valid = valid && pairs[i].key && pairs[i].value;
+    }
+
+    for (i = 0; valid && i < header->rule_amount; i++)
+    {
+        rules[i].selector = (bem_stylesheet_selector *)bemRelocateCSS(map, rules[i].selector, header->selectors, header->selector_amount, sizeof(bem_stylesheet_selector), &valid);
+        rules[i].properties = (struct bem_dictionary *)bemRelocateCSS(map, rules[i].properties, header->dictionaries, header->rule_amount, sizeof(bem_dictionary), &valid);
+        all_rules[i] = (bem_rule_set *)bemRelocateCSS(map, all_rules[i], header->rules, header->rule_amount, sizeof(bem_rule_set), &valid);
+        element_rules[i] = (bem_rule_set *)bemRelocateCSS(map, element_rules[i], header->rules, header->rule_amount, sizeof(bem_rule_set), &valid);
+        valid = valid && rules[i].selector && rules[i].properties && all_rules[i] && element_rules[i] && rules[i].condition <= header->condition_amount;
+
+        if (rules[i].order >= css->rule_order)
+            css->rule_order = rules[i].order + 1;
+    }
+
+    // Media conditions are compiled again from their text and stay on the heap
+    for (i = 0; valid && i < header->condition_amount; i++)
+    {
+        text = (const char *)bemRelocateCSS(map, (const void *)(uintptr_t)conditions[2 * i], header->strings, strings, 1, &valid);
+
+        if (!valid || !text || conditions[2 * i + 1] > i || (file = bemFileNewString(css->pool, text)) == NULL)
+        {
+            valid = false;
+            break;
+        }
+
+        valid = bemReadMedia(css, file, &type, buffer, sizeof(buffer), &condition);
+        bemFileDelete(file);
+
+        if (valid)
+        {
+            condition.parent = (unsigned)conditions[2 * i + 1];
+            valid = bemAddMedia(css, &condition) == i + 1;
+        }
+    }
+
+    if (!valid || mprotect(mapping, size, PROT_READ))
+    {
+        for (i = 0; i < css->condition_amount; i++)
+            bemClearMedia(css->conditions + i);
+
+        css->condition_amount = 0;
+
+        munmap(mapping, size);
+        return false;
+    }
+
+    // The collections borrow the mapped arrays, rules_size 0 makes any change copy them first
+    css->all_rules.needs_sorting = 0;
+    css->all_rules.rules_size = 0;
+    css->all_rules.rules_amount = header->rule_amount;
+    css->all_rules.rules = all_rules;
+
+    for (i = 0; i < ELEMENT_MAX; i++)
+    {
+        css->rules[i].needs_sorting = 0;
+        css->rules[i].rules_size = 0;
+        css->rules[i].rules_amount = header->element_starts[i + 1] - header->element_starts[i];
+        css->rules[i].rules = css->rules[i].rules_amount ? element_rules + header->element_starts[i] : NULL;
+    }
+
+    memcpy(css->hash, header->hash, sizeof(css->hash));
+    css->mapping = mapping;
+    css->mapping_size = size;
+
+    return true;
+}
+
+static void bemParseInlineStyle(bem_memory_pool *pool, const char *str, bem_dictionary *properties)
+{
+    char name[256], value[65536], *pointer;
+    const char *start;
+    bool custom;
+
+    // Same declarations as bemReadProperties(), scanned in place instead of through a bem_file
+    while (*(str = bemSkipInlineSpace(str)) && *str != '}')
+    {
+        if (*str == ';')
+        {
+            str++;
+            continue;
+        }
+
+        for (start = str; isalnum(*str & 255) || *str == '-' || *str == '_' || (*str & 128); str++)
+            ;
+
+        str = bemSkipInlineSpace(str);
+
+        if (str == start || *str != ':' || (size_t)(str - start) >= sizeof(name))
+        {
+            if (!bemPoolError(pool, 0, "Bad declaration in style attribute."))
+                break;
+
+            bemParseInlineValue(&str, value, sizeof(value));
+            continue;
+        }
+
+        // Property names are case-insensitive, custom properties are not
+        custom = !strncmp(start, "--", 2);
+
+        for (pointer = name; start < str && (isalnum(*start & 255) || *start == '-' || *start == '_' || (*start & 128)); start++)
+            *pointer++ = custom ? *start : (char)tolower(*start & 255);
+
+        *pointer = '\0';
+        str++;
+
+        if (!bemParseInlineValue(&str, value, sizeof(value)))
+        {
+            if (!bemPoolError(pool, 0, "Bad value for '%s' in style attribute.", name))
+                break;
+
+            continue;
+        }
+
+        if (*value)
+            bemSetProperty(properties, name, value);
+    }
+}
+
+static bool bemParseInlineValue(const char **str, char *buffer, size_t buffer_size)
+{
+    const char *current = *str;
+    char *pointer = buffer, *end = buffer + buffer_size - 1;
+    int ch, quote = 0, parens = 0;
+    bool space = false, truncated = false;
+
+    // Same rules as bemReadValue(), stopping after ';' or at '}'
+    while ((ch = *current & 255) != '\0')
+    {
+        current++;
+
+        if (!quote && !parens && ch == ';')
+        {
+            break;
+        }
+        else if (!quote && !parens && ch == '}')
+        {
+            current--;
+            break;
+        }
+        else if (!quote && ch == '/' && *current == '*')
+        {
+            current = bemSkipInlineSpace(current - 1);
+            space = pointer > buffer;
+            continue;
+        }
+        else if (!quote && isspace(ch))
+        {
+            space = pointer > buffer;
+            continue;
+        }
+
+        if (quote && ch == '\\')
+        {
+            if (pointer < end)
+                *pointer++ = (char)ch;
+
+            if ((ch = *current & 255) == '\0')
+                break;
+
+            current++;
+        }
+        else if (quote && ch == quote)
+        {
+            quote = 0;
+        }
+        else if (!quote && (ch == '\"' || ch == '\''))
+        {
+            quote = ch;
+        }
+        else if (!quote && ch == '(')
+        {
+            parens++;
+        }
+        else if (!quote && ch == ')' && parens > 0)
+        {
+            parens--;
+        }
+
+        if (space && pointer < end)
+            *pointer++ = ' ';
+
+        space = false;
+
+        if (pointer < end)
+            *pointer++ = (char)ch;
+        else
+            truncated = true;
+    }
+
+    *pointer = '\0';
+    *str = current;
+
+    // Importance is not tracked, drop the annotation
+    if ((size_t)(pointer - buffer) >= 10 && !strcasecmp(pointer - 10, "!important"))
+    {
+        for (pointer -= 10; pointer > buffer && pointer[-1] == ' '; pointer--)
+            ;
+
+        *pointer = '\0';
+    }
+
+    return (!truncated);
+}
+
+static int bemPeek(bem_file *file)
+{
+    int ch = bemFileGetc(file);
+
+    if (ch != EOF)
+        bemFileUngetc(file, ch);
+
+    return ch;
+}
+
+static char *bemRead(bem_file *file, bem_type *type, char *buffer, size_t buffer_size)
+{
+    char *pointer = buffer, *end = buffer + buffer_size - 1;
+    int ch, quote;
+
+    *type = BEM_TYPE_ERROR;
+
+    // Skip whitespace and comments
+    while ((ch = bemFileGetc(file)) != EOF)
+    {
+        if (ch == '/' && bemPeek(file) == '*')
+        {
+            for (bemFileGetc(file), quote = 0; (ch = bemFileGetc(file)) != EOF && (quote != '*' || ch != '/'); quote = ch)
+                ;
+        }
+        else if (!isspace(ch))
+        {
+            break;
+        }
+    }
+
+    if (ch == EOF)
+        return NULL;
+
+    if (ch == '\"' || ch == '\'')
+    {
+        for (quote = ch; (ch = bemFileGetc(file)) != EOF && ch != quote && ch != '\n';)
+        {
+            if (ch == '\\' && (ch = bemFileGetc(file)) == EOF)
+                break;
+
+            if (pointer < end)
+                *pointer++ = (char)ch;
+        }
+
+        if (ch != quote)
+        {
+            bemFileError(file, "Unterminated string.");
+            return NULL;
+        }
+
+        *type = BEM_TYPE_QSTRING;
+    }
+    else if (isdigit(ch) || ((ch == '.' || ch == '+' || ch == '-') && isdigit(bemPeek(file))))
+    {
+        // A number with optional units or percent
+        do
+        {
+            if (pointer < end)
+                *pointer++ = (char)ch;
+        } while ((ch = bemFileGetc(file)) != EOF && (isalnum(ch) || ch == '.' || ch == '%'));
+
+        if (ch != EOF)
+            bemFileUngetc(file, ch);
+
+        *type = BEM_TYPE_NUMBER;
+    }
+    else if (isalpha(ch) || ch == '_' || ch == '-' || ch == '@' || ch == '\\' || ch >= 0x80)
+    {
+        // An identifier or at-keyword
+        do
+        {
+            if (ch == '\\' && (ch = bemFileGetc(file)) == EOF)
+                break;
+
+            if (pointer < end)
+                *pointer++ = (char)ch;
+        } while ((ch = bemFileGetc(file)) != EOF && (isalnum(ch) || ch == '_' || ch == '-' || ch == '\\' || ch >= 0x80));
+
+        if (ch != EOF)
+            bemFileUngetc(file, ch);
+
+        *type = BEM_TYPE_STRING;
+    }
+    else
+    {
+        *pointer++ = (char)ch;
+
+        // Attribute operators are the only two-character tokens
+        if (strchr("~|^$*", ch) && bemPeek(file) == '=')
+            *pointer++ = (char)bemFileGetc(file);
+
+        *type = BEM_TYPE_RESERVED;
+    }
+
+    *pointer = '\0';
+
+    return buffer;
+}
+
+static bool bemReadMedia(bem_stylesheet *css, bem_file *file, bem_type *type, char *buffer, size_t buffer_size, bem_media_condition *condition)
+{
+    bem_media_query *query = NULL, *queries;
+    bem_media_feature *features;
+    char name[256], value[256], text[2048], *pointer;
+    size_t i, j;
+    bool valid = true;
+
+    memset(condition, 0, sizeof(bem_media_condition));
+
+    // Compiles a media query list up to the '{' or ';' after it, so it can be evaluated again later
+    while (valid && bemRead(file, type, buffer, buffer_size))
+    {
+        if (*type == BEM_TYPE_RESERVED && (!strcmp(buffer, "{") || !strcmp(buffer, ";")))
+            break;
+
+        if (*type == BEM_TYPE_RESERVED && !strcmp(buffer, ","))
+        {
+            valid = query != NULL;
+            query = NULL;
+            continue;
+        }
+
+        if (!query)
+        {
+            if ((queries = (bem_media_query *)realloc(condition->queries, (condition->query_amount + 1) * sizeof(bem_media_query))) == NULL)
+            {
+                valid = false;
+                continue;
+            }
+
+            condition->queries = queries;
+            query = queries + condition->query_amount++;
+            memset(query, 0, sizeof(bem_media_query));
+        }
+
+        if (*type == BEM_TYPE_RESERVED && !strcmp(buffer, "("))
+        {
+            // "(name)" or "(name: value)"
+            if (!bemRead(file, type, name, sizeof(name)) || *type != BEM_TYPE_STRING || !bemRead(file, type, buffer, buffer_size))
+            {
+                valid = false;
+                continue;
+            }
+
+            *value = '\0';
+
+            if (*type == BEM_TYPE_RESERVED && !strcmp(buffer, ":"))
+            {
+                // Join the value's tokens so "16 / 9" reads as "16/9"
+                while ((valid = bemRead(file, type, buffer, buffer_size) && *type != BEM_TYPE_QSTRING) && (*type != BEM_TYPE_RESERVED || strcmp(buffer, ")")))
+                    strncat(value, buffer, sizeof(value) - strlen(value) - 1);
+            }
+            else
+            {
+                valid = *type == BEM_TYPE_RESERVED && !strcmp(buffer, ")");
+            }
+
+            if (!valid || (features = (bem_media_feature *)realloc(query->features, (query->feature_amount + 1) * sizeof(bem_media_feature))) == NULL)
+            {
+                valid = false;
+                continue;
+            }
+
+            for (pointer = name; *pointer; pointer++)
+                *pointer = (char)tolower(*pointer & 255);
+
+            query->features = features;
+            query->features[query->feature_amount].name = bemPoolGetString(css->pool, name);
+            query->features[query->feature_amount++].value = bemPoolGetString(css->pool, value);
+        }
+        else if (*type == BEM_TYPE_STRING)
+        {
+            for (pointer = buffer; *pointer; pointer++)
+                *pointer = (char)tolower(*pointer & 255);
+
+            if (!strcmp(buffer, "not"))
+                query->negate = true;
+            else if (strcmp(buffer, "only") && strcmp(buffer, "and"))
+                query->type = strcmp(buffer, "all") ? bemPoolGetString(css->pool, buffer) : NULL;
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    // The caller checks what ended the list, the end of the file is fine for bemMapCSS()
+    if (!valid || (query == NULL && condition->query_amount > 0))
+    {
+        bemClearMedia(condition);
+        return false;
+    }
+
+    // The normalized text identifies the condition and is what bemCSSSave() stores
+    for (i = 0, pointer = text, *text = '\0'; i < condition->query_amount; i++)
+    {
+        query = condition->queries + i;
+
+        snprintf(pointer, sizeof(text) - (size_t)(pointer - text), "%s%s%s", i ? ", " : "", query->negate ? "not " : "", query->type ? query->type : "all");
+        pointer += strlen(pointer);
+
+        for (j = 0; j < query->feature_amount; j++)
+        {
+            if (*query->features[j].value)
+                snprintf(pointer, sizeof(text) - (size_t)(pointer - text), " and (%s: %s)", query->features[j].name, query->features[j].value);
+            else
+                snprintf(pointer, sizeof(text) - (size_t)(pointer - text), " and (%s)", query->features[j].name);
+
+            pointer += strlen(pointer);
+        }
+    }
+
+    condition->text = bemPoolGetString(css->pool, text);
+
+    return true;
+}
+
+static bem_dictionary *bemReadProperties(bem_stylesheet *css, bem_file *file, bem_dictionary *properties)
+{
+    bem_type type;
+    char name[256], value[65536], *pointer;
+
+    if (!properties && (properties = bemDictionaryNew(css->pool)) == NULL)
+        return NULL;
+
+    // "name: value;" pairs up to the closing '}' or the end of the file
+    while (bemRead(file, &type, name, sizeof(name)))
+    {
+        if (type == BEM_TYPE_RESERVED && !strcmp(name, "}"))
+            break;
+        else if (type == BEM_TYPE_RESERVED && !strcmp(name, ";"))
+            continue;
+
+        if (type != BEM_TYPE_STRING || !bemRead(file, &type, value, sizeof(value)) || type != BEM_TYPE_RESERVED || strcmp(value, ":"))
+        {
+            if (!bemFileError(file, "Bad declaration."))
+                break;
+
+            if (type != BEM_TYPE_RESERVED || strcmp(value, "}"))
+                bemReadValue(file, value, sizeof(value));
+
+            continue;
+        }
+
+        if (!bemReadValue(file, value, sizeof(value)))
+        {
+            if (!bemFileError(file, "Bad value for '%s'.", name))
+                break;
+
+            continue;
+        }
+
+        if (!*value)
+            continue;
+
+        // Property names are case-insensitive, custom properties are not
+        if (strncmp(name, "--", 2))
+        {
+            for (pointer = name; *pointer; pointer++)
+                *pointer = (char)tolower(*pointer & 255);
+        }
+
+        bemSetProperty(properties, name, value);
+    }
+
+    return properties;
+}
+
+static bool bemReadRules(bem_stylesheet *css, bem_file *file, int depth, unsigned condition)
+{
+    bem_type type;
+    bem_stylesheet_selector *selector, **selectors = NULL, **temp;
+    bem_dictionary *properties;
+    bem_media_condition media;
+    bem_file *import;
+    char buffer[2048], *url, *end, *media_list;
+    size_t i, selector_amount, selectors_size = 0;
+    unsigned current = condition, media_stack[32], import_condition;
+    int media_depth = 0;
+    bool result = true, match;
+
+    while (result && bemRead(file, &type, buffer, sizeof(buffer)))
+    {
+        if (type == BEM_TYPE_RESERVED && !strcmp(buffer, "}"))
+        {
+            // End of an entered @media block
+            if (media_depth > 0)
+                current = --media_depth > 0 ? media_stack[media_depth - 1] : condition;
+            else
+                result = bemFileError(file, "Unexpected '}'.");
+
+            continue;
+        }
+        else if (type == BEM_TYPE_RESERVED && !strcmp(buffer, ";"))
+        {
+            continue;
+        }
+        else if (type == BEM_TYPE_STRING && buffer[0] == '@')
+        {
+            if (!strcasecmp(buffer, "@media"))
+            {
+                if (!bemReadMedia(css, file, &type, buffer, sizeof(buffer), &media))
+                {
+                    result = bemFileError(file, "Bad @media rule.");
+                    continue;
+                }
+
+                if (type != BEM_TYPE_RESERVED || strcmp(buffer, "{"))
+                {
+                    bemClearMedia(&media);
+                    result = bemFileError(file, "Bad @media rule.");
+                    continue;
+                }
+
+                if (media_depth >= (int)(sizeof(media_stack) / sizeof(media_stack[0])))
+                {
+                    bemClearMedia(&media);
+
+                    if ((result = bemFileError(file, "Too many nested @media rules.")) == true)
+                        result = bemSkipBlock(file);
+
+                    continue;
+                }
+
+                // Pruning decides now and never builds the rules of other media, otherwise the block's rules remember their condition
+                if (css->media_pruning)
+                {
+                    match = bemMatchMedia(css, &media);
+                    bemClearMedia(&media);
+
+                    if (!match)
+                    {
+                        result = bemSkipBlock(file);
+                        continue;
+                    }
+                }
+                else
+                {
+                    media.parent = current;
+
+                    if ((current = bemAddMedia(css, &media)) == 0)
+                    {
+                        current = media_depth > 0 ? media_stack[media_depth - 1] : condition;
+                        result = bemSkipBlock(file);
+                        continue;
+                    }
+                }
+
+                media_stack[media_depth++] = current;
+            }
+            else if (!strcasecmp(buffer, "@import"))
+            {
+                // "@import url(...) media;" or "@import "..." media;"
+                if (!bemReadValue(file, buffer, sizeof(buffer)))
+                {
+                    result = bemFileError(file, "Bad @import rule.");
+                    continue;
+                }
+
+                media_list = NULL;
+
+                if (!strncasecmp(buffer, "url(", 4))
+                {
+                    for (url = buffer + 4; isspace(*url & 255); url++)
+                        ;
+
+                    if ((end = strchr(url, ')')) != NULL)
+                        media_list = end + 1;
+                }
+                else
+                {
+                    url = buffer;
+                    end = NULL;
+                }
+
+                if (*url == '\"' || *url == '\'')
+                {
+                    if ((end = strchr(url + 1, *url)) != NULL && !media_list)
+                        media_list = end + 1;
+
+                    url++;
+                }
+
+                if (!end)
+                {
+                    result = bemFileError(file, "Bad @import rule.");
+                    continue;
+                }
+
+                while (end > url && isspace(end[-1] & 255))
+                    end--;
+
+                *end = '\0';
+                import_condition = current;
+
+                while (media_list && isspace(*media_list & 255))
+                    media_list++;
+
+                if (media_list && *media_list)
+                {
+                    // Same as an @media block around the imported rules
+                    if ((import = bemFileNewString(css->pool, media_list)) == NULL)
+                        continue;
+
+                    match = bemReadMedia(css, import, &type, buffer + sizeof(buffer) / 2, sizeof(buffer) / 2, &media);
+                    bemFileDelete(import);
+
+                    if (!match)
+                    {
+                        result = bemFileError(file, "Bad media list for '%s'.", url);
+                        continue;
+                    }
+
+                    if (css->media_pruning)
+                    {
+                        match = bemMatchMedia(css, &media);
+                        bemClearMedia(&media);
+
+                        if (!match)
+                            continue;
+                    }
+                    else
+                    {
+                        media.parent = current;
+
+                        if ((import_condition = bemAddMedia(css, &media)) == 0)
+                            continue;
+                    }
+                }
+
+                if (depth >= 8)
+                {
+                    result = bemFileError(file, "Too many nested imports for '%s'.", url);
+                }
+                else if ((import = bemFileNewURL(css->pool, url, file->url)) != NULL)
+                {
+                    result = bemImportStylesheet(css, import, depth + 1, import_condition);
+                    bemFileDelete(import);
+                }
+            }
+            else
+            {
+                // Other at-rules are skipped up to their ';' or over their block
+                while (bemRead(file, &type, buffer, sizeof(buffer)) && (type != BEM_TYPE_RESERVED || (strcmp(buffer, ";") && strcmp(buffer, "{"))))
+                    ;
+
+                if (type == BEM_TYPE_RESERVED && !strcmp(buffer, "{"))
+                    result = bemSkipBlock(file);
+            }
+
+            continue;
+        }
+
+        // A comma-separated selector list and its declaration block
+        for (selector_amount = 0; (selector = bemReadSelector(css, file, &type, buffer, sizeof(buffer))) != NULL;)
+        {
+            if (selector_amount >= selectors_size)
+            {
+                if ((temp = (bem_stylesheet_selector **)realloc(selectors, (selectors_size + 32) * sizeof(bem_stylesheet_selector *))) == NULL)
+                {
+                    bemCSSSelectorDelete(selector);
+                    break;
+                }
+
+                selectors = temp;
+                selectors_size += 32;
+            }
+
+            selectors[selector_amount++] = selector;
+
+            if (!strcmp(buffer, "{") || !bemRead(file, &type, buffer, sizeof(buffer)))
+                break;
+        }
+
+        if (!selector)
+        {
+            // One bad selector drops the whole rule
+            for (i = 0; i < selector_amount; i++)
+                bemCSSSelectorDelete(selectors[i]);
+
+            if ((result = bemFileError(file, "Bad selector.")) == true)
+            {
+                while (type != BEM_TYPE_RESERVED || strcmp(buffer, "{"))
+                {
+                    if (!bemRead(file, &type, buffer, sizeof(buffer)))
+                        break;
+                }
+
+                if (type == BEM_TYPE_RESERVED && !strcmp(buffer, "{"))
+                    result = bemSkipBlock(file);
+            }
+
+            continue;
+        }
+
+        properties = bemReadProperties(css, file, NULL);
+
+        for (i = 0; i < selector_amount; i++)
+        {
+            if (properties)
+                bemAddRule(css, selectors[i], properties, current);
+            else
+                bemCSSSelectorDelete(selectors[i]);
+        }
+
+        bemDictionaryDelete(properties);
+    }
+
+    free(selectors);
+
+    return result;
+}
+
+static bem_stylesheet_selector *bemReadSelector(bem_stylesheet *css, bem_file *file, bem_type *type, char *buffer, size_t buffer_size)
+{
+    bem_stylesheet_selector *selector = NULL;
+    bem_relation relation = RELATION_CHILD;
+    bem_element element;
+    bem_match match;
+    char name[256], value[256], *pointer;
+    int ch, parens;
+    bool space;
+
+    // buffer holds the first token, each pass reads one compound selector and the combinator after it
+    for (;;)
+    {
+        element = ELEMENT_WILDCARD;
+        space = false;
+
+        if (*type == BEM_TYPE_STRING || (*type == BEM_TYPE_RESERVED && !strcmp(buffer, "*")))
+        {
+            if (*type == BEM_TYPE_STRING && (element = bemElementValue(buffer)) < ELEMENT_WILDCARD)
+                break;
+
+            space = isspace(bemPeek(file));
+
+            if (!bemRead(file, type, buffer, buffer_size))
+                break;
+        }
+        else if (*type != BEM_TYPE_RESERVED || !strchr(".#[:", buffer[0]) || buffer[1])
+        {
+            break;
+        }
+
+        if ((selector = bemCSSSelectorNew(css, selector, element, relation)) == NULL)
+            return NULL;
+
+        while (!space && *type == BEM_TYPE_RESERVED && strchr(".#[:", buffer[0]) && !buffer[1])
+        {
+            if (buffer[0] == '.' || buffer[0] == '#')
+            {
+                match = buffer[0] == '.' ? MATCH_CLASS : MATCH_ID;
+
+                if (!bemRead(file, type, buffer, buffer_size) || *type != BEM_TYPE_STRING)
+                    break;
+
+                bemCSSSelectorAddStatement(css, selector, match, buffer, NULL);
+            }
+            else if (buffer[0] == ':')
+            {
+                // Pseudo-classes and pseudo-elements, with any "(argument)" kept as the value
+                if (bemPeek(file) == ':')
+                    bemFileGetc(file);
+
+                if (!bemRead(file, type, name, sizeof(name)) || *type != BEM_TYPE_STRING)
+                    break;
+
+                for (pointer = name; *pointer; pointer++)
+                    *pointer = (char)tolower(*pointer & 255);
+
+                if (bemPeek(file) == '(')
+                {
+                    for (bemFileGetc(file), pointer = value, parens = 1; (ch = bemFileGetc(file)) != EOF; )
+                    {
+                        if (ch == '(')
+                            parens++;
+                        else if (ch == ')' && --parens == 0)
+                            break;
+
+                        if (pointer < (value + sizeof(value) - 1) && (!isspace(ch) || (pointer > value && pointer[-1] != ' ')))
+                            *pointer++ = isspace(ch) ? ' ' : (char)ch;
+                    }
+
+                    if (ch == EOF)
+                        break;
+
+                    while (pointer > value && pointer[-1] == ' ')
+                        pointer--;
+
+                    *pointer = '\0';
+
+                    bemCSSSelectorAddStatement(css, selector, MATCH_PSEUDO_CLASS, name, value);
+                }
+                else
+                {
+                    bemCSSSelectorAddStatement(css, selector, MATCH_PSEUDO_CLASS, name, NULL);
+                }
+            }
+            else
+            {
+                // "[name]", "[name=value]" or "[name op value i]"
+                if (!bemRead(file, type, name, sizeof(name)) || *type != BEM_TYPE_STRING || !bemRead(file, type, buffer, buffer_size) || *type != BEM_TYPE_RESERVED)
+                    break;
+
+                for (pointer = name; *pointer; pointer++)
+                    *pointer = (char)tolower(*pointer & 255);
+
+                if (!strcmp(buffer, "]"))
+                {
+                    bemCSSSelectorAddStatement(css, selector, MATCH_ATTRIBUTE_EXIST, name, NULL);
+                }
+                else
+                {
+                    if (!strcmp(buffer, "="))
+                        match = MATCH_ATTRIBUTE_EQUALS;
+                    else if (!strcmp(buffer, "*="))
+                        match = MATCH_ATTRIBUTE_CONTAINS;
+                    else if (!strcmp(buffer, "^="))
+                        match = MATCH_ATTRIBUTE_BEGINS;
+                    else if (!strcmp(buffer, "$="))
+                        match = MATCH_ATTRIBUTE_ENDS;
+                    else if (!strcmp(buffer, "|="))
+                        match = MATCH_ATTRIBUTE_LANGUAGE;
+                    else if (!strcmp(buffer, "~="))
+                        match = MATCH_ATTRIBUTE_SPACE;
+                    else
+                        break;
+
+                    if (!bemRead(file, type, value, sizeof(value)) || *type == BEM_TYPE_RESERVED || !bemRead(file, type, buffer, buffer_size))
+                        break;
+
+                    // Case flags are accepted but not applied
+                    if (*type == BEM_TYPE_STRING && (!strcasecmp(buffer, "i") || !strcasecmp(buffer, "s")) && !bemRead(file, type, buffer, buffer_size))
+                        break;
+
+                    if (*type != BEM_TYPE_RESERVED || strcmp(buffer, "]"))
+                        break;
+
+                    bemCSSSelectorAddStatement(css, selector, match, name, value);
+                }
+            }
+
+            space = isspace(bemPeek(file));
+
+            if (!bemRead(file, type, buffer, buffer_size))
+                break;
+        }
+
+        if (*type != BEM_TYPE_RESERVED && !space)
+            break;
+
+        // The list separator or declaration block ends the selector
+        if (*type == BEM_TYPE_RESERVED && (!strcmp(buffer, ",") || !strcmp(buffer, "{")))
+            return (selector);
+
+        if (*type == BEM_TYPE_RESERVED && (!strcmp(buffer, ">") || !strcmp(buffer, "+") || !strcmp(buffer, "~")))
+        {
+            relation = buffer[0] == '>' ? RELATION_IMMEDIATE_CHILD : buffer[0] == '+' ? RELATION_IMMEDIATE_SIBLING : RELATION_SIBLING;
+
+            if (!bemRead(file, type, buffer, buffer_size))
+                break;
+        }
+        else if (space)
+        {
+            relation = RELATION_CHILD;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    bemCSSSelectorDelete(selector);
+
+    return NULL;
+}
+
+static char *bemReadValue(bem_file *file, char *buffer, size_t buffer_size)
+{
+    char *pointer = buffer, *end = buffer + buffer_size - 1;
+    int ch, quote = 0, parens = 0;
+    bool space = false, truncated = false;
+
+    // Everything up to ';' or '}' outside of strings and parenthesis, with whitespace collapsed
+    while ((ch = bemFileGetc(file)) != EOF)
+    {
+        if (!quote && !parens && ch == ';')
+        {
+            break;
+        }
+        else if (!quote && !parens && ch == '}')
+        {
+            bemFileUngetc(file, ch);
+            break;
+        }
+        else if (!quote && ch == '/' && bemPeek(file) == '*')
+        {
+            for (bemFileGetc(file); (ch = bemFileGetc(file)) != EOF && (ch != '*' || bemPeek(file) != '/');)
+                ;
+
+            bemFileGetc(file);
+            space = pointer > buffer;
+            continue;
+        }
+        else if (!quote && isspace(ch))
+        {
+            space = pointer > buffer;
+            continue;
+        }
+
+        if (quote && ch == '\\')
+        {
+            if (pointer < end)
+                *pointer++ = (char)ch;
+
+            if ((ch = bemFileGetc(file)) == EOF)
+                break;
+        }
+        else if (quote && ch == quote)
+        {
+            quote = 0;
+        }
+        else if (!quote && (ch == '\"' || ch == '\''))
+        {
+            quote = ch;
+        }
+        else if (!quote && ch == '(')
+        {
+            parens++;
+        }
+        else if (!quote && ch == ')' && parens > 0)
+        {
+            parens--;
+        }
+
+        if (space && pointer < end)
+            *pointer++ = ' ';
+
+        space = false;
+
+        if (pointer < end)
+            *pointer++ = (char)ch;
+        else
+            truncated = true;
+    }
+
+    *pointer = '\0';
+
+    // Importance is not tracked, drop the annotation
+    if ((size_t)(pointer - buffer) >= 10 && !strcasecmp(pointer - 10, "!important"))
+    {
+        for (pointer -= 10; pointer > buffer && pointer[-1] == ' '; pointer--)
+            ;
+
+        *pointer = '\0';
+    }
+
+    return (truncated ? NULL : buffer);
+}
+
+static void *bemRelocateCSS(bem_uchar *map, const void *pointer, size_t table, size_t amount, size_t size, bool *valid)
+{
+    size_t offset = (size_t)(uintptr_t)pointer;
+
+    if (!offset)
+        return NULL;
+
+    if (offset < table || (offset - table) / size >= amount || (offset - table) % size)
+    {
+        *valid = false;
+        return NULL;
+    }
+
+    return (map + offset);
+}
+
+static void bemSetProperty(bem_dictionary *properties, const char *name, const char *value)
+{
+    static const char *const sides[] = {"top", "right", "bottom", "left"};
+    static const char *const parts[] = {"color", "style", "width"};
+    static const char *const initial[] = {"currentcolor", "none", "medium"};
+    static const char *const styles[] = {"none", "hidden", "dotted", "dashed", "solid", "double", "groove", "ridge", "inset", "outset"};
+    static const int shorthand[4][4] = {{0, 0, 0, 0}, {0, 1, 0, 1}, {0, 1, 2, 1}, {0, 1, 2, 3}};
+    const char *tokens[5], *values[3];
+    char buffer[1024], key[64];
+    size_t i, j, count, part = 3;
+    int side = 4, first, last;
+
+    // Shorthands are stored as their longhands, so whichever declaration comes last in the cascade wins
+    if (!strncmp(name, "border-", 7))
+    {
+        for (part = 0; part < 3 && strcmp(name + 7, parts[part]); part++)
+            ;
+
+        for (side = 0; side < 4 && strcmp(name + 7, sides[side]); side++)
+            ;
+    }
+
+    if (!strcmp(name, "margin") || !strcmp(name, "padding") || part < 3)
+    {
+        // "margin", "padding", "border-color", "border-style" and "border-width" list top, right, bottom and left
+        if ((count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 5)) < 1 || count > 4)
+            return;
+
+        for (side = 0; side < 4; side++)
+        {
+            if (part < 3)
+                snprintf(key, sizeof(key), "border-%s-%s", sides[side], parts[part]);
+            else
+                snprintf(key, sizeof(key), "%s-%s", name, sides[side]);
+
+            bemDictionarySetKeyValue(properties, key, tokens[shorthand[count - 1][side]]);
+        }
+    }
+    else if (!strcmp(name, "border") || side < 4)
+    {
+        // "border" and "border-<side>" take a color, style and width in any order and reset the ones left out
+        if ((count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 4)) < 1 || count > 3)
+            return;
+
+        if (count == 1 && (!strcasecmp(tokens[0], "inherit") || !strcasecmp(tokens[0], "initial")))
+        {
+            values[0] = values[1] = values[2] = tokens[0];
+        }
+        else
+        {
+            values[0] = values[1] = values[2] = NULL;
+
+            for (i = 0; i < count; i++)
+            {
+                for (j = 0; j < sizeof(styles) / sizeof(styles[0]) && strcasecmp(tokens[i], styles[j]); j++)
+                    ;
+
+                if (j < sizeof(styles) / sizeof(styles[0]))
+                    part = 1;
+                else if (isdigit(*tokens[i] & 255) || *tokens[i] == '.' || !strcasecmp(tokens[i], "thin") || !strcasecmp(tokens[i], "medium") || !strcasecmp(tokens[i], "thick"))
+                    part = 2;
+                else
+                    part = 0;
+
+                // Each part at most once
+                if (values[part])
+                    return;
+
+                values[part] = tokens[i];
+            }
+
+            for (part = 0; part < 3; part++)
+            {
+                if (!values[part])
+                    values[part] = initial[part];
+            }
+        }
+
+        for (first = side < 4 ? side : 0, last = side < 4 ? side : 3; first <= last; first++)
+        {
+            for (part = 0; part < 3; part++)
+            {
+                snprintf(key, sizeof(key), "border-%s-%s", sides[first], parts[part]);
+                bemDictionarySetKeyValue(properties, key, values[part]);
+            }
+        }
+    }
+    else
+    {
+        bemDictionarySetKeyValue(properties, name, value);
+    }
+}
+
+static bool bemSkipBlock(bem_file *file)
+{
+    int ch, quote = 0, depth = 1;
+
+    // Skips to the '}' matching an already read '{' without tokenizing
+    while ((ch = bemFileGetc(file)) != EOF)
+    {
+        if (quote)
+        {
+            if (ch == '\\')
+                bemFileGetc(file);
+            else if (ch == quote)
+                quote = 0;
+        }
+        else if (ch == '\"' || ch == '\'')
+        {
+            quote = ch;
+        }
+        else if (ch == '/' && bemPeek(file) == '*')
+        {
+            for (bemFileGetc(file); (ch = bemFileGetc(file)) != EOF && (ch != '*' || bemPeek(file) != '/');)
+                ;
+
+            bemFileGetc(file);
+        }
+        else if (ch == '{')
+        {
+            depth++;
+        }
+        else if (ch == '}' && --depth == 0)
+        {
+            return true;
+        }
+    }
+
+    return bemFileError(file, "Unterminated block.");
+}
+
+static const char *bemSkipInlineSpace(const char *str)
+{
+    // Whitespace and comments between tokens, an unterminated comment runs to the end
+    for (;;)
+    {
+        while (isspace(*str & 255))
+            str++;
+
+        if (str[0] != '/' || str[1] != '*')
+            return str;
+
+        for (str += 2; *str && (str[0] != '*' || str[1] != '/'); str++)
+            ;
+
+        if (*str)
+            str += 2;
+    }
+}
+
+static void bemUnmapCSS(bem_stylesheet *css)
+{
+    bem_rule_collection all_rules = css->all_rules;
+    bem_stylesheet_selector *selector;
+    bem_dictionary *properties;
+    bem_rule_set *rule;
+    void *mapping = css->mapping;
+    unsigned rule_order = css->rule_order;
+    size_t i, j;
+
+    // Copy the mapped rules to the heap so the stylesheet can be changed
+    css->mapping = NULL;
+    memset(&css->all_rules, 0, sizeof(css->all_rules));
+    memset(css->rules, 0, sizeof(css->rules));
+
+    for (i = 0; i < all_rules.rules_amount; i++)
+    {
+        if ((selector = bemCopySelector(css, all_rules.rules[i]->selector)) == NULL)
+            continue;
+
+        if ((properties = bemDictionaryCopy(all_rules.rules[i]->properties)) != NULL)
+        {
+            for (j = 0; j < properties->pair_amount; j++)
+            {
+                properties->pairs[j].key = bemPoolGetString(css->pool, properties->pairs[j].key);
+                properties->pairs[j].value = bemPoolGetString(css->pool, properties->pairs[j].value);
+            }
+        }
+
+        if ((rule = bemRuleNew(css, all_rules.rules[i]->hash, selector, properties)) != NULL)
+        {
+            rule->order = all_rules.rules[i]->order;
+            rule->condition = all_rules.rules[i]->condition;
+            bemRuleCollectionAdd(css, &css->all_rules, rule);
+            bemRuleCollectionAdd(css, css->rules + selector->element, rule);
+        }
+        else
+        {
+            bemCSSSelectorDelete(selector);
+            bemDictionaryDelete(properties);
+        }
+    }
+
+    munmap(mapping, css->mapping_size);
+    css->mapping_size = 0;
+    css->rule_order = rule_order;
+}
+
+bem_dictionary *bemDictionaryCopy(const bem_dictionary *dictionary)
+{
+    bem_dictionary *new_dictionary;
+
+    if (!dictionary)
+        return NULL;
+    if ((new_dictionary = calloc(1, sizeof(bem_dictionary))) == NULL)
+        return NULL;
+
+    new_dictionary->pool = dictionary->pool;
+    new_dictionary->pair_amount = dictionary->pair_amount;
+    new_dictionary->pairs_size = dictionary->pair_amount;
+
+    if ((new_dictionary->pairs = calloc(new_dictionary->pair_amount, sizeof(bem_pair))) == NULL)
+    {
+        free(new_dictionary);
+        return NULL;
+    }
+
+    memcpy(new_dictionary->pairs, dictionary->pairs, new_dictionary->pair_amount * sizeof(bem_pair));
+
+    return new_dictionary;
+}
+
+void bemDictionaryDelete(bem_dictionary *dictionary)
+{
+    if (dictionary)
+    {
+        if (dictionary->pairs)
+            free(dictionary->pairs);
+        free(dictionary);
+    }
+}
+
+size_t bemDictionaryGetCount(const bem_dictionary *dictionary)
+{
+    return (dictionary ? dictionary->pair_amount : 0);
+}
+
+const char *bemDictionaryGetIndexKeyValue(const bem_dictionary *dictionary, size_t index, const char **key)
+{
+    if (!dictionary || index >= dictionary->pair_amount || !key)
+        return NULL;
+
+    *key = dictionary->pairs[index].key;
+
+    return dictionary->pairs[index].value;
+}
+
+const char *bemDictionaryGetKeyValue(const bem_dictionary *dictionary, const char *key)
+{
+    bem_pair temp, *ptr;
+
+    if (!dictionary || dictionary->pair_amount == 0)
+        return NULL;
+
+    temp.key = key;
+    temp.value = NULL;
+
+    if ((ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs)) != NULL)
+    {
+        return ptr->value;
+    }
+
+    return NULL;
+}
+
+bem_dictionary *bemDictionaryNew(bem_memory_pool *pool)
+{
+    bem_dictionary *dictionary;
+
+    if ((dictionary = (bem_dictionary *)calloc(1, sizeof(bem_dictionary))) != NULL)
+        dictionary->pool = pool;
+
+    return dictionary;
+}
+
+void bemDictionaryRemoveKey(bem_dictionary *dictionary, const char *key)
+{
+    bem_pair temp, *ptr;
+    size_t index;
+
+    if (!dictionary || dictionary->pair_amount == 0)
+        return;
+
+    temp.key = key;
+    temp.value = NULL;
+
+    if ((ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs)) != NULL)
+    {
+        dictionary->pair_amount--;
+
+        index = (size_t)(ptr - dictionary->pairs);
+
+        if (index < dictionary->pair_amount)
+            memmove(ptr, ptr + 1, (dictionary->pair_amount - index) * sizeof(bem_pair));
+    }
+}
+
+void bemDictionarySetKeyValue(bem_dictionary *dictionary, const char *key, const char *value)
+{
+    bem_pair temp, *ptr = NULL;
+
+    if (!dictionary)
+    {
+        return;
+    }
+    else if (dictionary->pair_amount == 1 && !strcmp(dictionary->pairs[0].key, key))
+    {
+        ptr = dictionary->pairs;
+    }
+    else if (dictionary->pair_amount > 1)
+    {
+        temp.key = key;
+        ptr = (bem_pair *)bsearch(&temp, dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs);
+    }
+
+    if (ptr)
+    {
+        ptr->value = bemPoolGetString(dictionary->pool, value);
+        return;
+    }
+
+    if (dictionary->pair_amount >= dictionary->pairs_size)
+    {
+        if ((ptr = realloc(dictionary->pairs, (dictionary->pairs_size + 4) * sizeof(bem_pair))) == NULL)
+            return;
+
+        dictionary->pairs_size += 4;
+        dictionary->pairs = ptr;
+    }
+
+    ptr = dictionary->pairs + dictionary->pair_amount;
+    dictionary->pair_amount++;
+
+    ptr->key = bemPoolGetString(dictionary->pool, key);
+    ptr->value = bemPoolGetString(dictionary->pool, value);
+
+    qsort(dictionary->pairs, dictionary->pair_amount, sizeof(bem_pair), (bem_comparison_function)bemComparePairs);
+}
+
+static int bemComparePairs(bem_pair *a, bem_pair *b)
+{
+    return strcasecmp(a->key, b->key);
+}
+
+void bemPoolDelete(bem_memory_pool *pool)
+{
+    if (pool)
+    {
+        if (pool->fonts_loaded || pool->font_amount > 0)
+            bemPoolDeleteFonts(pool);
+
+        if (pool->images)
+        {
+            size_t i;
+
+            for (i = 0; i < pool->images_size; i++)
+                free(pool->images[i].image);
+
+            free(pool->images);
+        }
+
+        if (pool->inlines)
+        {
+            size_t i;
+
+            for (i = 0; i < pool->inlines_size; i++)
+                bemDictionaryDelete(pool->inlines[i].properties);
+
+            free(pool->inlines);
+        }
+
+        free(pool->words);
+        free(pool->word_buckets);
+
+        if (pool->string_amount > 0)
+        {
+            size_t i;
+            char **temp;
+
+            for (i = pool->string_amount, temp = pool->strings; i > 0; i--, temp++)
+                free(*temp);
+
+            free(pool->strings);
+        }
+
+        free(pool->last_error);
+        free(pool);
+    }
+}
+
+bool bemPoolError(bem_memory_pool *pool, int line_number, const char *message, ...)
+{
+    bool result;
+
+    va_list ap;
+    va_start(ap, message);
+    result = bemPoolErrorv(pool, line_number, message, ap);
+    va_end(ap);
+
+    return result;
+}
+
+bool bemPoolErrorv(bem_memory_pool *pool, int line_number, const char *message, va_list ap)
+{
+    char buffer[8192];
+
+    vsnprintf(buffer, sizeof(buffer), message, ap);
+    free(pool->last_error);
+    pool->last_error = strdup(buffer);
+
+    return (pool->error_callback)(pool->error_context, buffer, line_number);
+}
+
+bem_image *bemPoolGetImage(bem_memory_pool *pool, const char *url, const char *base_url)
+{
+    bem_image_entry *entry;
+    bem_file *file;
+    struct stat info;
+
+    if (!pool || !url || (url = bemPoolGetURL(pool, url, base_url)) == NULL)
+        return NULL;
+
+    if ((entry = bemFindImage(pool, url)) == NULL)
+        return NULL;
+
+    if (entry->checked)
+        return entry->image;
+
+    // Entries loaded from disk are trusted while the file is unchanged, missing files aren't looked for again this session
+    entry->checked = true;
+
+    if (stat(url, &info))
+    {
+        free(entry->image);
+        entry->image = NULL;
+        entry->mtime = 0;
+        entry->size = 0;
+        return NULL;
+    }
+
+    if (entry->image || entry->size)
+    {
+        if (entry->mtime == info.st_mtime && entry->size == info.st_size)
+            return entry->image;
+
+        free(entry->image);
+        entry->image = NULL;
+    }
+
+    entry->mtime = info.st_mtime;
+    entry->size = info.st_size;
+
+    if ((file = bemFileNewURL(pool, url, NULL)) != NULL)
+    {
+        entry->image = bemImageNew(pool, file);
+        bemFileDelete(file);
+    }
+
+    return entry->image;
+}
+
+const char *bemPoolGetLastError(bem_memory_pool *pool)
+{
+    return pool ? pool->last_error : NULL;
+}
+
+const char *bemPoolGetString(bem_memory_pool *pool, const char *str)
+{
+    char *news, **temp;
+    size_t left, right, middle;
+    int result;
+
+    if (!pool || !str)
+    {
+        return NULL;
+    }
+    else if (!*str)
+    {
+        return "";
+    }
+
+    // Find the insertion point so the array stays sorted without a qsort per new string
+    for (left = 0, right = pool->string_amount; left < right;)
+    {
+        middle = (left + right) / 2;
+
+        if ((result = strcmp(str, pool->strings[middle])) == 0)
+            return pool->strings[middle];
+        else if (result < 0)
+            right = middle;
+        else
+            left = middle + 1;
+    }
+
+    if (pool->string_amount >= pool->strings_size)
+    {
+        if ((temp = realloc(pool->strings, (pool->strings_size + 32) * sizeof(char *))) == NULL)
+            return NULL;
+
+        pool->strings_size += 32;
+        pool->strings = temp;
+    }
+
+    if ((news = strdup(str)) == NULL)
+        return NULL;
+
+    memmove(pool->strings + left + 1, pool->strings + left, (pool->string_amount - left) * sizeof(char *));
+    pool->strings[left] = news;
+    pool->string_amount++;
+
+    return news;
+}
+
+const char *bemPoolGetURL(bem_memory_pool *pool, const char *url, const char *base_url)
+{
+    const char *mapped;
+    char *ptr, temp[1024], new_url[1024];
+
+    if (*url == '/')
+    {
+        if (!base_url)
+        {
+            return bemPoolGetString(pool, url);
+        }
+        else if (!strncmp(base_url, "http://", 7))
+        {
+            strncpy(temp, base_url, sizeof(temp) - 1);
+            temp[sizeof(temp) - 1] = '\0';
+
+            if ((ptr = strchr(temp + 7, '/')) != NULL)
+                *ptr = '\0';
+
+            snprintf(new_url, sizeof(new_url), "%s%s", temp, url);
+            url = new_url;
+        }
+        else if (!strncmp(base_url, "https://", 8))
+        {
+            strncpy(temp, base_url, sizeof(temp) - 1);
+            temp[sizeof(temp) - 1] = '\0';
+
+            if ((ptr = strchr(temp + 8, '/')) != NULL)
+                *ptr = '\0';
+
+            snprintf(new_url, sizeof(new_url), "%s%s", temp, url);
+            url = new_url;
+        }
+        else
+        {
+            return bemPoolGetString(pool, url);
+        }
+    }
+    else if (strncmp(url, "http://", 7) && strncmp(url, "https://", 8))
+    {
+        if (!base_url)
+        {
+            getcwd(temp, sizeof(temp));
+            snprintf(new_url, sizeof(new_url), "%s/%s", temp, url);
+
+            return bemPoolGetString(pool, new_url);
+        }
+        else
+        {
+            strncpy(temp, base_url, sizeof(temp) - 1);
+            temp[sizeof(temp) - 1] = '\0';
+
+            if ((ptr = strrchr(temp, '/')) != NULL)
+                *ptr = '\0';
+
+            snprintf(new_url, sizeof(new_url), "%s/%s", temp, url);
+
+            if (new_url[0] == '/')
+                return (bemPoolGetString(pool, new_url));
+
+            url = new_url;
+        }
+    }
+
+    // Remote URLs are only fetched once per pool
+    if (pool->urls && (mapped = bemDictionaryGetKeyValue(pool->urls, url)) != NULL)
+        return (mapped);
+
+    if ((mapped = (pool->url_callback)(pool->url_context, url, temp, sizeof(temp))) != NULL)
+    {
+        if (!pool->urls)
+            pool->urls = bemDictionaryNew(pool);
+
+        bemDictionarySetKeyValue(pool->urls, url, temp);
+        mapped = bemPoolGetString(pool, temp);
+    }
+
+    return (mapped);
+}
+
+const bem_word_stats *bemPoolGetWordStats(bem_memory_pool *pool)
+{
+    return (pool ? &pool->word_stats : NULL);
+}
+
+bool bemPoolLoadImages(bem_memory_pool *pool, const char *filename)
+{
+    bem_image_entry *entry;
+    bem_image *image;
+    FILE *fp;
+    char line[2048], format[64], *url;
+    long long mtime, size;
+    int width, height, x_resolution, y_resolution, units, length;
+
+    if (!pool || !filename || (fp = fopen(filename, "r")) == NULL)
+        return false;
+
+    if (!fgets(line, sizeof(line), fp) || strcmp(line, "BEMIMAGES 1\n"))
+    {
+        fclose(fp);
+        return false;
+    }
+
+    // One "mtime size format width height x-resolution y-resolution units url" line per entry
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (sscanf(line, "%lld %lld %63s %d %d %d %d %d %n", &mtime, &size, format, &width, &height, &x_resolution, &y_resolution, &units, &length) != 8)
+            continue;
+
+        url = line + length;
+        url[strcspn(url, "\n")] = '\0';
+
+        if (!*url || (entry = bemFindImage(pool, bemPoolGetString(pool, url))) == NULL || entry->checked || entry->image || entry->size)
+            continue;
+
+        entry->mtime = (time_t)mtime;
+        entry->size = (off_t)size;
+
+        if (strcmp(format, "-") && width > 0 && height > 0 && (image = (bem_image *)calloc(1, sizeof(bem_image))) != NULL)
+        {
+            image->pool = pool;
+            image->format = bemPoolGetString(pool, format);
+            image->width = width;
+            image->height = height;
+            image->x_resolution = x_resolution;
+            image->y_resolution = y_resolution;
+            image->units = units == RESOLUTION_PER_INCH || units == RESOLUTION_PER_CM ? (bem_resolution)units : RESOLUTION_NONE;
+            entry->image = image;
+        }
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+float bemPoolMeasureWord(bem_memory_pool *pool, const bem_text *text, const char *word, size_t length)
+{
+    bem_word_entry *entry, *other;
+    char buffer[256], *temp = NULL;
+    unsigned hash = 0, index, *link, bits[3];
+    size_t i;
+    float width = 0.0f;
+
+    if (!pool || !text || !text->font || !word)
+        return 0.0f;
+
+    if (pool->words_size > 0 && length <= BEM_WORD_MAX_LENGTH)
+    {
+        // FNV-1a over the word and everything else that changes its width
+        memcpy(bits + 0, &text->font_size, sizeof(float));
+        memcpy(bits + 1, &text->letter_spacing, sizeof(float));
+        memcpy(bits + 2, &text->word_spacing, sizeof(float));
+
+        for (i = 0, hash = 2166136261u; i < length; i++)
+            hash = (hash ^ (unsigned char)word[i]) * 16777619u;
+
+        hash = (hash ^ (unsigned)((size_t)text->font >> 4)) * 16777619u;
+        hash = (hash ^ bits[0] ^ (bits[1] << 7) ^ (bits[2] << 13)) * 16777619u;
+
+        if ((entry = bemFindWord(pool, text, word, length, hash)) != NULL)
+        {
+            pool->word_stats.hits++;
+            return entry->width;
+        }
+    }
+
+    // bemFontMeasureText() wants a nul-terminated string
+    if (length < sizeof(buffer))
+    {
+        memcpy(buffer, word, length);
+        buffer[length] = '\0';
+        bemFontMeasureText(text->font, text, buffer, NULL, 0, &width);
+    }
+    else if ((temp = (char *)malloc(length + 1)) != NULL)
+    {
+        memcpy(temp, word, length);
+        temp[length] = '\0';
+        bemFontMeasureText(text->font, text, temp, NULL, 0, &width);
+        free(temp);
+    }
+
+    if (pool->words_size == 0 || length > BEM_WORD_MAX_LENGTH)
+    {
+        pool->word_stats.uncached++;
+        return width;
+    }
+
+    pool->word_stats.misses++;
+
+    if (!pool->words)
+    {
+        if ((pool->words = (bem_word_entry *)calloc(pool->words_size, sizeof(bem_word_entry))) == NULL)
+            return width;
+
+        if ((pool->word_buckets = (unsigned *)calloc(pool->words_size, sizeof(unsigned))) == NULL)
+        {
+            free(pool->words);
+            pool->words = NULL;
+            return width;
+        }
+    }
+
+    if (pool->word_amount < pool->words_size)
+    {
+        index = (unsigned)++pool->word_amount;
+        entry = pool->words + index - 1;
+    }
+    else
+    {
+        // Full, reuse the least recently used entry
+        index = pool->word_oldest;
+        entry = pool->words + index - 1;
+
+        for (link = pool->word_buckets + (entry->hash & (pool->words_size - 1)); *link != index; link = &pool->words[*link - 1].chain)
+            ;
+
+        *link = entry->chain;
+
+        if ((pool->word_oldest = entry->newer) != 0)
+            pool->words[entry->newer - 1].older = 0;
+        else
+            pool->word_newest = 0;
+
+        pool->word_stats.evictions++;
+    }
+
+    entry->font = text->font;
+    entry->font_size = text->font_size;
+    entry->letter_spacing = text->letter_spacing;
+    entry->word_spacing = text->word_spacing;
+    entry->width = width;
+    entry->hash = hash;
+    entry->length = (unsigned char)length;
+
+    memcpy(entry->word, word, length);
+    entry->word[length] = '\0';
+
+    entry->chain = pool->word_buckets[hash & (pool->words_size - 1)];
+    pool->word_buckets[hash & (pool->words_size - 1)] = index;
+
+    entry->newer = 0;
+    entry->older = pool->word_newest;
+
+    if (pool->word_newest)
+    {
+        other = pool->words + pool->word_newest - 1;
+        other->newer = index;
+    }
+
+    pool->word_newest = index;
+
+    if (!pool->word_oldest)
+        pool->word_oldest = index;
+
+    return (width);
+}
+
+bem_memory_pool *bemPoolNew(void)
+{
+    bem_memory_pool *pool = (bem_memory_pool *)calloc(1, sizeof(bem_memory_pool));
+
+    if (pool)
+    {
+        if ((pool->locale = localeconv()) != NULL)
+        {
+            if (!pool->locale->decimal_point || !strcmp(pool->locale->decimal_point, "."))
+            {
+                pool->locale = NULL;
+            }
+            else
+            {
+                pool->locale_decimal_length = strlen(pool->locale->decimal_point);
+            }
+        }
+
+        pool->error_callback = bemDefaultErrorCallback;
+        pool->url_callback = bemDefaultURLCallback;
+        pool->words_size = BEM_WORD_CACHE_SIZE;
+    }
+
+    return (pool);
+}
+
+bool bemPoolSaveImages(bem_memory_pool *pool, const char *filename)
+{
+    if (!pool || !filename)
+        return false;
+
+    return (bemWriteFile(filename, (bem_write_function)bemWriteImages, pool));
+}
+
+void bemPoolSetCSSCache(bem_memory_pool *pool, const char *directory)
+{
+    if (!pool)
+        return;
+
+    pool->css_cache = directory && *directory ? bemPoolGetString(pool, directory) : NULL;
+}
+
+void bemPoolSetErrorCallback(bem_memory_pool *pool, bem_error_callback callback, void *context)
+{
+    if (!pool)
+        return;
+
+    pool->error_callback = callback ? callback : bemDefaultErrorCallback;
+    pool->error_context = context;
+}
+
+void bemPoolSetFontMetrics(bem_memory_pool *pool, const char *directory)
+{
+    if (!pool)
+        return;
+
+    pool->font_metrics = directory && *directory ? bemPoolGetString(pool, directory) : NULL;
+}
+
+void bemPoolSetFontThreads(bem_memory_pool *pool, int threads)
+{
+    if (!pool)
+        return;
+
+    pool->font_threads = threads > 0 ? threads : 0;
+}
+
+void bemPoolSetURLCallback(bem_memory_pool *pool, bem_url_callback callback, void *context)
+{
+    if (!pool)
+        return;
+
+    pool->url_callback = callback ? callback : bemDefaultURLCallback;
+    pool->url_context = context;
+}
+
+void bemPoolSetWordCache(bem_memory_pool *pool, size_t size)
+{
+    if (!pool)
+        return;
+
+    // Entries are linked by 32-bit indices, the size is rounded down to a power of two for the buckets
+    if (size > 0x40000000)
+        size = 0x40000000;
+
+    while (size & (size - 1))
+        size &= size - 1;
+
+    free(pool->words);
+    free(pool->word_buckets);
+
+    pool->word_amount = 0;
+    pool->words_size = size;
+    pool->words = NULL;
+    pool->word_buckets = NULL;
+    pool->word_newest = 0;
+    pool->word_oldest = 0;
+
+    memset(&pool->word_stats, 0, sizeof(pool->word_stats));
+}
+
+static bem_word_entry *bemFindWord(bem_memory_pool *pool, const bem_text *text, const char *word, size_t length, unsigned hash)
+{
+    bem_word_entry *entry;
+    unsigned index;
+
+    if (!pool->words)
+        return NULL;
+
+    for (index = pool->word_buckets[hash & (pool->words_size - 1)]; index; index = entry->chain)
+    {
+        entry = pool->words + index - 1;
+
+        if (entry->hash != hash || entry->font != text->font || entry->length != length || entry->font_size != text->font_size ||
+            entry->letter_spacing != text->letter_spacing || entry->word_spacing != text->word_spacing || memcmp(entry->word, word, length))
+            continue;
+
+        // Move the entry to the front of the LRU list
+        if (pool->word_newest != index)
+        {
+            pool->words[entry->newer - 1].older = entry->older;
+
+            if (entry->older)
+                pool->words[entry->older - 1].newer = entry->newer;
+            else
+                pool->word_oldest = entry->newer;
+
+            entry->newer = 0;
+            entry->older = pool->word_newest;
+            pool->words[pool->word_newest - 1].newer = index;
+            pool->word_newest = index;
+        }
+
+        return entry;
+    }
+
+    return NULL;
+}
+
+void bemSHA3Final(bem_sha3 *context, unsigned char *hash, size_t hash_length)
+{
+    // SHA-3 domain separation and pad10*1
+    context->state[context->bytes_used] ^= 0x06;
+    context->state[context->bytes_per_block - 1] ^= 0x80;
+
+    bemSHA3Permute(context->state);
+
+    if (hash_length > context->bytes_per_block)
+        hash_length = context->bytes_per_block;
+
+    memcpy(hash, context->state, hash_length);
+}
+
+void bemSHA3Init(bem_sha3 *context)
+{
+    memset(context, 0, sizeof(bem_sha3));
+
+    context->bytes_per_block = 200 - 2 * BEM_SHA3_256_SIZE;
+}
+
+void bemSHA3Update(bem_sha3 *context, const void *data, size_t data_length)
+{
+    const bem_uchar *bytes = (const bem_uchar *)data;
+
+    while (data_length > 0)
+    {
+        context->state[context->bytes_used++] ^= *bytes++;
+        data_length--;
+
+        if (context->bytes_used == context->bytes_per_block)
+        {
+            bemSHA3Permute(context->state);
+            context->bytes_used = 0;
+        }
+    }
+}
+
+static void bemSHA3Permute(bem_uchar *state)
+{
+    static const uint64_t round_constants[24] = {
+        0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+        0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+        0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+        0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+        0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+        0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+    static const int rotations[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+    static const int lanes[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+    uint64_t a[25], c[5], d, t, u;
+    int i, j, round;
+
+    // The state is stored as little-endian lanes
+    for (i = 0; i < 25; i++)
+    {
+        for (a[i] = 0, j = 7; j >= 0; j--)
+            a[i] = (a[i] << 8) | state[8 * i + j];
+    }
+
+    for (round = 0; round < 24; round++)
+    {
+        for (i = 0; i < 5; i++)
+            c[i] = a[i] ^ a[i + 5] ^ a[i + 10] ^ a[i + 15] ^ a[i + 20];
+
+        for (i = 0; i < 5; i++)
+        {
+            d = c[(i + 4) % 5] ^ ((c[(i + 1) % 5] << 1) | (c[(i + 1) % 5] >> 63));
+
+            for (j = 0; j < 25; j += 5)
+                a[i + j] ^= d;
+        }
+
+        for (i = 0, t = a[1]; i < 24; i++)
+        {
+            u = a[lanes[i]];
+            a[lanes[i]] = (t << rotations[i]) | (t >> (64 - rotations[i]));
+            t = u;
+        }
+
+        for (j = 0; j < 25; j += 5)
+        {
+            for (i = 0; i < 5; i++)
+                c[i] = a[j + i];
+
+            for (i = 0; i < 5; i++)
+                a[j + i] = c[i] ^ (~c[(i + 1) % 5] & c[(i + 2) % 5]);
+        }
+
+        a[0] ^= round_constants[round];
+    }
+
+    for (i = 0; i < 25; i++)
+    {
+        for (j = 0; j < 8; j++)
+            state[8 * i + j] = (bem_uchar)(a[i] >> (8 * j));
+    }
+}
+
+void bemImageDelete(bem_image *image)
+{
+    free(image);
+}
+
+const char *bemImageGetFormat(bem_image *image)
+{
+    return (image ? image->format : NULL);
+}
+
+int bemImageGetHeight(bem_image *image)
+{
+    return (image ? image->height : 0);
+}
+
+bem_size bemImageGetSize(bem_image *image)
+{
+    bem_size size;
+
+    if (image)
+    {
+        if (image->x_resolution > 0 && image->y_resolution > 0 && image->units != RESOLUTION_NONE)
+        {
+            if (image->units == RESOLUTION_PER_INCH)
+            {
+                size.width = 72.0f * image->width / image->x_resolution;
+                size.height = 72.0f * image->height / image->y_resolution;
+            }
+            else
+            {
+                size.width = 72.0f / 2.54f * image->width / image->x_resolution;
+                size.height = 72.0f / 2.54f * image->height / image->y_resolution;
+            }
+        }
+        else
+        {
+            size.width = 0.72f * image->width;
+            size.height = 0.72f * image->height;
+        }
+    }
+    else
+    {
+        size.width = 0.0f;
+        size.height = 0.0f;
+    }
+
+    return (size);
+}
+
+int bemImageGetWidth(bem_image *image)
+{
+    return (image ? image->width : 0);
+}
+
+bem_image *bemImageNew(bem_memory_pool *pool, bem_file *file)
+{
+    bem_image *image;
+    bem_image_probe probe;
+    bem_uchar buffer[32];
+    size_t position = 0;
+    int status = 0;
+
+    if (!pool || !file)
+        return NULL;
+
+    if ((image = (bem_image *)calloc(1, sizeof(bem_image))) == NULL)
+        return NULL;
+
+    image->pool = pool;
+
+    memset(&probe, 0, sizeof(probe));
+    probe.length = 12;
+
+    // Only read the bytes the prober asks for, seeking past everything else
+    while (status == 0)
+    {
+        if (probe.offset != position && bemFileSeek(file, probe.offset) != probe.offset)
+            break;
+
+        if (bemFileRead(file, buffer, probe.length) != probe.length)
+            break;
+
+        position = probe.offset + probe.length;
+        status = bemImageProbe(&probe, image, buffer);
+    }
+
+    if (status <= 0)
+    {
+        free(image);
+        return NULL;
+    }
+
+    return (image);
+}
+
+bem_image *bemImageNewBuffer(bem_memory_pool *pool, const void *buffer, size_t bytes, size_t *needed)
+{
+    bem_image *image;
+    bem_image_probe probe;
+    int status = 0;
+
+    if (needed)
+        *needed = 0;
+
+    if (!pool || !buffer)
+        return NULL;
+
+    if ((image = (bem_image *)calloc(1, sizeof(bem_image))) == NULL)
+        return NULL;
+
+    image->pool = pool;
+
+    memset(&probe, 0, sizeof(probe));
+    probe.length = 12;
+
+    // The buffer may only be a prefix of the image, report how much of it is needed to continue
+    while (status == 0 && probe.length <= bytes && probe.offset <= bytes - probe.length)
+        status = bemImageProbe(&probe, image, (const bem_uchar *)buffer + probe.offset);
+
+    if (status <= 0)
+    {
+        if (status == 0 && needed)
+            *needed = probe.offset + probe.length;
+
+        free(image);
+        return NULL;
+    }
+
+    return (image);
+}
+
+static bem_image_entry *bemFindImage(bem_memory_pool *pool, const char *url)
+{
+    bem_image_entry *images, *entry;
+    size_t i, hash, images_size;
+
+    if (!url)
+        return NULL;
+
+    if (pool->image_amount >= pool->images_size / 2)
+    {
+        images_size = pool->images_size ? 2 * pool->images_size : 64;
+
+        if ((images = (bem_image_entry *)calloc(images_size, sizeof(bem_image_entry))) == NULL)
+            return NULL;
+
+        for (i = 0, entry = pool->images; i < pool->images_size; i++, entry++)
+        {
+            if (!entry->url)
+                continue;
+
+            hash = ((size_t)entry->url >> 4) & (images_size - 1);
+
+            while (images[hash].url)
+                hash = (hash + 1) & (images_size - 1);
+
+            images[hash] = *entry;
+        }
+
+        free(pool->images);
+        pool->images = images;
+        pool->images_size = images_size;
+    }
+
+    // URLs are interned, so the pointer is the key
+    for (i = ((size_t)url >> 4) & (pool->images_size - 1); pool->images[i].url; i = (i + 1) & (pool->images_size - 1))
+    {
+        if (pool->images[i].url == url)
+            return pool->images + i;
+    }
+
+    pool->images[i].url = url;
+    pool->image_amount++;
+
+    return pool->images + i;
+}
+
+static int bemImageProbe(bem_image_probe *probe, bem_image *image, const bem_uchar *data)
+{
+    size_t length;
+    int marker;
+
+    switch (probe->state)
+    {
+    case IMAGE_PROBE_SIGNATURE:
+        // 12 bytes are enough to tell every supported format apart
+        if (!memcmp(data, "\211PNG\015\012\032\012", 8))
+        {
+            image->format = "image/png";
+            probe->state = IMAGE_PROBE_PNG;
+            probe->offset = 12;
+            probe->length = 12;
+        }
+        else if (!memcmp(data, "GIF87a", 6) || !memcmp(data, "GIF89a", 6))
+        {
+            image->format = "image/gif";
+            image->width = (data[7] << 8) | data[6];
+            image->height = (data[9] << 8) | data[8];
+            return (image->width > 0 && image->height > 0 ? 1 : -1);
+        }
+        else if (!memcmp(data, "\377\330\377", 3))
+        {
+            image->format = "image/jpeg";
+            probe->state = IMAGE_PROBE_JPEG_MARKER;
+            probe->offset = 2;
+            probe->length = 4;
+        }
+        else if (!memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WEBP", 4))
+        {
+            image->format = "image/webp";
+            probe->state = IMAGE_PROBE_WEBP;
+            probe->offset = 12;
+            probe->length = 18;
+        }
+        else if (!memcmp(data, "BM", 2))
+        {
+            image->format = "image/bmp";
+            probe->state = IMAGE_PROBE_BMP;
+            probe->offset = 14;
+            probe->length = 12;
+        }
+        else
+        {
+            return -1;
+        }
+        return 0;
+
+    case IMAGE_PROBE_PNG:
+        // IHDR must be the first chunk
+        if (memcmp(data, "IHDR", 4))
+            return -1;
+
+        image->width = (int)bemDecodeUlong(data + 4);
+        image->height = (int)bemDecodeUlong(data + 8);
+        return (image->width > 0 && image->height > 0 ? 1 : -1);
+
+    case IMAGE_PROBE_BMP:
+        if ((length = (size_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned)data[3] << 24))) == 12)
+        {
+            // OS/2 BITMAPCOREHEADER with 16-bit dimensions
+            image->width = data[4] | (data[5] << 8);
+            image->height = data[6] | (data[7] << 8);
+            return (image->width > 0 && image->height > 0 ? 1 : -1);
+        }
+
+        if (length < 40)
+            return -1;
+
+        image->width = (int)(data[4] | (data[5] << 8) | (data[6] << 16) | ((unsigned)data[7] << 24));
+        image->height = (int)(data[8] | (data[9] << 8) | (data[10] << 16) | ((unsigned)data[11] << 24));
+
+        // Negative heights are top-down bitmaps; INT_MIN has no positive counterpart
+        if (image->height == INT_MIN)
+            return -1;
+        else if (image->height < 0)
+            image->height = -image->height;
+
+        if (image->width <= 0 || image->height <= 0)
+            return -1;
+
+        probe->state = IMAGE_PROBE_BMP_RESOLUTION;
+        probe->offset = 38;
+        probe->length = 8;
+        return 0;
+
+    case IMAGE_PROBE_BMP_RESOLUTION:
+        // Pixels per meter
+        image->x_resolution = (int)(data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned)data[3] << 24)) / 100;
+        image->y_resolution = (int)(data[4] | (data[5] << 8) | (data[6] << 16) | ((unsigned)data[7] << 24)) / 100;
+
+        if (image->x_resolution > 0 && image->y_resolution > 0)
+            image->units = RESOLUTION_PER_CM;
+        else
+            image->x_resolution = image->y_resolution = 0;
+        return 1;
+
+    case IMAGE_PROBE_WEBP:
+        if (!memcmp(data, "VP8 ", 4) && !memcmp(data + 11, "\235\001\052", 3))
+        {
+            // Lossy, 14-bit dimensions after the key frame start code
+            image->width = (data[14] | (data[15] << 8)) & 0x3fff;
+            image->height = (data[16] | (data[17] << 8)) & 0x3fff;
+        }
+        else if (!memcmp(data, "VP8L", 4) && data[8] == 0x2f)
+        {
+            // Lossless, 14-bit width and height minus one packed into 28 bits
+            image->width = (data[9] | ((data[10] & 0x3f) << 8)) + 1;
+            image->height = ((data[10] >> 6) | (data[11] << 2) | ((data[12] & 0x0f) << 10)) + 1;
+        }
+        else if (!memcmp(data, "VP8X", 4))
+        {
+            // Extended, 24-bit canvas width and height minus one
+            image->width = (data[12] | (data[13] << 8) | (data[14] << 16)) + 1;
+            image->height = (data[15] | (data[16] << 8) | (data[17] << 16)) + 1;
+        }
+        else
+        {
+            return -1;
+        }
+        return (image->width > 0 && image->height > 0 ? 1 : -1);
+
+    case IMAGE_PROBE_JPEG_MARKER:
+        if (data[0] != 0xff)
+            return -1;
+
+        if ((marker = data[1]) == 0xff)
+        {
+            // Fill byte before the marker
+            probe->offset++;
+            return 0;
+        }
+
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8))
+        {
+            // Standalone markers have no length
+            probe->offset += 2;
+            return 0;
+        }
+
+        if (marker == 0xd9 || marker == 0xda || (length = (size_t)bemDecodeUshort(data + 2)) < 2)
+            return -1;
+
+        probe->next = probe->offset + 2 + length;
+
+        if ((marker >= 0xc0 && marker <= 0xc3) || (marker >= 0xc5 && marker <= 0xc7) || (marker >= 0xc9 && marker <= 0xcb) || (marker >= 0xcd && marker <= 0xcf))
+        {
+            if (length < 7)
+                return -1;
+
+            probe->state = IMAGE_PROBE_JPEG_SOF;
+            probe->offset += 4;
+            probe->length = 5;
+        }
+        else if (marker == 0xe0 && length >= 16)
+        {
+            probe->state = IMAGE_PROBE_JPEG_JFIF;
+            probe->offset += 4;
+            probe->length = 12;
+        }
+        else
+        {
+            // Skip the segment without reading it
+            probe->offset = probe->next;
+        }
+        return 0;
+
+    case IMAGE_PROBE_JPEG_JFIF:
+        if (!memcmp(data, "JFIF", 5) && (data[7] == 1 || data[7] == 2))
+        {
+            image->units = data[7] == 1 ? RESOLUTION_PER_INCH : RESOLUTION_PER_CM;
+            image->x_resolution = bemDecodeUshort(data + 8);
+            image->y_resolution = bemDecodeUshort(data + 10);
+        }
+
+        probe->state = IMAGE_PROBE_JPEG_MARKER;
+        probe->offset = probe->next;
+        probe->length = 4;
+        return 0;
+
+    case IMAGE_PROBE_JPEG_SOF:
+        // Precision, then height and width
+        image->height = bemDecodeUshort(data + 1);
+        image->width = bemDecodeUshort(data + 3);
+        return (image->width > 0 && image->height > 0 ? 1 : -1);
+    }
+
+    return -1;
+}
+
+static bool bemWriteImages(bem_memory_pool *pool, FILE *fp)
+{
+    bem_image_entry *entry;
+    size_t i;
+    bool written;
+
+    written = fputs("BEMIMAGES 1\n", fp) >= 0;
+
+    for (i = 0, entry = pool->images; written && i < pool->images_size; i++, entry++)
+    {
+        if (!entry->url || (!entry->image && !entry->size) || strchr(entry->url, '\n'))
+            continue;
+
+        if (entry->image)
+            written = fprintf(fp, "%lld %lld %s %d %d %d %d %d %s\n", (long long)entry->mtime, (long long)entry->size, entry->image->format, entry->image->width,
+                              entry->image->height, entry->image->x_resolution, entry->image->y_resolution, (int)entry->image->units, entry->url) > 0;
+        else
+            written = fprintf(fp, "%lld %lld - 0 0 0 0 0 %s\n", (long long)entry->mtime, (long long)entry->size, entry->url) > 0;
+    }
+
+    return (written);
+}
+
+void bemFileDelete(bem_file *file)
+{
+    if (!file)
+        return;
+
+    if (file->file_pointer)
+        gzclose(file->file_pointer);
+
+    free(file);
+}
+
+bool bemFileError(bem_file *file, const char *message, ...)
+{
+    bool result;
+    char sane_url[1024], *sane_pointer, temp[1024];
+    const char *url_pointer;
+    va_list ap;
+
+    if (file->url)
+    {
+        for (sane_pointer = sane_url, url_pointer = file->url; *url_pointer && sane_pointer < (sane_url + sizeof(sane_url) - 1); url_pointer++)
+        {
+            if (*url_pointer < ' ' || *url_pointer == '%')
+            {
+                *sane_pointer++ = '_';
+            }
+            else
+            {
+                *sane_pointer++ = *url_pointer;
+            }
+        }
+        *sane_pointer = '\0';
+
+        if (file->line_number)
+        {
+            snprintf(temp, sizeof(temp), "%s:%d: %s", sane_url, file->line_number, message);
+        }
+        else if (file->url)
+        {
+            snprintf(temp, sizeof(temp), "%s: %s", sane_url, message);
+        }
+        message = temp;
+    }
+    else if (file->line_number)
+    {
+        snprintf(temp, sizeof(temp), "%d: %s", file->line_number, message);
+        message = temp;
+    }
+
+    va_start(ap, message);
+    result = bemPoolErrorv(file->pool, file->line_number, message, ap);
+    va_end(ap);
+
+    return result;
+}
+
+int bemFileGetc(bem_file *file)
+{
+    int ch;
+
+    if (file->buffer_pointer)
+    {
+        if (file->buffer_pointer < file->buffer_end)
+        {
+            ch = (int)*(file->buffer_pointer)++;
+        }
+        else
+        {
+            ch = EOF;
+        }
+    }
+    else
+    {
+        ch = gzgetc(file->file_pointer);
+    }
+
+    if (ch == '\n')
+        file->line_number++;
+
+    return ch;
+}
+
+bem_file *bemFileNewBuffer(bem_memory_pool *pool, const void *buffer, size_t bytes)
+{
+    bem_file *file;
+
+    if ((file = calloc(1, sizeof(bem_file))) != NULL)
+    {
+        file->pool = pool;
+        file->buffer = buffer;
+        file->buffer_pointer = file->buffer;
+        file->buffer_end = file->buffer + bytes;
+        file->line_number = 1;
+    }
+
+    return file;
+}
+
+bem_file *bemFileNewString(bem_memory_pool *pool, const char *str)
+{
+    return bemFileNewBuffer(pool, str, strlen(str));
+}
+
+bem_file *bemFileNewURL(bem_memory_pool *pool, const char *url, const char *base_url)
+{
+    bem_file *file;
+    const char *file_name;
+
+    if ((file_name = bemPoolGetURL(pool, url, base_url)) == NULL)
+        return NULL;
+
+    if ((file = calloc(1, sizeof(bem_file))) != NULL)
+    {
+        file->pool = pool;
+        file->url = file_name;
+        file->file_pointer = gzopen(file_name, "rb");
+        file->line_number = 1;
+
+        if (!file->file_pointer)
+        {
+            perror(file_name);
+            free(file);
+            file = NULL;
+        }
+    }
+
+    return file;
+}
+
+size_t bemFileRead(bem_file *file, void *buffer, size_t bytes)
+{
+    ssize_t read_bytes;
+
+    if (!file || !buffer || bytes == 0)
+        return 0;
+
+    if (file->buffer_pointer)
+    {
+        if ((size_t)(file->buffer_end - file->buffer_pointer) < bytes)
+            bytes = (size_t)(file->buffer_end - file->buffer_pointer);
+
+        if (bytes > 0)
+        {
+            memcpy(buffer, file->buffer_pointer, bytes);
+            file->buffer_pointer += bytes;
+        }
+
+        return bytes;
+    }
+    else if ((read_bytes = gzread(file->file_pointer, buffer, (unsigned)bytes)) < 0)
+    {
+        return 0;
+    }
+
+    return (size_t)read_bytes;
+}
+
+size_t bemFileSeek(bem_file *file, size_t offset)
+{
+    ssize_t seek_offset;
+
+    if (!file)
+        return 0;
+
+    if (file->buffer_pointer)
+    {
+        if (offset > (size_t)(file->buffer_end - file->buffer))
+            offset = (size_t)(file->buffer_end - file->buffer);
+
+        file->buffer_pointer = file->buffer + offset;
+
+        return offset;
+    }
+
+    if ((seek_offset = gzseek(file->file_pointer, (long)offset, SEEK_SET)) < 0)
+        return 0;
+
+    return (size_t)seek_offset;
+}
+
+void bemFileUngetc(bem_file *file, int ch)
+{
+    if (file->buffer_pointer && file->buffer_pointer > file->buffer)
+    {
+        file->buffer_pointer--;
+    }
+    else if (file->file_pointer)
+    {
+        gzungetc(ch, file->file_pointer);
+    }
+
+    if (ch == '\n')
+        file->line_number--;
+}
+
+void bemFontAddCached(bem_memory_pool *pool, bem_font *font, const char *url)
+{
+    if (!pool || !font || !url)
+        return;
+
+    if (!pool->fonts_loaded)
+        bemLoadAllFonts(pool);
+
+    bemAddFont(pool, font, url);
+    bemSortFonts(pool);
+}
+
+size_t bemFontBreakLines(bem_font *font, const bem_text *text, const char *str, float width, bem_text_break *lines, size_t max_lines)
+{
+    bem_text measure;
+    const char *start, *begin = str;
+    size_t num_lines = 0, end = 0;
+    float space, word, line = 0.0f;
+    bool content = false;
+
+    if (!font || !text || !str)
+        return 0;
+
+    // Greedy breaking at spaces with cached word widths, each break is the end of a line and its width
+    measure = *text;
+    measure.font = font;
+
+    space = bemPoolMeasureWord(font->pool, &measure, " ", 1);
+
+    while (*str)
+    {
+        if (*str == '\n')
+        {
+            bemAddTextBreak(lines, max_lines, &num_lines, content ? end : (size_t)(str - begin), line);
+
+            line = 0.0f;
+            content = false;
+            str++;
+            continue;
+        }
+        else if (isspace(*str & 255))
+        {
+            str++;
+            continue;
+        }
+
+        for (start = str; *str && !isspace(*str & 255); str++)
+            ;
+
+        word = bemPoolMeasureWord(font->pool, &measure, start, (size_t)(str - start));
+
+        if (content && line + space + word > width)
+        {
+            bemAddTextBreak(lines, max_lines, &num_lines, end, line);
+            line = word;
+        }
+        else
+        {
+            line += (content ? space : 0.0f) + word;
+        }
+
+        content = true;
+        end = (size_t)(str - begin);
+    }
+
+    if (content)
+        bemAddTextBreak(lines, max_lines, &num_lines, end, line);
+
+    return (num_lines);
+}
+
+int bemFontComputeExtents(bem_font *font, float size, const char *str, bem_rectangle *extents)
+{
+    const bem_font_metric *page;
+    int ch, width = 0;
+
+    if (!font || !str || !extents)
+        return 0;
+
+    while ((ch = bemFontNextChar(&str)) > 0)
+    {
+        if (ch < BEM_FONT_MAX_CHAR && font->data && !(font->loaded[ch / 2048] & (1 << ((ch / 256) & 7))))
+            bemFontLoadPage(font, ch / 256);
+
+        if (ch < BEM_FONT_MAX_CHAR && (page = font->widths[ch / 256]) != NULL)
+            width += page[ch & 255].width;
+        else
+            width += (int)font->units / 2;
+    }
+
+    extents->left_offset = 0.0f;
+    extents->bottom_offset = size * font->descent / font->units;
+    extents->right_offset = size * width / font->units;
+    extents->top_offset = size * font->ascent / font->units;
+
+    return 1;
+}
+
+void bemFontDelete(bem_font *font)
+{
+    size_t i;
+
+    if (!font)
+        return;
+
+    // Shared metrics point into the mapping instead of owning their pages
+    if (font->metrics)
+    {
+        munmap((void *)font->metrics, font->metrics_size);
+    }
+    else
+    {
+        for (i = 0; i < BEM_FONT_MAX_CHAR / 256; i++)
+        {
+            free(font->glyphs[i]);
+            free(font->widths[i]);
+        }
+    }
+
+    if (font->data)
+        munmap((void *)font->data, font->data_size);
+
+    free(font);
+}
+
+bem_font *bemFontFindCached(bem_memory_pool *pool, const char *family, bem_font_stretch stretch, bem_font_style style, bem_font_variant variant, bem_font_weight weight)
+{
+    static const char *const cursive[] = {"Comic Sans MS", "Comic Neue", "Apple Chancery", "URW Chancery L", "Zapf Chancery", NULL};
+    static const char *const fantasy[] = {"Impact", "Papyrus", "Luminari", NULL};
+    static const char *const monospace[] = {"DejaVu Sans Mono", "Liberation Mono", "Noto Sans Mono", "Menlo", "Courier New", "Courier", NULL};
+    static const char *const sans_serif[] = {"DejaVu Sans", "Liberation Sans", "Noto Sans", "Helvetica", "Arial", NULL};
+    static const char *const serif[] = {"DejaVu Serif", "Liberation Serif", "Noto Serif", "Times New Roman", "Times", NULL};
+    const char *const *generic = NULL;
+    bem_font *font;
+    int font_weight;
+
+    (void)variant;
+
+    if (!pool || !family || !*family)
+        return NULL;
+
+    if (!pool->fonts_loaded)
+        bemLoadAllFonts(pool);
+
+    if (weight == FONT_WEIGHT_NORMAL)
+        font_weight = 400;
+    else if (weight == FONT_WEIGHT_BOLD || weight == FONT_WEIGHT_BOLDER)
+        font_weight = 700;
+    else if (weight == FONT_WEIGHT_LIGHTER)
+        font_weight = 300;
+    else
+        font_weight = (int)weight;
+
+    if (!strcasecmp(family, "cursive"))
+        generic = cursive;
+    else if (!strcasecmp(family, "fantasy"))
+        generic = fantasy;
+    else if (!strcasecmp(family, "monospace"))
+        generic = monospace;
+    else if (!strcasecmp(family, "sans-serif"))
+        generic = sans_serif;
+    else if (!strcasecmp(family, "serif"))
+        generic = serif;
+
+    if (!generic)
+        return bemFindFont(pool, family, stretch, style, font_weight);
+
+    for (; *generic; generic++)
+    {
+        if ((font = bemFindFont(pool, *generic, stretch, style, font_weight)) != NULL)
+            return font;
+    }
+
+    return NULL;
+}
+
+int bemFontGetAscent(bem_font *font)
+{
+    return (font ? font->ascent : 0);
+}
+
+bem_rectangle *bemFontGetBounds(bem_font *font, bem_rectangle *bounds)
+{
+    if (!font || !bounds)
+        return NULL;
+
+    bounds->left_offset = font->x_min;
+    bounds->top_offset = font->y_max;
+    bounds->right_offset = font->x_max;
+    bounds->bottom_offset = font->y_min;
+
+    return bounds;
+}
+
+bem_font *bemFontGetCached(bem_memory_pool *pool, size_t index)
+{
+    const bem_font_cache_header *header;
+    const bem_font_cache_record *record;
+    const char *url;
+    bem_font_info *info;
+
+    if (!pool)
+        return NULL;
+
+    if (!pool->fonts_loaded)
+        bemLoadAllFonts(pool);
+
+    if (index < pool->font_amount)
+    {
+        info = pool->fonts + index;
+
+        if (!info->font && (info->font = bemOpenFont(pool, info->font_url, info->font_index)) != NULL)
+            bemShareFontMetrics(pool, info->font, info->font_url);
+
+        return info->font;
+    }
+
+    index -= pool->font_amount;
+    header = (const bem_font_cache_header *)pool->font_cache;
+
+    if (!header || index >= header->font_amount)
+        return NULL;
+
+    if (!pool->font_cache_fonts[index])
+    {
+        record = (const bem_font_cache_record *)(header + 1) + index;
+        url = (const char *)pool->font_cache + pool->font_cache_size - header->strings_size + record->url;
+
+        if ((pool->font_cache_fonts[index] = bemOpenFont(pool, url, record->index)) != NULL)
+            bemShareFontMetrics(pool, pool->font_cache_fonts[index], url);
+    }
+
+    return pool->font_cache_fonts[index];
+}
+
+size_t bemFontGetCachedCount(bem_memory_pool *pool)
+{
+    if (!pool)
+        return 0;
+
+    if (!pool->fonts_loaded)
+        bemLoadAllFonts(pool);
+
+    return (pool->font_amount + (pool->font_cache ? ((const bem_font_cache_header *)pool->font_cache)->font_amount : 0));
+}
+
+int bemFontGetCapHeight(bem_font *font)
+{
+    return (font ? font->cap_height : 0);
+}
+
+const char *bemFontGetCopyright(bem_font *font)
+{
+    return (font ? font->copyright : NULL);
+}
+
+int bemFontGetDescent(bem_font *font)
+{
+    return (font ? font->descent : 0);
+}
+
+bem_rectangle *bemFontGetExtents(bem_font *font, float size, const char *str, bem_rectangle *extents)
+{
+    return (bemFontComputeExtents(font, size, str, extents) ? extents : NULL);
+}
+
+const char *bemFontGetFamily(bem_font *font)
+{
+    return (font ? font->family : NULL);
+}
+
+size_t bemFontGetFontAmount(bem_font *font)
+{
+    return (font ? font->fonts_amount : 0);
+}
+
+int bemFontGetGlyph(bem_font *font, int ch)
+{
+    unsigned short *page;
+
+    if (!font || ch < 0 || ch >= BEM_FONT_MAX_CHAR)
+        return 0;
+
+    if (font->data && !(font->loaded[ch / 2048] & (1 << ((ch / 256) & 7))))
+        bemFontLoadPage(font, ch / 256);
+
+    return ((page = font->glyphs[ch / 256]) != NULL ? page[ch & 255] : 0);
+}
+
+const char *bemFontGetPostScriptName(bem_font *font)
+{
+    return (font ? font->postscript_name : NULL);
+}
+
+bem_font_style bemFontGetStyle(bem_font *font)
+{
+    return (font ? font->style : FONT_STYLE_NORMAL);
+}
+
+const char *bemFontGetVersion(bem_font *font)
+{
+    return (font ? font->version : NULL);
+}
+
+bem_font_weight bemFontGetWeight(bem_font *font)
+{
+    int weight;
+
+    if (!font)
+        return FONT_WEIGHT_400;
+
+    if ((weight = (font->weight + 50) / 100 * 100) < 100)
+        weight = 100;
+    else if (weight > 900)
+        weight = 900;
+
+    return (bem_font_weight)weight;
+}
+
+int bemFontGetWidth(bem_font *font, int ch)
+{
+    if (!font)
+        return 0;
+
+    if (ch >= 0 && ch < BEM_FONT_MAX_CHAR && font->data && !(font->loaded[ch / 2048] & (1 << ((ch / 256) & 7))))
+        bemFontLoadPage(font, ch / 256);
+
+    if (ch >= 0 && ch < BEM_FONT_MAX_CHAR && font->widths[ch / 256])
+        return font->widths[ch / 256][ch & 255].width;
+
+    return (int)font->units / 2;
+}
+
+int bemFontGetXHeight(bem_font *font)
+{
+    return (font ? font->x_height : 0);
+}
+
+bool bemFontIsFixedPitch(bem_font *font)
+{
+    return (font ? font->is_fixed_width : false);
+}
+
+size_t bemFontMeasureText(bem_font *font, const bem_text *text, const char *str, bem_text_break *breaks, size_t max_breaks, float *width)
+{
+    const unsigned char *s = (const unsigned char *)str, *start;
+    const bem_font_metric *ascii, *page;
+    float scale, letter_spacing, word_spacing;
+    size_t num_breaks = 0, chars = 0, spaces = 0;
+    long units = 0;
+    int ch, missing;
+
+    if (width)
+        *width = 0.0f;
+
+    if (!font || !text || !str)
+        return 0;
+
+    // Widths are summed in font units and scaled only at break opportunities
+    scale = text->font_size / font->units;
+    letter_spacing = text->letter_spacing;
+    word_spacing = text->word_spacing;
+    missing = (int)font->units / 2;
+
+    if (font->data && !(font->loaded[0] & 1))
+        bemFontLoadPage(font, 0);
+
+    ascii = font->widths[0];
+
+    while (*s)
+    {
+        if (*s < 0x80 && ascii)
+        {
+            // ASCII fast path, one table lookup per byte
+            ch = *s++;
+
+            if (ch == ' ' || ch == '\t' || ch == '\n')
+            {
+                bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(s - 1 - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+                spaces += ch == ' ';
+            }
+
+            units += ascii[ch].width;
+            chars++;
+
+            if (ch == '-')
+                bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(s - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+
+            continue;
+        }
+
+        start = s;
+        ch = bemFontNextChar((const char **)&s);
+
+        if (ch == 0xad)
+        {
+            // Soft hyphens are invisible unless the line breaks there
+            bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(s - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+            continue;
+        }
+
+        if (ch == 0x3000)
+            bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(start - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+
+        if (ch < BEM_FONT_MAX_CHAR && font->data && !(font->loaded[ch / 2048] & (1 << ((ch / 256) & 7))))
+            bemFontLoadPage(font, ch / 256);
+
+        if (ch < BEM_FONT_MAX_CHAR && (page = font->widths[ch / 256]) != NULL)
+            units += page[ch & 255].width;
+        else
+            units += missing;
+
+        chars++;
+        spaces += ch == ' ' || ch == 0xa0;
+
+        if (ch == '-' || ch == 0x2010 || ch == 0x200b)
+            bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(s - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+    }
+
+    // The end of the text is always a break opportunity
+    bemAddTextBreak(breaks, max_breaks, &num_breaks, (size_t)(s - (const unsigned char *)str), scale * units + letter_spacing * chars + word_spacing * spaces);
+
+    if (width)
+        *width = scale * units + letter_spacing * chars + word_spacing * spaces;
+
+    return num_breaks;
+}
+
+bem_font *bemFontNew(bem_memory_pool *pool, bem_file *file, size_t index)
+{
+    return bemFontRead(pool, file, index, NULL, 0);
+}
+
+void bemPoolDeleteFonts(bem_memory_pool *pool)
+{
+    size_t i, count;
+
+    if (!pool)
+        return;
+
+    for (i = 0; i < pool->font_amount; i++)
+        bemFontDelete(pool->fonts[i].font);
+
+    free(pool->fonts);
+    bemDeleteFontIndex(pool);
+
+    if (pool->font_cache)
+    {
+        for (i = 0, count = ((const bem_font_cache_header *)pool->font_cache)->font_amount; i < count; i++)
+            bemFontDelete(pool->font_cache_fonts[i]);
+
+        free(pool->font_cache_fonts);
+        munmap((void *)pool->font_cache, pool->font_cache_size);
+    }
+
+    pool->fonts = NULL;
+    pool->font_amount = 0;
+    pool->fonts_size = 0;
+    pool->font_cache = NULL;
+    pool->font_cache_size = 0;
+    pool->font_cache_fonts = NULL;
+    pool->fonts_loaded = false;
+
+    // Measured words point at the fonts that are gone
+    bemPoolSetWordCache(pool, pool->words_size);
+}
+
+// bem_font_stretch values in condensed to expanded order
+static const unsigned bem_font_stretch_order[] = {5, 1, 2, 3, 4, 9, 8, 7, 6};
+
+static void bemAddFont(bem_memory_pool *pool, bem_font *font, const char *url)
+{
+    bem_font_info info;
+
+    if (!font->family)
+        return;
+
+    info.font_url = url;
+    info.font_family = font->family;
+    info.font_index = font->index;
+    info.font = font;
+    info.font_stretch = font->stretch;
+    info.font_style = font->style;
+    info.font_variant = FONT_VARIANT_NORMAL;
+    info.font_weight = bemFontGetWeight(font);
+
+    bemAddFontInfo(pool, &info);
+}
+
+static void bemAddFontInfo(bem_memory_pool *pool, const bem_font_info *font_info)
+{
+    bem_font_info *info;
+
+    if (pool->font_amount >= pool->fonts_size)
+    {
+        if ((info = realloc(pool->fonts, (pool->fonts_size + 64) * sizeof(bem_font_info))) == NULL)
+            return;
+
+        pool->fonts_size += 64;
+        pool->fonts = info;
+    }
+
+    info = pool->fonts + pool->font_amount++;
+
+    *info = *font_info;
+    info->font_url = bemPoolGetString(pool, font_info->font_url);
+    info->font_family = bemPoolGetString(pool, font_info->font_family);
+}
+
+static void bemAddScan(bem_memory_pool *pool, bem_font_scanner *scanner, const char *url, struct stat *info, size_t cached)
+{
+    const bem_font_cache_header *header = (const bem_font_cache_header *)pool->font_cache;
+    const bem_font_cache_file *file;
+    bem_font_scan *scan;
+
+    if (scanner->scan_amount >= scanner->scans_size)
+    {
+        if ((scan = realloc(scanner->scans, (scanner->scans_size + 64) * sizeof(bem_font_scan))) == NULL)
+            return;
+
+        scanner->scans_size += 64;
+        scanner->scans = scan;
+    }
+
+    scan = scanner->scans + scanner->scan_amount;
+
+    if ((scan->url = strdup(url)) == NULL)
+        return;
+
+    scanner->scan_amount++;
+
+    scan->mtime = info->st_mtime;
+    scan->size = info->st_size;
+    scan->reuse = false;
+    scan->cached = cached;
+    scan->font_amount = 0;
+    scan->fonts = NULL;
+
+    // A file whose modification time and size match its cache entry keeps the records it already has
+    if (header && cached < header->file_amount)
+    {
+        file = (const bem_font_cache_file *)((const bem_font_cache_directory *)((const bem_font_cache_family *)((const bem_font_cache_record *)(header + 1) + header->font_amount) + header->family_amount) + header->directory_amount) + cached;
+        scan->reuse = file->mtime == (unsigned)info->st_mtime && file->size == (unsigned)info->st_size;
+    }
+
+    if (!scan->reuse)
+        scanner->changed = true;
+}
+
+static void bemAddTextBreak(bem_text_break *breaks, size_t max_breaks, size_t *num_breaks, size_t offset, float width)
+{
+    // Count every break so callers can size the array from the return value
+    if (*num_breaks < max_breaks)
+    {
+        breaks[*num_breaks].offset = offset;
+        breaks[*num_breaks].width = width;
+    }
+
+    (*num_breaks)++;
+}
+
+static int bemCompareFaces(bem_font_face *a, bem_font_face *b)
+{
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    else
+        return a->index < b->index ? -1 : a->index > b->index;
+}
+
+static int bemCompareInfo(bem_font_info *a, bem_font_info *b)
+{
+    int result;
+
+    if ((result = strcasecmp(a->font_family, b->font_family)) != 0)
+        return result;
+    else if (a->font_style != b->font_style)
+        return (int)a->font_style - (int)b->font_style;
+    else if (a->font_weight != b->font_weight)
+        return (int)a->font_weight - (int)b->font_weight;
+    else if ((result = strcmp(a->font_url, b->font_url)) != 0)
+        return result;
+    else
+        return (int)a->font_index - (int)b->font_index;
+}
+
+static int bemCompareNames(char **a, char **b)
+{
+    return (strcmp(*a, *b));
+}
+
+static int bemCompareScans(bem_font_scan **a, bem_font_scan **b)
+{
+    // Largest files first so one big collection doesn't start last and hold up the other threads
+    if ((*a)->size != (*b)->size)
+        return (*a)->size > (*b)->size ? -1 : 1;
+    else
+        return strcmp((*a)->url, (*b)->url);
+}
+
+static int bemCompareScanURLs(bem_font_scan **a, bem_font_scan **b)
+{
+    return (strcmp((*a)->url, (*b)->url));
+}
+
+static void bemDeleteFontIndex(bem_memory_pool *pool)
+{
+    free(pool->font_families);
+    free(pool->font_faces);
+    free(pool->font_matches);
+
+    pool->font_families_size = 0;
+    pool->font_families = NULL;
+    pool->font_faces = NULL;
+    pool->font_match_amount = 0;
+    pool->font_matches_size = 0;
+    pool->font_matches = NULL;
+}
+
+static void bemDeleteScanner(bem_font_scanner *scanner)
+{
+    size_t i;
+
+    for (i = 0; i < scanner->directory_amount; i++)
+        free(scanner->directories[i].path);
+
+    for (i = 0; i < scanner->scan_amount; i++)
+    {
+        free(scanner->scans[i].url);
+        free(scanner->scans[i].fonts);
+    }
+
+    free(scanner->directories);
+    free(scanner->scans);
+    free(scanner->queue);
+
+    memset(scanner, 0, sizeof(bem_font_scanner));
+}
+
+static size_t bemFindFace(const bem_font_face *faces, size_t left, size_t right, unsigned key)
+{
+    size_t middle;
+
+    // First face with a key greater than or equal to key
+    while (left < right)
+    {
+        middle = (left + right) / 2;
+
+        if (faces[middle].key < key)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    return left;
+}
+
+static bem_font_family *bemFindFamily(bem_font_family *families, size_t families_size, const char *family, bool create)
+{
+    unsigned hash = bemFontFamilyHash(family);
+    size_t i, mask = families_size - 1;
+
+    for (i = hash & mask; families[i].family; i = (i + 1) & mask)
+    {
+        if (families[i].hash == hash && (families[i].family == family || !strcasecmp(families[i].family, family)))
+            return families + i;
+    }
+
+    if (!create)
+        return NULL;
+
+    families[i].family = family;
+    families[i].hash = hash;
+
+    return families + i;
+}
+
+static bem_font *bemFindFont(bem_memory_pool *pool, const char *family, bem_font_stretch stretch, bem_font_style style, int weight)
+{
+    const bem_font_family *entry;
+
+    if (!pool->font_families)
+        bemIndexFonts(pool);
+
+    if (!pool->font_families || (entry = bemFindFamily(pool->font_families, pool->font_families_size, family, false)) == NULL)
+        return NULL;
+
+    return bemFontGetCached(pool, bemMatchFace(pool->font_faces + entry->first, entry->amount, stretch, style, weight)->index);
+}
+
+static bem_font *bemFindFontList(bem_memory_pool *pool, const char *families, bem_font_stretch stretch, bem_font_style style, bem_font_weight weight)
+{
+    bem_font_match *matches, *match;
+    bem_font *font = NULL;
+    unsigned key = ((unsigned)stretch << 16) | ((unsigned)style << 12) | ((unsigned)weight & 0xfff);
+    size_t i, hash, mask, matches_size;
+    const char *ptr;
+    char family[256], *familyptr;
+    int quote;
+
+    // Load first, a rebuild clears the match table
+    if (!pool->fonts_loaded)
+        bemLoadAllFonts(pool);
+
+    if (pool->font_match_amount >= pool->font_matches_size / 2)
+    {
+        matches_size = pool->font_matches_size ? 2 * pool->font_matches_size : 64;
+
+        if ((matches = (bem_font_match *)calloc(matches_size, sizeof(bem_font_match))) == NULL)
+            return NULL;
+
+        for (i = 0, match = pool->font_matches; i < pool->font_matches_size; i++, match++)
+        {
+            if (!match->families)
+                continue;
+
+            hash = ((size_t)match->families >> 4) ^ ((size_t)match->key * 2654435761U);
+
+            hash &= matches_size - 1;
+
+            while (matches[hash].families)
+                hash = (hash + 1) & (matches_size - 1);
+
+            matches[hash] = *match;
+        }
+
+        free(pool->font_matches);
+        pool->font_matches = matches;
+        pool->font_matches_size = matches_size;
+    }
+
+    // families is interned, so the pointer identifies the font-family value
+    mask = pool->font_matches_size - 1;
+    hash = ((size_t)families >> 4) ^ ((size_t)key * 2654435761U);
+
+    for (i = hash & mask; pool->font_matches[i].families; i = (i + 1) & mask)
+    {
+        if (pool->font_matches[i].families == families && pool->font_matches[i].key == key)
+            return pool->font_matches[i].font;
+    }
+
+    for (ptr = families; *ptr && !font;)
+    {
+        while (*ptr == ',' || isspace(*ptr & 255))
+            ptr++;
+
+        quote = (*ptr == '\"' || *ptr == '\'') ? *ptr++ : 0;
+
+        for (familyptr = family; *ptr && (quote ? *ptr != quote : *ptr != ','); ptr++)
+        {
+            if (familyptr < family + sizeof(family) - 1)
+                *familyptr++ = *ptr;
+        }
+
+        if (quote && *ptr)
+            ptr++;
+
+        while (familyptr > family && isspace(familyptr[-1] & 255))
+            familyptr--;
+
+        *familyptr = '\0';
+
+        if (family[0])
+            font = bemFontFindCached(pool, family, stretch, style, FONT_VARIANT_NORMAL, weight);
+    }
+
+    // Nothing in the list is installed, use the default family
+    if (!font)
+        font = bemFontFindCached(pool, "serif", stretch, style, FONT_VARIANT_NORMAL, weight);
+
+    match = pool->font_matches + i;
+    match->families = families;
+    match->key = key;
+    match->font = font;
+    pool->font_match_amount++;
+
+    return font;
+}
+
+static unsigned bemFontFamilyHash(const char *family)
+{
+    unsigned hash = 2166136261U;
+
+    // FNV-1a over the ASCII case folded name, family names match case-insensitively
+    for (; *family; family++)
+        hash = (hash ^ (unsigned char)tolower(*family & 255)) * 16777619U;
+
+    return hash;
+}
+
+static void bemFontLoadPage(bem_font *font, int block)
+{
+    const bem_uchar *cmap = font->data + font->cmap_offset, *ends, *starts, *deltas, *ranges, *groups, *glyph_id;
+    int ch, first = block * 256, last = first + 255, glyph, seg_count, format;
+    unsigned start, end, left, right, middle, num_groups;
+
+    font->loaded[block / 8] |= (bem_uchar)(1 << (block & 7));
+
+    if ((format = bemDecodeUshort(cmap)) == 4)
+    {
+        if (first > 65535)
+            return;
+
+        seg_count = bemDecodeUshort(cmap + 6) / 2;
+        ends = cmap + 14;
+        starts = ends + 2 * seg_count + 2;
+        deltas = starts + 2 * seg_count;
+        ranges = deltas + 2 * seg_count;
+
+        // First segment ending in or after this block, then walk the segments that overlap it
+        for (left = 0, right = (unsigned)seg_count; left < right;)
+        {
+            middle = (left + right) / 2;
+
+            if (bemDecodeUshort(ends + 2 * middle) < first)
+                left = middle + 1;
+            else
+                right = middle;
+        }
+
+        for (ch = first; ch <= last && left < (unsigned)seg_count; left++)
+        {
+            start = (unsigned)bemDecodeUshort(starts + 2 * left);
+            end = (unsigned)bemDecodeUshort(ends + 2 * left);
+
+            for (ch = ch > (int)start ? ch : (int)start; ch <= last && ch <= (int)end; ch++)
+            {
+                if (bemDecodeUshort(ranges + 2 * left) == 0)
+                {
+                    glyph = (ch + bemDecodeUshort(deltas + 2 * left)) & 65535;
+                }
+                else
+                {
+                    // idRangeOffset is relative to its own position in the table
+                    glyph_id = ranges + 2 * left + bemDecodeUshort(ranges + 2 * left) + 2 * (ch - (int)start);
+                    glyph = glyph_id + 2 <= cmap + font->cmap_length ? bemDecodeUshort(glyph_id) : 0;
+
+                    if (glyph)
+                        glyph = (glyph + bemDecodeUshort(deltas + 2 * left)) & 65535;
+                }
+
+                bemFontSetGlyph(font, ch, glyph);
+            }
+        }
+    }
+    else
+    {
+        num_groups = bemDecodeUlong(cmap + 12);
+        groups = cmap + 16;
+
+        for (left = 0, right = num_groups; left < right;)
+        {
+            middle = (left + right) / 2;
+
+            if (bemDecodeUlong(groups + 12 * middle + 4) < (unsigned)first)
+                left = middle + 1;
+            else
+                right = middle;
+        }
+
+        for (ch = first; ch <= last && left < num_groups; left++)
+        {
+            start = bemDecodeUlong(groups + 12 * left);
+            end = bemDecodeUlong(groups + 12 * left + 4);
+
+            if (start > (unsigned)last)
+                break;
+
+            for (ch = ch > (int)start ? ch : (int)start; ch <= last && (unsigned)ch <= end; ch++)
+            {
+                // Format 13 maps the whole range to a single glyph
+                glyph = (int)(format == 12 ? bemDecodeUlong(groups + 12 * left + 8) + (unsigned)ch - start : bemDecodeUlong(groups + 12 * left + 8));
+
+                bemFontSetGlyph(font, ch, glyph);
+            }
+        }
+    }
+}
+
+static int bemFontNextChar(const char **str)
+{
+    const unsigned char *s = (const unsigned char *)*str;
+    int ch;
+
+    if (!*s)
+        return 0;
+
+    if ((*s & 0xe0) == 0xc0 && (s[1] & 0xc0) == 0x80)
+    {
+        ch = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+        s += 2;
+    }
+    else if ((*s & 0xf0) == 0xe0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80)
+    {
+        ch = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+        s += 3;
+    }
+    else if ((*s & 0xf8) == 0xf0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80)
+    {
+        ch = ((s[0] & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+        s += 4;
+    }
+    else
+    {
+        // Not UTF-8, treat the byte as ISO-8859-1
+        ch = *s++;
+    }
+
+    *str = (const char *)s;
+
+    return ch;
+}
+
+static bem_font *bemFontRead(bem_memory_pool *pool, bem_file *file, size_t index, const bem_uchar *data, size_t data_size)
+{
+    static const bem_font_stretch stretches[] = {
+        FONT_STRETCH_ULTRA_CONDENCED, FONT_STRETCH_EXTRA_CONDENCED, FONT_STRETCH_CONDENCED, FONT_STRETCH_SEMI_CONDENCED, FONT_STRETCH_NORMAL,
+        FONT_STRETCH_SEMI_EXPANDED, FONT_STRETCH_EXPANDED, FONT_STRETCH_EXTRA_EXPANDED, FONT_STRETCH_ULTRA_EXPANDED};
+    bem_font *font;
+    bem_off_table table;
+    bem_off_names names;
+    bem_off_head head;
+    bem_off_hhea hhea;
+    bem_off_os_2 os_2;
+    bem_off_post post;
+    bem_off_span cmap;
+    bem_off_dir *hmtx;
+    bem_font_metric *metrics, *page;
+    const bem_uchar *subtable;
+    size_t num_fonts;
+    unsigned offset, length = 0;
+    unsigned short *glyphs;
+    int ch, glyph, format = 0, num_glyphs, seg_count = 0;
+
+    if (!pool || !file)
+        return NULL;
+
+    memset(&names, 0, sizeof(names));
+    memset(&cmap, 0, sizeof(cmap));
+
+    if (!bemReadTable(file, index, &table, &num_fonts))
+        return NULL;
+
+    if (!bemReadNames(file, &table, &names) || !bemReadHead(file, &table, &head) || !bemReadHhea(file, &table, &hhea) ||
+        (font = (bem_font *)calloc(1, sizeof(bem_font))) == NULL)
+    {
+        free(names.names);
+        free(names.storage);
+        free(table.entries);
+        return NULL;
+    }
+
+    font->pool = pool;
+    font->index = index;
+    font->fonts_amount = num_fonts;
+
+    font->copyright = bemCopyName(pool, &names, 0);
+    font->version = bemCopyName(pool, &names, 5);
+    font->postscript_name = bemCopyName(pool, &names, 6);
+
+    if ((font->family = bemCopyName(pool, &names, 16)) == NULL)
+        font->family = bemCopyName(pool, &names, 1);
+
+    font->units = head.units_per_em ? (float)head.units_per_em : 1000.0f;
+    font->x_max = head.x_max;
+    font->x_min = head.x_min;
+    font->y_max = head.y_max;
+    font->y_min = head.y_min;
+    font->style = (head.mac_style & 2) ? FONT_STYLE_ITALIC : FONT_STYLE_NORMAL;
+
+    if (bemReadOs2(file, &table, &os_2))
+    {
+        font->weight = (short)os_2.weight_class;
+        font->stretch = os_2.width_class >= 1 && os_2.width_class <= 9 ? stretches[os_2.width_class - 1] : FONT_STRETCH_NORMAL;
+        font->ascent = os_2.typo_ascender;
+        font->descent = os_2.typo_descender;
+        font->cap_height = os_2.cap_height;
+        font->x_height = os_2.x_height;
+    }
+    else
+    {
+        font->weight = (head.mac_style & 1) ? 700 : 400;
+        font->stretch = FONT_STRETCH_NORMAL;
+        font->ascent = hhea.ascender;
+        font->descent = hhea.descender;
+    }
+
+    if (font->cap_height == 0)
+        font->cap_height = (short)(0.7f * font->units);
+    if (font->x_height == 0)
+        font->x_height = (short)(0.5f * font->units);
+
+    if (bemReadPost(file, &table, &post))
+    {
+        font->italic_angle = post.italic_angle;
+        font->is_fixed_width = post.is_fixed_pitch != 0;
+
+        if (font->style == FONT_STYLE_NORMAL && post.italic_angle != 0.0f)
+            font->style = FONT_STYLE_OBLIQUE;
+    }
+
+    num_glyphs = bemReadMaxp(file, &table);
+
+    // With the font file mapped, only check that the cmap subtable and hmtx are in bounds and leave decoding them to
+    // bemFontLoadPage, one 256 character block at a time
+    if (data && (hmtx = bemFindTable(&table, BEM_OFF_HMTX)) != NULL && hmtx->offset <= data_size && hmtx->length <= data_size - hmtx->offset &&
+        hhea.number_of_horizontal_metrics > 0 && (unsigned)hhea.number_of_horizontal_metrics <= hmtx->length / 4 &&
+        bemLoadTable(file, &table, BEM_OFF_CMAP, &cmap) && (offset = bemFindCmap(&cmap)) != 0 && offset < cmap.length)
+    {
+        subtable = cmap.data + offset;
+        length = cmap.length - offset;
+
+        if (length >= 16 && (format = bemDecodeUshort(subtable)) == 4)
+        {
+            if ((seg_count = bemDecodeUshort(subtable + 6) / 2) <= 0 || 16 + 8 * (unsigned)seg_count > length)
+                format = 0;
+        }
+        else if (format == 12 || format == 13)
+        {
+            if (bemDecodeUlong(subtable + 12) == 0 || bemDecodeUlong(subtable + 12) > (length - 16) / 12)
+                format = 0;
+        }
+        else
+        {
+            format = 0;
+        }
+    }
+
+    if (format)
+    {
+        font->data = data;
+        font->data_size = data_size;
+        font->cmap_offset = (unsigned)(subtable - data);
+        font->cmap_length = length;
+        font->hmtx_offset = hmtx->offset;
+        font->num_glyphs = num_glyphs > 0 ? num_glyphs : 65536;
+        font->num_metrics = hhea.number_of_horizontal_metrics;
+
+        if (format == 4)
+        {
+            // The last segment is the 0xFFFF terminator
+            font->min_char = bemDecodeUshort(subtable + 16 + 2 * seg_count);
+            font->max_char = bemDecodeUshort(subtable + 14 + 2 * (seg_count > 1 ? seg_count - 2 : 0));
+        }
+        else
+        {
+            font->min_char = (int)bemDecodeUlong(subtable + 16);
+            font->max_char = (int)bemDecodeUlong(subtable + 16 + 12 * (bemDecodeUlong(subtable + 12) - 1) + 4);
+        }
+
+        if (font->max_char >= BEM_FONT_MAX_CHAR)
+            font->max_char = BEM_FONT_MAX_CHAR - 1;
+    }
+    else if (bemReadCmap(file, &table, font->glyphs) > 0 && (metrics = bemReadHmtx(file, &table, &hhea)) != NULL)
+    {
+        font->min_char = -1;
+
+        for (ch = 0; ch < BEM_FONT_MAX_CHAR; ch++)
+        {
+            // Skip whole blocks without mapped characters
+            if ((glyphs = font->glyphs[ch / 256]) == NULL)
+            {
+                ch |= 255;
+                continue;
+            }
+
+            if ((glyph = glyphs[ch & 255]) == 0 || (num_glyphs > 0 && glyph >= num_glyphs))
+                continue;
+
+            if (glyph >= hhea.number_of_horizontal_metrics)
+                glyph = hhea.number_of_horizontal_metrics - 1;
+
+            if ((page = font->widths[ch / 256]) == NULL)
+            {
+                if ((page = (bem_font_metric *)calloc(256, sizeof(bem_font_metric))) == NULL)
+                    break;
+
+                font->widths[ch / 256] = page;
+            }
+
+            page[ch & 255] = metrics[glyph];
+
+            if (font->min_char < 0)
+                font->min_char = ch;
+            font->max_char = ch;
+        }
+
+        free(metrics);
+    }
+
+    bemFreeTable(&cmap);
+    free(names.names);
+    free(names.storage);
+    free(table.entries);
+
+    return (font);
+}
+
+static void bemFontSetGlyph(bem_font *font, int ch, int glyph)
+{
+    const bem_uchar *metric;
+    bem_font_metric *page;
+
+    if (glyph <= 0 || glyph >= font->num_glyphs || !bemSetGlyph(font->glyphs, ch, (unsigned)glyph))
+        return;
+
+    if (glyph >= font->num_metrics)
+        glyph = font->num_metrics - 1;
+
+    if ((page = font->widths[ch / 256]) == NULL)
+    {
+        if ((page = (bem_font_metric *)calloc(256, sizeof(bem_font_metric))) == NULL)
+            return;
+
+        font->widths[ch / 256] = page;
+    }
+
+    metric = font->data + font->hmtx_offset + 4 * glyph;
+    page[ch & 255].width = (short)bemDecodeUshort(metric);
+    page[ch & 255].left_bearing = (short)bemDecodeShort(metric + 2);
+}
+
+static void bemFontUnloadPage(bem_font *font, int block)
+{
+    free(font->glyphs[block]);
+    font->glyphs[block] = NULL;
+
+    free(font->widths[block]);
+    font->widths[block] = NULL;
+
+    font->loaded[block / 8] &= (bem_uchar)~(1 << (block & 7));
+}
+
+static void bemGetCname(char *cname, size_t cname_size)
+{
+    const char *cache, *home;
+
+    if ((cache = getenv("BEM_FONT_CACHE")) != NULL)
+    {
+        snprintf(cname, cname_size, "%s", cache);
+    }
+    else if ((cache = getenv("XDG_CACHE_HOME")) != NULL)
+    {
+        snprintf(cname, cname_size, "%s/bem-fonts.dat", cache);
+    }
+    else if ((home = getenv("HOME")) != NULL)
+    {
+        snprintf(cname, cname_size, "%s/.cache", home);
+        mkdir(cname, 0700);
+        snprintf(cname, cname_size, "%s/.cache/bem-fonts.dat", home);
+    }
+    else
+    {
+        snprintf(cname, cname_size, "/tmp/bem-fonts-%d.dat", (int)getuid());
+    }
+}
+
+static size_t bemGetFontDirectories(char directories[][1024], size_t max_directories)
+{
+    static const char *const system_directories[] = {"/usr/share/fonts", "/usr/local/share/fonts", "/System/Library/Fonts", "/Library/Fonts"};
+    const char *path, *home;
+    char *ptr;
+    size_t i, num_directories = 0;
+
+    if ((path = getenv("BEM_FONT_PATH")) != NULL)
+    {
+        // Colon-separated list of directories, replacing the defaults
+        while (*path && num_directories < max_directories)
+        {
+            for (ptr = directories[num_directories]; *path && *path != ':'; path++)
+            {
+                if (ptr < directories[num_directories] + 1023)
+                    *ptr++ = *path;
+            }
+
+            *ptr = '\0';
+
+            if (ptr > directories[num_directories])
+                num_directories++;
+
+            if (*path == ':')
+                path++;
+        }
+
+        return num_directories;
+    }
+
+    for (i = 0; i < sizeof(system_directories) / sizeof(system_directories[0]) && num_directories < max_directories; i++)
+        snprintf(directories[num_directories++], 1024, "%s", system_directories[i]);
+
+    if ((home = getenv("HOME")) != NULL && num_directories + 2 <= max_directories)
+    {
+        snprintf(directories[num_directories++], 1024, "%s/.fonts", home);
+        snprintf(directories[num_directories++], 1024, "%s/.local/share/fonts", home);
+    }
+
+    return num_directories;
+}
+
+static void bemIndexFonts(bem_memory_pool *pool)
+{
+    const bem_font_cache_header *header = (const bem_font_cache_header *)pool->font_cache;
+    const bem_font_cache_record *record = NULL;
+    const char *strings = NULL, *family;
+    bem_font_family *families, *entry;
+    bem_font_face *faces;
+    bem_font_info *info;
+    size_t i, pass, first, weight, num_faces, families_size = 16;
+    unsigned stretch, style;
+
+    num_faces = pool->font_amount + (header ? header->font_amount : 0);
+
+    if (header)
+        strings = (const char *)pool->font_cache + pool->font_cache_size - header->strings_size;
+
+    // Every face could be its own family, keep the table at most half full
+    while (families_size < 2 * num_faces)
+        families_size *= 2;
+
+    families = (bem_font_family *)calloc(families_size, sizeof(bem_font_family));
+    faces = (bem_font_face *)malloc((num_faces + 1) * sizeof(bem_font_face));
+
+    if (!families || !faces)
+    {
+        free(families);
+        free(faces);
+        return;
+    }
+
+    // Count the faces of each family, give every family its range, then fill the ranges
+    for (pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            for (i = 0, first = 0, entry = families; i < families_size; i++, entry++)
+            {
+                entry->first = first;
+                first += entry->amount;
+                entry->amount = 0;
+            }
+        }
+
+        for (i = 0; i < num_faces; i++)
+        {
+            if (i < pool->font_amount)
+            {
+                info = pool->fonts + i;
+                family = info->font_family;
+                stretch = info->font_stretch;
+                style = info->font_style;
+                weight = info->font_weight;
+            }
+            else
+            {
+                record = (const bem_font_cache_record *)(header + 1) + i - pool->font_amount;
+                family = strings + record->family;
+                stretch = record->stretch;
+                style = record->style;
+                weight = record->weight;
+            }
+
+            entry = bemFindFamily(families, families_size, family, true);
+
+            if (pass == 1)
+            {
+                faces[entry->first + entry->amount].key = (bem_font_stretch_order[stretch] << 16) | (style << 12) | (weight > 0xfff ? 0xfff : (unsigned)weight);
+                faces[entry->first + entry->amount].index = i;
+            }
+
+            entry->amount++;
+        }
+    }
+
+    for (i = 0, entry = families; i < families_size; i++, entry++)
+    {
+        if (entry->amount > 1)
+            qsort(faces + entry->first, entry->amount, sizeof(bem_font_face), (bem_comparison_function)bemCompareFaces);
+    }
+
+    pool->font_families_size = families_size;
+    pool->font_families = families;
+    pool->font_faces = faces;
+}
+
+static void bemLoadAllFonts(bem_memory_pool *pool)
+{
+    char cname[1024];
+    struct stat cinfo;
+    bem_font_scanner scanner;
+
+    pool->fonts_loaded = true;
+
+    bemGetCname(cname, sizeof(cname));
+
+    if (!stat(cname, &cinfo))
+        bemLoadCache(pool, cname, &cinfo);
+
+    memset(&scanner, 0, sizeof(scanner));
+
+    if (bemScanAllFonts(pool, &scanner))
+        bemSaveCache(pool, cname, &scanner);
+
+    bemDeleteScanner(&scanner);
+}
+
+static bool bemLoadCache(bem_memory_pool *pool, const char *cname, struct stat *cinfo)
+{
+    const bem_font_cache_header *header;
+    const bem_font_cache_record *record;
+    const bem_font_cache_family *family;
+    const bem_font_cache_directory *directory;
+    const bem_font_cache_file *file;
+    const char *strings;
+    void *map;
+    size_t i;
+    int fd;
+    bool valid;
+
+    if (cinfo->st_size < (off_t)sizeof(bem_font_cache_header) || (fd = open(cname, O_RDONLY)) < 0)
+        return false;
+
+    map = mmap(NULL, (size_t)cinfo->st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    // Validate the offsets once so lookups and refreshes can use the mapping without checks
+    header = (const bem_font_cache_header *)map;
+    record = (const bem_font_cache_record *)(header + 1);
+    family = (const bem_font_cache_family *)(record + header->font_amount);
+    directory = (const bem_font_cache_directory *)(family + header->family_amount);
+    file = (const bem_font_cache_file *)(directory + header->directory_amount);
+    strings = (const char *)(file + header->file_amount);
+
+    if (memcmp(header->magic, "BEMFONTS", 8) || header->version != BEM_FONT_CACHE_VERSION || header->strings_size == 0 ||
+        header->font_amount > (size_t)cinfo->st_size / sizeof(bem_font_cache_record) ||
+        header->family_amount > (size_t)cinfo->st_size / sizeof(bem_font_cache_family) ||
+        header->directory_amount > (size_t)cinfo->st_size / sizeof(bem_font_cache_directory) ||
+        header->file_amount > (size_t)cinfo->st_size / sizeof(bem_font_cache_file) ||
+        sizeof(bem_font_cache_header) + header->font_amount * sizeof(bem_font_cache_record) + header->family_amount * sizeof(bem_font_cache_family) +
+        header->directory_amount * sizeof(bem_font_cache_directory) + header->file_amount * sizeof(bem_font_cache_file) + header->strings_size != (size_t)cinfo->st_size ||
+        strings[header->strings_size - 1])
+    {
+        munmap(map, (size_t)cinfo->st_size);
+        return false;
+    }
+
+    for (i = 0, valid = true; valid && i < header->font_amount; i++, record++)
+        valid = record->url < header->strings_size && record->family < header->strings_size && record->file < header->file_amount && record->style <= FONT_STYLE_OBLIQUE && record->stretch <= FONT_STRETCH_SEMI_EXPANDED;
+
+    for (i = 0; valid && i < header->family_amount; i++, family++)
+        valid = family->name < header->strings_size && family->first <= header->font_amount && family->amount <= header->font_amount - family->first;
+
+    // Directory end indices must move forward so walking the tree always terminates
+    for (i = 0; valid && i < header->directory_amount; i++, directory++)
+        valid = directory->path < header->strings_size && directory->first_file <= header->file_amount && directory->file_amount <= header->file_amount - directory->first_file &&
+                directory->end > i && directory->end <= header->directory_amount;
+
+    for (i = 0; valid && i < header->file_amount; i++, file++)
+        valid = file->path < header->strings_size;
+
+    if (!valid || (pool->font_cache_fonts = (bem_font **)calloc(header->font_amount + 1, sizeof(bem_font *))) == NULL)
+    {
+        munmap(map, (size_t)cinfo->st_size);
+        return false;
+    }
+
+    pool->font_cache = (const bem_uchar *)map;
+    pool->font_cache_size = (size_t)cinfo->st_size;
+
+    return true;
+}
+
+static void bemLoadFonts(bem_memory_pool *pool, const char *d, bem_font_scanner *scanner, size_t cached)
+{
+    const bem_font_cache_header *header = (const bem_font_cache_header *)pool->font_cache;
+    const bem_font_cache_directory *directories = NULL, *directory = NULL;
+    const bem_font_cache_file *files = NULL;
+    const char *strings = NULL, *ext;
+    bem_font_scan_directory *scan_directory;
+    DIR *dir;
+    struct dirent *dent;
+    struct stat info;
+    char filename[1024], **names = NULL, **temp;
+    size_t i, left, right, middle, child, file, index, num_names = 0, names_size = 0;
+    int result;
+
+    if (stat(d, &info) || !S_ISDIR(info.st_mode))
+        return;
+
+    if (header)
+    {
+        directories = (const bem_font_cache_directory *)((const bem_font_cache_family *)((const bem_font_cache_record *)(header + 1) + header->font_amount) + header->family_amount);
+        files = (const bem_font_cache_file *)(directories + header->directory_amount);
+        strings = (const char *)pool->font_cache + pool->font_cache_size - header->strings_size;
+
+        if (cached < header->directory_amount)
+            directory = directories + cached;
+    }
+
+    if (scanner->directory_amount >= scanner->directories_size)
+    {
+        if ((scan_directory = realloc(scanner->directories, (scanner->directories_size + 16) * sizeof(bem_font_scan_directory))) == NULL)
+            return;
+
+        scanner->directories_size += 16;
+        scanner->directories = scan_directory;
+    }
+
+    index = scanner->directory_amount;
+    scan_directory = scanner->directories + index;
+
+    if ((scan_directory->path = strdup(d)) == NULL)
+        return;
+
+    scanner->directory_amount++;
+
+    scan_directory->mtime = info.st_mtime;
+    scan_directory->first_scan = scanner->scan_amount;
+
+    if (directory && directory->mtime == (unsigned)info.st_mtime)
+    {
+        // Nothing was added, removed or renamed here since the cache was written, so the files only need a stat
+        for (i = directory->first_file; i < directory->first_file + directory->file_amount; i++)
+        {
+            if (stat(strings + files[i].path, &info) || !S_ISREG(info.st_mode))
+                scanner->changed = true;
+            else
+                bemAddScan(pool, scanner, strings + files[i].path, &info, i);
+        }
+
+        scanner->directories[index].scan_amount = scanner->scan_amount - scanner->directories[index].first_scan;
+
+        for (i = cached + 1; i < directory->end; i = directories[i].end)
+            bemLoadFonts(pool, strings + directories[i].path, scanner, i);
+
+        scanner->directories[index].end = scanner->directory_amount;
+        return;
+    }
+
+    scanner->changed = true;
+
+    if ((dir = opendir(d)) != NULL)
+    {
+        while ((dent = readdir(dir)) != NULL)
+        {
+            if (dent->d_name[0] == '.')
+                continue;
+
+            if (num_names >= names_size)
+            {
+                if ((temp = realloc(names, (names_size + 64) * sizeof(char *))) == NULL)
+                    break;
+
+                names_size += 64;
+                names = temp;
+            }
+
+            if ((names[num_names] = strdup(dent->d_name)) != NULL)
+                num_names++;
+        }
+
+        closedir(dir);
+    }
+
+    // Sorted so the cache doesn't depend on readdir order and cached files can be found with a binary search
+    if (num_names > 1)
+        qsort(names, num_names, sizeof(char *), (bem_comparison_function)bemCompareNames);
+
+    // Files first, then subdirectories, so the files of each directory stay contiguous
+    for (i = 0; i < num_names; i++)
+    {
+        snprintf(filename, sizeof(filename), "%s/%s", d, names[i]);
+
+        if ((result = stat(filename, &info)) == 0 && S_ISDIR(info.st_mode))
+            continue;
+
+        if (!result && S_ISREG(info.st_mode) && (ext = strrchr(names[i], '.')) != NULL &&
+            (!strcasecmp(ext, ".otc") || !strcasecmp(ext, ".otf") || !strcasecmp(ext, ".ttc") || !strcasecmp(ext, ".ttf")))
+        {
+            file = BEM_FONT_CACHE_NONE;
+
+            for (left = directory ? directory->first_file : 0, right = directory ? directory->first_file + directory->file_amount : 0; left < right;)
+            {
+                middle = (left + right) / 2;
+
+                if ((result = strcmp(filename, strings + files[middle].path)) == 0)
+                {
+                    file = middle;
+                    break;
+                }
+                else if (result < 0)
+                    right = middle;
+                else
+                    left = middle + 1;
+            }
+
+            bemAddScan(pool, scanner, filename, &info, file);
+        }
+
+        free(names[i]);
+        names[i] = NULL;
+    }
+
+    scanner->directories[index].scan_amount = scanner->scan_amount - scanner->directories[index].first_scan;
+
+    for (i = 0; i < num_names; i++)
+    {
+        if (!names[i])
+            continue;
+
+        snprintf(filename, sizeof(filename), "%s/%s", d, names[i]);
+
+        for (child = directory ? cached + 1 : 0, file = BEM_FONT_CACHE_NONE; directory && child < directory->end; child = directories[child].end)
+        {
+            if (!strcmp(filename, strings + directories[child].path))
+            {
+                file = child;
+                break;
+            }
+        }
+
+        bemLoadFonts(pool, filename, scanner, file);
+        free(names[i]);
+    }
+
+    free(names);
+
+    scanner->directories[index].end = scanner->directory_amount;
+}
+
+static bool bemMapFontMetrics(bem_font *font, const char *mname, const char *url, struct stat *info)
+{
+    const bem_font_metrics_header *header;
+    const bem_font_metric *metrics;
+    const unsigned short *glyphs;
+    const unsigned *pages, *glyph_pages;
+    struct stat minfo;
+    void *map = MAP_FAILED;
+    size_t i, url_size = strlen(url) + 1, pages_offset = sizeof(bem_font_metrics_header) + ((url_size + 3) & ~(size_t)3);
+    int fd;
+
+    if ((fd = open(mname, O_RDONLY)) < 0)
+        return false;
+
+    if (!fstat(fd, &minfo) && (size_t)minfo.st_size >= pages_offset + 2 * BEM_FONT_MAX_CHAR / 256 * sizeof(unsigned))
+        map = mmap(NULL, (size_t)minfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    header = (const bem_font_metrics_header *)map;
+    pages = (const unsigned *)((const char *)map + pages_offset);
+    glyph_pages = pages + BEM_FONT_MAX_CHAR / 256;
+    metrics = (const bem_font_metric *)(glyph_pages + BEM_FONT_MAX_CHAR / 256);
+    glyphs = (const unsigned short *)(metrics + 256 * (header->page_amount <= BEM_FONT_MAX_CHAR / 256 ? header->page_amount : 0));
+
+    // The file name is only a hash, the header carries the full key
+    if (memcmp(header->magic, "BEMFMETR", 8) || header->version != BEM_FONT_METRICS_VERSION || header->index != (unsigned)font->index ||
+        header->mtime != (unsigned)info->st_mtime || header->size != (unsigned)info->st_size || header->url_size != url_size ||
+        memcmp(header + 1, url, url_size) || header->page_amount > BEM_FONT_MAX_CHAR / 256 || header->glyph_page_amount > BEM_FONT_MAX_CHAR / 256 ||
+        (size_t)minfo.st_size != (size_t)((const char *)(glyphs + 256 * header->glyph_page_amount) - (const char *)map))
+    {
+        munmap(map, (size_t)minfo.st_size);
+        return false;
+    }
+
+    for (i = 0; i < BEM_FONT_MAX_CHAR / 256; i++)
+    {
+        if (pages[i] > header->page_amount || glyph_pages[i] > header->glyph_page_amount)
+        {
+            munmap(map, (size_t)minfo.st_size);
+            return false;
+        }
+    }
+
+    // Swap the private pages for the shared ones, the font file itself is no longer needed
+    for (i = 0; i < BEM_FONT_MAX_CHAR / 256; i++)
+    {
+        free(font->widths[i]);
+        font->widths[i] = pages[i] ? (bem_font_metric *)(metrics + 256 * (pages[i] - 1)) : NULL;
+
+        free(font->glyphs[i]);
+        font->glyphs[i] = glyph_pages[i] ? (unsigned short *)(glyphs + 256 * (glyph_pages[i] - 1)) : NULL;
+    }
+
+    if (font->data)
+    {
+        munmap((void *)font->data, font->data_size);
+        font->data = NULL;
+    }
+
+    memset(font->loaded, 255, sizeof(font->loaded));
+
+    font->metrics = (const bem_uchar *)map;
+    font->metrics_size = (size_t)minfo.st_size;
+
+    return true;
+}
+
+static const bem_font_face *bemMatchFace(const bem_font_face *faces, size_t amount, bem_font_stretch stretch, bem_font_style style, int weight)
+{
+    static const bem_font_style styles[3][3] = {
+        {FONT_STYLE_NORMAL, FONT_STYLE_OBLIQUE, FONT_STYLE_ITALIC},
+        {FONT_STYLE_ITALIC, FONT_STYLE_OBLIQUE, FONT_STYLE_NORMAL},
+        {FONT_STYLE_OBLIQUE, FONT_STYLE_ITALIC, FONT_STYLE_NORMAL}};
+    unsigned want = bem_font_stretch_order[stretch], found, key = 0;
+    size_t i, left, right, first = 0, last = 0;
+
+    // Faces are sorted by stretch, style and weight, so each step of the CSS font matching algorithm narrows a range
+    // with binary searches.  font-stretch: the exact width, else narrower first at or below normal and wider first above
+    i = bemFindFace(faces, 0, amount, want << 16);
+
+    if (i < amount && (faces[i].key >> 16) == want)
+        found = want;
+    else if (i == amount || (want <= bem_font_stretch_order[FONT_STRETCH_NORMAL] && i > 0))
+        found = faces[i - 1].key >> 16;
+    else
+        found = faces[i].key >> 16;
+
+    left = bemFindFace(faces, 0, amount, found << 16);
+    right = bemFindFace(faces, left, amount, (found + 1) << 16);
+
+    // font-style: italic falls back to oblique, oblique to italic, then normal
+    for (i = 0; i < 3 && first == last; i++)
+    {
+        key = (found << 16) | ((unsigned)styles[style][i] << 12);
+        first = bemFindFace(faces, left, right, key);
+        last = bemFindFace(faces, first, right, key + (1 << 12));
+    }
+
+    // font-weight: between 400 and 500 try up to 500, then lighter, then heavier.  Below 400 lighter first, above 500
+    // heavier first.
+    i = bemFindFace(faces, first, last, key | (unsigned)weight);
+
+    if (i < last && (int)(faces[i].key & 0xfff) == weight)
+        return faces + i;
+    else if (weight >= 400 && weight <= 500 && i < last && (faces[i].key & 0xfff) <= 500)
+        return faces + i;
+    else if (weight <= 500)
+        return faces + (i > first ? i - 1 : i);
+    else
+        return faces + (i < last ? i : i - 1);
+}
+
+static bem_font *bemOpenFont(bem_memory_pool *pool, const char *url, size_t index)
+{
+    bem_file *file;
+    bem_font *font;
+    struct stat info;
+    void *map = MAP_FAILED;
+    int fd;
+
+    // Local files are mapped and opened header-only, the font keeps the mapping for bemFontLoadPage
+    if ((fd = open(url, O_RDONLY)) >= 0)
+    {
+        if (!fstat(fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0)
+            map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+        close(fd);
+    }
+
+    if (map != MAP_FAILED)
+    {
+        if ((file = bemFileNewBuffer(pool, map, (size_t)info.st_size)) == NULL)
+        {
+            munmap(map, (size_t)info.st_size);
+            return NULL;
+        }
+
+        font = bemFontRead(pool, file, index, (const bem_uchar *)map, (size_t)info.st_size);
+
+        bemFileDelete(file);
+
+        if (!font || !font->data)
+            munmap(map, (size_t)info.st_size);
+
+        return font;
+    }
+
+    if ((file = bemFileNewURL(pool, url, NULL)) == NULL)
+        return NULL;
+
+    font = bemFontNew(pool, file, index);
+
+    bemFileDelete(file);
+
+    return font;
+}
+
+static void bemParseFonts(bem_memory_pool *pool, bem_font_scanner *scanner)
+{
+    bem_font_worker *workers;
+    bem_font_scan *scan;
+    bem_font_info *info;
+    size_t i, j, num_workers;
+    long num_cpus;
+
+    if ((scanner->queue = (bem_font_scan **)malloc((scanner->scan_amount + 1) * sizeof(bem_font_scan *))) == NULL)
+        return;
+
+    for (i = 0, scan = scanner->scans, scanner->queue_amount = 0; i < scanner->scan_amount; i++, scan++)
+    {
+        if (!scan->reuse)
+            scanner->queue[scanner->queue_amount++] = scan;
+    }
+
+    if (scanner->queue_amount == 0)
+        return;
+
+    if (pool->font_threads > 0)
+    {
+        num_workers = (size_t)pool->font_threads;
+    }
+    else
+    {
+        num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = num_cpus > 0 ? (size_t)num_cpus : 1;
+    }
+
+    if (num_workers > scanner->queue_amount)
+        num_workers = scanner->queue_amount;
+
+    if ((workers = (bem_font_worker *)calloc(num_workers, sizeof(bem_font_worker))) == NULL)
+        return;
+
+    qsort(scanner->queue, scanner->queue_amount, sizeof(bem_font_scan *), (bem_comparison_function)bemCompareScans);
+
+    pthread_mutex_init(&scanner->mutex, NULL);
+    scanner->next = 0;
+
+    // Pools aren't thread safe, so every worker interns its strings in a pool of its own
+    for (i = 0; i < num_workers; i++)
+    {
+        workers[i].scanner = scanner;
+
+        if ((workers[i].pool = bemPoolNew()) == NULL)
+            break;
+
+        bemPoolSetErrorCallback(workers[i].pool, pool->error_callback, pool->error_context);
+
+        if (i > 0 && pthread_create(&workers[i].thread, NULL, bemScanFonts, workers + i))
+        {
+            bemPoolDelete(workers[i].pool);
+            workers[i].pool = NULL;
+            break;
+        }
+    }
+
+    num_workers = i;
+
+    // The calling thread is worker 0
+    if (num_workers > 0)
+        bemScanFonts(workers);
+
+    for (i = 1; i < num_workers; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    pthread_mutex_destroy(&scanner->mutex);
+
+    // Merge in scan order and re-intern the strings in the caller's pool, bemSortFonts then puts them in their final order
+    for (i = 0, scan = scanner->scans; i < scanner->scan_amount; i++, scan++)
+    {
+        for (j = 0, info = scan->fonts; j < scan->font_amount; j++, info++)
+            bemAddFontInfo(pool, info);
+
+        free(scan->fonts);
+        scan->fonts = NULL;
+    }
+
+    for (i = 0; i < num_workers; i++)
+        bemPoolDelete(workers[i].pool);
+
+    free(workers);
+}
+
+static void bemSaveCache(bem_memory_pool *pool, const char *cname, bem_font_scanner *scanner)
+{
+    bem_font_cache_header header;
+    bem_font_cache_record *records, *record;
+    bem_font_cache_family *families, *family = NULL;
+    bem_font_cache_directory *directories, *directory;
+    bem_font_cache_file *files, *file;
+    bem_font_scan **sorted, key, *keyptr = &key, **found;
+    bem_font_info *info;
+    char *strings;
+    size_t i, length, strings_size = 1;
+
+    for (i = 0; i < scanner->directory_amount; i++)
+        strings_size += strlen(scanner->directories[i].path) + 1;
+
+    for (i = 0; i < scanner->scan_amount; i++)
+        strings_size += strlen(scanner->scans[i].url) + 1;
+
+    for (i = 0, info = pool->fonts; i < pool->font_amount; i++, info++)
+        strings_size += strlen(info->font_family) + 1;
+
+    records = (bem_font_cache_record *)calloc(pool->font_amount + 1, sizeof(bem_font_cache_record));
+    families = (bem_font_cache_family *)calloc(pool->font_amount + 1, sizeof(bem_font_cache_family));
+    directories = (bem_font_cache_directory *)calloc(scanner->directory_amount + 1, sizeof(bem_font_cache_directory));
+    files = (bem_font_cache_file *)calloc(scanner->scan_amount + 1, sizeof(bem_font_cache_file));
+    sorted = (bem_font_scan **)malloc((scanner->scan_amount + 1) * sizeof(bem_font_scan *));
+    strings = (char *)malloc(strings_size);
+
+    if (!records || !families || !directories || !files || !sorted || !strings)
+    {
+        free(records);
+        free(families);
+        free(directories);
+        free(files);
+        free(sorted);
+        free(strings);
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "BEMFONTS", 8);
+    header.version = BEM_FONT_CACHE_VERSION;
+    header.font_amount = (unsigned)pool->font_amount;
+    header.directory_amount = (unsigned)scanner->directory_amount;
+    header.file_amount = (unsigned)scanner->scan_amount;
+
+    // Offset 0 is an empty string so the string table is never empty
+    strings[0] = '\0';
+    strings_size = 1;
+
+    for (i = 0, directory = directories; i < scanner->directory_amount; i++, directory++)
+    {
+        directory->path = (unsigned)strings_size;
+        directory->mtime = (unsigned)scanner->directories[i].mtime;
+        directory->first_file = (unsigned)scanner->directories[i].first_scan;
+        directory->file_amount = (unsigned)scanner->directories[i].scan_amount;
+        directory->end = (unsigned)scanner->directories[i].end;
+
+        length = strlen(scanner->directories[i].path) + 1;
+        memcpy(strings + strings_size, scanner->directories[i].path, length);
+        strings_size += length;
+    }
+
+    for (i = 0, file = files; i < scanner->scan_amount; i++, file++)
+    {
+        file->path = (unsigned)strings_size;
+        file->mtime = (unsigned)scanner->scans[i].mtime;
+        file->size = (unsigned)scanner->scans[i].size;
+
+        length = strlen(scanner->scans[i].url) + 1;
+        memcpy(strings + strings_size, scanner->scans[i].url, length);
+        strings_size += length;
+
+        sorted[i] = scanner->scans + i;
+    }
+
+    if (scanner->scan_amount > 1)
+        qsort(sorted, scanner->scan_amount, sizeof(bem_font_scan *), (bem_comparison_function)bemCompareScanURLs);
+
+    // Fonts are sorted by family, so each family is a run of records sharing one name
+    for (i = 0, info = pool->fonts, record = records; i < pool->font_amount; i++, info++, record++)
+    {
+        key.url = (char *)info->font_url;
+
+        if ((found = (bem_font_scan **)bsearch(&keyptr, sorted, scanner->scan_amount, sizeof(bem_font_scan *), (bem_comparison_function)bemCompareScanURLs)) == NULL)
+            break;
+
+        if (!family || strcasecmp(info->font_family, strings + family->name))
+        {
+            family = families + header.family_amount++;
+            family->name = (unsigned)strings_size;
+            family->first = (unsigned)i;
+
+            length = strlen(info->font_family) + 1;
+            memcpy(strings + strings_size, info->font_family, length);
+            strings_size += length;
+        }
+
+        family->amount++;
+
+        record->file = (unsigned)(*found - scanner->scans);
+        record->url = files[record->file].path;
+        record->family = family->name;
+        record->index = (unsigned)info->font_index;
+        record->weight = (unsigned short)info->font_weight;
+        record->style = (unsigned char)info->font_style;
+        record->stretch = (unsigned char)info->font_stretch;
+    }
+
+    header.strings_size = (unsigned)strings_size;
+
+    if (i == pool->font_amount)
+    {
+        bem_write_span spans[] = {{&header, sizeof(header)},
+                                  {records, pool->font_amount * sizeof(bem_font_cache_record)},
+                                  {families, header.family_amount * sizeof(bem_font_cache_family)},
+                                  {directories, scanner->directory_amount * sizeof(bem_font_cache_directory)},
+                                  {files, scanner->scan_amount * sizeof(bem_font_cache_file)},
+                                  {strings, strings_size},
+                                  {NULL, 0}};
+
+        bemWriteFile(cname, (bem_write_function)bemWriteSpans, spans);
+    }
+
+    free(records);
+    free(families);
+    free(directories);
+    free(files);
+    free(sorted);
+    free(strings);
+}
+
+static bool bemScanAllFonts(bem_memory_pool *pool, bem_font_scanner *scanner)
+{
+    const bem_font_cache_header *header = (const bem_font_cache_header *)pool->font_cache;
+    const bem_font_cache_record *record;
+    const bem_font_cache_directory *directories = NULL;
+    const char *strings = NULL;
+    char roots[16][1024];
+    bem_font_scan **files = NULL;
+    bem_font_info info;
+    size_t i, root, cached, num_roots;
+
+    if (header)
+    {
+        directories = (const bem_font_cache_directory *)((const bem_font_cache_family *)((const bem_font_cache_record *)(header + 1) + header->font_amount) + header->family_amount);
+        strings = (const char *)pool->font_cache + pool->font_cache_size - header->strings_size;
+    }
+
+    num_roots = bemGetFontDirectories(roots, sizeof(roots) / sizeof(roots[0]));
+
+    for (i = 0; i < num_roots; i++)
+    {
+        // Any cached directory will do, so a root that used to be a subdirectory keeps its entries
+        for (root = 0, cached = BEM_FONT_CACHE_NONE; header && root < header->directory_amount; root++)
+        {
+            if (!strcmp(roots[i], strings + directories[root].path))
+            {
+                cached = root;
+                break;
+            }
+        }
+
+        bemLoadFonts(pool, roots[i], scanner, cached);
+    }
+
+    // Removed directories or files show up as a count mismatch
+    if (header && (scanner->directory_amount != header->directory_amount || scanner->scan_amount != header->file_amount))
+        scanner->changed = true;
+
+    if (header && (!scanner->changed || (files = (bem_font_scan **)calloc(header->file_amount + 1, sizeof(bem_font_scan *))) == NULL))
+        return false;
+
+    bemParseFonts(pool, scanner);
+
+    if (header)
+    {
+        // Unchanged files keep their records from the old cache, which is then replaced by pool->fonts
+        for (i = 0; i < scanner->scan_amount; i++)
+        {
+            if (scanner->scans[i].reuse)
+                files[scanner->scans[i].cached] = scanner->scans + i;
+        }
+
+        for (i = 0, record = (const bem_font_cache_record *)(header + 1); i < header->font_amount; i++, record++)
+        {
+            if (!files[record->file])
+                continue;
+
+            info.font_url = files[record->file]->url;
+            info.font_family = strings + record->family;
+            info.font_index = record->index;
+            info.font = NULL;
+            info.font_stretch = (bem_font_stretch)record->stretch;
+            info.font_style = (bem_font_style)record->style;
+            info.font_variant = FONT_VARIANT_NORMAL;
+            info.font_weight = (bem_font_weight)record->weight;
+
+            bemAddFontInfo(pool, &info);
+        }
+
+        free(files);
+        free(pool->font_cache_fonts);
+        munmap((void *)pool->font_cache, pool->font_cache_size);
+
+        pool->font_cache = NULL;
+        pool->font_cache_size = 0;
+        pool->font_cache_fonts = NULL;
+    }
+
+    bemSortFonts(pool);
+
+    return true;
+}
+
+static void *bemScanFonts(void *data)
+{
+    bem_font_worker *worker = (bem_font_worker *)data;
+    bem_font_scanner *scanner = worker->scanner;
+    bem_font_scan *scan;
+    bem_font_info *info;
+    bem_font *font;
+    size_t i, num_fonts;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&scanner->mutex);
+        scan = scanner->next < scanner->queue_amount ? scanner->queue[scanner->next++] : NULL;
+        pthread_mutex_unlock(&scanner->mutex);
+
+        if (!scan)
+            break;
+
+        // Only the names and style are needed here, so a header-only open is enough
+        for (i = 0, num_fonts = 1; i < num_fonts; i++)
+        {
+            if ((font = bemOpenFont(worker->pool, scan->url, i)) == NULL)
+                break;
+
+            num_fonts = font->fonts_amount;
+
+            if (font->family && (info = realloc(scan->fonts, (scan->font_amount + 1) * sizeof(bem_font_info))) != NULL)
+            {
+                scan->fonts = info;
+                info += scan->font_amount++;
+
+                info->font_url = scan->url;
+                info->font_family = font->family;
+                info->font_index = font->index;
+                info->font = NULL;
+                info->font_stretch = font->stretch;
+                info->font_style = font->style;
+                info->font_variant = FONT_VARIANT_NORMAL;
+                info->font_weight = bemFontGetWeight(font);
+            }
+
+            bemFontDelete(font);
+        }
+    }
+
+    return NULL;
+}
+
+static void bemShareFontMetrics(bem_memory_pool *pool, bem_font *font, const char *url)
+{
+    bem_font_metrics_file metrics;
+    unsigned hash = 2166136261u;
+    const char *directory, *s;
+    char mname[PATH_MAX];
+    struct stat info;
+    int length;
+
+    if ((directory = pool->font_metrics) == NULL && (directory = getenv("BEM_FONT_METRICS")) == NULL)
+        return;
+
+    if (stat(url, &info) || !S_ISREG(info.st_mode))
+        return;
+
+    for (s = url; *s; s++)
+        hash = (hash ^ (unsigned char)*s) * 16777619u;
+
+    if ((length = snprintf(mname, sizeof(mname), "%s/%08x-%u.dat", directory, hash, (unsigned)font->index)) < 0 || (size_t)length >= sizeof(mname))
+        return;
+
+    if (bemMapFontMetrics(font, mname, url, &info))
+        return;
+
+    memset(&metrics, 0, sizeof(metrics));
+    memcpy(metrics.header.magic, "BEMFMETR", 8);
+    metrics.header.version = BEM_FONT_METRICS_VERSION;
+    metrics.header.index = (unsigned)font->index;
+    metrics.header.mtime = (unsigned)info.st_mtime;
+    metrics.header.size = (unsigned)info.st_size;
+    metrics.header.url_size = (unsigned)(strlen(url) + 1);
+    metrics.font = font;
+    metrics.url = url;
+
+    // First process to use this font publishes it for the others
+    mkdir(directory, 0755);
+
+    if (bemWriteFile(mname, (bem_write_function)bemWriteFontMetrics, &metrics))
+        bemMapFontMetrics(font, mname, url, &info);
+}
+
+static void bemSortFonts(bem_memory_pool *pool)
+{
+    if (pool->font_amount > 1)
+        qsort(pool->fonts, pool->font_amount, sizeof(bem_font_info), (bem_comparison_function)bemCompareInfo);
+
+    // Indices into pool->fonts have changed
+    bemDeleteFontIndex(pool);
+}
+
+static bool bemWriteFontMetrics(bem_font_metrics_file *metrics, FILE *fp)
+{
+    static const char padding[4] = {0};
+    bem_font *font = metrics->font;
+    size_t i, url_size = metrics->header.url_size, padding_size = ((url_size + 3) & ~(size_t)3) - url_size;
+    long tables_offset = -1;
+    unsigned short *glyphs;
+    bool unloaded, written;
+
+    // Glyph pages follow all of the width pages, so they wait in memory until the widths are out
+    if ((glyphs = (unsigned short *)malloc(BEM_FONT_MAX_CHAR * sizeof(unsigned short))) == NULL)
+        return (false);
+
+    written = fwrite(&metrics->header, sizeof(metrics->header), 1, fp) == 1 && fwrite(metrics->url, 1, url_size, fp) == url_size &&
+              fwrite(padding, 1, padding_size, fp) == padding_size && (tables_offset = ftell(fp)) >= 0 && fwrite(metrics->pages, sizeof(metrics->pages), 1, fp) == 1 &&
+              fwrite(metrics->glyph_pages, sizeof(metrics->glyph_pages), 1, fp) == 1;
+
+    // Pages that aren't loaded yet are decoded, counted, written and dropped one at a time
+    for (i = 0; written && i < BEM_FONT_MAX_CHAR / 256; i++)
+    {
+        unloaded = font->data && !(font->loaded[i / 8] & (1 << (i & 7)));
+
+        if (unloaded)
+            bemFontLoadPage(font, (int)i);
+
+        metrics->pages[i] = font->widths[i] ? ++metrics->header.page_amount : 0;
+        metrics->glyph_pages[i] = font->glyphs[i] ? ++metrics->header.glyph_page_amount : 0;
+
+        if (metrics->pages[i] && fwrite(font->widths[i], sizeof(bem_font_metric), 256, fp) != 256)
+            written = false;
+        else if (metrics->glyph_pages[i])
+            memcpy(glyphs + 256 * (metrics->glyph_pages[i] - 1), font->glyphs[i], 256 * sizeof(unsigned short));
+
+        if (unloaded)
+            bemFontUnloadPage(font, (int)i);
+    }
+
+    // Then the header and page tables again, now that the pages are counted
+    written = written && fwrite(glyphs, 256 * sizeof(unsigned short), metrics->header.glyph_page_amount, fp) == metrics->header.glyph_page_amount && !fseek(fp, 0, SEEK_SET) &&
+              fwrite(&metrics->header, sizeof(metrics->header), 1, fp) == 1 && !fseek(fp, tables_offset, SEEK_SET) && fwrite(metrics->pages, sizeof(metrics->pages), 1, fp) == 1 &&
+              fwrite(metrics->glyph_pages, sizeof(metrics->glyph_pages), 1, fp) == 1;
+
+    free(glyphs);
+
+    return (written);
+}
+
+static const char *bemCopyName(bem_memory_pool *pool, bem_off_names *names, unsigned name_id)
+{
+    bem_off_name *name, *best = NULL;
+    const unsigned char *ptr, *end;
+    char buffer[1024], *buffer_ptr, *buffer_end = buffer + sizeof(buffer) - 5;
+    int i, score, best_score = 0;
+    unsigned ch;
+
+    for (i = 0, name = names->names; i < names->num_names; i++, name++)
+    {
+        if (name->name_id != name_id)
+            continue;
+
+        // Prefer US English Windows names, then any Unicode name, then Macintosh Roman
+        if (name->platform_id == 3 && (name->encoding_id == 1 || name->encoding_id == 10))
+            score = name->language_id == 0x0409 ? 4 : 3;
+        else if (name->platform_id == 0)
+            score = 2;
+        else if (name->platform_id == 1 && name->encoding_id == 0)
+            score = 1;
+        else
+            continue;
+
+        if (score > best_score && (unsigned)name->offset + name->length <= names->storage_size)
+        {
+            best = name;
+            best_score = score;
+        }
+    }
+
+    if (!best)
+        return NULL;
+
+    ptr = names->storage + best->offset;
+    end = ptr + best->length;
+
+    for (buffer_ptr = buffer; ptr < end && buffer_ptr < buffer_end;)
+    {
+        if (best->platform_id == 1)
+        {
+            ch = *ptr++;
+        }
+        else if (ptr + 1 < end)
+        {
+            ch = (unsigned)((ptr[0] << 8) | ptr[1]);
+            ptr += 2;
+
+            if (ch >= 0xd800 && ch < 0xdc00 && ptr + 1 < end)
+            {
+                ch = 0x10000 + ((ch - 0xd800) << 10) + ((unsigned)((ptr[0] << 8) | ptr[1]) - 0xdc00);
+                ptr += 2;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        if (ch < 0x80)
+        {
+            *buffer_ptr++ = (char)ch;
+        }
+        else if (ch < 0x800)
+        {
+            *buffer_ptr++ = (char)(0xc0 | (ch >> 6));
+            *buffer_ptr++ = (char)(0x80 | (ch & 0x3f));
+        }
+        else if (ch < 0x10000)
+        {
+            *buffer_ptr++ = (char)(0xe0 | (ch >> 12));
+            *buffer_ptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+            *buffer_ptr++ = (char)(0x80 | (ch & 0x3f));
+        }
+        else
+        {
+            *buffer_ptr++ = (char)(0xf0 | (ch >> 18));
+            *buffer_ptr++ = (char)(0x80 | ((ch >> 12) & 0x3f));
+            *buffer_ptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+            *buffer_ptr++ = (char)(0x80 | (ch & 0x3f));
+        }
+    }
+
+    *buffer_ptr = '\0';
+
+    return (buffer[0] ? bemPoolGetString(pool, buffer) : NULL);
+}
+
+static int bemDecodeShort(const bem_uchar *data)
+{
+    return ((short)((data[0] << 8) | data[1]));
+}
+
+static unsigned bemDecodeUlong(const bem_uchar *data)
+{
+    return (((unsigned)data[0] << 24) | ((unsigned)data[1] << 16) | ((unsigned)data[2] << 8) | data[3]);
+}
+
+static int bemDecodeUshort(const bem_uchar *data)
+{
+    return ((data[0] << 8) | data[1]);
+}
+
+static unsigned bemFindCmap(const bem_off_span *cmap)
+{
+    unsigned offset, best_offset = 0, i, record;
+    int platform_id, encoding_id, num_tables, score, best_score = 0;
+
+    num_tables = bemLoadUshort(cmap, 2);
+
+    for (i = 0, record = 4; i < (unsigned)num_tables && record + 8 <= cmap->length; i++, record += 8)
+    {
+        platform_id = bemLoadUshort(cmap, record);
+        encoding_id = bemLoadUshort(cmap, record + 2);
+        offset = bemLoadUlong(cmap, record + 4);
+
+        // Full Unicode repertoire (format 12) beats BMP-only (format 4) beats symbol fonts
+        if ((platform_id == 3 && encoding_id == 10) || (platform_id == 0 && (encoding_id == 4 || encoding_id == 6)))
+            score = 3;
+        else if ((platform_id == 3 && encoding_id == 1) || (platform_id == 0 && encoding_id <= 3))
+            score = 2;
+        else if (platform_id == 3 && encoding_id == 0)
+            score = 1;
+        else
+            continue;
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_offset = offset;
+        }
+    }
+
+    return best_offset;
+}
+
+static bem_off_dir *bemFindTable(bem_off_table *table, unsigned tag)
+{
+    bem_off_dir *entry;
+    int i;
+
+    for (i = 0, entry = table->entries; i < table->num_entries; i++, entry++)
+    {
+        if (entry->tag == tag)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static void bemFreeTable(bem_off_span *span)
+{
+    free(span->buffer);
+    memset(span, 0, sizeof(bem_off_span));
+}
+
+static int bemLoadShort(const bem_off_span *span, unsigned offset)
+{
+    return ((short)bemLoadUshort(span, offset));
+}
+
+static bool bemLoadTable(bem_file *file, bem_off_table *table, unsigned tag, bem_off_span *span)
+{
+    bem_off_dir *entry;
+    size_t size;
+
+    memset(span, 0, sizeof(bem_off_span));
+
+    if ((entry = bemFindTable(table, tag)) == NULL || entry->length == 0)
+        return false;
+
+    if (file->buffer)
+    {
+        // In-memory and mapped files are decoded in place
+        size = (size_t)(file->buffer_end - file->buffer);
+
+        if (entry->offset > size || entry->length > size - entry->offset)
+            return false;
+
+        span->data = file->buffer + entry->offset;
+    }
+    else
+    {
+        // Otherwise fetch the whole table with one seek and one read
+        if ((span->buffer = (bem_uchar *)malloc(entry->length)) == NULL || bemFileSeek(file, entry->offset) != entry->offset ||
+            bemFileRead(file, span->buffer, entry->length) != entry->length)
+        {
+            bemFreeTable(span);
+            return false;
+        }
+
+        span->data = span->buffer;
+    }
+
+    span->length = entry->length;
+
+    return true;
+}
+
+static unsigned bemLoadUlong(const bem_off_span *span, unsigned offset)
+{
+    return (span->length >= 4 && offset <= span->length - 4 ? bemDecodeUlong(span->data + offset) : 0);
+}
+
+static int bemLoadUshort(const bem_off_span *span, unsigned offset)
+{
+    return (span->length >= 2 && offset <= span->length - 2 ? bemDecodeUshort(span->data + offset) : 0);
+}
+
+static int bemReadCmap(bem_file *file, bem_off_table *table, unsigned short **glyphs)
+{
+    bem_off_span span, subtable;
+    unsigned offset;
+    int num_glyphs = -1;
+
+    if (!bemLoadTable(file, table, BEM_OFF_CMAP, &span))
+        return -1;
+
+    if ((offset = bemFindCmap(&span)) != 0 && offset < span.length)
+    {
+        subtable.data = span.data + offset;
+        subtable.length = span.length - offset;
+        subtable.buffer = NULL;
+
+        num_glyphs = bemReadCmapSubtable(&subtable, glyphs);
+    }
+
+    bemFreeTable(&span);
+
+    return num_glyphs;
+}
+
+static int bemReadCmapSubtable(const bem_off_span *subtable, unsigned short **glyphs)
+{
+    unsigned num_groups, i, length, start, end, ends, starts, deltas, ranges, glyph_ids;
+    int format, num_glyphs = 0, ch, glyph, id_delta, id_range_offset;
+    int seg_count, num_glyph_ids, j;
+
+    switch (format = bemLoadUshort(subtable, 0))
+    {
+    case 4:
+        if ((length = (unsigned)bemLoadUshort(subtable, 2)) > subtable->length)
+            length = subtable->length;
+
+        seg_count = bemLoadUshort(subtable, 6) / 2;
+
+        if (seg_count <= 0 || length < 16 + 8 * (unsigned)seg_count)
+            return -1;
+
+        ends = 14;
+        starts = ends + 2 * (unsigned)seg_count + 2;
+        deltas = starts + 2 * (unsigned)seg_count;
+        ranges = deltas + 2 * (unsigned)seg_count;
+        glyph_ids = ranges + 2 * (unsigned)seg_count;
+        num_glyph_ids = (int)(length - glyph_ids) / 2;
+
+        for (j = 0; j < seg_count; j++)
+        {
+            start = (unsigned)bemLoadUshort(subtable, starts + 2 * (unsigned)j);
+            end = (unsigned)bemLoadUshort(subtable, ends + 2 * (unsigned)j);
+            id_delta = bemLoadShort(subtable, deltas + 2 * (unsigned)j);
+            id_range_offset = bemLoadUshort(subtable, ranges + 2 * (unsigned)j);
+
+            for (ch = (int)start; ch <= (int)end; ch++)
+            {
+                if (id_range_offset == 0)
+                {
+                    glyph = (ch + id_delta) & 65535;
+                }
+                else
+                {
+                    // idRangeOffset is relative to its own position in the table
+                    i = (unsigned)(id_range_offset / 2 + (ch - (int)start) - (seg_count - j));
+                    glyph = i < (unsigned)num_glyph_ids ? bemLoadUshort(subtable, glyph_ids + 2 * i) : 0;
+
+                    if (glyph)
+                        glyph = (glyph + id_delta) & 65535;
+                }
+
+                if (glyph && !bemSetGlyph(glyphs, ch, (unsigned)glyph))
+                    return -1;
+
+                num_glyphs += glyph != 0;
+            }
+        }
+        break;
+
+    case 12:
+    case 13:
+        if ((length = bemLoadUlong(subtable, 4)) > subtable->length)
+            length = subtable->length;
+
+        num_groups = bemLoadUlong(subtable, 12);
+
+        if (length < 16 || num_groups == 0 || num_groups > (length - 16) / 12)
+            return -1;
+
+        for (i = 0; i < num_groups; i++)
+        {
+            start = bemLoadUlong(subtable, 16 + 12 * i);
+
+            if ((end = bemLoadUlong(subtable, 20 + 12 * i)) >= BEM_FONT_MAX_CHAR)
+                end = BEM_FONT_MAX_CHAR - 1;
+
+            for (ch = (int)start; start <= end && ch <= (int)end; ch++)
+            {
+                // Format 13 maps the whole range to a single glyph
+                glyph = (int)(format == 12 ? bemLoadUlong(subtable, 24 + 12 * i) + (unsigned)ch - start : bemLoadUlong(subtable, 24 + 12 * i));
+
+                if (glyph > 0 && glyph < 65536 && !bemSetGlyph(glyphs, ch, (unsigned)glyph))
+                    return -1;
+
+                num_glyphs += glyph > 0 && glyph < 65536;
+            }
+        }
+        break;
+
+    default:
+        return -1;
+    }
+
+    return num_glyphs;
+}
+
+static bool bemReadHead(bem_file *file, bem_off_table *table, bem_off_head *head)
+{
+    bem_off_span span;
+
+    memset(head, 0, sizeof(bem_off_head));
+
+    if (!bemLoadTable(file, table, BEM_OFF_HEAD, &span))
+        return false;
+
+    if (span.length <= 36)
+    {
+        bemFreeTable(&span);
+        return false;
+    }
+
+    head->units_per_em = (unsigned short)bemLoadUshort(&span, 18);
+    head->x_min = (short)bemLoadShort(&span, 36);
+    head->y_min = (short)bemLoadShort(&span, 38);
+    head->x_max = (short)bemLoadShort(&span, 40);
+    head->y_max = (short)bemLoadShort(&span, 42);
+    head->mac_style = (unsigned short)bemLoadUshort(&span, 44);
+
+    bemFreeTable(&span);
+
+    return true;
+}
+
+static bool bemReadHhea(bem_file *file, bem_off_table *table, bem_off_hhea *hhea)
+{
+    bem_off_span span;
+
+    memset(hhea, 0, sizeof(bem_off_hhea));
+
+    if (!bemLoadTable(file, table, BEM_OFF_HHEA, &span))
+        return false;
+
+    hhea->ascender = (short)bemLoadShort(&span, 4);
+    hhea->descender = (short)bemLoadShort(&span, 6);
+    hhea->number_of_horizontal_metrics = bemLoadUshort(&span, 34);
+
+    bemFreeTable(&span);
+
+    return (hhea->number_of_horizontal_metrics > 0);
+}
+
+static bem_font_metric *bemReadHmtx(bem_file *file, bem_off_table *table, bem_off_hhea *hhea)
+{
+    bem_font_metric *metrics;
+    bem_off_span span;
+    int i;
+
+    if (hhea->number_of_horizontal_metrics <= 0 || !bemLoadTable(file, table, BEM_OFF_HMTX, &span))
+        return NULL;
+
+    if ((metrics = (bem_font_metric *)calloc((size_t)hhea->number_of_horizontal_metrics, sizeof(bem_font_metric))) != NULL)
+    {
+        for (i = 0; i < hhea->number_of_horizontal_metrics; i++)
+        {
+            metrics[i].width = (short)bemLoadUshort(&span, 4 * (unsigned)i);
+            metrics[i].left_bearing = (short)bemLoadShort(&span, 4 * (unsigned)i + 2);
+        }
+    }
+
+    bemFreeTable(&span);
+
+    return metrics;
+}
+
+static int bemReadMaxp(bem_file *file, bem_off_table *table)
+{
+    bem_off_span span;
+    int num_glyphs = -1;
+
+    if (!bemLoadTable(file, table, BEM_OFF_MAXP, &span))
+        return -1;
+
+    if (span.length > 4)
+        num_glyphs = bemLoadUshort(&span, 4);
+
+    bemFreeTable(&span);
+
+    return num_glyphs;
+}
+
+static bool bemReadNames(bem_file *file, bem_off_table *table, bem_off_names *names)
+{
+    bem_off_span span;
+    bem_off_name *name;
+    unsigned storage_offset, record;
+    int i;
+
+    memset(names, 0, sizeof(bem_off_names));
+
+    if (!bemLoadTable(file, table, BEM_OFF_NAME, &span))
+        return false;
+
+    names->num_names = bemLoadUshort(&span, 2);
+    storage_offset = (unsigned)bemLoadUshort(&span, 4);
+
+    if (names->num_names <= 0 || storage_offset >= span.length ||
+        (names->names = (bem_off_name *)calloc((size_t)names->num_names, sizeof(bem_off_name))) == NULL ||
+        (names->storage = (unsigned char *)malloc(span.length - storage_offset)) == NULL)
+    {
+        free(names->names);
+        memset(names, 0, sizeof(bem_off_names));
+        bemFreeTable(&span);
+        return false;
+    }
+
+    for (i = 0, name = names->names, record = 6; i < names->num_names; i++, name++, record += 12)
+    {
+        name->platform_id = (unsigned short)bemLoadUshort(&span, record);
+        name->encoding_id = (unsigned short)bemLoadUshort(&span, record + 2);
+        name->language_id = (unsigned short)bemLoadUshort(&span, record + 4);
+        name->name_id = (unsigned short)bemLoadUshort(&span, record + 6);
+        name->length = (unsigned short)bemLoadUshort(&span, record + 8);
+        name->offset = (unsigned short)bemLoadUshort(&span, record + 10);
+    }
+
+    names->storage_size = span.length - storage_offset;
+    memcpy(names->storage, span.data + storage_offset, names->storage_size);
+
+    bemFreeTable(&span);
+
+    return true;
+}
+
+static bool bemReadOs2(bem_file *file, bem_off_table *table, bem_off_os_2 *os_2)
+{
+    bem_off_span span;
+    int version;
+
+    memset(os_2, 0, sizeof(bem_off_os_2));
+
+    if (!bemLoadTable(file, table, BEM_OFF_OS_2, &span))
+        return false;
+
+    if (span.length <= 68)
+    {
+        bemFreeTable(&span);
+        return false;
+    }
+
+    version = bemLoadUshort(&span, 0);
+
+    os_2->weight_class = (unsigned short)bemLoadUshort(&span, 4);
+    os_2->width_class = (unsigned short)bemLoadUshort(&span, 6);
+    os_2->fs_type = (unsigned short)bemLoadUshort(&span, 8);
+    os_2->typo_ascender = (short)bemLoadShort(&span, 68);
+    os_2->typo_descender = (short)bemLoadShort(&span, 70);
+
+    if (version >= 2)
+    {
+        os_2->x_height = (short)bemLoadShort(&span, 86);
+        os_2->cap_height = (short)bemLoadShort(&span, 88);
+    }
+
+    bemFreeTable(&span);
+
+    return true;
+}
+
+static bool bemReadPost(bem_file *file, bem_off_table *table, bem_off_post *post)
+{
+    bem_off_span span;
+
+    memset(post, 0, sizeof(bem_off_post));
+
+    if (!bemLoadTable(file, table, BEM_OFF_POST, &span))
+        return false;
+
+    if (span.length <= 12)
+    {
+        bemFreeTable(&span);
+        return false;
+    }
+
+    post->italic_angle = (int)bemLoadUlong(&span, 4) / 65536.0f;
+    post->is_fixed_pitch = bemLoadUlong(&span, 12);
+
+    bemFreeTable(&span);
+
+    return true;
+}
+
+static bool bemReadTable(bem_file *file, size_t index, bem_off_table *table, size_t *num_fonts)
+{
+    bem_uchar header[12], *entries;
+    unsigned tag, offset;
+    int j;
+
+    memset(table, 0, sizeof(bem_off_table));
+
+    if (bemFileRead(file, header, sizeof(header)) != sizeof(header))
+        return false;
+
+    if ((tag = bemDecodeUlong(header)) == BEM_OFF_TTCF)
+    {
+        // Font collection, the offset table for each font follows the 12 byte header
+        if ((*num_fonts = bemDecodeUlong(header + 8)) == 0 || *num_fonts > 65535 || index >= *num_fonts)
+            return false;
+
+        offset = 12 + 4 * (unsigned)index;
+
+        if (bemFileSeek(file, offset) != offset || bemFileRead(file, header, 4) != 4)
+            return false;
+
+        offset = bemDecodeUlong(header);
+
+        if (bemFileSeek(file, offset) != offset || bemFileRead(file, header, sizeof(header)) != sizeof(header))
+            return false;
+
+        tag = bemDecodeUlong(header);
+    }
+    else if (index > 0)
+    {
+        return false;
+    }
+    else
+    {
+        *num_fonts = 1;
+    }
+
+    // TrueType, CFF ("OTTO") and Apple TrueType ("true") outlines
+    if (tag != 0x00010000 && tag != 0x4f54544f && tag != 0x74727565)
+        return false;
+
+    if ((table->num_entries = bemDecodeUshort(header + 4)) <= 0)
+        return false;
+
+    // Read the whole table directory at once
+    if ((entries = (bem_uchar *)malloc(16 * (size_t)table->num_entries)) == NULL)
+        return false;
+
+    if (bemFileRead(file, entries, 16 * (size_t)table->num_entries) != 16 * (size_t)table->num_entries ||
+        (table->entries = (bem_off_dir *)calloc((size_t)table->num_entries, sizeof(bem_off_dir))) == NULL)
+    {
+        free(entries);
+        return false;
+    }
+
+    for (j = 0; j < table->num_entries; j++)
+    {
+        table->entries[j].tag = bemDecodeUlong(entries + 16 * j);
+        table->entries[j].checksum = bemDecodeUlong(entries + 16 * j + 4);
+        table->entries[j].offset = bemDecodeUlong(entries + 16 * j + 8);
+        table->entries[j].length = bemDecodeUlong(entries + 16 * j + 12);
+    }
+
+    free(entries);
+
+    return true;
+}
+
+static bool bemSetGlyph(unsigned short **glyphs, int ch, unsigned glyph)
+{
+    unsigned short *page;
+
+    // Glyph IDs are 16-bit, 0 (.notdef) doubles as "not mapped"
+    if (glyph > 65535)
+        return true;
+
+    if ((page = glyphs[ch / 256]) == NULL)
+    {
+        if ((page = (unsigned short *)calloc(256, sizeof(unsigned short))) == NULL)
+            return false;
+
+        glyphs[ch / 256] = page;
+    }
+
+    page[ch & 255] = (unsigned short)glyph;
+
+    return true;
+}
+
+static const char *const bem_elements[ELEMENT_MAX] = {
+    "*", "!--", "!DOCTYPE", "a", "abbr", "acronym", "address", "applet", "area", "article",
+    "aside", "audio", "b", "base", "basefont", "bdi", "bdo", "big", "blink", "blockquote", "body",
+    "br", "button", "canvas", "caption", "center", "cite", "code", "col", "colgroup", "data",
+    "datalist", "dd", "del", "details", "dfn", "dialog", "dir", "div", "dl", "dt", "em", "embed",
+    "fieldset", "figcaption", "figure", "font", "footer", "form", "frame", "frameset", "h1", "h2",
+    "h3", "h4", "h5", "h6", "head", "header", "hr", "html", "i", "iframe", "img", "input", "ins",
+    "isindex", "kbd", "label", "legend", "li", "link", "main", "map", "mark", "menu", "meta",
+    "meter", "multicol", "nav", "nobr", "noframes", "noscript", "object", "ol", "optgroup",
+    "option", "output", "p", "param", "picture", "pre", "progress", "q", "rb", "rp", "rt", "rtc",
+    "ruby", "s", "samp", "script", "section", "select", "small", "source", "spacer", "span",
+    "strike", "strong", "style", "sub", "summary", "sup", "table", "tbody", "td", "template",
+    "textarea", "tfoot", "th", "thead", "time", "title", "tr", "track", "tt", "u", "ul", "var",
+    "video", "wbr"};
+
+static const unsigned char bem_element_displacements[64] = {
+      1,   1,   0,   6,   0,   0,   0,   3,   1,   1,   2,   0,   0,   0,   1,   0,
+      0,   0,   0,   0,   0,   0,   1,   4,   2,   0,   0,   1,   3,   1,   0,   0,
+      0,   0,   1,   3,   2,   0,   0,   4,   0,   2,   2,   4,   3,   2,   0,   0,
+      0,   0,   1,   0,   0,   1,   0,   1,   0,   0,   2,   0,   1,   1,   0,   2};
+
+static const unsigned char bem_element_slots[256] = {
+    255,  97,  69,  96, 255, 255, 255, 255,  26, 255, 255,  23, 255, 255, 255, 255,
+     28,  56, 255, 255,  50, 255,  99,  40,  47, 255, 255, 255, 255, 255,  86, 255,
+    130,  34,  15,  44,  64, 255, 255, 255, 100, 255, 255, 255, 255,  57, 255,  14,
+     20,  78, 255, 118, 255, 255, 105, 255, 115, 255, 113, 255, 102, 255, 255, 255,
+    129,  98,  29, 255, 107,  43, 255,  32,  82,  31,  27, 255,  10,  95, 255, 255,
+     67,  12, 117, 255,  74,  71,  61, 116,  83, 255,  55, 255,  88, 255,  87,  52,
+    255, 124, 255, 255, 255,  72,  25, 255,  22,  17,  48,   1,  36,  65,  76,  62,
+     30, 131, 120,  41,  19, 255, 123, 255,   8, 255, 255, 255, 109,   7,  92,  84,
+    255, 255,  73, 255, 255, 126,  60, 255,  70,  90, 255,  66, 255, 255, 112, 255,
+    255,  77, 255,  38,  75, 255, 255,  16, 255, 255, 255, 255, 255,  59, 255, 255,
+    119, 255, 127, 255,  51, 110, 255, 255, 255, 255,   6,   0, 128,  49, 255,  39,
+    255, 255, 255,  45, 255, 255, 255,  21,   9, 108, 255, 255, 255,   3, 255, 255,
+     81, 255, 255, 255, 255, 255, 255, 255, 255, 255,  35,  53,  46,  42, 255, 255,
+    255, 255,  58, 255, 255,  85,  79, 104, 255, 255,   4,  11, 255,  37,   2, 255,
+    255, 255, 111, 255, 101, 125, 106, 114,  13,  93,  54,  80, 255,  91,  24,  33,
+    255,  89,   5, 103, 255, 255,  94,  63, 122, 255, 255, 255,  18, 121,  68, 255};
+
+const char *bemElementString(bem_element element)
+{
+    if (element < ELEMENT_WILDCARD || element >= ELEMENT_MAX)
+        return NULL;
+
+    return bem_elements[element];
+}
+
+bem_element bemElementValue(const char *str)
+{
+    return (str ? bemElementValueN(str, strlen(str)) : ELEMENT_UNKNOWN);
+}
+
+bem_element bemElementValueN(const char *str, size_t length)
+{
+    unsigned hash = 2166136261u ^ (unsigned)length;
+    size_t i;
+    int element;
+
+    if (!str || length == 0 || length > BEM_ELEMENT_NAME_MAX)
+        return ELEMENT_UNKNOWN;
+
+    // Perfect hash generated by element-hash.py, "| 0x20" folds case for every character in a tag name
+    for (i = 0; i < length; i++)
+        hash = (hash ^ ((unsigned char)str[i] | 0x20)) * 16777619u;
+
+    element = bem_element_slots[(hash ^ bem_element_displacements[(hash >> 8) & 63]) & 255];
+
+    if (element == 255 || strncasecmp(bem_elements[element], str, length) || bem_elements[element][length])
+        return ELEMENT_UNKNOWN;
+
+    return (bem_element)element;
+}
+
+void bemHTMLDelete(bem_document *html)
+{
+    bem_node_slab *slab, *next;
+    int i;
+
+    if (!html)
+        return;
+
+    if (html->root)
+        bemHtmlDelete(html, html->root);
+
+    for (slab = html->slabs; slab; slab = next)
+    {
+        next = slab->next;
+        free(slab);
+    }
+
+    for (i = 0; i < ELEMENT_MAX; i++)
+        free(html->elements[i].nodes);
+
+    free(html->ids);
+    free(html->id_buckets);
+    bemCSSDelete(html->css);
+    free(html);
+}
+
+bem_node *bemHTMLFindNode(bem_document *html, bem_node *current, bem_element element, const char *id)
+{
+    bem_node *node, *best = NULL;
+    bem_node_list *list;
+    bem_id_entry *entry;
+    const char *node_id;
+    unsigned order = 0;
+    size_t index, left, right, middle;
+
+    if (!html || !html->root || (element == ELEMENT_WILDCARD && !id) || element < ELEMENT_WILDCARD || element >= ELEMENT_MAX)
+        return NULL;
+
+    if (html->index_dirty)
+        bemHtmlIndexRebuild(html);
+
+    if (html->index_dirty)
+    {
+        // The rebuild ran out of memory, so walk the tree until one succeeds
+        for (node = current ? bemHtmlWalkNext(current) : html->root; node; node = bemHtmlWalkNext(node))
+        {
+            if (element == ELEMENT_WILDCARD ? node->element <= ELEMENT_DOCTYPE : node->element != element)
+                continue;
+
+            if (!id || ((node_id = bemDictionaryGetKeyValue(node->value.element.attributes, "id")) != NULL && !strcmp(node_id, id)))
+                return node;
+        }
+
+        return NULL;
+    }
+
+    if (current)
+    {
+        // Matches must come after the first element following the current node
+        for (node = bemHtmlWalkNext(current); node && node->element <= ELEMENT_DOCTYPE; node = bemHtmlWalkNext(node))
+            ;
+
+        if (!node)
+            return NULL;
+
+        order = node->value.element.order;
+    }
+
+    if (id)
+    {
+        if (!html->id_buckets)
+            return NULL;
+
+        for (index = html->id_buckets[bemHtmlIndexHash(id) & (html->id_buckets_size - 1)]; index; index = entry->next)
+        {
+            entry = html->ids + index - 1;
+
+            if (entry->node->value.element.order >= order && (element == ELEMENT_WILDCARD || entry->node->element == element) &&
+                (!best || entry->node->value.element.order < best->value.element.order) && !strcmp(entry->id, id))
+                best = entry->node;
+        }
+
+        return (best);
+    }
+
+    list = html->elements + element;
+
+    for (left = 0, right = list->node_amount; left < right;)
+    {
+        middle = (left + right) / 2;
+
+        if (list->nodes[middle]->value.element.order < order)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    return (left < list->node_amount ? list->nodes[left] : NULL);
+}
+
+bem_stylesheet *bemHTMLGetCSS(bem_document *html)
+{
+    return (html ? html->css : NULL);
+}
+
+const char *bemHTMLGetDOCTYPE(bem_document *html)
+{
+    return (html ? html->doctype : NULL);
+}
+
+bem_node *bemHTMLGetRootNode(bem_document *html)
+{
+    return (html ? html->root : NULL);
+}
+
+bem_document *bemHTMLNew(bem_memory_pool *pool, bem_stylesheet *css)
+{
+    bem_document *html;
+
+    if (!pool)
+        return NULL;
+
+    if ((html = (bem_document *)calloc(1, sizeof(bem_document))) != NULL)
+    {
+        html->pool = pool;
+        html->css = css ? bemCSSNewLayer(css) : bemCSSNew(pool);
+        html->error_callback = bemDefaultErrorCallback;
+        html->url_callback = bemDefaultURLCallback;
+    }
+
+    return (html);
+}
+
+bem_node *bemHTMLNewRootNode(bem_document *html, const char *doctype)
+{
+    bem_node *root;
+
+    if (!html || html->root)
+        return NULL;
+
+    if ((root = (bem_node *)bemHtmlAllocate(html, offsetof(bem_node, value) + sizeof(root->value.element))) == NULL)
+        return NULL;
+
+    root->element = ELEMENT_DOCTYPE;
+    root->value.element.html = html;
+
+    html->root = root;
+    html->doctype = bemPoolGetString(html->pool, doctype);
+
+    return (root);
+}
+
+void bemHTMLSetErrorCallback(bem_document *html, bem_error_callback callback, void *cbdata)
+{
+    if (!html)
+        return;
+
+    html->error_callback = callback ? callback : bemDefaultErrorCallback;
+    html->error_context = cbdata;
+}
+
+void bemHTMLSetURLCallback(bem_document *html, bem_url_callback callback, void *cbdata)
+{
+    if (!html)
+        return;
+
+    html->url_callback = callback ? callback : bemDefaultURLCallback;
+    html->url_context = cbdata;
+}
+
+static void *bemHtmlAllocate(bem_document *html, size_t size)
+{
+    bem_node_slab *slab;
+    void *ptr;
+
+    // Nodes are carved out of per-document slabs so that siblings end up next to
+    // each other in memory; element nodes all have the same size and are reused.
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if (size == ((offsetof(bem_node, value) + sizeof(html->root->value.element) + sizeof(void *) - 1) & ~(sizeof(void *) - 1)) && html->free_nodes)
+    {
+        ptr = html->free_nodes;
+        html->free_nodes = html->free_nodes->next;
+
+        memset(ptr, 0, size);
+
+        return ptr;
+    }
+
+    if ((slab = html->slabs) == NULL || (slab->size - slab->used) < size)
+    {
+        size_t slab_size = size > BEM_NODE_SLAB_SIZE / 4 ? size : BEM_NODE_SLAB_SIZE;
+
+        if ((slab = (bem_node_slab *)malloc(sizeof(bem_node_slab) + slab_size)) == NULL)
+            return NULL;
+
+        slab->used = 0;
+        slab->size = slab_size;
+
+        if (slab_size == size && html->slabs)
+        {
+            // Keep the current slab in front so oversized strings don't waste it
+            slab->next = html->slabs->next;
+            html->slabs->next = slab;
+        }
+        else
+        {
+            slab->next = html->slabs;
+            html->slabs = slab;
+        }
+    }
+
+    ptr = slab->data + slab->used;
+    slab->used += size;
+
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+static const char *bemHtmlGetText(bem_node *node, size_t *length)
+{
+    // Referenced text is read in place without waiting for bemNodeGetString() to terminate it
+    if (node->flags & NODE_FLAG_REFERENCE)
+    {
+        *length = node->value.reference.length;
+        return (node->value.reference.data);
+    }
+
+    *length = strlen(node->value.string);
+
+    return (node->value.string);
+}
+
+static bem_node *bemHtmlWalkNext(bem_node *current)
+{
+    if (!current)
+        return NULL;
+
+    if (current->element >= ELEMENT_DOCTYPE && current->value.element.first_child)
+        return current->value.element.first_child;
+
+    while (current && !current->next)
+        current = current->parent;
+
+    return (current ? current->next : NULL);
+}
+
+static void bemHtmlDelete(bem_document *html, bem_node *node)
+{
+    bem_node *child, *next;
+
+    if (node->element < ELEMENT_DOCTYPE)
+        return;
+
+    for (child = node->value.element.first_child; child; child = next)
+    {
+        next = child->next;
+        bemHtmlDelete(html, child);
+    }
+
+    bemDictionaryDelete(node->value.element.attributes);
+    bemDictionaryDelete((bem_dictionary *)node->value.element.base_properties);
+
+    node->next = html->free_nodes;
+    html->free_nodes = node;
+}
+
+static void bemHtmlIndexAdd(bem_document *html, bem_node *node)
+{
+    bem_node_list *list = html->elements + node->element;
+    bem_node **nodes;
+
+    if (html->index_dirty)
+        return;
+
+    if (list->node_amount >= list->nodes_size)
+    {
+        if ((nodes = realloc(list->nodes, (list->nodes_size + 16) * sizeof(bem_node *))) == NULL)
+        {
+            html->index_dirty = true;
+            return;
+        }
+
+        list->nodes_size += 16;
+        list->nodes = nodes;
+    }
+
+    node->value.element.order = ++html->index_order;
+    list->nodes[list->node_amount++] = node;
+}
+
+static void bemHtmlIndexAddId(bem_document *html, bem_node *node, const char *id)
+{
+    bem_id_entry *entry;
+    size_t i, *bucket;
+
+    if (html->index_dirty)
+        return;
+
+    if (html->id_amount >= html->ids_size)
+    {
+        if ((entry = realloc(html->ids, (html->ids_size + 64) * sizeof(bem_id_entry))) == NULL)
+        {
+            html->index_dirty = true;
+            return;
+        }
+
+        html->ids_size += 64;
+        html->ids = entry;
+    }
+
+    if (html->id_amount >= html->id_buckets_size)
+    {
+        if ((bucket = calloc(html->id_buckets_size ? 2 * html->id_buckets_size : 64, sizeof(size_t))) == NULL)
+        {
+            html->index_dirty = true;
+            return;
+        }
+
+        free(html->id_buckets);
+
+        html->id_buckets_size = html->id_buckets_size ? 2 * html->id_buckets_size : 64;
+        html->id_buckets = bucket;
+
+        for (i = 0, entry = html->ids; i < html->id_amount; i++, entry++)
+        {
+            bucket = html->id_buckets + (bemHtmlIndexHash(entry->id) & (html->id_buckets_size - 1));
+            entry->next = *bucket;
+            *bucket = i + 1;
+        }
+    }
+
+    entry = html->ids + html->id_amount++;
+    entry->id = id;
+    entry->node = node;
+
+    bucket = html->id_buckets + (bemHtmlIndexHash(id) & (html->id_buckets_size - 1));
+    entry->next = *bucket;
+    *bucket = html->id_amount;
+}
+
+static unsigned bemHtmlIndexHash(const char *id)
+{
+    unsigned hash = 2166136261u;
+
+    while (*id)
+        hash = (hash ^ (unsigned char)*id++) * 16777619u;
+
+    return (hash);
+}
+
+static void bemHtmlIndexRebuild(bem_document *html)
+{
+    bem_node_iterator iterator;
+    bem_node *node;
+    const char *id;
+    int i;
+
+    for (i = 0; i < ELEMENT_MAX; i++)
+        html->elements[i].node_amount = 0;
+
+    html->id_amount = 0;
+    html->index_order = 0;
+    html->index_dirty = false;
+
+    if (html->id_buckets)
+        memset(html->id_buckets, 0, html->id_buckets_size * sizeof(size_t));
+
+    bemNodeIteratorInit(&iterator, html->root);
+
+    while ((node = bemNodeIteratorNextPreOrder(&iterator)) != NULL && !html->index_dirty)
+    {
+        if (node->element <= ELEMENT_DOCTYPE)
+            continue;
+
+        bemHtmlIndexAdd(html, node);
+
+        if ((id = bemDictionaryGetKeyValue(node->value.element.attributes, "id")) != NULL)
+            bemHtmlIndexAddId(html, node, id);
+    }
+}
+
+static bem_node *bemHtmlNew(bem_node *parent, bem_element element, const char *str)
+{
+    bem_document *html;
+    bem_node *node, *temp;
+    size_t size;
+
+    if (!parent || parent->element < ELEMENT_DOCTYPE)
+        return NULL;
+
+    html = parent->value.element.html;
+
+    if (element >= ELEMENT_DOCTYPE)
+        size = offsetof(bem_node, value) + sizeof(node->value.element);
+    else if (str)
+        size = offsetof(bem_node, value) + strlen(str) + 1;
+    else
+        size = offsetof(bem_node, value) + sizeof(node->value.reference);
+
+    if ((node = (bem_node *)bemHtmlAllocate(html, size)) == NULL)
+        return NULL;
+
+    node->element = element;
+    node->parent = parent;
+
+    if (element >= ELEMENT_DOCTYPE)
+        node->value.element.html = html;
+    else if (str)
+        memcpy(node->value.string, str, strlen(str) + 1);
+
+    if ((node->previous = parent->value.element.last_child) != NULL)
+        node->previous->next = node;
+    else
+        parent->value.element.first_child = node;
+
+    parent->value.element.last_child = node;
+
+    if (element > ELEMENT_DOCTYPE && !html->index_dirty)
+    {
+        // Nodes appended at the end of the document keep the index in document order,
+        // anything else is picked up by a rebuild on the next lookup.
+        for (temp = parent; temp && !temp->next; temp = temp->parent)
+            ;
+
+        if (temp)
+            html->index_dirty = true;
+        else
+            bemHtmlIndexAdd(html, node);
+    }
+
+    return (node);
+}
+
+static void bemHtmlRemove(bem_node *node)
+{
+    if (node->parent)
+    {
+        if (node->previous)
+            node->previous->next = node->next;
+        else
+            node->parent->value.element.first_child = node->next;
+
+        if (node->next)
+            node->next->previous = node->previous;
+        else
+            node->parent->value.element.last_child = node->previous;
+    }
+
+    node->parent = NULL;
+    node->previous = NULL;
+    node->next = NULL;
+}
+
+size_t bemNodeAttributeGetCount(bem_node *node)
+{
+    if (!node || node->element < ELEMENT_DOCTYPE)
+        return 0;
+
+    return bemDictionaryGetCount(node->value.element.attributes);
+}
+
+const char *bemNodeAttributeGetIndexNameValue(bem_node *node, size_t index, const char **name)
+{
+    if (!node || node->element < ELEMENT_DOCTYPE)
+        return NULL;
+
+    return bemDictionaryGetIndexKeyValue(node->value.element.attributes, index, name);
+}
+
+const char *bemNodeAttributeGetNameValue(bem_node *node, const char *name)
+{
+    if (!node || node->element < ELEMENT_DOCTYPE)
+        return NULL;
+
+    return bemDictionaryGetKeyValue(node->value.element.attributes, name);
+}
+
+void bemNodeAttributeRemove(bem_node *node, const char *name)
+{
+    if (!node || node->element < ELEMENT_DOCTYPE)
+        return;
+
+    if (name && !strcasecmp(name, "id") && bemDictionaryGetKeyValue(node->value.element.attributes, "id"))
+        node->value.element.html->index_dirty = true;
+
+    bemDictionaryRemoveKey(node->value.element.attributes, name);
+
+    bemDictionaryDelete((bem_dictionary *)node->value.element.base_properties);
+    node->value.element.base_properties = NULL;
+}
+
+void bemNodeAttributeSetNameValue(bem_node *node, const char *name, const char *value)
+{
+    bem_document *html;
+    bool is_id;
+
+    if (!node || node->element < ELEMENT_DOCTYPE || !name)
+        return;
+
+    html = node->value.element.html;
+
+    if (!node->value.element.attributes)
+        node->value.element.attributes = bemDictionaryNew(html->pool);
+
+    if ((is_id = node->element > ELEMENT_DOCTYPE && !strcasecmp(name, "id")) && bemDictionaryGetKeyValue(node->value.element.attributes, "id"))
+        html->index_dirty = true;
+
+    bemDictionarySetKeyValue(node->value.element.attributes, name, value);
+
+    bemDictionaryDelete((bem_dictionary *)node->value.element.base_properties);
+    node->value.element.base_properties = NULL;
+
+    if (is_id && value)
+    {
+        // Only the last element in document order can be appended to the id index
+        if (node->value.element.order == html->index_order)
+            bemHtmlIndexAddId(html, node, bemDictionaryGetKeyValue(node->value.element.attributes, "id"));
+        else
+            html->index_dirty = true;
+    }
+}
+
+bool bemNodeComputeCSSBox(bem_node *node, bem_compute compute, bem_box *box)
+{
+    static const char *const sides[] = {"top", "right", "bottom", "left"};
+    static const char *const corners[] = {"top-left", "top-right", "bottom-right", "bottom-left"};
+    static const char *const parts[] = {"color", "style", "width"};
+    static const char *const repeats[] = {"repeat", "no-repeat", "repeat-x", "repeat-y"};
+    static const char *const boxes[] = {"border-box", "padding-box", "content-box"};
+    static const int shorthand[4][4] = {{0, 0, 0, 0}, {0, 1, 0, 1}, {0, 1, 2, 1}, {0, 1, 2, 3}};
+    const bem_dictionary *properties;
+    bem_memory_pool *pool;
+    bem_stylesheet *css;
+    bem_border_properties *edges[4];
+    bem_size *radii[4];
+    bem_color current = {0.0f, 0.0f, 0.0f, 1.0f};
+    const char *value, *tokens[9];
+    char buffer[256], shadow[256], key[64], *ptr;
+    size_t i, j, count, vertical;
+    float lengths[4];
+    int side, depth;
+
+    if (!node || node->element <= ELEMENT_DOCTYPE || !box || (properties = bemNodeComputeCSSProperties(node, compute)) == NULL)
+        return false;
+
+    pool = node->value.element.html->pool;
+    css = node->value.element.html->css;
+
+    // Only the painted properties are converted, sizes and edges come from bemLayoutNew()
+    memset(box, 0, sizeof(bem_box));
+    box->background_origin = BACKGROUND_BOX_PADDING;
+    box->list_style_position = LIST_STYLE_POSITION_OUTSIDE;
+    box->overflow = OVERFLOW_VISIBLE;
+    box->orphans = 2;
+    box->windows = 2;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "color")) != NULL)
+        bemGetColor(pool, value, &current);
+
+    edges[0] = &box->border.top;
+    edges[1] = &box->border.right;
+    edges[2] = &box->border.bottom;
+    edges[3] = &box->border.left;
+
+    for (side = 0; side < 4; side++)
+    {
+        edges[side]->color = current;
+        edges[side]->style = BORDER_STYLE_NONE;
+        edges[side]->width = 2.25f;
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "background")) != NULL)
+    {
+        count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 8);
+
+        for (i = 0; i < count; i++)
+        {
+            for (j = 0; j < sizeof(repeats) / sizeof(repeats[0]) && strcasecmp(tokens[i], repeats[j]); j++)
+                ;
+
+            if (j < sizeof(repeats) / sizeof(repeats[0]))
+                box->background_repeat = (bem_background_repeat)j;
+            else if (!strncasecmp(tokens[i], "url(", 4))
+                box->background_image = bemGetImageURL(pool, tokens[i]);
+            else if (!strcasecmp(tokens[i], "fixed"))
+                box->background_attachment = BACKGROUND_ATTACHMENT_FIXED;
+            else if (!strcasecmp(tokens[i], "currentcolor"))
+                box->background_color = current;
+            else
+                bemGetColor(pool, tokens[i], &box->background_color);
+        }
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "background-color")) != NULL)
+    {
+        if (!strcasecmp(value, "currentcolor"))
+            box->background_color = current;
+        else
+            bemGetColor(pool, value, &box->background_color);
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "background-image")) != NULL)
+        box->background_image = bemGetImageURL(pool, value);
+
+    if ((value = bemDictionaryGetKeyValue(properties, "background-repeat")) != NULL)
+    {
+        for (j = 0; j < sizeof(repeats) / sizeof(repeats[0]) && strcasecmp(value, repeats[j]); j++)
+            ;
+
+        if (j < sizeof(repeats) / sizeof(repeats[0]))
+            box->background_repeat = (bem_background_repeat)j;
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "background-attachment")) != NULL && !strcasecmp(value, "fixed"))
+        box->background_attachment = BACKGROUND_ATTACHMENT_FIXED;
+
+    for (j = 0; j < sizeof(boxes) / sizeof(boxes[0]); j++)
+    {
+        if ((value = bemDictionaryGetKeyValue(properties, "background-clip")) != NULL && !strcasecmp(value, boxes[j]))
+            box->background_clip = (bem_background_box)j;
+
+        if ((value = bemDictionaryGetKeyValue(properties, "background-origin")) != NULL && !strcasecmp(value, boxes[j]))
+            box->background_origin = (bem_background_box)j;
+    }
+
+    // The border shorthands were expanded into the longhands when they were parsed
+    for (side = 0; side < 4; side++)
+    {
+        for (i = 0; i < sizeof(parts) / sizeof(parts[0]); i++)
+        {
+            snprintf(key, sizeof(key), "border-%s-%s", sides[side], parts[i]);
+
+            if ((value = bemDictionaryGetKeyValue(properties, key)) != NULL)
+                bemGetBorder(pool, css, value, &current, edges[side], (int)i);
+        }
+
+        if (edges[side]->style <= BORDER_STYLE_NONE)
+            edges[side]->width = 0.0f;
+    }
+
+    // "border-radius: h1 [h2 [h3 [h4]]] [/ v1 [v2 [v3 [v4]]]]", percentages need the box size and are left at 0
+    radii[0] = &box->border_radius.top_left;
+    radii[1] = &box->border_radius.top_right;
+    radii[2] = &box->border_radius.bottom_right;
+    radii[3] = &box->border_radius.bottom_left;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "border-radius")) != NULL && (count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 9)) > 0)
+    {
+        for (i = 0; i < count && strcmp(tokens[i], "/"); i++)
+            ;
+
+        vertical = i + 1 < count ? count - i - 1 : 0;
+
+        if (i > 4)
+            i = 4;
+
+        if (vertical > 4)
+            vertical = 4;
+
+        for (side = 0; i > 0 && side < 4; side++)
+        {
+            radii[side]->width = bemGetLength(pool, tokens[shorthand[i - 1][side]], 0.0f, 0.75f, css, NULL);
+            radii[side]->height = vertical ? bemGetLength(pool, tokens[count - vertical + (size_t)shorthand[vertical - 1][side]], 0.0f, 0.75f, css, NULL) : radii[side]->width;
+        }
+    }
+
+    for (side = 0; side < 4; side++)
+    {
+        snprintf(key, sizeof(key), "border-%s-radius", corners[side]);
+
+        if ((value = bemDictionaryGetKeyValue(properties, key)) != NULL && (count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 2)) > 0)
+        {
+            radii[side]->width = bemGetLength(pool, tokens[0], 0.0f, 0.75f, css, NULL);
+            radii[side]->height = count > 1 ? bemGetLength(pool, tokens[1], 0.0f, 0.75f, css, NULL) : radii[side]->width;
+        }
+    }
+
+    // Only the first of a list of shadows is kept
+    if ((value = bemDictionaryGetKeyValue(properties, "box-shadow")) != NULL && strcasecmp(value, "none"))
+    {
+        snprintf(shadow, sizeof(shadow), "%s", value);
+
+        for (ptr = shadow, depth = 0; *ptr && (depth > 0 || *ptr != ','); ptr++)
+        {
+            if (*ptr == '(')
+                depth++;
+            else if (*ptr == ')')
+                depth--;
+        }
+
+        *ptr = '\0';
+        count = bemLayoutTokens(shadow, buffer, sizeof(buffer), tokens, 8);
+        box->box_shadow.color = current;
+
+        for (i = 0, j = 0; i < count; i++)
+        {
+            if (!strcasecmp(tokens[i], "inset"))
+                box->box_shadow.inset = true;
+            else if (isdigit(*tokens[i] & 255) || *tokens[i] == '-' || *tokens[i] == '+' || *tokens[i] == '.')
+                lengths[j < 4 ? j++ : 3] = bemGetLength(pool, tokens[i], 0.0f, 0.75f, css, NULL);
+            else if (strcasecmp(tokens[i], "currentcolor"))
+                bemGetColor(pool, tokens[i], &box->box_shadow.color);
+        }
+
+        if (j >= 2)
+        {
+            box->box_shadow.horizontal_offset = lengths[0];
+            box->box_shadow.vertical_offset = lengths[1];
+            box->box_shadow.blur_radius = j > 2 && lengths[2] > 0.0f ? lengths[2] : 0.0f;
+            box->box_shadow.spread_distance = j > 3 ? lengths[3] : 0.0f;
+        }
+        else
+        {
+            memset(&box->box_shadow, 0, sizeof(bem_box_shadow));
+        }
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "float")) != NULL)
+        box->float_value = !strcasecmp(value, "left") ? FLOAT_LEFT : !strcasecmp(value, "right") ? FLOAT_RIGHT : FLOAT_NONE;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "list-style-image")) != NULL)
+        box->list_style_image = bemGetImageURL(pool, value);
+
+    if ((value = bemDictionaryGetKeyValue(properties, "list-style-position")) != NULL && !strcasecmp(value, "inside"))
+        box->list_style_position = LIST_STYLE_POSITION_INSIDE;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "overflow")) != NULL)
+    {
+        if (!strcasecmp(value, "hidden"))
+            box->overflow = OVERFLOW_HIDDEN;
+        else if (!strcasecmp(value, "scroll"))
+            box->overflow = OVERFLOW_SCROLL;
+        else if (!strcasecmp(value, "auto"))
+            box->overflow = OVERFLOW_AUTO;
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "z-index")) != NULL && strcasecmp(value, "auto"))
+        box->z_index = (int)strtol(value, NULL, 10);
+
+    if (compute != COMPUTE_BASE)
+        bemDictionaryDelete((bem_dictionary *)properties);
+
+    return (true);
+}
+
+bem_display bemNodeComputeCSSDisplay(bem_node *node, bem_compute compute)
+{
+    static const char *const displays[] = {"none", "block", "inline", "inline-block", "inline-table", "list-item", "table", "table-caption", "table-header-group", "table-footer-group", "table-row-group", "table-row", "table-column-group", "table-column", "table-cell"};
+    const bem_dictionary *properties;
+    const char *value;
+    bem_display display = DISPLAY_INLINE;
+    size_t i;
+
+    if (!node || node->element <= ELEMENT_DOCTYPE || (properties = bemNodeComputeCSSProperties(node, compute)) == NULL)
+        return DISPLAY_INLINE;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "display")) != NULL)
+    {
+        // Flex and grid containers lay out their children like blocks for now
+        for (i = 0; i < sizeof(displays) / sizeof(displays[0]); i++)
+        {
+            if (!strcasecmp(value, displays[i]))
+            {
+                display = (bem_display)i;
+                break;
+            }
+        }
+
+        if (!strcasecmp(value, "flex") || !strcasecmp(value, "grid") || !strcasecmp(value, "flow-root"))
+            display = DISPLAY_BLOCK;
+        else if (!strcasecmp(value, "inline-flex") || !strcasecmp(value, "inline-grid"))
+            display = DISPLAY_INLINE_BLOCK;
+    }
+
+    if (compute != COMPUTE_BASE)
+        bemDictionaryDelete((bem_dictionary *)properties);
+
+    return (display);
+}
+
+const bem_dictionary *bemNodeComputeCSSProperties(bem_node *node, bem_compute compute)
+{
+    bem_document *html;
+    bem_node *current;
+
+    if (!node || node->element <= ELEMENT_DOCTYPE)
+        return NULL;
+
+    // New rules or media invalidate every cached result in the document
+    html = node->value.element.html;
+
+    if (html->css_generation != html->css->generation)
+    {
+        for (current = html->root; current; current = bemHtmlWalkNext(current))
+        {
+            if (current->element > ELEMENT_DOCTYPE && current->value.element.base_properties)
+            {
+                bemDictionaryDelete((bem_dictionary *)current->value.element.base_properties);
+                current->value.element.base_properties = NULL;
+            }
+        }
+
+        html->css_generation = html->css->generation;
+    }
+
+    // Base properties are cached on the node, pseudo-element properties belong to the caller
+    if (compute != COMPUTE_BASE)
+        return bemCreateProperties(node, compute);
+
+    if (!node->value.element.base_properties)
+        node->value.element.base_properties = bemCreateProperties(node, compute);
+
+    return node->value.element.base_properties;
+}
+
+bool bemNodeComputeCSSTable(bem_node *node, bem_compute compute, bem_table *table)
+{
+    const bem_dictionary *properties;
+    bem_document *html;
+    const char *value, *tokens[2];
+    char buffer[256];
+    size_t count;
+
+    if (!node || node->element <= ELEMENT_DOCTYPE || !table || (properties = bemNodeComputeCSSProperties(node, compute)) == NULL)
+        return false;
+
+    html = node->value.element.html;
+
+    memset(table, 0, sizeof(bem_table));
+    table->empty_cells = EMPTY_CELLS_SHOW;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "border-collapse")) != NULL && !strcasecmp(value, "collapse"))
+        table->border_collapse = BORDER_COLLAPSE_COLLAPSE;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "caption-side")) != NULL && !strcasecmp(value, "bottom"))
+        table->caption_side = CAPTION_SIDE_BOTTOM;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "empty-cells")) != NULL && !strcasecmp(value, "hide"))
+        table->empty_cells = EMPTY_CELLS_HIDE;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "table-layout")) != NULL && !strcasecmp(value, "fixed"))
+        table->table_layout = TABLE_LAYOUT_FIXED;
+
+    // One length is both the horizontal and vertical spacing, collapsed borders have none
+    if (table->border_collapse == BORDER_COLLAPSE_SEPARATE && (value = bemDictionaryGetKeyValue(properties, "border-spacing")) != NULL &&
+        (count = bemLayoutTokens(value, buffer, sizeof(buffer), tokens, 2)) > 0)
+    {
+        table->border_spacing.width = bemGetLength(html->pool, tokens[0], 0.0f, 0.75f, html->css, NULL);
+        table->border_spacing.height = count > 1 ? bemGetLength(html->pool, tokens[1], 0.0f, 0.75f, html->css, NULL) : table->border_spacing.width;
+    }
+
+    if (compute != COMPUTE_BASE)
+        bemDictionaryDelete((bem_dictionary *)properties);
+
+    return (true);
+}
+
+bool bemNodeComputeCSSTextFont(bem_node *node, const bem_dictionary *properties, bem_text *text)
+{
+    static const char *const stretches[] = {"normal", "ultra-condensed", "extra-condensed", "condensed", "semi-condensed", "ultra-expanded", "extra-expanded", "expanded", "semi-expanded"};
+    bem_memory_pool *pool;
+    const char *value;
+    int i, weight;
+
+    if (!node || node->element < ELEMENT_DOCTYPE || !properties || !text)
+        return false;
+
+    pool = node->value.element.html->pool;
+
+    // Properties that aren't set keep the values already in text, normally the parent's
+    if ((value = bemDictionaryGetKeyValue(properties, "font-family")) != NULL)
+        text->font_family = bemPoolGetString(pool, value);
+    else if (!text->font_family)
+        text->font_family = bemPoolGetString(pool, "serif");
+
+    if ((value = bemDictionaryGetKeyValue(properties, "font-stretch")) != NULL)
+    {
+        for (i = 0; i < (int)(sizeof(stretches) / sizeof(stretches[0])); i++)
+        {
+            if (!strcasecmp(value, stretches[i]))
+                text->font_strech = (bem_font_stretch)i;
+        }
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "font-style")) != NULL)
+    {
+        if (!strcasecmp(value, "normal"))
+            text->font_style = FONT_STYLE_NORMAL;
+        else if (!strcasecmp(value, "italic"))
+            text->font_style = FONT_STYLE_ITALIC;
+        else if (!strcasecmp(value, "oblique"))
+            text->font_style = FONT_STYLE_OBLIQUE;
+    }
+
+    if ((value = bemDictionaryGetKeyValue(properties, "font-variant")) != NULL)
+    {
+        if (!strcasecmp(value, "normal"))
+            text->font_variant = FONT_VARIANT_NORMAL;
+        else if (!strcasecmp(value, "small-caps"))
+            text->font_variant = FONT_VARIANT_SMALL_CAPS;
+    }
+
+    if (text->font_weight == FONT_WEIGHT_NORMAL)
+        weight = 400;
+    else if (text->font_weight == FONT_WEIGHT_BOLD || text->font_weight == FONT_WEIGHT_BOLDER)
+        weight = 700;
+    else if (text->font_weight == FONT_WEIGHT_LIGHTER)
+        weight = 300;
+    else
+        weight = (int)text->font_weight;
+
+    if ((value = bemDictionaryGetKeyValue(properties, "font-weight")) != NULL)
+    {
+        // bolder and lighter are relative to the inherited weight
+        if (!strcasecmp(value, "normal"))
+            weight = 400;
+        else if (!strcasecmp(value, "bold"))
+            weight = 700;
+        else if (!strcasecmp(value, "bolder"))
+            weight = weight < 350 ? 400 : weight < 550 ? 700 : 900;
+        else if (!strcasecmp(value, "lighter"))
+            weight = weight < 550 ? 100 : weight < 750 ? 400 : 700;
+        else if (atoi(value) >= 1 && atoi(value) <= 1000)
+            weight = atoi(value);
+    }
+
+    text->font_weight = (bem_font_weight)weight;
+    text->font = bemFindFontList(pool, text->font_family, text->font_strech, text->font_style, text->font_weight);
+
+    return (text->font != NULL);
+}
+
+void bemNodeDelete(bem_document *html, bem_node *node)
+{
+    if (!html || !node)
+        return;
+
+    if (node == html->root)
+        html->root = NULL;
+
+    if (node->element >= ELEMENT_DOCTYPE)
+        html->index_dirty = true;
+
+    bemHtmlRemove(node);
+    bemHtmlDelete(html, node);
+}
+
+const char *bemNodeGetComment(bem_node *node)
+{
+    if (!node || node->element != ELEMENT_COMMENT)
+        return NULL;
+
+    return (node->value.comment);
+}
+
+bem_element bemNodeGetElement(bem_node *node)
+{
+    return (node ? node->element : ELEMENT_WILDCARD);
+}
+
+bem_node *bemNodeGetFirstChildNode(bem_node *node)
+{
+    return (node && node->element >= ELEMENT_DOCTYPE ? node->value.element.first_child : NULL);
+}
+
+bem_node *bemNodeGetLastChildNode(bem_node *node)
+{
+    return (node && node->element >= ELEMENT_DOCTYPE ? node->value.element.last_child : NULL);
+}
+
+bem_node *bemNodeGetNextSiblingNode(bem_node *node)
+{
+    return (node ? node->next : NULL);
+}
+
+bem_node *bemNodeGetParentNode(bem_node *node)
+{
+    return (node ? node->parent : NULL);
+}
+
+bem_node *bemNodeGetPreviousSiblingNode(bem_node *node)
+{
+    return (node ? node->previous : NULL);
+}
+
+const char *bemNodeGetString(bem_node *node)
+{
+    char *copy;
+
+    if (!node || node->element != ELEMENT_STRING)
+        return NULL;
+
+    if (!(node->flags & NODE_FLAG_REFERENCE))
+        return (node->value.string);
+
+    // Spans of a source buffer have no nul, so the first caller that needs one gets a copy in the document's slabs
+    if (!(node->flags & NODE_FLAG_TERMINATED))
+    {
+        if (!node->parent || (copy = (char *)bemHtmlAllocate(node->parent->value.element.html, node->value.reference.length + 1)) == NULL)
+            return NULL;
+
+        memcpy(copy, node->value.reference.data, node->value.reference.length);
+        copy[node->value.reference.length] = '\0';
+
+        node->value.reference.data = copy;
+        node->flags |= NODE_FLAG_TERMINATED;
+    }
+
+    return (node->value.reference.data);
+}
+
+bem_node *bemNodeNewComment(bem_node *parent, const char *c)
+{
+    if (!parent || !c)
+        return NULL;
+
+    return bemHtmlNew(parent, ELEMENT_COMMENT, c);
+}
+
+bem_node *bemNodeNewElement(bem_node *parent, bem_element element)
+{
+    if (!parent || element <= ELEMENT_DOCTYPE || element >= ELEMENT_MAX)
+        return NULL;
+
+    return bemHtmlNew(parent, element, NULL);
+}
+
+bem_node *bemNodeNewString(bem_node *parent, const char *s)
+{
+    if (!parent || !s)
+        return NULL;
+
+    return bemHtmlNew(parent, ELEMENT_STRING, s);
+}
+
+bem_node *bemNodeNewStringReference(bem_node *parent, const char *s, size_t length)
+{
+    bem_node *node;
+
+    // The string is not copied, so it must outlive the document (pool strings or
+    // a source buffer that is kept mapped for the lifetime of the document), and
+    // it doesn't need a nul after the length bytes.
+    if (!parent || !s)
+        return NULL;
+
+    if ((node = bemHtmlNew(parent, ELEMENT_STRING, NULL)) != NULL)
+    {
+        node->flags |= NODE_FLAG_REFERENCE;
+        node->value.reference.data = s;
+        node->value.reference.length = length;
+    }
+
+    return (node);
+}
+
+bem_node *bemNodeNewUnknown(bem_node *parent, const char *unknown)
+{
+    if (!parent || !unknown)
+        return NULL;
+
+    return bemHtmlNew(parent, ELEMENT_UNKNOWN, unknown);
+}
+
+void bemSnapshotDelete(bem_snapshot *snapshot)
+{
+    if (snapshot)
+    {
+        free(snapshot->nodes);
+        free(snapshot);
+    }
+}
+
+size_t bemSnapshotGetCount(bem_snapshot *snapshot)
+{
+    return (snapshot ? snapshot->node_amount : 0);
+}
+
+const bem_flat_node *bemSnapshotGetNodes(bem_snapshot *snapshot)
+{
+    return (snapshot ? snapshot->nodes : NULL);
+}
+
+bem_snapshot *bemSnapshotNew(bem_node *root)
+{
+    bem_snapshot *snapshot;
+    bem_node_iterator iterator;
+    bem_node *node;
+    bem_flat_node *flat;
+    size_t *open = NULL, open_amount = 0, open_size = 0, *temp;
+
+    if (!root)
+        return NULL;
+
+    if ((snapshot = (bem_snapshot *)calloc(1, sizeof(bem_snapshot))) == NULL)
+        return NULL;
+
+    bemNodeIteratorInit(&iterator, root);
+
+    while ((node = bemNodeIteratorNextPreOrder(&iterator)) != NULL)
+    {
+        if (snapshot->node_amount >= snapshot->nodes_size)
+        {
+            if ((flat = realloc(snapshot->nodes, (snapshot->nodes_size + 1024) * sizeof(bem_flat_node))) == NULL)
+                break;
+
+            snapshot->nodes_size += 1024;
+            snapshot->nodes = flat;
+        }
+
+        if (open_amount >= open_size)
+        {
+            if ((temp = realloc(open, (open_size + 64) * sizeof(size_t))) == NULL)
+                break;
+
+            open_size += 64;
+            open = temp;
+        }
+
+        // Close the subtrees that end before this node
+        while (open_amount > 0 && snapshot->nodes[open[open_amount - 1]].depth >= iterator.depth)
+            snapshot->nodes[open[--open_amount]].next = snapshot->node_amount;
+
+        open[open_amount++] = snapshot->node_amount;
+
+        flat = snapshot->nodes + snapshot->node_amount++;
+        flat->depth = iterator.depth;
+        flat->element = node->element;
+        flat->next = 0;
+        flat->node = node;
+    }
+
+    while (open_amount > 0)
+        snapshot->nodes[open[--open_amount]].next = snapshot->node_amount;
+
+    free(open);
+
+    if (node)
+    {
+        bemSnapshotDelete(snapshot);
+        return NULL;
+    }
+
+    return (snapshot);
+}
+
+void bemLayoutDelete(bem_layout *layout)
+{
+    bem_node_slab *slab, *next;
+
+    if (!layout)
+        return;
+
+    for (slab = layout->slabs; slab; slab = next)
+    {
+        next = slab->next;
+        free(slab);
+    }
+
+    free(layout);
+}
+
+const bem_layout_box *bemLayoutGetRoot(bem_layout *layout)
+{
+    return (layout ? layout->root : NULL);
+}
+
+const bem_layout_timings *bemLayoutGetTimings(bem_layout *layout)
+{
+    return (layout ? &layout->timings : NULL);
+}
+
+bem_layout *bemLayoutNew(bem_document *html, float width)
+{
+    bem_layout *layout;
+    bem_layout_style *style;
+    bem_layout_flow flow;
+    const bem_media *media;
+    double start = bemLayoutTime();
+
+    if (!html || !html->root)
+        return NULL;
+
+    if ((layout = (bem_layout *)calloc(1, sizeof(bem_layout))) == NULL)
+        return NULL;
+
+    layout->html = html;
+
+    // Without a width the page box of the document's media is the initial containing block
+    media = &html->css->media;
+
+    if (width <= 0.0f)
+        width = media->size.width - media->margin.left_offset - media->margin.right_offset;
+
+    if ((style = (bem_layout_style *)bemLayoutAllocate(layout, sizeof(bem_layout_style))) == NULL ||
+        (layout->root = bemLayoutAddBox(layout, NULL, LAYOUT_BLOCK, html->root, style)) == NULL)
+    {
+        bemLayoutDelete(layout);
+        return NULL;
+    }
+
+    style->display = DISPLAY_BLOCK;
+    style->size.width = width;
+    style->size.height = -1.0f;
+    style->text.font_size = 12.0f;
+    style->text.line_height = 14.4f;
+    style->text.font_weight = FONT_WEIGHT_NORMAL;
+    style->text.color.alpha = 1.0f;
+
+    layout->root->x = media->margin.left_offset;
+    layout->root->y = media->margin.top_offset;
+    layout->root->width = width;
+
+    memset(&flow, 0, sizeof(flow));
+    flow.block = layout->root;
+    flow.left = flow.right = layout->root->x;
+    flow.width = width;
+    flow.y = layout->root->y;
+    flow.first_line = true;
+
+    bemLayoutChildren(layout, &flow, html->root, style);
+    bemLayoutFinishLine(&flow);
+
+    layout->root->height = flow.y + flow.margin - layout->root->y;
+    bemLayoutOverflow(layout->root);
+    layout->width = width;
+    layout->height = layout->root->height;
+
+    layout->timings.total = bemLayoutTime() - start;
+    layout->timings.layout = layout->timings.total - layout->timings.style - layout->timings.text;
+
+    return (layout);
+}
+
+static bem_layout_box *bemLayoutAddBox(bem_layout *layout, bem_layout_box *parent, bem_layout_type type, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_box *box;
+
+    if ((box = (bem_layout_box *)bemLayoutAllocate(layout, sizeof(bem_layout_box))) == NULL)
+        return NULL;
+
+    box->type = type;
+    box->node = node;
+    box->style = style;
+
+    if (parent)
+        bemLayoutAppend(parent, box);
+
+    layout->box_amount++;
+
+    return (box);
+}
+
+static void *bemLayoutAllocate(bem_layout *layout, size_t size)
+{
+    bem_node_slab *slab;
+    size_t slab_size;
+    void *ptr;
+
+    // Same slab scheme as the document's nodes, everything is freed at once by bemLayoutDelete()
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if ((slab = layout->slabs) == NULL || (slab->size - slab->used) < size)
+    {
+        slab_size = size > BEM_NODE_SLAB_SIZE / 4 ? size : BEM_NODE_SLAB_SIZE;
+
+        if ((slab = (bem_node_slab *)malloc(sizeof(bem_node_slab) + slab_size)) == NULL)
+            return NULL;
+
+        slab->used = 0;
+        slab->size = slab_size;
+
+        if (slab_size == size && layout->slabs)
+        {
+            slab->next = layout->slabs->next;
+            layout->slabs->next = slab;
+        }
+        else
+        {
+            slab->next = layout->slabs;
+            layout->slabs = slab;
+        }
+    }
+
+    ptr = slab->data + slab->used;
+    slab->used += size;
+
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+static void bemLayoutAppend(bem_layout_box *parent, bem_layout_box *box)
+{
+    box->parent = parent;
+
+    if (parent->last_child)
+        parent->last_child->next = box;
+    else
+        parent->first_child = box;
+
+    parent->last_child = box;
+}
+
+static void bemLayoutAtomic(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_flow inner;
+    bem_layout_box *box, *parent;
+    bem_size size;
+    float edges, space = 0.0f, outer;
+
+    edges = style->border.left_offset + style->padding.left_offset + style->padding.right_offset + style->border.right_offset;
+
+    if ((box = bemLayoutAddBox(layout, NULL, LAYOUT_INLINE_BLOCK, node, style)) == NULL)
+        return;
+
+    if (bemLayoutReplaced(layout, node, style, &size))
+    {
+        box->width = size.width + edges;
+        box->height = size.height + style->border.top_offset + style->padding.top_offset + style->padding.bottom_offset + style->border.bottom_offset;
+    }
+    else
+    {
+        // Lay the content out where the line starts, then shrink the box to the widest line unless the width is set
+        memset(&inner, 0, sizeof(inner));
+        inner.block = box;
+        inner.left = inner.right = flow->left + style->margin.left_offset + style->border.left_offset + style->padding.left_offset;
+        inner.width = style->size.width >= 0.0f ? style->size.width : flow->width - style->margin.left_offset - style->margin.right_offset - edges;
+        inner.y = flow->y + style->margin.top_offset + style->border.top_offset + style->padding.top_offset;
+        inner.first_line = true;
+
+        if (inner.width < 0.0f)
+            inner.width = 0.0f;
+
+        box->x = flow->left + style->margin.left_offset;
+        box->y = flow->y + style->margin.top_offset;
+
+        if (style->display == DISPLAY_INLINE_TABLE)
+        {
+            bemLayoutTable(layout, &inner, node, style);
+        }
+        else
+        {
+            bemLayoutChildren(layout, &inner, node, style);
+            bemLayoutFinishLine(&inner);
+        }
+
+        box->width = (style->size.width >= 0.0f ? style->size.width : inner.right - inner.left) + edges;
+        box->height = (style->size.height >= 0.0f ? style->size.height : inner.y + inner.margin - (box->y + style->border.top_offset + style->padding.top_offset)) +
+                      style->border.top_offset + style->padding.top_offset + style->padding.bottom_offset + style->border.bottom_offset;
+    }
+
+    outer = style->margin.left_offset + box->width + style->margin.right_offset;
+
+    if (flow->space)
+        space = bemLayoutMeasure(flow->block->style, " ", NULL);
+
+    if (flow->line && flow->content && flow->block->style->text.white_space != WHITE_SPACE_NO_WRAP && flow->block->style->text.white_space != WHITE_SPACE_PRE &&
+        flow->line_x + space + outer > flow->left + flow->width)
+    {
+        bemLayoutFinishLine(flow);
+        space = 0.0f;
+    }
+
+    flow->line_x += space;
+    parent = bemLayoutOpenLine(layout, flow);
+    bemLayoutAppend(parent, box);
+
+    // The bottom margin edge sits on the baseline, bemLayoutFinishLine() moves the box there
+    bemLayoutMove(box, flow->line_x + style->margin.left_offset - box->x, flow->line->y - box->y);
+    box->baseline = box->height + style->margin.bottom_offset;
+
+    if (flow->above < box->baseline + style->margin.top_offset)
+        flow->above = box->baseline + style->margin.top_offset;
+
+    flow->line_x += outer;
+    flow->content = true;
+    flow->space = false;
+    flow->run = NULL;
+}
+
+static bem_layout_box *bemLayoutBlock(bem_layout *layout, bem_layout_flow *flow, bem_layout_box *box, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_flow inner;
+    float margin, edges, width, free_space, right;
+
+    if (!box && (box = bemLayoutAddBox(layout, flow->block, LAYOUT_BLOCK, node, style)) == NULL)
+        return NULL;
+
+    // Adjacent vertical margins collapse to the larger one, a negative margin is subtracted from it
+    if (flow->margin >= 0.0f && style->margin.top_offset >= 0.0f)
+        margin = flow->margin > style->margin.top_offset ? flow->margin : style->margin.top_offset;
+    else if (flow->margin < 0.0f && style->margin.top_offset < 0.0f)
+        margin = flow->margin < style->margin.top_offset ? flow->margin : style->margin.top_offset;
+    else
+        margin = flow->margin + style->margin.top_offset;
+
+    edges = style->border.left_offset + style->padding.left_offset + style->padding.right_offset + style->border.right_offset;
+
+    if ((width = style->size.width) < 0.0f && (width = flow->width - style->margin.left_offset - style->margin.right_offset - edges) < 0.0f)
+        width = 0.0f;
+
+    box->x = flow->left + style->margin.left_offset;
+    box->y = flow->y + margin;
+    box->width = width + edges;
+
+    if (style->size.width >= 0.0f && style->auto_margins && (free_space = flow->width - style->margin.left_offset - box->width - style->margin.right_offset) > 0.0f)
+        box->x += style->auto_margins == 3 ? free_space / 2 : style->auto_margins == 1 ? free_space : 0.0f;
+
+    memset(&inner, 0, sizeof(inner));
+    inner.block = box;
+    inner.left = inner.right = box->x + style->border.left_offset + style->padding.left_offset;
+    inner.width = width;
+    inner.y = box->y + style->border.top_offset + style->padding.top_offset;
+    inner.first_line = true;
+
+    if (style->display == DISPLAY_TABLE)
+    {
+        bemLayoutTable(layout, &inner, node, style);
+
+        // Auto tables shrink to their columns and are only then centered
+        if (style->size.width < 0.0f)
+        {
+            box->width = inner.right - inner.left + edges;
+
+            if (style->auto_margins && (free_space = flow->width - style->margin.left_offset - box->width - style->margin.right_offset) > 0.0f)
+                bemLayoutMove(box, style->auto_margins == 3 ? free_space / 2 : style->auto_margins == 1 ? free_space : 0.0f, 0.0f);
+        }
+    }
+    else
+    {
+        bemLayoutChildren(layout, &inner, node, style);
+        bemLayoutFinishLine(&inner);
+    }
+
+    box->height = (style->size.height >= 0.0f ? style->size.height : inner.y + inner.margin - (box->y + style->border.top_offset + style->padding.top_offset)) +
+                  style->border.top_offset + style->padding.top_offset + style->padding.bottom_offset + style->border.bottom_offset;
+
+    flow->y = box->y + box->height;
+    flow->margin = style->margin.bottom_offset;
+
+    // Shrink-to-fit containers only need the content's width from auto-sized blocks
+    right = (style->size.width >= 0.0f ? box->x + box->width : inner.right + style->padding.right_offset + style->border.right_offset) + style->margin.right_offset;
+
+    if (right > flow->right)
+        flow->right = right;
+
+    return (box);
+}
+
+static void bemLayoutBorder(bem_layout *layout, const bem_dictionary *properties, const bem_text *text, bem_rectangle *border)
+{
+    static const char *const sides[] = {"top", "right", "bottom", "left"};
+    const char *value;
+    float widths[4];
+    char key[64];
+    int side;
+
+    // "border" and the other shorthands were expanded into these when they were parsed
+    for (side = 0; side < 4; side++)
+    {
+        snprintf(key, sizeof(key), "border-%s-style", sides[side]);
+
+        if ((value = bemDictionaryGetKeyValue(properties, key)) == NULL || !strcasecmp(value, "none") || !strcasecmp(value, "hidden"))
+        {
+            widths[side] = 0.0f;
+            continue;
+        }
+
+        snprintf(key, sizeof(key), "border-%s-width", sides[side]);
+
+        if ((value = bemDictionaryGetKeyValue(properties, key)) == NULL)
+            value = "medium";
+
+        widths[side] = bemGetLength(layout->html->pool, value, 0.0f, 0.75f, layout->html->css, text);
+    }
+
+    border->top_offset = widths[0];
+    border->right_offset = widths[1];
+    border->bottom_offset = widths[2];
+    border->left_offset = widths[3];
+}
+
+static void bemLayoutChildren(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style)
+{
+    bem_node *child;
+    const bem_layout_style *child_style, *previous = NULL;
+
+    // Deeper elements are dropped rather than overflowing the stack
+    if (layout->depth >= BEM_LAYOUT_MAX_DEPTH)
+        return;
+
+    layout->depth++;
+
+    for (child = node->value.element.first_child; child; child = child->next)
+    {
+        if (child->element == ELEMENT_STRING)
+        {
+            bemLayoutText(layout, flow, child, style);
+            continue;
+        }
+        else if (child->element == ELEMENT_DOCTYPE)
+        {
+            bemLayoutChildren(layout, flow, child, style);
+            continue;
+        }
+        else if (child->element < ELEMENT_DOCTYPE)
+        {
+            continue;
+        }
+
+        if ((child_style = bemLayoutStyle(layout, child, style, previous, flow->width)) == NULL)
+            continue;
+
+        previous = child_style;
+
+        switch (child_style->display)
+        {
+        case DISPLAY_NONE:
+        case DISPLAY_TABLE_COLUMN:
+        case DISPLAY_TABLE_COLUMN_GROUP:
+            break;
+
+        case DISPLAY_INLINE:
+            if (bemLayoutReplaced(layout, child, child_style, NULL))
+                bemLayoutAtomic(layout, flow, child, child_style);
+            else
+                bemLayoutInline(layout, flow, child, child_style);
+            break;
+
+        case DISPLAY_INLINE_BLOCK:
+        case DISPLAY_INLINE_TABLE:
+            bemLayoutAtomic(layout, flow, child, child_style);
+            break;
+
+        default:
+            // Table parts outside of a table stack like blocks
+            bemLayoutFinishLine(flow);
+            bemLayoutBlock(layout, flow, NULL, child, child_style);
+            break;
+        }
+    }
+
+    layout->depth--;
+}
+
+static void bemLayoutEdges(bem_layout *layout, const bem_dictionary *properties, const char *name, float width, const bem_text *text, bem_rectangle *edges, unsigned char *auto_sides)
+{
+    static const char *const sides[] = {"top", "right", "bottom", "left"};
+    const char *value;
+    float lengths[4];
+    char key[64];
+    int side;
+
+    // The shorthand was expanded into these when it was parsed
+    for (side = 0; side < 4; side++)
+    {
+        snprintf(key, sizeof(key), "%s-%s", name, sides[side]);
+
+        if ((value = bemDictionaryGetKeyValue(properties, key)) != NULL && !strcasecmp(value, "auto"))
+        {
+            lengths[side] = 0.0f;
+
+            if (auto_sides && side & 1)
+                *auto_sides |= side == 3 ? 1 : 2;
+        }
+        else
+        {
+            // Percentages on every side are of the containing block's width
+            lengths[side] = value ? bemGetLength(layout->html->pool, value, width, 0.75f, layout->html->css, text) : 0.0f;
+        }
+    }
+
+    edges->top_offset = lengths[0];
+    edges->right_offset = lengths[1];
+    edges->bottom_offset = lengths[2];
+    edges->left_offset = lengths[3];
+}
+
+static void bemLayoutFinishLine(bem_layout_flow *flow)
+{
+    bem_layout_box *line;
+    float shift = 0.0f, free_space;
+    int i;
+
+    flow->space = false;
+
+    if ((line = flow->line) == NULL)
+        return;
+
+    // Fragments of inline elements that continue on the next line end here
+    for (i = flow->inline_depth - 1; i >= 0; i--)
+    {
+        if (flow->inlines[i].box)
+        {
+            flow->inlines[i].box->width = flow->line_x - flow->inlines[i].box->x;
+            flow->inlines[i].box = NULL;
+        }
+    }
+
+    if (flow->line_x > flow->right)
+        flow->right = flow->line_x;
+
+    if ((free_space = flow->left + flow->width - flow->line_x) > 0.0f)
+    {
+        if (flow->block->style->text.text_align == TEXT_ALIGN_CENTER)
+            shift = free_space / 2;
+        else if (flow->block->style->text.text_align == TEXT_ALIGN_RIGHT)
+            shift = free_space;
+    }
+
+    line->height = flow->above + flow->below;
+    line->baseline = flow->above;
+
+    bemLayoutPlace(line, line->y + line->baseline, shift);
+
+    flow->y = line->y + line->height;
+    flow->line = NULL;
+    flow->run = NULL;
+    flow->content = false;
+    flow->first_line = false;
+}
+
+static void bemLayoutInline(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_inline *current;
+    int depth;
+
+    // Past the limit the content flows into the enclosing element's fragments
+    if (flow->inline_depth >= BEM_LAYOUT_MAX_INLINES)
+    {
+        bemLayoutChildren(layout, flow, node, style);
+        return;
+    }
+
+    depth = flow->inline_depth++;
+    current = flow->inlines + depth;
+    current->node = node;
+    current->style = style;
+    current->box = NULL;
+    current->started = false;
+
+    bemLayoutChildren(layout, flow, node, style);
+
+    // The last fragment gets the right edges
+    if (current->box)
+    {
+        flow->line_x += style->padding.right_offset + style->border.right_offset;
+        current->box->width = flow->line_x - current->box->x;
+        flow->line_x += style->margin.right_offset;
+    }
+
+    flow->inline_depth = depth;
+    flow->run = NULL;
+}
+
+static void bemLayoutIntrinsic(bem_layout *layout, bem_node *node, const bem_layout_style *style, bem_layout_intrinsic *intrinsic)
+{
+    bem_layout_intrinsic inner;
+    bem_node *child;
+    const bem_layout_style *child_style, *previous = NULL;
+    bem_white_space white_space = style->text.white_space;
+    bem_size size;
+    const char *ptr, *start, *end;
+    size_t length;
+    float width, edges;
+
+    if (layout->depth >= BEM_LAYOUT_MAX_DEPTH)
+        return;
+
+    layout->depth++;
+
+    // Same walk as the layout but only measures, nothing is placed
+    for (child = node->value.element.first_child; child; child = child->next)
+    {
+        if (child->element == ELEMENT_STRING)
+        {
+            for (ptr = bemHtmlGetText(child, &length), end = ptr + length; ptr < end;)
+            {
+                if (*ptr == '\n' && white_space != WHITE_SPACE_NORMAL && white_space != WHITE_SPACE_NO_WRAP)
+                {
+                    if (intrinsic->line > intrinsic->max)
+                        intrinsic->max = intrinsic->line;
+
+                    intrinsic->line = 0.0f;
+                    intrinsic->space = false;
+                    ptr++;
+                    continue;
+                }
+                else if (isspace(*ptr & 255) && white_space != WHITE_SPACE_PRE && white_space != WHITE_SPACE_PRE_WRAP)
+                {
+                    intrinsic->space = intrinsic->line > 0.0f;
+                    ptr++;
+                    continue;
+                }
+
+                start = ptr;
+
+                if (white_space == WHITE_SPACE_PRE || white_space == WHITE_SPACE_PRE_WRAP)
+                {
+                    while (ptr < end && *ptr != '\n' && (white_space == WHITE_SPACE_PRE || *ptr != ' '))
+                        ptr++;
+                    while (white_space == WHITE_SPACE_PRE_WRAP && ptr < end && *ptr == ' ')
+                        ptr++;
+                }
+                else
+                {
+                    while (ptr < end && !isspace(*ptr & 255))
+                        ptr++;
+                }
+
+                width = bemLayoutMeasure(style, start, ptr);
+
+                if (intrinsic->space)
+                    intrinsic->line += bemLayoutMeasure(style, " ", NULL);
+
+                intrinsic->line += width;
+                intrinsic->space = false;
+
+                if (white_space == WHITE_SPACE_NO_WRAP || white_space == WHITE_SPACE_PRE)
+                    width = intrinsic->line;
+
+                if (width > intrinsic->min)
+                    intrinsic->min = width;
+            }
+
+            continue;
+        }
+        else if (child->element == ELEMENT_DOCTYPE)
+        {
+            bemLayoutIntrinsic(layout, child, style, intrinsic);
+            continue;
+        }
+        else if (child->element < ELEMENT_DOCTYPE)
+        {
+            continue;
+        }
+
+        if ((child_style = bemLayoutStyle(layout, child, style, previous, 0.0f)) == NULL)
+            continue;
+
+        previous = child_style;
+        edges = child_style->margin.left_offset + child_style->border.left_offset + child_style->padding.left_offset + child_style->padding.right_offset +
+                child_style->border.right_offset + child_style->margin.right_offset;
+
+        switch (child_style->display)
+        {
+        case DISPLAY_NONE:
+        case DISPLAY_TABLE_COLUMN:
+        case DISPLAY_TABLE_COLUMN_GROUP:
+            break;
+
+        case DISPLAY_INLINE:
+            if (bemLayoutReplaced(layout, child, child_style, &size))
+            {
+                intrinsic->line += size.width + edges;
+                intrinsic->space = false;
+
+                if (size.width + edges > intrinsic->min)
+                    intrinsic->min = size.width + edges;
+            }
+            else
+            {
+                intrinsic->line += child_style->margin.left_offset + child_style->border.left_offset + child_style->padding.left_offset;
+                bemLayoutIntrinsic(layout, child, child_style, intrinsic);
+                intrinsic->line += child_style->padding.right_offset + child_style->border.right_offset + child_style->margin.right_offset;
+            }
+            break;
+
+        case DISPLAY_INLINE_BLOCK:
+        case DISPLAY_INLINE_TABLE:
+        case DISPLAY_TABLE_CELL:
+            // Atomic boxes sit on the line, the cells of a row add up
+            memset(&inner, 0, sizeof(inner));
+            bemLayoutIntrinsic(layout, child, child_style, &inner);
+
+            if (inner.line > inner.max)
+                inner.max = inner.line;
+            if (inner.cells > inner.min)
+                inner.min = inner.cells;
+
+            if (child_style->size.width >= 0.0f && child_style->display != DISPLAY_TABLE_CELL)
+                inner.min = inner.max = child_style->size.width;
+            else if (child_style->size.width > inner.max)
+                inner.max = child_style->size.width;
+
+            intrinsic->line += inner.max + edges;
+            intrinsic->space = false;
+
+            if (child_style->display == DISPLAY_TABLE_CELL)
+                intrinsic->cells += inner.min + edges;
+            else if (inner.min + edges > intrinsic->min)
+                intrinsic->min = inner.min + edges;
+            break;
+
+        default:
+            // Blocks end the line and are as wide as their own content
+            if (intrinsic->line > intrinsic->max)
+                intrinsic->max = intrinsic->line;
+            if (intrinsic->cells > intrinsic->min)
+                intrinsic->min = intrinsic->cells;
+
+            intrinsic->line = intrinsic->cells = 0.0f;
+            intrinsic->space = false;
+
+            memset(&inner, 0, sizeof(inner));
+            bemLayoutIntrinsic(layout, child, child_style, &inner);
+
+            if (inner.line > inner.max)
+                inner.max = inner.line;
+            if (inner.cells > inner.min)
+                inner.min = inner.cells;
+
+            if (child_style->size.width >= 0.0f)
+                inner.min = inner.max = child_style->size.width;
+
+            if (inner.min + edges > intrinsic->min)
+                intrinsic->min = inner.min + edges;
+            if (inner.max + edges > intrinsic->max)
+                intrinsic->max = inner.max + edges;
+            break;
+        }
+    }
+
+    layout->depth--;
+}
+
+static float bemLayoutMeasure(const bem_layout_style *style, const char *start, const char *end)
+{
+    const char *ptr;
+    size_t chars = 0;
+
+    if (!end)
+        end = start + strlen(start);
+
+    // Words go through the pool's cache of measured words
+    if (style->text.font)
+        return bemPoolMeasureWord(style->text.font->pool, &style->text, start, (size_t)(end - start));
+
+    // Without a font every character is half an em wide
+    for (ptr = start; ptr < end; ptr++)
+    {
+        if ((*ptr & 0xc0) != 0x80)
+            chars++;
+    }
+
+    return (chars * (style->text.font_size / 2 + style->text.letter_spacing));
+}
+
+static void bemLayoutMetrics(const bem_layout_style *style, float *above, float *below, float *ascent)
+{
+    const bem_font *font = style->text.font;
+    float descent, leading;
+
+    if (font && font->units > 0.0f && font->ascent > 0)
+    {
+        *ascent = font->ascent * style->text.font_size / font->units;
+        descent = (font->descent < 0 ? -font->descent : font->descent) * style->text.font_size / font->units;
+    }
+    else
+    {
+        *ascent = 0.8f * style->text.font_size;
+        descent = 0.2f * style->text.font_size;
+    }
+
+    // Half of the leading goes above the glyphs and half below
+    leading = style->text.line_height - *ascent - descent;
+    *above = *ascent + leading / 2;
+    *below = descent + leading / 2;
+}
+
+static void bemLayoutMove(bem_layout_box *box, float dx, float dy)
+{
+    bem_layout_box *child;
+
+    box->x += dx;
+    box->y += dy;
+
+    for (child = box->first_child; child; child = child->next)
+        bemLayoutMove(child, dx, dy);
+}
+
+static bem_layout_box *bemLayoutOpenLine(bem_layout *layout, bem_layout_flow *flow)
+{
+    bem_layout_box *parent;
+    bem_layout_inline *current;
+    const bem_layout_style *style;
+    float above, below, ascent;
+    int i;
+
+    if (!flow->line)
+    {
+        // The pending margin ends at the first line
+        flow->y += flow->margin;
+        flow->margin = 0.0f;
+
+        if ((flow->line = bemLayoutAddBox(layout, flow->block, LAYOUT_LINE, NULL, flow->block->style)) == NULL)
+            return flow->block;
+
+        flow->line->x = flow->left;
+        flow->line->y = flow->y;
+        flow->line->width = flow->width;
+        flow->line_x = flow->left + (flow->first_line ? flow->block->style->text.text_indent : 0.0f);
+
+        // Every line is at least as tall as the block's own font and line height
+        bemLayoutMetrics(flow->block->style, &flow->above, &flow->below, &ascent);
+    }
+
+    for (i = 0, parent = flow->line; i < flow->inline_depth; parent = current->box, i++)
+    {
+        current = flow->inlines + i;
+
+        if (current->box)
+            continue;
+
+        style = current->style;
+
+        if (!current->started)
+            flow->line_x += style->margin.left_offset;
+
+        if ((current->box = bemLayoutAddBox(layout, parent, LAYOUT_INLINE, current->node, style)) == NULL)
+            return parent;
+
+        current->box->x = flow->line_x;
+
+        if (!current->started)
+        {
+            flow->line_x += style->border.left_offset + style->padding.left_offset;
+            current->started = true;
+        }
+
+        bemLayoutMetrics(style, &above, &below, &ascent);
+
+        current->box->baseline = ascent + style->border.top_offset + style->padding.top_offset;
+        current->box->height = ascent + below - (above - ascent) + style->border.top_offset + style->padding.top_offset + style->padding.bottom_offset + style->border.bottom_offset;
+
+        if (above > flow->above)
+            flow->above = above;
+
+        if (below > flow->below)
+            flow->below = below;
+    }
+
+    return (parent);
+}
+
+static void bemLayoutOverflow(bem_layout_box *box)
+{
+    bem_layout_box *child;
+    const char *value;
+    bem_box paint;
+    float left = box->x, top = box->y, right = box->x + box->width, bottom = box->y + box->height, outset;
+
+    // Only the few elements with an outer shadow need their computed box
+    if (box->node && box->node->element > ELEMENT_DOCTYPE && box->style && box->style->properties &&
+        (value = bemDictionaryGetKeyValue(box->style->properties, "box-shadow")) != NULL && strcasecmp(value, "none") &&
+        bemNodeComputeCSSBox(box->node, COMPUTE_BASE, &paint) && !paint.box_shadow.inset)
+    {
+        outset = paint.box_shadow.spread_distance + paint.box_shadow.blur_radius;
+
+        if (box->x + paint.box_shadow.horizontal_offset - outset < left)
+            left = box->x + paint.box_shadow.horizontal_offset - outset;
+        if (box->y + paint.box_shadow.vertical_offset - outset < top)
+            top = box->y + paint.box_shadow.vertical_offset - outset;
+        if (box->x + box->width + paint.box_shadow.horizontal_offset + outset > right)
+            right = box->x + box->width + paint.box_shadow.horizontal_offset + outset;
+        if (box->y + box->height + paint.box_shadow.vertical_offset + outset > bottom)
+            bottom = box->y + box->height + paint.box_shadow.vertical_offset + outset;
+    }
+
+    for (child = box->first_child; child; child = child->next)
+    {
+        bemLayoutOverflow(child);
+
+        if (child->overflow_x < left)
+            left = child->overflow_x;
+        if (child->overflow_y < top)
+            top = child->overflow_y;
+        if (child->overflow_x + child->overflow_width > right)
+            right = child->overflow_x + child->overflow_width;
+        if (child->overflow_y + child->overflow_height > bottom)
+            bottom = child->overflow_y + child->overflow_height;
+    }
+
+    box->overflow_x = left;
+    box->overflow_y = top;
+    box->overflow_width = right - left;
+    box->overflow_height = bottom - top;
+}
+
+static void bemLayoutPlace(bem_layout_box *box, float baseline, float shift)
+{
+    bem_layout_box *child;
+
+    // Everything on a line shares its baseline, atomic boxes move with their content
+    for (child = box->first_child; child; child = child->next)
+    {
+        if (child->type == LAYOUT_INLINE_BLOCK)
+        {
+            bemLayoutMove(child, shift, baseline - child->baseline - child->y);
+        }
+        else
+        {
+            child->x += shift;
+            child->y = baseline - child->baseline;
+
+            if (child->first_child)
+                bemLayoutPlace(child, baseline, shift);
+        }
+    }
+}
+
+static bool bemLayoutReplaced(bem_layout *layout, bem_node *node, const bem_layout_style *style, bem_size *size)
+{
+    const bem_image *image;
+
+    if (node->element != ELEMENT_IMG && node->element != ELEMENT_CANVAS && node->element != ELEMENT_EMBED && node->element != ELEMENT_IFRAME &&
+        node->element != ELEMENT_OBJECT && node->element != ELEMENT_VIDEO)
+        return false;
+
+    if (!size)
+        return true;
+
+    // Replaced elements are as big as their style says, images fall back on their own size
+    size->width = style->size.width;
+    size->height = style->size.height;
+
+    if ((size->width < 0.0f || size->height < 0.0f) && node->element == ELEMENT_IMG &&
+        (image = bemPoolGetImage(layout->html->pool, bemDictionaryGetKeyValue(node->value.element.attributes, "src"), NULL)) != NULL && image->width > 0 &&
+        image->height > 0)
+    {
+        if (size->width < 0.0f && size->height < 0.0f)
+        {
+            size->width = 0.75f * image->width;
+            size->height = 0.75f * image->height;
+        }
+        else if (size->width < 0.0f)
+        {
+            size->width = size->height * image->width / image->height;
+        }
+        else
+        {
+            size->height = size->width * image->height / image->width;
+        }
+    }
+
+    if (size->width < 0.0f)
+        size->width = 0.0f;
+
+    if (size->height < 0.0f)
+        size->height = 0.0f;
+
+    return (true);
+}
+
+static const bem_layout_style *bemLayoutStyle(bem_layout *layout, bem_node *node, const bem_layout_style *parent, const bem_layout_style *previous, float width)
+{
+    static const char *const sizes[] = {"xx-small", "x-small", "small", "medium", "large", "x-large", "xx-large"};
+    static const float scales[] = {0.6f, 0.75f, 0.889f, 1.0f, 1.2f, 1.5f, 2.0f};
+    static const char *const fonts[] = {"font-family", "font-stretch", "font-style", "font-variant", "font-weight"};
+    const bem_dictionary *properties;
+    bem_layout_style *style;
+    bem_memory_pool *pool = layout->html->pool;
+    const char *value;
+    char *units;
+    double start = bemLayoutTime(), number;
+    float size;
+    size_t i;
+    bool font = parent->text.font == NULL;
+
+    if ((properties = bemNodeComputeCSSProperties(node, COMPUTE_BASE)) == NULL)
+        return NULL;
+
+    // Siblings with the same matches have identical interned properties and share the converted style
+    if (previous && previous->properties && previous->inherited == node->value.element.inherited && previous->properties->pair_amount == properties->pair_amount &&
+        !memcmp(previous->properties->pairs, properties->pairs, properties->pair_amount * sizeof(properties->pairs[0])))
+    {
+        layout->styles_shared++;
+        layout->timings.style += bemLayoutTime() - start;
+
+        return (previous);
+    }
+
+    if ((style = (bem_layout_style *)bemLayoutAllocate(layout, sizeof(bem_layout_style))) == NULL)
+        return NULL;
+
+    layout->style_amount++;
+
+    style->properties = properties;
+    style->inherited = node->value.element.inherited;
+    style->text = parent->text;
+    style->display = bemNodeComputeCSSDisplay(node, COMPUTE_BASE);
+
+    // Values the element inherited were converted by its parent, only its own need converting
+    for (i = 0; i < sizeof(fonts) / sizeof(fonts[0]) && !font; i++)
+        font = bemLayoutValue(style, fonts[i]) != NULL;
+
+    if (font)
+        bemNodeComputeCSSTextFont(node, properties, &style->text);
+
+    if ((value = bemLayoutValue(style, "font-size")) != NULL)
+    {
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && strcasecmp(value, sizes[i]); i++)
+            ;
+
+        if (i < sizeof(sizes) / sizeof(sizes[0]))
+            size = 12.0f * scales[i];
+        else if (!strcasecmp(value, "larger"))
+            size = parent->text.font_size * 1.2f;
+        else if (!strcasecmp(value, "smaller"))
+            size = parent->text.font_size / 1.2f;
+        else
+            size = bemGetLength(pool, value, parent->text.font_size, 0.75f, layout->html->css, &parent->text);
+
+        if (size > 0.0f)
+            style->text.font_size = size;
+    }
+
+    // Numbers and "normal" scale with the element's own font size even when inherited
+    if ((value = bemDictionaryGetKeyValue(properties, "line-height")) == NULL || !strcasecmp(value, "normal"))
+    {
+        style->text.line_height = 1.2f * style->text.font_size;
+    }
+    else
+    {
+        number = bemStrtod(pool, value, &units);
+
+        if (units != value && !*units)
+            style->text.line_height = (float)number * style->text.font_size;
+        else if (bemLayoutValue(style, "line-height"))
+            style->text.line_height = bemGetLength(pool, value, style->text.font_size, 0.75f, layout->html->css, &style->text);
+    }
+
+    if ((value = bemLayoutValue(style, "letter-spacing")) != NULL)
+        style->text.letter_spacing = strcasecmp(value, "normal") ? bemGetLength(pool, value, 0.0f, 0.75f, layout->html->css, &style->text) : 0.0f;
+
+    if ((value = bemLayoutValue(style, "word-spacing")) != NULL)
+        style->text.word_spacing = strcasecmp(value, "normal") ? bemGetLength(pool, value, 0.0f, 0.75f, layout->html->css, &style->text) : 0.0f;
+
+    // Percentages are of each block's own width even when inherited
+    if ((value = bemLayoutValue(style, "text-indent")) != NULL || ((value = bemDictionaryGetKeyValue(properties, "text-indent")) != NULL && strchr(value, '%')))
+        style->text.text_indent = bemGetLength(pool, value, width, 0.75f, layout->html->css, &style->text);
+
+    if ((value = bemLayoutValue(style, "text-align")) != NULL)
+    {
+        if (!strcasecmp(value, "left") || !strcasecmp(value, "start"))
+            style->text.text_align = TEXT_ALIGN_LEFT;
+        else if (!strcasecmp(value, "right") || !strcasecmp(value, "end"))
+            style->text.text_align = TEXT_ALIGN_RIGHT;
+        else if (!strcasecmp(value, "center"))
+            style->text.text_align = TEXT_ALIGN_CENTER;
+        else if (!strcasecmp(value, "justify"))
+            style->text.text_align = TEXT_ALIGN_JUSTIFY;
+    }
+
+    if ((value = bemLayoutValue(style, "color")) != NULL)
+        bemGetColor(pool, value, &style->text.color);
+
+    if ((value = bemLayoutValue(style, "white-space")) != NULL)
+    {
+        if (!strcasecmp(value, "normal"))
+            style->text.white_space = WHITE_SPACE_NORMAL;
+        else if (!strcasecmp(value, "nowrap"))
+            style->text.white_space = WHITE_SPACE_NO_WRAP;
+        else if (!strcasecmp(value, "pre"))
+            style->text.white_space = WHITE_SPACE_PRE;
+        else if (!strcasecmp(value, "pre-line"))
+            style->text.white_space = WHITE_SPACE_PRE_LINE;
+        else if (!strcasecmp(value, "pre-wrap"))
+            style->text.white_space = WHITE_SPACE_PRE_WRAP;
+    }
+
+    // Box edges aren't inherited
+    bemLayoutEdges(layout, properties, "margin", width, &style->text, &style->margin, &style->auto_margins);
+    bemLayoutEdges(layout, properties, "padding", width, &style->text, &style->padding, NULL);
+    bemLayoutBorder(layout, properties, &style->text, &style->border);
+
+    if ((value = bemDictionaryGetKeyValue(properties, "width")) == NULL || !strcasecmp(value, "auto"))
+        style->size.width = -1.0f;
+    else
+        style->size.width = bemGetLength(pool, value, width, 0.75f, layout->html->css, &style->text);
+
+    if ((value = bemDictionaryGetKeyValue(properties, "height")) == NULL || !strcasecmp(value, "auto") || strchr(value, '%'))
+        style->size.height = -1.0f;
+    else
+        style->size.height = bemGetLength(pool, value, 0.0f, 0.75f, layout->html->css, &style->text);
+
+    if ((value = bemDictionaryGetKeyValue(properties, "box-sizing")) != NULL && !strcasecmp(value, "border-box"))
+    {
+        if (style->size.width >= 0.0f && (style->size.width -= style->border.left_offset + style->padding.left_offset + style->padding.right_offset + style->border.right_offset) < 0.0f)
+            style->size.width = 0.0f;
+
+        if (style->size.height >= 0.0f && (style->size.height -= style->border.top_offset + style->padding.top_offset + style->padding.bottom_offset + style->border.bottom_offset) < 0.0f)
+            style->size.height = 0.0f;
+    }
+
+    layout->timings.style += bemLayoutTime() - start;
+
+    return (style);
+}
+
+static void bemLayoutTable(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_table table;
+    bem_layout_flow inner;
+    bem_layout_row *row;
+    bem_layout_cell *cell;
+    bem_layout_box *row_box;
+    size_t i, j, k, *active = NULL, *temp, active_amount = 0, active_size = 0;
+    float spacing, vertical, width, x, y, height, cell_width, needed;
+    int pass;
+
+    memset(&table, 0, sizeof(table));
+
+    bemNodeComputeCSSTable(node, COMPUTE_BASE, &table.table);
+
+    spacing = table.table.border_spacing.width;
+    vertical = table.table.border_spacing.height;
+    table.fixed = table.table.table_layout == TABLE_LAYOUT_FIXED && style->size.width >= 0.0f;
+    table.width = style->size.width >= 0.0f ? style->size.width : flow->width;
+
+    // Header groups go first and footer groups last, wherever they are in the document
+    for (pass = 0; pass < 3; pass++)
+        bemLayoutTableRows(layout, &table, node, style, pass);
+
+    bemLayoutTableEndGroup(&table);
+
+    bemLayoutTableWidths(&table, style->size.width, flow->width, spacing);
+
+    for (i = 0, x = flow->left + spacing; i < table.column_amount; i++)
+    {
+        table.columns[i].x = x;
+        x += table.columns[i].width + spacing;
+    }
+
+    if ((width = table.column_amount > 0 ? x - flow->left : 0.0f) < style->size.width)
+        width = style->size.width;
+
+    if (flow->left + width > flow->right)
+        flow->right = flow->left + width;
+
+    bemLayoutTableCaptions(layout, flow, node, style, false, width);
+
+    // The grid doesn't collapse margins with the captions
+    flow->y += flow->margin;
+    flow->margin = 0.0f;
+
+    for (i = 0, y = flow->y + (table.row_amount > 0 ? vertical : 0.0f); i < table.row_amount; i++)
+    {
+        row = table.rows + i;
+
+        if ((row_box = bemLayoutAddBox(layout, flow->block, LAYOUT_BLOCK, row->node, row->style)) == NULL)
+            break;
+
+        row_box->x = flow->left + spacing;
+        row_box->y = y;
+        row_box->width = width > 2 * spacing ? width - 2 * spacing : 0.0f;
+        height = row->style->size.height > 0.0f ? row->style->size.height : 0.0f;
+
+        // Each cell's content is laid out once, at its final width
+        for (j = row->first_cell; j < row->first_cell + row->cell_amount; j++)
+        {
+            cell = table.cells + j;
+
+            for (k = cell->column, cell_width = spacing * (cell->colspan - 1); k < cell->column + cell->colspan; k++)
+                cell_width += table.columns[k].width;
+
+            if ((cell->box = bemLayoutAddBox(layout, row_box, LAYOUT_BLOCK, cell->node, cell->style)) == NULL)
+                continue;
+
+            cell->box->x = table.columns[cell->column].x;
+            cell->box->y = y;
+            cell->box->width = cell_width;
+
+            memset(&inner, 0, sizeof(inner));
+            inner.block = cell->box;
+            inner.left = inner.right = cell->box->x + cell->style->border.left_offset + cell->style->padding.left_offset;
+            inner.width = cell_width - cell->style->border.left_offset - cell->style->padding.left_offset - cell->style->padding.right_offset - cell->style->border.right_offset;
+            inner.y = y + cell->style->border.top_offset + cell->style->padding.top_offset;
+            inner.first_line = true;
+
+            if (inner.width < 0.0f)
+                inner.width = 0.0f;
+
+            bemLayoutChildren(layout, &inner, cell->node, cell->style);
+            bemLayoutFinishLine(&inner);
+
+            cell->content = inner.y + inner.margin - (y + cell->style->border.top_offset + cell->style->padding.top_offset);
+            needed = (cell->style->size.height > cell->content ? cell->style->size.height : cell->content) + cell->style->border.top_offset + cell->style->padding.top_offset +
+                     cell->style->padding.bottom_offset + cell->style->border.bottom_offset;
+
+            if (cell->rowspan == 1)
+            {
+                if (needed > height)
+                    height = needed;
+            }
+            else
+            {
+                if (active_amount >= active_size)
+                {
+                    if ((temp = (size_t *)realloc(active, (active_size + 16) * sizeof(size_t))) == NULL)
+                        continue;
+
+                    active = temp;
+                    active_size += 16;
+                }
+
+                active[active_amount++] = j;
+            }
+        }
+
+        // Cells spanning rows stretch their last row to fit, the table's last row ends them all
+        for (k = 0; k < active_amount; k++)
+        {
+            cell = table.cells + active[k];
+
+            if (cell->row + cell->rowspan - 1 > i && i < table.row_amount - 1)
+                continue;
+
+            needed = cell->box->y + (cell->style->size.height > cell->content ? cell->style->size.height : cell->content) + cell->style->border.top_offset +
+                     cell->style->padding.top_offset + cell->style->padding.bottom_offset + cell->style->border.bottom_offset - y;
+
+            if (needed > height)
+                height = needed;
+        }
+
+        row_box->height = height;
+
+        for (j = row->first_cell; j < row->first_cell + row->cell_amount; j++)
+        {
+            if (table.cells[j].rowspan == 1 && table.cells[j].box)
+                bemLayoutTableAlign(table.cells + j, y + height);
+        }
+
+        for (k = 0; k < active_amount;)
+        {
+            cell = table.cells + active[k];
+
+            if (cell->row + cell->rowspan - 1 > i && i < table.row_amount - 1)
+            {
+                k++;
+                continue;
+            }
+
+            bemLayoutTableAlign(cell, y + height);
+            active[k] = active[--active_amount];
+        }
+
+        y += height + vertical;
+    }
+
+    flow->y = y;
+
+    bemLayoutTableCaptions(layout, flow, node, style, true, width);
+
+    free(active);
+    free(table.rows);
+    free(table.cells);
+    free(table.columns);
+    free(table.spans);
+}
+
+static bool bemLayoutTableAddRow(bem_layout *layout, bem_layout_table *table, bem_node *node, const bem_layout_style *style)
+{
+    bem_layout_row *row, *rows;
+    bem_layout_cell *cell, *cells;
+    bem_layout_intrinsic intrinsic;
+    bem_node *child;
+    const bem_layout_style *cell_style, *previous = NULL;
+    const char *value;
+    size_t i, column = 0, colspan, rowspan;
+    float edges;
+
+    if (table->row_amount >= table->rows_size)
+    {
+        // Doubling keeps 10,000-row tables linear
+        if ((rows = (bem_layout_row *)realloc(table->rows, (table->rows_size ? 2 * table->rows_size : 32) * sizeof(bem_layout_row))) == NULL)
+            return false;
+
+        table->rows = rows;
+        table->rows_size = table->rows_size ? 2 * table->rows_size : 32;
+    }
+
+    row = table->rows + table->row_amount;
+    row->node = node;
+    row->style = style;
+    row->first_cell = table->cell_amount;
+    row->cell_amount = 0;
+
+    // Rowspans from the rows above cover some of this row's columns
+    for (i = 0; i < table->column_amount && table->row_amount > 0; i++)
+    {
+        if (table->spans[i] > 0)
+            table->spans[i]--;
+    }
+
+    for (child = node->value.element.first_child; child; child = child->next)
+    {
+        if (child->element <= ELEMENT_DOCTYPE || bemNodeComputeCSSDisplay(child, COMPUTE_BASE) != DISPLAY_TABLE_CELL)
+            continue;
+
+        if ((cell_style = bemLayoutStyle(layout, child, style, previous, table->width)) == NULL)
+            continue;
+
+        previous = cell_style;
+
+        if ((value = bemNodeAttributeGetNameValue(child, "colspan")) == NULL || (colspan = (size_t)atoi(value)) < 1)
+            colspan = 1;
+        else if (colspan > 1000)
+            colspan = 1000;
+
+        if ((value = bemNodeAttributeGetNameValue(child, "rowspan")) == NULL || (rowspan = (size_t)atoi(value)) < 1)
+            rowspan = 1;
+        else if (rowspan > 65534)
+            rowspan = 65534;
+
+        while (column < table->column_amount && table->spans[column] > 0)
+            column++;
+
+        if (!bemLayoutTableColumns(table, column + colspan))
+            return false;
+
+        if (table->cell_amount >= table->cells_size)
+        {
+            if ((cells = (bem_layout_cell *)realloc(table->cells, (table->cells_size ? 2 * table->cells_size : 128) * sizeof(bem_layout_cell))) == NULL)
+                return false;
+
+            table->cells = cells;
+            table->cells_size = table->cells_size ? 2 * table->cells_size : 128;
+        }
+
+        cell = table->cells + table->cell_amount++;
+
+        memset(cell, 0, sizeof(bem_layout_cell));
+        cell->node = child;
+        cell->style = cell_style;
+        cell->row = table->row_amount;
+        cell->column = column;
+        cell->colspan = colspan;
+        cell->rowspan = rowspan;
+
+        for (i = column; i < column + colspan; i++)
+            table->spans[i] = rowspan;
+
+        edges = cell_style->border.left_offset + cell_style->padding.left_offset + cell_style->padding.right_offset + cell_style->border.right_offset;
+
+        if (table->fixed)
+        {
+            // Fixed layout only looks at the first row
+            if (table->row_amount == 0 && cell_style->size.width >= 0.0f)
+            {
+                for (i = column; i < column + colspan; i++)
+                {
+                    if (table->columns[i].width < 0.0f)
+                        table->columns[i].width = (cell_style->size.width + edges) / colspan;
+                }
+            }
+        }
+        else
+        {
+            // Each cell is measured once, its columns keep the widest results
+            memset(&intrinsic, 0, sizeof(intrinsic));
+            bemLayoutIntrinsic(layout, child, cell_style, &intrinsic);
+
+            if (intrinsic.line > intrinsic.max)
+                intrinsic.max = intrinsic.line;
+            if (intrinsic.cells > intrinsic.min)
+                intrinsic.min = intrinsic.cells;
+
+            if (cell_style->size.width > intrinsic.max)
+                intrinsic.max = cell_style->size.width;
+            if (intrinsic.min > intrinsic.max)
+                intrinsic.max = intrinsic.min;
+
+            cell->min = intrinsic.min + edges;
+            cell->max = intrinsic.max + edges;
+
+            if (colspan == 1)
+            {
+                if (cell->min > table->columns[column].min)
+                    table->columns[column].min = cell->min;
+                if (cell->max > table->columns[column].max)
+                    table->columns[column].max = cell->max;
+            }
+        }
+
+        column += colspan;
+        row->cell_amount++;
+    }
+
+    table->row_amount++;
+
+    return (true);
+}
+
+static void bemLayoutTableAlign(bem_layout_cell *cell, float bottom)
+{
+    bem_layout_box *child;
+    const char *value;
+    float free_space, shift = 0.0f;
+
+    // Cells are as tall as their rows, the content moves down for middle and bottom
+    cell->box->height = bottom - cell->box->y;
+    free_space = cell->box->height - cell->content - cell->style->border.top_offset - cell->style->padding.top_offset - cell->style->padding.bottom_offset -
+                 cell->style->border.bottom_offset;
+
+    if (free_space <= 0.0f || (value = bemDictionaryGetKeyValue(cell->style->properties, "vertical-align")) == NULL)
+        return;
+
+    if (!strcasecmp(value, "middle"))
+        shift = free_space / 2;
+    else if (!strcasecmp(value, "bottom"))
+        shift = free_space;
+
+    for (child = cell->box->first_child; child && shift > 0.0f; child = child->next)
+        bemLayoutMove(child, 0.0f, shift);
+}
+
+static void bemLayoutTableCaptions(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style, bool bottom, float width)
+{
+    bem_node *child;
+    const bem_layout_style *child_style;
+    const char *value;
+    float saved = flow->width;
+
+    // Captions are blocks as wide as the table, above or below it
+    flow->width = width;
+
+    for (child = node->value.element.first_child; child; child = child->next)
+    {
+        if (child->element <= ELEMENT_DOCTYPE || bemNodeComputeCSSDisplay(child, COMPUTE_BASE) != DISPLAY_TABLE_CAPTION)
+            continue;
+
+        value = bemDictionaryGetKeyValue(bemNodeComputeCSSProperties(child, COMPUTE_BASE), "caption-side");
+
+        if ((value && !strcasecmp(value, "bottom")) != bottom)
+            continue;
+
+        if ((child_style = bemLayoutStyle(layout, child, style, NULL, width)) != NULL)
+            bemLayoutBlock(layout, flow, NULL, child, child_style);
+    }
+
+    flow->width = saved;
+}
+
+static bool bemLayoutTableColumns(bem_layout_table *table, size_t amount)
+{
+    bem_layout_column *columns;
+    size_t *spans, size, i;
+
+    if (amount <= table->column_amount)
+        return true;
+
+    if (amount > table->columns_size)
+    {
+        for (size = table->columns_size ? 2 * table->columns_size : 16; size < amount; size *= 2)
+            ;
+
+        if ((columns = (bem_layout_column *)realloc(table->columns, size * sizeof(bem_layout_column))) == NULL)
+            return false;
+
+        table->columns = columns;
+
+        if ((spans = (size_t *)realloc(table->spans, size * sizeof(size_t))) == NULL)
+            return false;
+
+        table->spans = spans;
+        table->columns_size = size;
+    }
+
+    for (i = table->column_amount; i < amount; i++)
+    {
+        memset(table->columns + i, 0, sizeof(bem_layout_column));
+        table->columns[i].width = -1.0f;
+        table->spans[i] = 0;
+    }
+
+    table->column_amount = amount;
+
+    return (true);
+}
+
+static void bemLayoutTableEndGroup(bem_layout_table *table)
+{
+    bem_layout_cell *cell;
+    size_t i;
+
+    // Rowspans stop at the last row of their group
+    if (table->group_row < table->row_amount)
+    {
+        for (i = table->rows[table->group_row].first_cell, cell = table->cells + i; i < table->cell_amount; i++, cell++)
+        {
+            if (cell->row + cell->rowspan > table->row_amount)
+                cell->rowspan = table->row_amount - cell->row;
+        }
+    }
+
+    for (i = 0; i < table->column_amount; i++)
+        table->spans[i] = 0;
+
+    table->group_row = table->row_amount;
+}
+
+static void bemLayoutTableRows(bem_layout *layout, bem_layout_table *table, bem_node *node, const bem_layout_style *style, int pass)
+{
+    bem_node *child;
+    const bem_layout_style *child_style, *previous = NULL;
+    bem_display display;
+    const char *value;
+    size_t i, span, first;
+    float width;
+
+    for (child = node->value.element.first_child; child; child = child->next)
+    {
+        // Text and other content between rows doesn't get anonymous boxes
+        if (child->element <= ELEMENT_DOCTYPE)
+            continue;
+
+        display = bemNodeComputeCSSDisplay(child, COMPUTE_BASE);
+
+        if (pass == 0 && display == DISPLAY_TABLE_COLUMN_GROUP && child->value.element.first_child)
+        {
+            bemLayoutTableRows(layout, table, child, style, 0);
+        }
+        else if (pass == 0 && (display == DISPLAY_TABLE_COLUMN || display == DISPLAY_TABLE_COLUMN_GROUP))
+        {
+            if ((value = bemNodeAttributeGetNameValue(child, "span")) == NULL || (span = (size_t)atoi(value)) < 1)
+                span = 1;
+            else if (span > 1000)
+                span = 1000;
+
+            first = table->column_amount;
+
+            if (!bemLayoutTableColumns(table, first + span))
+                return;
+
+            // Column widths only matter to fixed layout
+            if (!table->fixed || (value = bemDictionaryGetKeyValue(bemNodeComputeCSSProperties(child, COMPUTE_BASE), "width")) == NULL || !strcasecmp(value, "auto"))
+                continue;
+
+            width = bemGetLength(layout->html->pool, value, table->width, 0.75f, layout->html->css, &style->text);
+
+            for (i = first; i < first + span; i++)
+                table->columns[i].width = width;
+        }
+        else if ((pass == 0 && display == DISPLAY_TABLE_HEADER_GROUP) || (pass == 1 && display == DISPLAY_TABLE_ROW_GROUP) || (pass == 2 && display == DISPLAY_TABLE_FOOTER_GROUP))
+        {
+            if ((child_style = bemLayoutStyle(layout, child, style, NULL, table->width)) == NULL)
+                continue;
+
+            // Rows directly in the table before the group form a group of their own
+            bemLayoutTableEndGroup(table);
+            bemLayoutTableRows(layout, table, child, child_style, 1);
+            bemLayoutTableEndGroup(table);
+        }
+        else if (pass == 1 && display == DISPLAY_TABLE_ROW)
+        {
+            if ((child_style = bemLayoutStyle(layout, child, style, previous, table->width)) == NULL)
+                continue;
+
+            previous = child_style;
+
+            if (!bemLayoutTableAddRow(layout, table, child, child_style))
+                return;
+        }
+    }
+}
+
+static void bemLayoutTableWidths(bem_layout_table *table, float width, float available, float spacing)
+{
+    bem_layout_column *column;
+    const bem_layout_cell *cell;
+    size_t i, j, unspecified = 0;
+    float total_min = 0.0f, total_max = 0.0f, specified = 0.0f, gaps, remaining, target, extra, ratio, span_min, span_max;
+
+    if (table->column_amount == 0)
+        return;
+
+    gaps = spacing * (table->column_amount + 1);
+
+    if (table->fixed)
+    {
+        // Columns without a width share what the others leave
+        for (i = 0, column = table->columns; i < table->column_amount; i++, column++)
+        {
+            if (column->width >= 0.0f)
+                specified += column->width;
+            else
+                unspecified++;
+        }
+
+        remaining = width - gaps - specified;
+
+        for (i = 0, column = table->columns; i < table->column_amount; i++, column++)
+        {
+            if (column->width < 0.0f)
+                column->width = remaining > 0.0f ? remaining / unspecified : 0.0f;
+            else if (!unspecified && remaining > 0.0f && specified > 0.0f)
+                column->width += remaining * column->width / specified;
+        }
+
+        return;
+    }
+
+    // Cells spanning columns spread what their columns lack evenly
+    for (i = 0, cell = table->cells; i < table->cell_amount; i++, cell++)
+    {
+        if (cell->colspan == 1)
+            continue;
+
+        for (j = cell->column, span_min = span_max = spacing * (cell->colspan - 1); j < cell->column + cell->colspan; j++)
+        {
+            span_min += table->columns[j].min;
+            span_max += table->columns[j].max;
+        }
+
+        for (j = cell->column; j < cell->column + cell->colspan; j++)
+        {
+            if (cell->min > span_min)
+                table->columns[j].min += (cell->min - span_min) / cell->colspan;
+            if (cell->max > span_max)
+                table->columns[j].max += (cell->max - span_max) / cell->colspan;
+        }
+    }
+
+    for (i = 0, column = table->columns; i < table->column_amount; i++, column++)
+    {
+        if (column->max < column->min)
+            column->max = column->min;
+
+        total_min += column->min;
+        total_max += column->max;
+    }
+
+    // Auto tables are as wide as their content up to the available width, never narrower than their minimum
+    if (width < 0.0f)
+        target = total_max + gaps < available ? total_max : available - gaps;
+    else
+        target = width - gaps;
+
+    if (target < total_min)
+        target = total_min;
+
+    if (target >= total_max)
+    {
+        extra = target - total_max;
+
+        for (i = 0, column = table->columns; i < table->column_amount; i++, column++)
+            column->width = column->max + (total_max > 0.0f ? extra * column->max / total_max : extra / table->column_amount);
+    }
+    else
+    {
+        ratio = total_max > total_min ? (target - total_min) / (total_max - total_min) : 0.0f;
+
+        for (i = 0, column = table->columns; i < table->column_amount; i++, column++)
+            column->width = column->min + (column->max - column->min) * ratio;
+    }
+}
+
+static void bemLayoutText(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style)
+{
+    const char *string, *source, *end;
+    char *copy, *ptr, *start;
+    size_t length;
+    bem_layout_box *parent, *run;
+    bem_white_space white_space = style->text.white_space;
+    bool collapse, wrap, breakable;
+    float width, space, above, below, ascent;
+    double begin = bemLayoutTime();
+
+    if ((string = bemHtmlGetText(node, &length)) == NULL || length == 0 || (copy = (char *)bemLayoutAllocate(layout, length + 1)) == NULL)
+        return;
+
+    collapse = white_space == WHITE_SPACE_NORMAL || white_space == WHITE_SPACE_NO_WRAP || white_space == WHITE_SPACE_PRE_LINE;
+    wrap = white_space != WHITE_SPACE_NO_WRAP && white_space != WHITE_SPACE_PRE;
+
+    // Runs point into a copy with white space collapsed, so a line's words stay contiguous
+    for (source = string, end = string + length, ptr = copy; source < end; source++)
+    {
+        if (*source == '\r' || !*source)
+            continue;
+        else if (*source == '\n' && white_space != WHITE_SPACE_NORMAL && white_space != WHITE_SPACE_NO_WRAP)
+        {
+            if (collapse && ptr > copy && ptr[-1] == ' ')
+                ptr--;
+
+            *ptr++ = '\n';
+        }
+        else if (isspace(*source & 255))
+        {
+            if (!collapse)
+                *ptr++ = ' ';
+            else if (ptr == copy || (ptr[-1] != ' ' && ptr[-1] != '\n'))
+                *ptr++ = ' ';
+        }
+        else
+        {
+            *ptr++ = *source;
+        }
+    }
+
+    *ptr = '\0';
+
+    for (ptr = copy; *ptr;)
+    {
+        if (*ptr == '\n')
+        {
+            // Preserved newlines end the line even when it is empty
+            bemLayoutOpenLine(layout, flow);
+            bemLayoutFinishLine(flow);
+            ptr++;
+            continue;
+        }
+        else if (collapse && *ptr == ' ')
+        {
+            flow->space = flow->content;
+            ptr++;
+            continue;
+        }
+
+        start = ptr;
+
+        if (collapse)
+        {
+            while (*ptr && *ptr != ' ' && *ptr != '\n')
+                ptr++;
+        }
+        else if (white_space == WHITE_SPACE_PRE)
+        {
+            while (*ptr && *ptr != '\n')
+                ptr++;
+        }
+        else
+        {
+            // Preserved spaces stay with the word before them
+            while (*ptr && *ptr != ' ' && *ptr != '\n')
+                ptr++;
+            while (*ptr == ' ')
+                ptr++;
+        }
+
+        width = bemLayoutMeasure(style, start, ptr);
+        space = flow->space ? bemLayoutMeasure(style, " ", NULL) : 0.0f;
+        breakable = flow->space || (start > copy && start[-1] == ' ');
+
+        if (wrap && breakable && flow->line && flow->content && flow->line_x + space + width > flow->left + flow->width)
+        {
+            bemLayoutFinishLine(flow);
+            space = 0.0f;
+        }
+
+        // The space goes before any fragment this word opens
+        flow->line_x += space;
+        parent = bemLayoutOpenLine(layout, flow);
+
+        if ((run = flow->run) != NULL && run->parent == parent && run->style == style && run->text + run->length + (space > 0.0f) == start)
+        {
+            run->length = (size_t)(ptr - run->text);
+            run->width += space + width;
+        }
+        else if ((run = bemLayoutAddBox(layout, parent, LAYOUT_TEXT, node, style)) != NULL)
+        {
+            bemLayoutMetrics(style, &above, &below, &ascent);
+
+            run->x = flow->line_x;
+            run->width = width;
+            run->baseline = ascent;
+            run->height = ascent + below - (above - ascent);
+            run->text = start;
+            run->length = (size_t)(ptr - start);
+
+            if (above > flow->above)
+                flow->above = above;
+
+            if (below > flow->below)
+                flow->below = below;
+
+            flow->run = run;
+        }
+
+        flow->line_x += width;
+        flow->content = true;
+        flow->space = false;
+    }
+
+    layout->timings.text += bemLayoutTime() - begin;
+}
+
+static double bemLayoutTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec + now.tv_nsec / 1000000000.0);
+}
+
+static size_t bemLayoutTokens(const char *value, char *buffer, size_t buffer_size, const char **tokens, size_t max_tokens)
+{
+    char *ptr;
+    size_t count = 0;
+    int parens = 0;
+
+    // Splits a copy of the value at white space outside of parenthesis, "1px solid rgb(0, 0, 0)" is three tokens
+    snprintf(buffer, buffer_size, "%s", value);
+
+    for (ptr = buffer; *ptr && count < max_tokens;)
+    {
+        while (isspace(*ptr & 255))
+            ptr++;
+
+        if (!*ptr)
+            break;
+
+        tokens[count++] = ptr;
+
+        for (; *ptr && (parens > 0 || !isspace(*ptr & 255)); ptr++)
+        {
+            if (*ptr == '(')
+                parens++;
+            else if (*ptr == ')' && parens > 0)
+                parens--;
+        }
+
+        if (*ptr)
+            *ptr++ = '\0';
+    }
+
+    return (count);
+}
+
+static const char *bemLayoutValue(const bem_layout_style *style, const char *key)
+{
+    size_t i;
+
+    // NULL when the cascade took the value from the parent, whose style already converted it
+    for (i = 0; i < sizeof(bem_inherited_properties) / sizeof(bem_inherited_properties[0]) && strcmp(key, bem_inherited_properties[i]); i++)
+        ;
+
+    if (i < sizeof(bem_inherited_properties) / sizeof(bem_inherited_properties[0]) && (style->inherited & (1ULL << i)))
+        return NULL;
+
+    return (bemDictionaryGetKeyValue(style->properties, key));
+}
+
+void bemDisplayListDelete(bem_display_list *list)
+{
+    if (!list)
+        return;
+
+    free(list->items);
+    free(list->fonts);
+    free(list->font_records);
+    free(list->strings);
+    free(list);
+}
+
+bem_font *bemDisplayListGetFont(bem_display_list *list, unsigned index)
+{
+    return (list && index < list->font_amount ? list->fonts[index] : NULL);
+}
+
+const bem_display_item *bemDisplayListGetItems(bem_display_list *list, size_t *amount)
+{
+    if (amount)
+        *amount = list ? list->item_amount : 0;
+
+    return (list ? list->items : NULL);
+}
+
+const char *bemDisplayListGetString(bem_display_list *list, unsigned offset)
+{
+    return (list && offset < list->strings_length ? list->strings + offset : NULL);
+}
+
+bem_display_list *bemDisplayListNew(bem_layout *layout, float x, float y, float width, float height)
+{
+    bem_display_list *list;
+    bem_display_style *styles;
+    bem_display_order *order;
+    bem_display_item *items;
+    size_t i;
+
+    if (!layout || !layout->root)
+        return NULL;
+
+    if ((list = (bem_display_list *)calloc(1, sizeof(bem_display_list))) == NULL)
+        return NULL;
+
+    if ((styles = (bem_display_style *)calloc(BEM_DISPLAY_STYLES, sizeof(bem_display_style))) == NULL)
+    {
+        free(list);
+        return NULL;
+    }
+
+    list->layout = layout;
+
+    // Without a viewport nothing is culled
+    if (width > 0.0f && height > 0.0f)
+    {
+        list->x = x;
+        list->y = y;
+        list->width = width;
+        list->height = height;
+    }
+
+    bemDisplayListBox(list, styles, layout->root, 0, 0);
+    bemDisplayListBox(list, styles, layout->root, 0, 1);
+
+    free(styles);
+
+    // Items were added in painting order, a stable sort by z-index keeps it within each level
+    if (!list->failed && list->sort && list->item_amount > 1)
+    {
+        order = (bem_display_order *)malloc(list->item_amount * sizeof(bem_display_order));
+        items = (bem_display_item *)malloc(list->item_amount * sizeof(bem_display_item));
+
+        if (order && items)
+        {
+            for (i = 0; i < list->item_amount; i++)
+            {
+                order[i].z_index = list->items[i].z_index;
+                order[i].index = i;
+            }
+
+            qsort(order, list->item_amount, sizeof(bem_display_order), (bem_comparison_function)bemDisplayListCompare);
+
+            for (i = 0; i < list->item_amount; i++)
+                items[i] = list->items[order[i].index];
+
+            free(list->items);
+            list->items = items;
+            list->items_size = list->item_amount;
+            items = NULL;
+        }
+        else
+        {
+            list->failed = true;
+        }
+
+        free(order);
+        free(items);
+    }
+
+    if (list->failed)
+    {
+        bemDisplayListDelete(list);
+        return NULL;
+    }
+
+    return (list);
+}
+
+void *bemDisplayListSerialize(bem_display_list *list, size_t *size)
+{
+    bem_display_list_header header;
+    unsigned char *buffer, *ptr;
+    size_t bytes;
+
+    if (size)
+        *size = 0;
+
+    if (!list || !size)
+        return NULL;
+
+    // Header, items, fonts and strings back to back, with offsets instead of pointers
+    bytes = sizeof(header) + list->item_amount * sizeof(bem_display_item) + list->font_amount * sizeof(bem_display_font) + list->strings_length;
+
+    if ((buffer = (unsigned char *)malloc(bytes)) == NULL)
+        return NULL;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "BEMDL\0\0\0", sizeof(header.magic));
+    header.version = BEM_DISPLAY_LIST_VERSION;
+    header.item_amount = (unsigned)list->item_amount;
+    header.font_amount = (unsigned)list->font_amount;
+    header.strings_size = (unsigned)list->strings_length;
+    header.x = list->x;
+    header.y = list->y;
+    header.width = list->width;
+    header.height = list->height;
+
+    ptr = buffer;
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+
+    if (list->item_amount)
+        memcpy(ptr, list->items, list->item_amount * sizeof(bem_display_item));
+    ptr += list->item_amount * sizeof(bem_display_item);
+
+    if (list->font_amount)
+        memcpy(ptr, list->font_records, list->font_amount * sizeof(bem_display_font));
+    ptr += list->font_amount * sizeof(bem_display_font);
+
+    if (list->strings_length)
+        memcpy(ptr, list->strings, list->strings_length);
+
+    *size = bytes;
+
+    return (buffer);
+}
+
+static bem_display_item *bemDisplayListAdd(bem_display_list *list, bem_paint type, int z_index, float x, float y, float width, float height)
+{
+    bem_display_item *item;
+    size_t items_size;
+
+    if (list->width > 0.0f && (x >= list->x + list->width || y >= list->y + list->height || x + width <= list->x || y + height <= list->y))
+    {
+        list->culled++;
+        return NULL;
+    }
+
+    if (list->item_amount >= list->items_size)
+    {
+        items_size = list->items_size ? 2 * list->items_size : 256;
+
+        if ((item = (bem_display_item *)realloc(list->items, items_size * sizeof(bem_display_item))) == NULL)
+        {
+            list->failed = true;
+            return NULL;
+        }
+
+        list->items = item;
+        list->items_size = items_size;
+    }
+
+    item = list->items + list->item_amount++;
+
+    memset(item, 0, sizeof(bem_display_item));
+    item->type = (unsigned char)type;
+    item->z_index = z_index;
+    item->x = x;
+    item->y = y;
+    item->width = width;
+    item->height = height;
+
+    if (z_index)
+        list->sort = true;
+
+    return (item);
+}
+
+static void bemDisplayListBox(bem_display_list *list, bem_display_style *styles, const bem_layout_box *box, int z_index, int phase)
+{
+    const bem_layout_box *child;
+    const bem_layout_style *style = box->style;
+    bem_display_style *cached = NULL;
+    const bem_dictionary *properties;
+    const bem_box *paint;
+    const bem_border_properties *edges[4];
+    bem_node *element = box->node;
+    bem_display_item *item;
+    const char *value;
+    float x, y, width, height, widths[4];
+    size_t i;
+    unsigned hash;
+    int side;
+
+    // Nothing in a subtree outside the viewport can paint inside of it
+    if (list->width > 0.0f && (box->overflow_x >= list->x + list->width || box->overflow_y >= list->y + list->height ||
+                               box->overflow_x + box->overflow_width <= list->x || box->overflow_y + box->overflow_height <= list->y))
+    {
+        list->skipped++;
+        return;
+    }
+
+    // Text runs use their element's style, and elements with the same interned properties paint the same, wherever they are
+    if (element && element->element == ELEMENT_STRING)
+        element = element->parent;
+
+    if (element && element->element > ELEMENT_DOCTYPE && style && (properties = style->properties) != NULL)
+    {
+        for (i = 0, hash = 2166136261u; i < properties->pair_amount; i++)
+            hash = (hash ^ (unsigned)((uintptr_t)properties->pairs[i].key >> 3) ^ (unsigned)((uintptr_t)properties->pairs[i].value << 7)) * 16777619u;
+
+        cached = styles + (hash & (BEM_DISPLAY_STYLES - 1));
+
+        if (cached->properties != properties && (!cached->properties || cached->hash != hash || cached->properties->pair_amount != properties->pair_amount ||
+                                                 memcmp(cached->properties->pairs, properties->pairs, properties->pair_amount * sizeof(bem_pair))))
+        {
+            cached->properties = bemNodeComputeCSSBox(element, COMPUTE_BASE, &cached->box) ? properties : NULL;
+            cached->hash = hash;
+            cached->visible = (value = bemDictionaryGetKeyValue(properties, "visibility")) == NULL || (strcasecmp(value, "hidden") && strcasecmp(value, "collapse"));
+
+            // z-index only applies to positioned boxes
+            if ((value = bemDictionaryGetKeyValue(properties, "position")) == NULL || !strcasecmp(value, "static"))
+                cached->box.z_index = 0;
+        }
+
+        if (!cached->properties)
+            cached = NULL;
+    }
+
+    // Phase 0 paints block-level backgrounds and borders, phase 1 the inline content on top of them, atomic inlines whole
+    if (box->type == LAYOUT_TEXT)
+    {
+        if (phase == 1 && (!cached || cached->visible))
+            bemDisplayListText(list, box, z_index);
+
+        return;
+    }
+    else if ((box->type == LAYOUT_LINE || box->type == LAYOUT_INLINE_BLOCK) && phase == 0)
+    {
+        // Atomic inlines paint their own block-level phase when the inline phase reaches them
+        return;
+    }
+
+    if (cached && box->type != LAYOUT_LINE)
+    {
+        paint = &cached->box;
+
+        // Stacking contexts are flattened, the box and its descendants take its z-index
+        if (paint->z_index)
+            z_index = paint->z_index;
+
+        if (cached->visible && (phase == 0) == (box->type == LAYOUT_BLOCK))
+        {
+            // Outer shadow, background, inset shadow, border and then the content
+            if (!paint->box_shadow.inset)
+                bemDisplayListShadow(list, z_index, box, paint);
+
+            x = box->x;
+            y = box->y;
+            width = box->width;
+            height = box->height;
+
+            if (paint->background_clip != BACKGROUND_BOX_BORDER)
+            {
+                x += style->border.left_offset;
+                y += style->border.top_offset;
+                width -= style->border.left_offset + style->border.right_offset;
+                height -= style->border.top_offset + style->border.bottom_offset;
+            }
+
+            if (paint->background_clip == BACKGROUND_BOX_CONTENT)
+            {
+                x += style->padding.left_offset;
+                y += style->padding.top_offset;
+                width -= style->padding.left_offset + style->padding.right_offset;
+                height -= style->padding.top_offset + style->padding.bottom_offset;
+            }
+
+            bemDisplayListRect(list, z_index, x, y, width, height, &paint->background_color, &paint->border_radius);
+
+            if (paint->background_image && width > 0.0f && height > 0.0f && (item = bemDisplayListAdd(list, PAINT_IMAGE, z_index, x, y, width, height)) != NULL)
+            {
+                // Bounds are the painting area, the first tile goes at the origin box
+                item->styles[0] = (unsigned char)paint->background_repeat;
+                item->values[0] = box->x + (paint->background_origin != BACKGROUND_BOX_BORDER ? style->border.left_offset : 0.0f) +
+                                  (paint->background_origin == BACKGROUND_BOX_CONTENT ? style->padding.left_offset : 0.0f);
+                item->values[1] = box->y + (paint->background_origin != BACKGROUND_BOX_BORDER ? style->border.top_offset : 0.0f) +
+                                  (paint->background_origin == BACKGROUND_BOX_CONTENT ? style->padding.top_offset : 0.0f);
+                item->string = bemDisplayListString(list, paint->background_image, strlen(paint->background_image));
+                item->length = (unsigned)strlen(paint->background_image);
+                bemDisplayListCorners(item, &paint->border_radius);
+            }
+
+            if (paint->box_shadow.inset)
+                bemDisplayListShadow(list, z_index, box, paint);
+
+            // Styles and colors are the element's, widths are the ones the layout used
+            widths[0] = style->border.top_offset;
+            widths[1] = style->border.right_offset;
+            widths[2] = style->border.bottom_offset;
+            widths[3] = style->border.left_offset;
+
+            edges[0] = &paint->border.top;
+            edges[1] = &paint->border.right;
+            edges[2] = &paint->border.bottom;
+            edges[3] = &paint->border.left;
+
+            if ((widths[0] > 0.0f || widths[1] > 0.0f || widths[2] > 0.0f || widths[3] > 0.0f) &&
+                (item = bemDisplayListAdd(list, PAINT_BORDER, z_index, box->x, box->y, box->width, box->height)) != NULL)
+            {
+                for (side = 0; side < 4; side++)
+                {
+                    item->styles[side] = (unsigned char)(widths[side] > 0.0f ? edges[side]->style : BORDER_STYLE_NONE);
+                    item->colors[side] = bemDisplayListColor(&edges[side]->color);
+                    item->values[side] = widths[side];
+                }
+
+                bemDisplayListCorners(item, &paint->border_radius);
+            }
+
+            if (element->element == ELEMENT_IMG && (value = bemNodeAttributeGetNameValue(element, "src")) != NULL)
+            {
+                x = box->x + style->border.left_offset + style->padding.left_offset;
+                y = box->y + style->border.top_offset + style->padding.top_offset;
+                width = box->width - style->border.left_offset - style->padding.left_offset - style->padding.right_offset - style->border.right_offset;
+                height = box->height - style->border.top_offset - style->padding.top_offset - style->padding.bottom_offset - style->border.bottom_offset;
+
+                if (width > 0.0f && height > 0.0f && (item = bemDisplayListAdd(list, PAINT_IMAGE, z_index, x, y, width, height)) != NULL)
+                {
+                    item->styles[0] = BACKGROUND_REPEAT_NONE;
+                    item->values[0] = x;
+                    item->values[1] = y;
+                    item->string = bemDisplayListString(list, value, strlen(value));
+                    item->length = (unsigned)strlen(value);
+                }
+            }
+        }
+
+        // Nothing inside a box that clips its content can show when the box itself is outside the viewport
+        if (paint->overflow != OVERFLOW_VISIBLE && list->width > 0.0f &&
+            (box->x >= list->x + list->width || box->y >= list->y + list->height || box->x + box->width <= list->x || box->y + box->height <= list->y))
+            return;
+    }
+
+    if (box->type == LAYOUT_INLINE_BLOCK)
+    {
+        for (child = box->first_child; child; child = child->next)
+            bemDisplayListBox(list, styles, child, z_index, 0);
+    }
+
+    for (child = box->first_child; child; child = child->next)
+        bemDisplayListBox(list, styles, child, z_index, phase);
+}
+
+static unsigned bemDisplayListColor(const bem_color *color)
+{
+    // 0xRRGGBBAA, the alpha byte is 0 for transparent colors
+    return (((unsigned)(color->red * 255.0f + 0.5f) << 24) | ((unsigned)(color->green * 255.0f + 0.5f) << 16) | ((unsigned)(color->blue * 255.0f + 0.5f) << 8) |
+            (unsigned)(color->alpha * 255.0f + 0.5f));
+}
+
+static int bemDisplayListCompare(bem_display_order *a, bem_display_order *b)
+{
+    if (a->z_index != b->z_index)
+        return (a->z_index < b->z_index ? -1 : 1);
+    else
+        return (a->index < b->index ? -1 : a->index > b->index);
+}
+
+static void bemDisplayListCorners(bem_display_item *item, const bem_border_radius *radius)
+{
+    item->radii[0] = radius->top_left.width;
+    item->radii[1] = radius->top_left.height;
+    item->radii[2] = radius->top_right.width;
+    item->radii[3] = radius->top_right.height;
+    item->radii[4] = radius->bottom_right.width;
+    item->radii[5] = radius->bottom_right.height;
+    item->radii[6] = radius->bottom_left.width;
+    item->radii[7] = radius->bottom_left.height;
+}
+
+static unsigned bemDisplayListFont(bem_display_list *list, bem_font *font)
+{
+    size_t i, fonts_size;
+    bem_font **fonts;
+    bem_display_font *records, *record;
+
+    // Runs mostly repeat the font before them
+    for (i = list->font_amount; i > 0; i--)
+    {
+        if (list->fonts[i - 1] == font)
+            return ((unsigned)(i - 1));
+    }
+
+    if (list->font_amount >= list->fonts_size)
+    {
+        fonts_size = list->fonts_size ? 2 * list->fonts_size : 16;
+
+        if ((fonts = (bem_font **)realloc(list->fonts, fonts_size * sizeof(bem_font *))) == NULL)
+        {
+            list->failed = true;
+            return (0);
+        }
+
+        list->fonts = fonts;
+
+        if ((records = (bem_display_font *)realloc(list->font_records, fonts_size * sizeof(bem_display_font))) == NULL)
+        {
+            list->failed = true;
+            return (0);
+        }
+
+        list->font_records = records;
+        list->fonts_size = fonts_size;
+    }
+
+    list->fonts[list->font_amount] = font;
+    record = list->font_records + list->font_amount;
+
+    record->family = bemDisplayListString(list, font->family, font->family ? strlen(font->family) : 0);
+    record->postscript_name = bemDisplayListString(list, font->postscript_name, font->postscript_name ? strlen(font->postscript_name) : 0);
+    record->weight = (unsigned short)font->weight;
+    record->style = (unsigned char)font->style;
+    record->stretch = (unsigned char)font->stretch;
+
+    return ((unsigned)list->font_amount++);
+}
+
+static bool bemDisplayListJoin(bem_display_item *item, int z_index, unsigned rgba, float x, float y, float width, float height)
+{
+    if (item->type != PAINT_RECT || item->z_index != z_index || item->colors[0] != rgba || item->radii[0] || item->radii[2] || item->radii[4] || item->radii[6])
+        return false;
+
+    if (bemDisplayListNear(item->y, y) && bemDisplayListNear(item->height, height) && bemDisplayListNear(item->x + item->width, x))
+        item->width = x + width - item->x;
+    else if (bemDisplayListNear(item->x, x) && bemDisplayListNear(item->width, width) && bemDisplayListNear(item->y + item->height, y))
+        item->height = y + height - item->y;
+    else
+        return false;
+
+    return (true);
+}
+
+static bool bemDisplayListNear(float a, float b)
+{
+    // Edges computed along different paths differ in the last bits
+    return (a - b > -0.01f && a - b < 0.01f);
+}
+
+static void bemDisplayListRect(bem_display_list *list, int z_index, float x, float y, float width, float height, const bem_color *color, const bem_border_radius *radius)
+{
+    bem_display_item *item;
+    unsigned rgba = bemDisplayListColor(color);
+    bool square = !radius || (!radius->top_left.width && !radius->top_right.width && !radius->bottom_right.width && !radius->bottom_left.width);
+
+    if (width <= 0.0f || height <= 0.0f || !(rgba & 255))
+        return;
+
+    // Square rects of one color sharing a whole edge with the previous one, like the cells of a row, become one
+    if (square && list->item_amount > 0 && bemDisplayListJoin(item = list->items + list->item_amount - 1, z_index, rgba, x, y, width, height))
+    {
+        list->merged++;
+
+        // A row that was just completed can continue the one above it
+        if (list->item_amount > 1 && bemDisplayListJoin(item - 1, z_index, rgba, item->x, item->y, item->width, item->height))
+        {
+            list->item_amount--;
+            list->merged++;
+        }
+
+        return;
+    }
+
+    if ((item = bemDisplayListAdd(list, PAINT_RECT, z_index, x, y, width, height)) == NULL)
+        return;
+
+    item->colors[0] = rgba;
+
+    if (radius)
+        bemDisplayListCorners(item, radius);
+}
+
+static void bemDisplayListShadow(bem_display_list *list, int z_index, const bem_layout_box *box, const bem_box *paint)
+{
+    const bem_box_shadow *shadow = &paint->box_shadow;
+    bem_display_item *item;
+    float outset = shadow->spread_distance + shadow->blur_radius;
+
+    if (shadow->color.alpha <= 0.0f || (!shadow->horizontal_offset && !shadow->vertical_offset && !shadow->blur_radius && !shadow->spread_distance))
+        return;
+
+    // Outer shadows extend past the box by the spread and blur, inset ones are inside of it
+    if (shadow->inset)
+        item = bemDisplayListAdd(list, PAINT_SHADOW, z_index, box->x, box->y, box->width, box->height);
+    else if (box->width + 2.0f * outset > 0.0f && box->height + 2.0f * outset > 0.0f)
+        item = bemDisplayListAdd(list, PAINT_SHADOW, z_index, box->x + shadow->horizontal_offset - outset, box->y + shadow->vertical_offset - outset, box->width + 2.0f * outset,
+                                 box->height + 2.0f * outset);
+    else
+        item = NULL;
+
+    if (!item)
+        return;
+
+    item->styles[0] = shadow->inset;
+    item->colors[0] = bemDisplayListColor(&shadow->color);
+    item->values[0] = shadow->horizontal_offset;
+    item->values[1] = shadow->vertical_offset;
+    item->values[2] = shadow->blur_radius;
+    item->values[3] = shadow->spread_distance;
+
+    bemDisplayListCorners(item, &paint->border_radius);
+}
+
+static unsigned bemDisplayListString(bem_display_list *list, const char *str, size_t length)
+{
+    size_t offset = list->strings_length, strings_size;
+    char *strings;
+
+    if (!str)
+        length = 0;
+
+    if (offset + length + 1 > list->strings_size)
+    {
+        for (strings_size = list->strings_size ? list->strings_size : 4096; strings_size < offset + length + 1; strings_size *= 2)
+            ;
+
+        if ((strings = (char *)realloc(list->strings, strings_size)) == NULL)
+        {
+            list->failed = true;
+            return (0);
+        }
+
+        list->strings = strings;
+        list->strings_size = strings_size;
+    }
+
+    if (length)
+        memcpy(list->strings + offset, str, length);
+
+    list->strings[offset + length] = '\0';
+    list->strings_length += length + 1;
+
+    return ((unsigned)offset);
+}
+
+static void bemDisplayListText(bem_display_list *list, const bem_layout_box *box, int z_index)
+{
+    const bem_text *text = &box->style->text;
+    const bem_layout_box *line;
+    bem_display_item *item;
+    unsigned font, color = bemDisplayListColor(&text->color);
+    float baseline = box->y + box->baseline, gap, space;
+    bool merge = false;
+
+    if (!box->text || !box->length || !(color & 255))
+        return;
+
+    font = text->font ? bemDisplayListFont(list, text->font) : (unsigned)-1;
+
+    for (line = box->parent; line && line->type != LAYOUT_LINE; line = line->parent)
+        ;
+
+    // Runs on one line in the same font continue the previous item, with a space when there was one between them
+    if (line == list->line && list->item_amount > 0 && (item = list->items + list->item_amount - 1)->type == PAINT_TEXT && item->z_index == z_index && item->font == font &&
+        item->colors[0] == color && item->values[0] == text->font_size && item->values[1] == baseline && item->values[2] == text->letter_spacing &&
+        item->values[3] == text->word_spacing && item->string + item->length + 1 == list->strings_length)
+    {
+        gap = box->x - item->x - item->width;
+
+        if (bemDisplayListNear(gap, 0.0f))
+        {
+            merge = true;
+        }
+        else if ((space = bemLayoutMeasure(box->style, " ", NULL)) > 0.0f && bemDisplayListNear(gap, space))
+        {
+            list->strings_length--;
+            bemDisplayListString(list, " ", 1);
+            item->length++;
+            merge = true;
+        }
+    }
+
+    if (merge)
+    {
+        list->strings_length--;
+        bemDisplayListString(list, box->text, box->length);
+
+        if (box->y + box->height > item->y + item->height)
+            item->height = box->y + box->height - item->y;
+
+        item->width = box->x + box->width - item->x;
+        item->length += (unsigned)box->length;
+        list->merged++;
+        return;
+    }
+
+    list->line = line;
+
+    if ((item = bemDisplayListAdd(list, PAINT_TEXT, z_index, box->x, box->y, box->width, box->height)) == NULL)
+        return;
+
+    item->font = font;
+    item->colors[0] = color;
+    item->values[0] = text->font_size;
+    item->values[1] = baseline;
+    item->values[2] = text->letter_spacing;
+    item->values[3] = text->word_spacing;
+    item->string = bemDisplayListString(list, box->text, box->length);
+    item->length = (unsigned)box->length;
+}
+
+static bool bemWriteFile(const char *filename, bem_write_function callback, void *context)
+{
+    char temp[PATH_MAX + 16];
+    FILE *fp;
+    bool written;
+    int length;
+
+    // Write to a temporary file and rename it so other processes never read or map a partial file
+    if ((length = snprintf(temp, sizeof(temp), "%s.%d", filename, (int)getpid())) < 0 || (size_t)length >= sizeof(temp))
+        return false;
+
+    if ((fp = fopen(temp, "wb")) == NULL)
+        return false;
+
+    written = (*callback)(context, fp);
+
+    if (fclose(fp) || !written || rename(temp, filename))
+    {
+        unlink(temp);
+        return false;
+    }
+
+    return true;
+}
+
+static bool bemWriteSpans(const bem_write_span *spans, FILE *fp)
+{
+    for (; spans->data; spans++)
+    {
+        if (fwrite(spans->data, 1, spans->length, fp) != spans->length)
+            return false;
+    }
+
+    return true;
+}
+
+static int bemTestCSSFileFunctions(void)
+{
+    static const char *const text = "p { color: red } @media print { p { font-size: 10pt } } @media screen { p { font-size: 20pt } } "
+                                     "@media print and (min-width: 500pt) { div { color: blue } @media (max-width: 400pt) { div { color: green } } }";
+    static const struct
+    {
+        bem_element element;
+        const char *name;
+        const char *value; // Expected from the stylesheet with "p { text-indent: 5pt }" imported after mapping
+    } tests[] = {{ELEMENT_P, "color", "red"}, {ELEMENT_P, "font-size", "10pt"}, {ELEMENT_P, "text-indent", "5pt"}, {ELEMENT_DIV, "color", "blue"}};
+    bem_memory_pool *pool;
+    bem_stylesheet *sheets[3] = {NULL, NULL, NULL}, *css;
+    bem_document *html[3] = {NULL, NULL, NULL};
+    bem_node *nodes[3][2];
+    bem_file *file;
+    bem_css_file_header *header;
+    bem_rule_set *rule;
+    bem_uchar *data = NULL;
+    const bem_dictionary *a, *b;
+    const char *value;
+    char filename[1024], badname[1024];
+    FILE *fp;
+    long size = 0;
+    size_t i, j, k;
+    int failures = 0;
+
+    if ((pool = bemPoolNew()) == NULL || (sheets[0] = bemCSSNew(pool)) == NULL || (file = bemFileNewString(pool, text)) == NULL)
+    {
+        bemCSSDelete(sheets[0]);
+        bemPoolDelete(pool);
+        return (1);
+    }
+
+    // Keep every @media block so the conditions are saved and compiled again when mapped
+    bemCSSSetMediaPruning(sheets[0], false);
+    bemCSSImport(sheets[0], file);
+    bemFileDelete(file);
+
+    snprintf(filename, sizeof(filename), "/tmp/bem-test-%d.css", (int)getpid());
+    snprintf(badname, sizeof(badname), "/tmp/bem-test-%d-bad.css", (int)getpid());
+
+    if (!bemCSSSave(sheets[0], filename) || (sheets[1] = bemCSSLoad(pool, filename, sheets[0]->hash)) == NULL || (sheets[2] = bemCSSLoad(pool, filename, NULL)) == NULL)
+    {
+        printf("bemTestCSSFileFunctions: Unable to save and map \"%s\"\n", filename);
+        failures++;
+    }
+    else
+    {
+        // Importing into a mapped stylesheet has to copy its rules to the heap first
+        if ((file = bemFileNewString(pool, "p { text-indent: 5pt }")) != NULL)
+        {
+            if (!bemCSSImport(sheets[2], file) || sheets[2]->mapping)
+            {
+                printf("bemTestCSSFileFunctions: Import into a mapped stylesheet failed\n");
+                failures++;
+            }
+
+            bemFileDelete(file);
+        }
+
+        // Each stylesheet gets a document with a body > div > p
+        for (i = 0; i < 3; i++)
+        {
+            if ((html[i] = bemHTMLNew(pool, sheets[i])) == NULL)
+                break;
+
+            nodes[i][1] = bemNodeNewElement(bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html[i], "html"), ELEMENT_HTML), ELEMENT_BODY), ELEMENT_DIV);
+            nodes[i][0] = bemNodeNewElement(nodes[i][1], ELEMENT_P);
+        }
+
+        // The mapped stylesheet computes the same properties as the one it was saved from
+        for (k = 0; i == 3 && k < 2; k++)
+        {
+            a = bemNodeComputeCSSProperties(nodes[0][k], COMPUTE_BASE);
+            b = bemNodeComputeCSSProperties(nodes[1][k], COMPUTE_BASE);
+
+            for (j = 0; a && b && a->pair_amount == b->pair_amount && j < a->pair_amount && !strcmp(a->pairs[j].key, b->pairs[j].key) && !strcmp(a->pairs[j].value, b->pairs[j].value); j++)
+                ;
+
+            if (!a || !b || a->pair_amount != b->pair_amount || j < a->pair_amount)
+            {
+                printf("bemTestCSSFileFunctions: Mapped %s properties differ from the saved ones\n", bemElementString(k ? ELEMENT_DIV : ELEMENT_P));
+                failures++;
+            }
+        }
+
+        for (k = 0; i == 3 && k < sizeof(tests) / sizeof(tests[0]); k++)
+        {
+            value = bemDictionaryGetKeyValue(bemNodeComputeCSSProperties(nodes[2][tests[k].element == ELEMENT_DIV], COMPUTE_BASE), tests[k].name);
+
+            if (!value || strcmp(value, tests[k].value))
+            {
+                printf("bemTestCSSFileFunctions: Mapped and imported %s gives %s: %s, expected %s\n", bemElementString(tests[k].element), tests[k].name, value ? value : "(null)", tests[k].value);
+                failures++;
+            }
+        }
+
+        if (i < 3)
+        {
+            printf("bemTestCSSFileFunctions: Unable to create documents\n");
+            failures++;
+        }
+    }
+
+    // Read the saved file back to write broken copies of it
+    if ((fp = fopen(filename, "rb")) != NULL)
+    {
+        if (!fseek(fp, 0, SEEK_END) && (size = ftell(fp)) > 0 && !fseek(fp, 0, SEEK_SET) && (data = (bem_uchar *)malloc((size_t)size)) != NULL &&
+            fread(data, 1, (size_t)size, fp) != (size_t)size)
+        {
+            free(data);
+            data = NULL;
+        }
+
+        fclose(fp);
+    }
+
+    for (i = 0; data && i < 2; i++)
+    {
+        // First a file cut in half, then one whose first rule points between two selectors
+        if (i)
+        {
+            header = (bem_css_file_header *)data;
+            rule = (bem_rule_set *)(data + header->rules);
+            rule->selector = (bem_stylesheet_selector *)((uintptr_t)rule->selector + 1);
+        }
+
+        if ((fp = fopen(badname, "wb")) != NULL)
+        {
+            fwrite(data, 1, i ? (size_t)size : (size_t)size / 2, fp);
+            fclose(fp);
+        }
+
+        if ((css = bemCSSLoad(pool, badname, NULL)) != NULL)
+        {
+            printf("bemTestCSSFileFunctions: Mapped a %s file\n", i ? "corrupted" : "truncated");
+            bemCSSDelete(css);
+            failures++;
+        }
+    }
+
+    if (!data)
+    {
+        printf("bemTestCSSFileFunctions: Unable to read \"%s\"\n", filename);
+        failures++;
+    }
+
+    free(data);
+    unlink(filename);
+    unlink(badname);
+
+    for (i = 0; i < 3; i++)
+    {
+        bemHTMLDelete(html[i]);
+        bemCSSDelete(sheets[i]);
+    }
+
+    bemPoolDelete(pool);
+
+    printf("bemTestCSSFileFunctions: %d stylesheet file tests failed\n", failures);
+
+    return (failures);
+}
+
+static int bemTestCSSFunctions(void)
+{
+    static const struct
+    {
+        const char *css;
+        const char *name;
+        const char *value;
+    } tests[] = {{"div p { color: red } div p { color: green }", "color", "green"},
+                 {"div p { color: red } body p { color: blue } div p { font-size: 10pt }", "color", "blue"},
+                 {"div p { color: red } body p { color: blue } div p { font-size: 10pt }", "font-size", "10pt"},
+                 {"body p { color: blue } div p { color: red } div p { font-size: 10pt }", "color", "red"},
+                 {"div p, body p { color: red } body p { color: blue } div p { color: green }", "color", "green"}};
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *p;
+    bem_file *file;
+    const char *value;
+    size_t i;
+    int failures = 0;
+
+    // Each document has a body > div > p and the author stylesheet of one test
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+        {
+            bemPoolDelete(pool);
+            return (failures + 1);
+        }
+
+        p = bemNodeNewElement(bemNodeNewElement(bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY), ELEMENT_DIV), ELEMENT_P);
+
+        if ((file = bemFileNewString(pool, tests[i].css)) != NULL)
+        {
+            bemCSSImport(bemHTMLGetCSS(html), file);
+            bemFileDelete(file);
+        }
+
+        value = bemDictionaryGetKeyValue(bemNodeComputeCSSProperties(p, COMPUTE_BASE), tests[i].name);
+
+        if (!value || strcmp(value, tests[i].value))
+        {
+            printf("bemTestCSSFunctions: \"%s\" gives %s: %s, expected %s\n", tests[i].css, tests[i].name, value ? value : "(null)", tests[i].value);
+            failures++;
+        }
+
+        bemHTMLDelete(html);
+        bemPoolDelete(pool);
+    }
+
+    printf("bemTestCSSFunctions: %d of %d cascade tests failed\n", failures, (int)(sizeof(tests) / sizeof(tests[0])));
+
+    return (failures);
+}
+
+static int bemTestCSSMediaFunctions(void)
+{
+    static const struct
+    {
+        float width;
+        bem_element element;
+        const char *name;
+        const char *value; // Inherited from the div and the user agent's body when no rule of their own applies
+    } tests[] = {{612.0f, ELEMENT_P, "color", "blue"},     {612.0f, ELEMENT_DIV, "font-size", "20pt"}, {400.0f, ELEMENT_P, "color", "green"},
+                 {400.0f, ELEMENT_DIV, "font-size", "12pt"}, {250.0f, ELEMENT_P, "color", "red"},      {612.0f, ELEMENT_P, "color", "blue"}};
+    bem_memory_pool *pool;
+    bem_stylesheet *css;
+    bem_document *html;
+    bem_node *nodes[2];
+    bem_file *file;
+    const char *value;
+    size_t i;
+    int failures = 0;
+
+    // The shared layer nests a condition inside another, the document's layer adds its own in front of them
+    if ((pool = bemPoolNew()) == NULL || (css = bemCSSNew(pool)) == NULL)
+    {
+        bemPoolDelete(pool);
+        return (1);
+    }
+
+    bemCSSSetMediaPruning(css, false);
+
+    if ((file = bemFileNewString(pool, "@media (min-width: 500pt) { @media print { p { color: blue } } } @media (max-width: 300pt) { p { color: red } }")) != NULL)
+    {
+        bemCSSImport(css, file);
+        bemFileDelete(file);
+    }
+
+    if ((html = bemHTMLNew(pool, css)) == NULL)
+    {
+        bemCSSDelete(css);
+        bemPoolDelete(pool);
+        return (1);
+    }
+
+    bemCSSSetMediaPruning(bemHTMLGetCSS(html), false);
+
+    if ((file = bemFileNewString(pool, "@media print { div { color: green } } @media (min-width: 500pt) { div { font-size: 20pt } }")) != NULL)
+    {
+        bemCSSImport(bemHTMLGetCSS(html), file);
+        bemFileDelete(file);
+    }
+
+    nodes[1] = bemNodeNewElement(bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY), ELEMENT_DIV);
+    nodes[0] = bemNodeNewElement(nodes[1], ELEMENT_P);
+
+    // Changing the width re-evaluates the kept @media blocks without importing anything again
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        bemCSSSetMedia(bemHTMLGetCSS(html), "print", 8, 2, tests[i].width, 792.0f);
+
+        value = bemDictionaryGetKeyValue(bemNodeComputeCSSProperties(nodes[tests[i].element == ELEMENT_DIV], COMPUTE_BASE), tests[i].name);
+
+        if (!value || strcmp(value, tests[i].value))
+        {
+            printf("bemTestCSSMediaFunctions: %.0fpt wide %s gives %s: %s, expected %s\n", tests[i].width, bemElementString(tests[i].element), tests[i].name, value ? value : "(null)", tests[i].value);
+            failures++;
+        }
+    }
+
+    bemHTMLDelete(html);
+    bemCSSDelete(css);
+    bemPoolDelete(pool);
+
+    printf("bemTestCSSMediaFunctions: %d of %d media tests failed\n", failures, (int)(sizeof(tests) / sizeof(tests[0])));
+
+    return (failures);
+}
+
+static int bemTestLayoutFunctions(void)
+{
+    static const struct
+    {
+        const char *css;
+        bem_element element;
+        const char *id; // Only boxes of the element with this id, any of them for NULL
+        int edges;      // 0 for the margins, 1 for the padding, 2 for the border, 3 for the font size and text indent, 4 for the width and height of the box
+        float top, left;
+    } tests[] = {{"p { margin: 10pt 0 }", ELEMENT_P, NULL, 0, 10.0f, 0.0f},
+                 {"ul { padding: 0 }", ELEMENT_UL, NULL, 1, 0.0f, 0.0f},
+                 {"p { margin: 10pt 0; margin-top: 5pt }", ELEMENT_P, NULL, 0, 5.0f, 0.0f},
+                 {"p { margin-left: 5pt } p { margin: 10pt 20pt }", ELEMENT_P, NULL, 0, 10.0f, 20.0f},
+                 {"p { border: 2pt solid } p { border-left-style: none }", ELEMENT_P, NULL, 2, 2.0f, 0.0f},
+                 {"p { border-top-style: dashed; border-left: 3pt dotted } p { border: 1pt }", ELEMENT_P, NULL, 2, 0.0f, 0.0f},
+                 {"p { border-width: 1pt 2pt 3pt 4pt; border-style: solid }", ELEMENT_P, NULL, 2, 1.0f, 4.0f},
+                 {"li { font-size: 80% }", ELEMENT_LI, NULL, 3, 7.68f, 0.0f},
+                 {"li { font-size: smaller }", ELEMENT_LI, NULL, 3, 8.33f, 0.0f},
+                 {"div { font-size: 2em; text-indent: 1em }", ELEMENT_DIV, NULL, 3, 48.0f, 48.0f},
+                 {"div { padding-left: 100pt; text-indent: 10% }", ELEMENT_DIV, NULL, 3, 12.0f, 28.8f},
+                 {"table { table-layout: fixed; width: 300pt; border-spacing: 0 } td { padding: 0 } #a { width: 50pt }", ELEMENT_TD, "b", 4, 125.0f, 0.0f},
+                 {"table { table-layout: fixed; width: 300pt; border-spacing: 0 } td { padding: 0 } #a { width: 50pt }", ELEMENT_TD, "d", 4, 175.0f, 0.0f},
+                 {"table { border-spacing: 0 } td { padding: 0 } #a { width: 80pt } #b { width: 60pt } #c { width: 40pt }", ELEMENT_TD, "d", 4, 140.0f, 0.0f},
+                 {"table { border-spacing: 0 } td { padding: 0 } #a { width: 80pt } #b { width: 60pt } #d { width: 200pt }", ELEMENT_TD, "b", 4, 90.0f, 0.0f},
+                 {"table { border-spacing: 0 } td { padding: 0; height: 20pt } #d { height: 30pt } #e { height: 40pt }", ELEMENT_TD, "c", 4, 0.0f, 50.0f}};
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *body, *li, *group, *row, *cell;
+    bem_file *file;
+    bem_layout *layout;
+    const bem_layout_box *box, *found;
+    const char *id;
+    const bem_rectangle *edges;
+    bem_rectangle text;
+    size_t i;
+    int failures = 0;
+
+    // Author shorthands have to beat the user agent's longhands and the other way around, relative sizes compound in nested elements, and spanning cells cover their columns and rows
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+        {
+            bemPoolDelete(pool);
+            return (failures + 1);
+        }
+
+        body = bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY);
+        bemNodeNewString(bemNodeNewElement(body, ELEMENT_P), "Paragraph");
+        li = bemNodeNewElement(bemNodeNewElement(body, ELEMENT_UL), ELEMENT_LI);
+        bemNodeNewString(li, "Item");
+        bemNodeNewString(bemNodeNewElement(bemNodeNewElement(li, ELEMENT_UL), ELEMENT_LI), "Nested");
+        bemNodeNewString(bemNodeNewElement(bemNodeNewElement(body, ELEMENT_DIV), ELEMENT_DIV), "Text");
+
+        // Empty cells, with the rowspan of "c" running past the end of its row group
+        group = bemNodeNewElement(bemNodeNewElement(body, ELEMENT_TABLE), ELEMENT_TBODY);
+        row = bemNodeNewElement(group, ELEMENT_TR);
+        bemNodeAttributeSetNameValue(bemNodeNewElement(row, ELEMENT_TD), "id", "a");
+        bemNodeAttributeSetNameValue(bemNodeNewElement(row, ELEMENT_TD), "id", "b");
+        cell = bemNodeNewElement(row, ELEMENT_TD);
+        bemNodeAttributeSetNameValue(cell, "id", "c");
+        bemNodeAttributeSetNameValue(cell, "rowspan", "3");
+        cell = bemNodeNewElement(bemNodeNewElement(group, ELEMENT_TR), ELEMENT_TD);
+        bemNodeAttributeSetNameValue(cell, "id", "d");
+        bemNodeAttributeSetNameValue(cell, "colspan", "2");
+        row = bemNodeNewElement(bemNodeNewElement(group->parent, ELEMENT_TBODY), ELEMENT_TR);
+        bemNodeAttributeSetNameValue(bemNodeNewElement(row, ELEMENT_TD), "id", "e");
+        bemNodeNewElement(row, ELEMENT_TD);
+        bemNodeNewElement(row, ELEMENT_TD);
+
+        if ((file = bemFileNewString(pool, tests[i].css)) != NULL)
+        {
+            bemCSSImport(bemHTMLGetCSS(html), file);
+            bemFileDelete(file);
+        }
+
+        // Pre-order walk to the last box of the element, which is the innermost one
+        for (box = (layout = bemLayoutNew(html, 400.0f)) != NULL ? bemLayoutGetRoot(layout) : NULL, found = NULL; box;)
+        {
+            if (box->node && box->node->element == tests[i].element && (!tests[i].id || ((id = bemNodeAttributeGetNameValue(box->node, "id")) != NULL && !strcmp(id, tests[i].id))))
+                found = box;
+
+            if (box->first_child)
+            {
+                box = box->first_child;
+            }
+            else
+            {
+                while (box && !box->next)
+                    box = box->parent;
+
+                box = box ? box->next : NULL;
+            }
+        }
+
+        if (found && tests[i].edges == 3)
+        {
+            text.top_offset = found->style->text.font_size;
+            text.left_offset = found->style->text.text_indent;
+        }
+        else if (found)
+        {
+            text.top_offset = found->width;
+            text.left_offset = found->height;
+        }
+
+        edges = !found ? NULL : tests[i].edges == 0 ? &found->style->margin : tests[i].edges == 1 ? &found->style->padding : tests[i].edges == 2 ? &found->style->border : &text;
+
+        if (!edges || edges->top_offset < tests[i].top - 0.01f || edges->top_offset > tests[i].top + 0.01f || edges->left_offset < tests[i].left - 0.01f ||
+            edges->left_offset > tests[i].left + 0.01f)
+        {
+            printf("bemTestLayoutFunctions: \"%s\" gives %s top %.2f left %.2f, expected %.2f and %.2f\n", tests[i].css, bemElementString(tests[i].element), edges ? edges->top_offset : -1.0f,
+                   edges ? edges->left_offset : -1.0f, tests[i].top, tests[i].left);
+            failures++;
+        }
+
+        bemLayoutDelete(layout);
+        bemHTMLDelete(html);
+        bemPoolDelete(pool);
+    }
+
+    printf("bemTestLayoutFunctions: %d of %d layout tests failed\n", failures, (int)(sizeof(tests) / sizeof(tests[0])));
+
+    return (failures);
+}
+
+static int bemTestWordCacheFunctions(void)
+{
+    static const float widths[] = {60.0f, 150.0f, 400.0f};
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *body, *p;
+    bem_layout *layout;
+    const bem_layout_box *box, *line;
+    size_t i, lines[3], hits;
+    float heights[3];
+    int cached, pass, failures = 0;
+
+    // The same paragraph has to break into the same lines whether its words are measured, looked up cold or looked up warm
+    for (i = 0; i < sizeof(widths) / sizeof(widths[0]); i++)
+    {
+        for (cached = 0, hits = 0; cached < 2; cached++)
+        {
+            if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+            {
+                bemPoolDelete(pool);
+                return (failures + 1);
+            }
+
+            bemPoolSetWordCache(pool, cached ? BEM_WORD_CACHE_SIZE : 0);
+
+            body = bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY);
+            p = bemNodeNewElement(body, ELEMENT_P);
+            bemNodeNewString(p, "The quarterly report shows that the revenue of the period ");
+            bemNodeNewString(bemNodeNewElement(p, ELEMENT_B), "increased significantly");
+            bemNodeNewString(p, " compared to the previous period, and the report shows that the operating expenses of the period decreased.");
+
+            for (pass = 0; pass <= cached; pass++)
+            {
+                lines[cached + pass] = 0;
+                heights[cached + pass] = 0.0f;
+
+                if ((layout = bemLayoutNew(html, widths[i])) == NULL)
+                    continue;
+
+                for (box = bemLayoutGetRoot(layout); box && box->node != p;)
+                    box = box->first_child;
+
+                for (line = box ? box->first_child : NULL; line; line = line->next)
+                {
+                    if (line->type == LAYOUT_LINE)
+                        lines[cached + pass]++;
+                }
+
+                heights[cached + pass] = box ? box->height : 0.0f;
+
+                bemLayoutDelete(layout);
+            }
+
+            if (cached)
+                hits = bemPoolGetWordStats(pool)->hits;
+
+            bemHTMLDelete(html);
+            bemPoolDelete(pool);
+        }
+
+        for (pass = 1; pass < 3; pass++)
+        {
+            if (!lines[0] || !hits || lines[pass] != lines[0] || heights[pass] != heights[0])
+            {
+                printf("bemTestWordCacheFunctions: %.0fpt wide paragraph has %lu lines %.2fpt high with the word cache %s and %lu lines %.2fpt high without it (%lu hits)\n", widths[i],
+                       (unsigned long)lines[pass], heights[pass], pass == 1 ? "cold" : "warm", (unsigned long)lines[0], heights[0], (unsigned long)hits);
+                failures++;
+            }
+        }
+    }
+
+    printf("bemTestWordCacheFunctions: %d of %d word cache tests failed\n", failures, (int)(2 * sizeof(widths) / sizeof(widths[0])));
+
+    return (failures);
+}
+
+static int bemCompareElementNames(const char **a, const char **b)
+{
+    return strcasecmp(*a, *b);
+}
+
+static void bemBenchDisplayList(size_t paragraphs)
+{
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *body, *node, *row;
+    bem_file *file;
+    bem_layout *layout;
+    bem_display_list *list;
+    const bem_media *media;
+    void *buffer;
+    size_t i, j, amount, bytes;
+    double start, full, page;
+
+    if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+        return;
+
+    if ((file = bemFileNewString(pool, ".note { background: #ffe; border: 1px solid #cc9; border-radius: 3px; box-shadow: 1px 1px 2px gray } table { border-collapse: collapse } "
+                                       "td { background: #eef; padding: 0 } em { color: maroon }")) != NULL)
+    {
+        bemCSSImport(bemHTMLGetCSS(html), file);
+        bemFileDelete(file);
+    }
+
+    // Paragraphs with inline markup, boxed notes and striped tables, most of it far below the first page
+    body = bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY);
+
+    for (i = 0; i < paragraphs; i++)
+    {
+        node = bemNodeNewElement(body, ELEMENT_P);
+        bemNodeNewString(node, "Quarterly revenue increased compared to the previous period, with ");
+        bemNodeNewString(bemNodeNewElement(node, ELEMENT_EM), "significant");
+        bemNodeNewString(node, " growth in international markets and ");
+        bemNodeNewString(bemNodeNewElement(node, ELEMENT_SPAN), "operating expenses");
+        bemNodeNewString(node, " held flat across the remaining product lines and services.");
+
+        if (i % 10 == 0)
+        {
+            node = bemNodeNewElement(body, ELEMENT_DIV);
+            bemNodeAttributeSetNameValue(node, "class", "note");
+            bemNodeNewString(node, "Figures are approximate and unaudited.");
+        }
+        else if (i % 10 == 5)
+        {
+            node = bemNodeNewElement(body, ELEMENT_TABLE);
+
+            for (j = 0; j < 4; j++)
+            {
+                row = bemNodeNewElement(node, ELEMENT_TR);
+                bemNodeNewString(bemNodeNewElement(row, ELEMENT_TD), "Region");
+                bemNodeNewString(bemNodeNewElement(row, ELEMENT_TD), "Revenue");
+                bemNodeNewString(bemNodeNewElement(row, ELEMENT_TD), "Growth");
+            }
+        }
+    }
+
+    if ((layout = bemLayoutNew(html, 0.0f)) == NULL)
+    {
+        bemHTMLDelete(html);
+        bemPoolDelete(pool);
+        return;
+    }
+
+    // The first list converts the painted properties, the second one is what gets reported
+    bemDisplayListDelete(bemDisplayListNew(layout, 0.0f, 0.0f, 0.0f, 0.0f));
+
+    start = bemLayoutTime();
+    list = bemDisplayListNew(layout, 0.0f, 0.0f, 0.0f, 0.0f);
+    full = bemLayoutTime() - start;
+
+    if (list)
+    {
+        buffer = bemDisplayListSerialize(list, &bytes);
+        bemDisplayListGetItems(list, &amount);
+
+        printf("bemDisplayListNew: %lu boxes, whole document %lu items (%lu merged) in %.3f seconds, %lu bytes serialized\n", (unsigned long)layout->box_amount,
+               (unsigned long)amount, (unsigned long)list->merged, full, (unsigned long)bytes);
+
+        free(buffer);
+        bemDisplayListDelete(list);
+    }
+
+    media = &html->css->media;
+
+    start = bemLayoutTime();
+    list = bemDisplayListNew(layout, 0.0f, 0.0f, media->size.width, media->size.height);
+    page = bemLayoutTime() - start;
+
+    if (list)
+    {
+        bemDisplayListGetItems(list, &amount);
+
+        printf("bemDisplayListNew: first page %lu items (%lu merged, %lu culled, %lu boxes skipped) in %.3f seconds\n", (unsigned long)amount,
+               (unsigned long)list->merged, (unsigned long)list->culled, (unsigned long)list->skipped, page);
+
+        bemDisplayListDelete(list);
+    }
+
+    bemLayoutDelete(layout);
+    bemHTMLDelete(html);
+    bemPoolDelete(pool);
+}
+
+static void bemBenchElementValue(int iterations)
+{
+    static const char *const tags[] = {"div", "SPAN", "a", "Table", "td", "tr", "p", "li", "blockquote", "figcaption", "h1", "img", "custom-tag", "xyzzy"};
+    const char *sorted[ELEMENT_MAX], **found;
+    clock_t start;
+    double search_time, hash_time;
+    int i, matches = 0;
+    size_t j, lookups = (size_t)iterations * (sizeof(tags) / sizeof(tags[0]));
+
+    memcpy(sorted, bem_elements, sizeof(sorted));
+    qsort(sorted, ELEMENT_MAX, sizeof(char *), (bem_comparison_function)bemCompareElementNames);
+
+    start = clock();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < sizeof(tags) / sizeof(tags[0]); j++)
+        {
+            if ((found = bsearch(tags + j, sorted, ELEMENT_MAX, sizeof(char *), (bem_comparison_function)bemCompareElementNames)) != NULL)
+                matches += (int)(found - sorted) > 0;
+        }
+    }
+    search_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < sizeof(tags) / sizeof(tags[0]); j++)
+            matches += bemElementValue(tags[j]) > ELEMENT_DOCTYPE;
+    }
+    hash_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("bemElementValue: %lu lookups, bsearch %.1f ns/lookup, perfect hash %.1f ns/lookup (%d)\n", (unsigned long)lookups,
+           1e9 * search_time / lookups, 1e9 * hash_time / lookups, matches);
+}
+
+static void bemBenchFontNew(int iterations)
+{
+    bem_memory_pool *pool;
+    bem_font_scanner scanner;
+    bem_file *file;
+    bem_font *font;
+    struct timespec start, end;
+    double elapsed;
+    size_t i, index, num_fonts, total = 0, bytes = 0;
+    int iteration;
+
+    if ((pool = bemPoolNew()) == NULL)
+        return;
+
+    // Only the file list is needed, the scan itself is not timed
+    memset(&scanner, 0, sizeof(scanner));
+    bemScanAllFonts(pool, &scanner);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        for (i = 0; i < scanner.scan_amount; i++)
+        {
+            for (index = 0, num_fonts = 1; index < num_fonts; index++)
+            {
+                if ((file = bemFileNewURL(pool, scanner.scans[i].url, NULL)) == NULL)
+                    break;
+
+                font = bemFontNew(pool, file, index);
+
+                bemFileDelete(file);
+
+                if (!font)
+                    break;
+
+                num_fonts = font->fonts_amount;
+                total++;
+
+                if (index == 0)
+                    bytes += (size_t)scanner.scans[i].size;
+
+                bemFontDelete(font);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (double)(end.tv_sec - start.tv_sec) + 1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+
+    printf("bemFontNew: %lu fonts from %lu files in %.3f seconds, %.1f us/font, %.1f MB/s\n", (unsigned long)total,
+           (unsigned long)scanner.scan_amount * iterations, elapsed, total ? 1e6 * elapsed / total : 0.0, elapsed > 0.0 ? 1e-6 * bytes / elapsed : 0.0);
+
+    bemDeleteScanner(&scanner);
+    bemPoolDelete(pool);
+}
+
+static void bemBenchFontScan(void)
+{
+    bem_memory_pool *pool;
+    bem_font_scanner scanner;
+    struct timespec start, end;
+    double elapsed, single = 0.0;
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads;
+
+    if (num_cpus < 1)
+        num_cpus = 1;
+
+    for (threads = 1; threads <= num_cpus; threads++)
+    {
+        if ((pool = bemPoolNew()) == NULL)
+            return;
+
+        bemPoolSetFontThreads(pool, threads);
+
+        memset(&scanner, 0, sizeof(scanner));
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bemScanAllFonts(pool, &scanner);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        bemDeleteScanner(&scanner);
+
+        elapsed = (double)(end.tv_sec - start.tv_sec) + 1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+
+        if (threads == 1)
+            single = elapsed;
+
+        printf("bemScanAllFonts: %2d threads, %lu fonts in %.3f seconds (%.2fx)\n", threads, (unsigned long)pool->font_amount, elapsed,
+               elapsed > 0.0 ? single / elapsed : 0.0);
+
+        bemPoolDelete(pool);
+    }
+}
+
+static void bemBenchMeasureText(int iterations)
+{
+    static const char *const sample = "The quick brown fox jumps over the lazy dog. Typographers call a sentence like this a pangram, "
+                                      "and na\xc3\xafve caf\xc3\xa9 owners in Z\xc3\xbcrich use one to check a well-hinted \xe2\x80\x9c" "font\xe2\x80\x9d.";
+    bem_memory_pool *pool;
+    bem_font *font;
+    bem_text text;
+    bem_text_break breaks[64];
+    bem_rectangle extents;
+    struct timespec start, end;
+    char word[64];
+    const char *s, *next;
+    double word_time, batch_time;
+    float total = 0.0f;
+    size_t glyphs = 0, length;
+    int i;
+
+    if ((pool = bemPoolNew()) == NULL)
+        return;
+
+    if ((font = bemFontFindCached(pool, "serif", FONT_STRETCH_NORMAL, FONT_STYLE_NORMAL, FONT_VARIANT_NORMAL, FONT_WEIGHT_400)) == NULL &&
+        (font = bemFontFindCached(pool, "sans-serif", FONT_STRETCH_NORMAL, FONT_STYLE_NORMAL, FONT_VARIANT_NORMAL, FONT_WEIGHT_400)) == NULL &&
+        (font = bemFontGetCached(pool, 0)) == NULL)
+    {
+        fputs("bemFontMeasureText: no fonts found\n", stderr);
+        bemPoolDelete(pool);
+        return;
+    }
+
+    memset(&text, 0, sizeof(text));
+    text.font = font;
+    text.font_size = 16.0f;
+    text.letter_spacing = 0.5f;
+    text.word_spacing = 2.0f;
+
+    s = sample;
+    while (bemFontNextChar(&s) > 0)
+        glyphs++;
+
+    // Word-at-a-time measurement, the way a line breaker without a batched API has to do it
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        for (s = sample; *s; s = next)
+        {
+            if ((next = strchr(s, ' ')) != NULL)
+                next++;
+            else
+                next = s + strlen(s);
+
+            if ((length = (size_t)(next - s)) >= sizeof(word))
+                length = sizeof(word) - 1;
+
+            memcpy(word, s, length);
+            word[length] = '\0';
+
+            bemFontComputeExtents(font, text.font_size, word, &extents);
+            total += extents.right_offset;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    word_time = (double)(end.tv_sec - start.tv_sec) + 1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        bemFontMeasureText(font, &text, sample, breaks, sizeof(breaks) / sizeof(breaks[0]), NULL);
+        total += breaks[0].width;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    batch_time = (double)(end.tv_sec - start.tv_sec) + 1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+
+    printf("bemFontMeasureText: %s, %lu glyphs, per-word extents %.1f Mglyphs/s, batched %.1f Mglyphs/s (%.0f)\n", bemFontGetFamily(font),
+           (unsigned long)glyphs * iterations, 1e-6 * glyphs * iterations / word_time, 1e-6 * glyphs * iterations / batch_time, total);
+
+    bemPoolDelete(pool);
+}
+
+static void bemBenchTableLayout(size_t rows)
+{
+    static const char *const cells[] = {"Widget", "Blue anodized aluminum housing, 40 mm", "12", "$4.99", "In stock"};
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *body, *table, *row;
+    bem_layout *layout;
+    const bem_layout_timings *timings;
+    char number[32];
+    size_t amount, i, j;
+    int fixed;
+
+    for (amount = rows; amount <= 2 * rows; amount += rows)
+    {
+        for (fixed = 0; fixed < 2; fixed++)
+        {
+            if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+                return;
+
+            body = bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY);
+            table = bemNodeNewElement(body, ELEMENT_TABLE);
+
+            if (fixed)
+                bemNodeAttributeSetNameValue(table, "style", "table-layout: fixed; width: 100%");
+
+            for (i = 0; i < amount; i++)
+            {
+                row = bemNodeNewElement(table, ELEMENT_TR);
+
+                snprintf(number, sizeof(number), "%lu", (unsigned long)i);
+                bemNodeNewString(bemNodeNewElement(row, ELEMENT_TD), number);
+
+                for (j = 0; j < sizeof(cells) / sizeof(cells[0]); j++)
+                    bemNodeNewString(bemNodeNewElement(row, ELEMENT_TD), cells[j]);
+            }
+
+            // Lay out once so the cascade is cached, the second run is what gets reported
+            bemLayoutDelete(bemLayoutNew(html, 0.0f));
+
+            if ((layout = bemLayoutNew(html, 0.0f)) != NULL)
+            {
+                timings = bemLayoutGetTimings(layout);
+
+                printf("bemLayoutNew: %s table, %lu rows, %lu cells in %.3f seconds, %.2f us/cell (style %.3f, text %.3f, layout %.3f)\n", fixed ? "fixed" : "auto",
+                       (unsigned long)amount, (unsigned long)amount * 6, timings->total, 1e6 * timings->total / (amount * 6), timings->style, timings->text,
+                       timings->layout);
+
+                bemLayoutDelete(layout);
+            }
+
+            bemHTMLDelete(html);
+            bemPoolDelete(pool);
+        }
+    }
+}
+
+static void bemBenchWordCache(size_t paragraphs)
+{
+    static const char *const vocabulary[] = {"the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "was", "with", "be", "by", "on", "not", "he", "this", "are",
+                                             "or", "his", "from", "at", "which", "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we", "can", "her",
+                                             "has", "there", "been", "if", "more", "when", "will", "would", "who", "so", "no", "report", "quarterly", "revenue", "increased",
+                                             "compared", "previous", "period", "customers", "products", "services", "market", "growth", "operating", "expenses", "results",
+                                             "international", "development", "information", "management", "performance", "significantly", "approximately", "transactions"};
+    bem_memory_pool *pool;
+    bem_document *html;
+    bem_node *body, *node;
+    bem_layout *layout;
+    const bem_word_stats *stats;
+    bem_text text;
+    bem_text_break lines[256];
+    struct timespec start, end;
+    char *buffer;
+    size_t i, j, length, word, hits, misses, num_lines = 0;
+    unsigned seed = 1;
+    double elapsed;
+    int cached, pass;
+
+    // Text-heavy page: short paragraphs with a skewed word distribution
+    if ((buffer = (char *)malloc(8192)) == NULL)
+        return;
+
+    for (cached = 0; cached < 2; cached++)
+    {
+        if ((pool = bemPoolNew()) == NULL || (html = bemHTMLNew(pool, NULL)) == NULL)
+            break;
+
+        bemPoolSetWordCache(pool, cached ? BEM_WORD_CACHE_SIZE : 0);
+
+        body = bemNodeNewElement(bemNodeNewElement(bemHTMLNewRootNode(html, "html"), ELEMENT_HTML), ELEMENT_BODY);
+
+        for (i = 0, seed = 1; i < paragraphs; i++)
+        {
+            for (j = 0, length = 0; j < 100; j++)
+            {
+                seed = seed * 1103515245 + 12345;
+                word = (seed >> 16) % (sizeof(vocabulary) / sizeof(vocabulary[0]));
+                word = (word * word) / (sizeof(vocabulary) / sizeof(vocabulary[0]));
+                length += (size_t)snprintf(buffer + length, 8192 - length, "%s%s", j ? " " : "", vocabulary[word]);
+            }
+
+            bemNodeNewString(bemNodeNewElement(body, ELEMENT_P), buffer);
+        }
+
+        // The cold layout fills the cascade and word caches, the warm one reuses them
+        for (pass = 0, layout = NULL; pass < 2; pass++)
+        {
+            bemLayoutDelete(layout);
+
+            stats = bemPoolGetWordStats(pool);
+            hits = stats->hits;
+            misses = stats->misses;
+
+            if ((layout = bemLayoutNew(html, 0.0f)) == NULL || !layout->root->first_child)
+                break;
+
+            hits = stats->hits - hits;
+            misses = stats->misses - misses;
+
+            printf("bemLayoutNew: %lu paragraphs, word cache %s, %s, %.3f seconds (text %.3f), %lu hits, %lu misses, %.2f%% hit rate\n", (unsigned long)paragraphs,
+                   cached ? "on" : "off", pass ? "warm" : "cold", layout->timings.total, layout->timings.text, (unsigned long)hits, (unsigned long)misses,
+                   hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+        }
+
+        if (pass < 2)
+        {
+            bemLayoutDelete(layout);
+            bemHTMLDelete(html);
+            bemPoolDelete(pool);
+            break;
+        }
+
+        if (cached)
+        {
+            // The line breaker on its own, over every paragraph's text
+            memset(&text, 0, sizeof(text));
+            text.font = layout->root->first_child->first_child->style->text.font;
+            text.font_size = 12.0f;
+
+            if (text.font)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                for (node = body->value.element.first_child; node; node = node->next)
+                    num_lines += bemFontBreakLines(text.font, &text, bemNodeGetString(node->value.element.first_child), 468.0f, lines, sizeof(lines) / sizeof(lines[0]));
+                clock_gettime(CLOCK_MONOTONIC, &end);
+
+                elapsed = (double)(end.tv_sec - start.tv_sec) + 1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+
+                printf("bemFontBreakLines: %lu paragraphs, %lu lines in %.3f seconds, %.1f us/paragraph\n", (unsigned long)paragraphs, (unsigned long)num_lines, elapsed,
+                       1e6 * elapsed / paragraphs);
+            }
+        }
+
+        bemLayoutDelete(layout);
+        bemHTMLDelete(html);
+        bemPoolDelete(pool);
+    }
+
+    free(buffer);
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+
+    // TODO: Fix compiler warnings
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench-display"))
+        {
+            bemBenchDisplayList(5000);
+        }
+        else if (!strcmp(argv[i], "--bench-elements"))
+        {
+            bemBenchElementValue(1000000);
+        }
+        else if (!strcmp(argv[i], "--bench-font-new"))
+        {
+            bemBenchFontNew(10);
+        }
+        else if (!strcmp(argv[i], "--bench-fonts"))
+        {
+            bemBenchFontScan();
+        }
+        else if (!strcmp(argv[i], "--bench-table"))
+        {
+            bemBenchTableLayout(10000);
+        }
+        else if (!strcmp(argv[i], "--bench-text"))
+        {
+            bemBenchMeasureText(1000000);
+        }
+        else if (!strcmp(argv[i], "--bench-words"))
+        {
+            bemBenchWordCache(2000);
+        }
+        else if (!strcmp(argv[i], "--test"))
+        {
+            if (bemTestCSSFileFunctions() + bemTestCSSFunctions() + bemTestCSSMediaFunctions() + bemTestLayoutFunctions() + bemTestWordCacheFunctions())
+                return 1;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--bench-display] [--bench-elements] [--bench-font-new] [--bench-fonts] [--bench-table] [--bench-text] [--bench-words] [--test]\n", argv[0]);
+            return 1;
+        }
+    }
+
     return 0;
 }
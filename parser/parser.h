@@ -20,20 +20,63 @@
  * SOFTWARE.
  */
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <sys/stat.h>
+#include <limits.h>
 #include <locale.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
 #include <ctype.h>
 #include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <zlib.h>
 
 #define BEM_SHA3_256_SIZE 32
 #define BEM_SHA3_512_SIZE 64
 
+#define BEM_NODE_SLAB_SIZE 65536
+#define BEM_ELEMENT_NAME_MAX 10
+
+#define BEM_FONT_MAX_CHAR 262144
+#define BEM_FONT_CACHE_VERSION 2
+#define BEM_FONT_CACHE_NONE ((size_t)-1)
+#define BEM_FONT_METRICS_VERSION 2
+
+#define BEM_CSS_FILE_VERSION 4
+
+#define BEM_LAYOUT_MAX_DEPTH 256  // Deeper elements are not laid out
+#define BEM_LAYOUT_MAX_INLINES 16 // Deeper inline elements don't get fragments of their own
+
+#define BEM_DISPLAY_LIST_VERSION 1
+#define BEM_DISPLAY_STYLES 256 // Converted styles the display list builder keeps, a power of 2
+
+#define BEM_WORD_CACHE_SIZE 8192 // Measured words each pool keeps by default
+#define BEM_WORD_MAX_LENGTH 31   // Longer words are measured every time
+
+#define BEM_OFF_CMAP 0x636d6170 // 'cmap'
+#define BEM_OFF_HEAD 0x68656164 // 'head'
+#define BEM_OFF_HHEA 0x68686561 // 'hhea'
+#define BEM_OFF_HMTX 0x686d7478 // 'hmtx'
+#define BEM_OFF_MAXP 0x6d617870 // 'maxp'
+#define BEM_OFF_NAME 0x6e616d65 // 'name'
+#define BEM_OFF_OS_2 0x4f532f32 // 'OS/2'
+#define BEM_OFF_POST 0x706f7374 // 'post'
+#define BEM_OFF_TTCF 0x74746366 // 'ttcf'
+
 typedef enum
 {
     BEM_LOGOP_NONE,
@@ -202,6 +245,15 @@ typedef enum
     FLOAT_RIGHT
 } bem_float;
 
+typedef enum
+{
+    LAYOUT_BLOCK,        // Block-level box of an element
+    LAYOUT_INLINE,       // Fragment of an inline element on one line
+    LAYOUT_INLINE_BLOCK, // Atomic inline: inline-block, inline-table or a replaced element
+    LAYOUT_LINE,         // Line box of an inline formatting context
+    LAYOUT_TEXT          // Run of text on a line
+} bem_layout_type;
+
 typedef enum
 {
     LIST_STYLE_POSITION_INSIDE,
@@ -234,6 +286,15 @@ typedef enum
     OVERFLOW_AUTO
 } bem_overflow;
 
+typedef enum
+{
+    PAINT_RECT,   // Solid background color
+    PAINT_SHADOW, // Box shadow, painted before the background unless inset
+    PAINT_BORDER,
+    PAINT_IMAGE, // Background image or replaced image
+    PAINT_TEXT
+} bem_paint;
+
 typedef enum
 {
     TABLE_LAYOUT_AUTO,
@@ -457,6 +518,18 @@ typedef enum
     RESOLUTION_PER_CM
 } bem_resolution;
 
+typedef enum
+{
+    IMAGE_PROBE_SIGNATURE,
+    IMAGE_PROBE_PNG,
+    IMAGE_PROBE_BMP,
+    IMAGE_PROBE_BMP_RESOLUTION,
+    IMAGE_PROBE_WEBP,
+    IMAGE_PROBE_JPEG_MARKER,
+    IMAGE_PROBE_JPEG_JFIF,
+    IMAGE_PROBE_JPEG_SOF
+} bem_image_probe_state;
+
 typedef enum
 {
     MATCH_ATTRIBUTE_EXIST,
@@ -479,6 +552,13 @@ typedef enum
     RELATION_IMMEDIATE_SIBLING
 } bem_relation;
 
+typedef enum
+{
+    NODE_FLAG_NONE = 0,
+    NODE_FLAG_REFERENCE = 1, // String points at caller-owned text
+    NODE_FLAG_TERMINATED = 2 // Referenced text is followed by a nul
+} bem_node_flag;
+
 typedef unsigned char bem_uchar;
 
 typedef unsigned char bem_sha3_256[BEM_SHA3_256_SIZE];
@@ -502,7 +582,7 @@ typedef struct
     const char *name, *value;
 } bem_stylesheet_selector_statement;
 
-typedef struct
+typedef struct bem_stylesheet_selector
 {
     struct bem_stylesheet_selector *previous;
     bem_element element;
@@ -517,6 +597,8 @@ typedef struct
     bem_sha3_256 hash;
     bem_stylesheet_selector *selector;
     struct bem_dictionary *properties;
+    unsigned order; // Source order within the stylesheet, later rules win ties
+    unsigned condition; // Media condition the rule depends on, 0 for none
 } bem_rule_set;
 
 typedef struct
@@ -546,13 +628,96 @@ typedef struct
 } bem_media;
 
 typedef struct
+{
+    const char *name; // "min-width" and so on, evaluated by bemEvaluateMediaFeature()
+    const char *value;
+} bem_media_feature;
+
+typedef struct
+{
+    bool negate;
+    const char *type; // NULL for "all"
+
+    size_t feature_amount;
+    bem_media_feature *features;
+} bem_media_query;
+
+typedef struct
+{
+    const char *text; // Normalized query list, interned
+    unsigned parent; // Enclosing condition for nested blocks, 0 for none
+
+    size_t query_amount; // An empty list matches all media
+    bem_media_query *queries;
+} bem_media_condition;
+
+typedef struct bem_stylesheet
 {
     struct bem_memory_pool *pool;
+    const struct bem_stylesheet *parent; // Shared lower-priority layer, never modified
+    size_t references; // The owner plus one per layer on top
+    unsigned rule_order;
     bem_media media;
     bem_rule_collection all_rules;
     bem_rule_collection rules[ELEMENT_MAX];
+
+    bem_sha3_256 hash; // Chained hash of everything imported
+
+    void *mapping; // Read-only bemCSSLoad() file the rules live in
+    size_t mapping_size;
+
+    bool media_pruning; // Skip non-matching @media blocks while importing
+    size_t condition_amount;
+    size_t conditions_size;
+    bem_media_condition *conditions;
+
+    unsigned generation; // Changes whenever matching results can change
+    unsigned media_generation;
+    bool *media_active; // Condition results for every layer against this media, top layer first
 } bem_stylesheet;
 
+typedef struct
+{
+    char magic[8]; // "BEMCSS\0\0"
+    unsigned version;
+    unsigned short sizes[6]; // Pointer and structure sizes the tables were written with
+    bem_sha3_256 hash;
+    size_t size;
+
+    size_t rule_amount; // One dictionary per rule
+    size_t selector_amount;
+    size_t statement_amount;
+    size_t pair_amount;
+    size_t condition_amount;
+
+    // Table offsets, pointers inside the tables are stored as offsets from the start of the file
+    size_t rules;
+    size_t selectors;
+    size_t statements;
+    size_t dictionaries;
+    size_t pairs;
+    size_t all_rules;
+    size_t element_rules;
+    size_t conditions; // Text and parent of each media condition
+    size_t strings;
+
+    size_t element_starts[ELEMENT_MAX + 1]; // Range of each element in element_rules
+} bem_css_file_header;
+
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t data_size;
+
+    size_t amount; // Strings already written, keyed by pointer
+    size_t keys_size;
+    const char **keys;
+    size_t *offsets;
+
+    bool failed;
+} bem_css_strings;
+
 typedef struct
 {
     unsigned char bytes_used;
@@ -572,6 +737,29 @@ typedef struct
     bem_resolution units;
 } bem_image;
 
+typedef struct
+{
+    bem_image_probe_state state;
+    size_t offset; // Offset of the bytes wanted next
+    size_t length; // Number of bytes wanted at offset
+    size_t next;   // Offset of the JPEG marker after the current segment
+} bem_image_probe;
+
+typedef struct
+{
+    const char *url; // Resolved URL, interned
+    time_t mtime;
+    off_t size;
+    bool checked;     // File was stat'ed this session
+    bem_image *image; // NULL when the URL is not a supported image
+} bem_image_entry;
+
+typedef struct
+{
+    const char *text;                  // Style attribute value, interned
+    struct bem_dictionary *properties; // Shared between every element with this style, never modified
+} bem_inline_style;
+
 typedef struct
 {
     const char *key;
@@ -592,14 +780,63 @@ typedef struct
 
 typedef struct
 {
-    char font_url[380];
-    char font_family[128];
+    char magic[8];
+
+    unsigned version;
+    unsigned font_amount;
+    unsigned family_amount;
+    unsigned directory_amount;
+    unsigned file_amount;
+    unsigned strings_size;
+} bem_font_cache_header;
+
+typedef struct
+{
+    unsigned url;
+    unsigned family;
+    unsigned index;
+    unsigned file;
 
-    unsigned char font_style;
-    unsigned char font_index;
+    unsigned short weight;
+    unsigned char style;
+    unsigned char stretch;
+} bem_font_cache_record;
+
+typedef struct
+{
+    unsigned name;
+    unsigned first;
+    unsigned amount;
+} bem_font_cache_family;
 
-    unsigned short font_weight;
-} bem_font_cache;
+typedef struct
+{
+    unsigned path;
+    unsigned mtime;
+    unsigned first_file;
+    unsigned file_amount;
+    unsigned end;
+} bem_font_cache_directory;
+
+typedef struct
+{
+    unsigned path;
+    unsigned mtime;
+    unsigned size;
+} bem_font_cache_file;
+
+typedef struct
+{
+    char magic[8];
+
+    unsigned version;
+    unsigned index;
+    unsigned mtime;
+    unsigned size;
+    unsigned url_size;
+    unsigned page_amount;
+    unsigned glyph_page_amount;
+} bem_font_metrics_header;
 
 typedef struct
 {
@@ -618,10 +855,18 @@ typedef struct
     int max_char;
     int min_char;
 
-    size_t cmap_amount;
-    int *cmap;
+    unsigned short *glyphs[BEM_FONT_MAX_CHAR / 256];
+    struct bem_font_metric *widths[BEM_FONT_MAX_CHAR / 256];
 
-    struct bem_font_metric *widths[262144 / 256]; // TODO: Make constant for this
+    const bem_uchar *data;
+    size_t data_size;
+    unsigned cmap_offset, cmap_length;
+    unsigned hmtx_offset;
+    int num_glyphs, num_metrics;
+    bem_uchar loaded[BEM_FONT_MAX_CHAR / 256 / 8];
+
+    const bem_uchar *metrics;
+    size_t metrics_size;
 
     float units;
     float italic_angle;
@@ -635,6 +880,16 @@ typedef struct
     bem_font_style style;
 } bem_font;
 
+typedef struct
+{
+    bem_font_metrics_header header;
+    bem_font *font;
+    const char *url;
+
+    unsigned pages[BEM_FONT_MAX_CHAR / 256];       // Index of each width page plus one, 0 when the page is empty
+    unsigned glyph_pages[BEM_FONT_MAX_CHAR / 256]; // Same for the glyph pages
+} bem_font_metrics_file;
+
 typedef struct
 {
     const char *font_url;
@@ -651,16 +906,142 @@ typedef struct
 } bem_font_info;
 
 typedef struct
+{
+    unsigned key;
+    size_t index;
+} bem_font_face;
+
+typedef struct
+{
+    const char *family;
+    unsigned hash;
+
+    size_t first;
+    size_t amount;
+} bem_font_family;
+
+typedef struct
+{
+    const char *families;
+    unsigned key;
+
+    bem_font *font;
+} bem_font_match;
+
+typedef struct
+{
+    char *url;
+    time_t mtime;
+    off_t size;
+
+    bool reuse;
+    size_t cached;
+
+    size_t font_amount;
+    bem_font_info *fonts;
+} bem_font_scan;
+
+typedef struct
+{
+    char *path;
+    time_t mtime;
+
+    size_t first_scan;
+    size_t scan_amount;
+    size_t end;
+} bem_font_scan_directory;
+
+typedef struct
+{
+    bool changed;
+
+    size_t directory_amount;
+    size_t directories_size;
+    bem_font_scan_directory *directories;
+
+    size_t scan_amount;
+    size_t scans_size;
+    bem_font_scan *scans;
+
+    pthread_mutex_t mutex;
+    size_t next;
+    size_t queue_amount;
+    bem_font_scan **queue;
+} bem_font_scanner;
+
+typedef struct
+{
+    bem_font_scanner *scanner;
+    struct bem_memory_pool *pool;
+    pthread_t thread;
+} bem_font_worker;
+
+typedef struct
+{
+    const bem_font *font; // NULL when the entry is unused
+    float font_size;
+    float letter_spacing;
+    float word_spacing;
+    float width;
+
+    unsigned hash;
+    unsigned chain;        // Next entry in the same bucket, plus one
+    unsigned newer, older; // Neighbours in the LRU list, plus one
+
+    unsigned char length;
+    char word[BEM_WORD_MAX_LENGTH + 1];
+} bem_word_entry;
+
+typedef struct
+{
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t uncached; // Words too long for the cache
+} bem_word_stats;
+
+typedef struct bem_memory_pool
 {
     struct lconv *locale;
     size_t locale_decimal_length;
 
     bool fonts_loaded;
+    int font_threads;
+    const char *font_metrics;
     size_t font_amount;
     size_t fonts_size;
-    size_t font_index[256];
     bem_font_info *fonts;
 
+    size_t font_families_size;
+    bem_font_family *font_families;
+    bem_font_face *font_faces;
+
+    size_t font_match_amount;
+    size_t font_matches_size;
+    bem_font_match *font_matches;
+
+    const char *css_cache;
+
+    const bem_uchar *font_cache;
+    size_t font_cache_size;
+    bem_font **font_cache_fonts;
+
+    size_t image_amount;
+    size_t images_size;
+    bem_image_entry *images;
+
+    size_t inline_amount;
+    size_t inlines_size;
+    bem_inline_style *inlines;
+
+    size_t word_amount;
+    size_t words_size; // Maximum number of entries, 0 disables the cache
+    bem_word_entry *words;
+    unsigned *word_buckets; // First entry of each bucket plus one, words_size buckets
+    unsigned word_newest;   // Plus one
+    unsigned word_oldest;   // Plus one
+    bem_word_stats word_stats;
+
     size_t string_amount;
     size_t strings_size;
     char **strings;
@@ -674,7 +1055,7 @@ typedef struct
     char *last_error;
 } bem_memory_pool;
 
-typedef struct
+typedef struct bem_dictionary
 {
     bem_memory_pool *pool;
 
@@ -691,9 +1072,16 @@ typedef struct
     const char *property_name, *property_value;
 } bem_attribute_mapping;
 
+typedef struct
+{
+    size_t start; // First mapping of the element in the table sorted by element and attribute
+    size_t amount;
+} bem_attribute_range;
+
 typedef struct
 {
     int score;
+    int layer;
     int order;
 
     bem_rule_set *rule;
@@ -813,6 +1201,8 @@ typedef struct
     bem_caption_side caption_side;
     bem_empty_cells empty_cells;
     bem_table_layout table_layout;
+
+    bem_size border_spacing; // Horizontal and vertical spacing between cells, 0 when collapsed
 } bem_table;
 
 typedef struct
@@ -844,10 +1234,59 @@ typedef struct
 } bem_text;
 
 typedef struct
+{
+    size_t offset; // Byte offset of the break opportunity
+    float width;   // Width of the text before the offset
+} bem_text_break;
+
+typedef struct
+{
+    size_t node_amount;
+    size_t nodes_size;
+
+    struct bem_node **nodes;
+} bem_node_list;
+
+typedef struct
+{
+    const char *id;
+    struct bem_node *node;
+
+    size_t next;
+} bem_id_entry;
+
+typedef struct bem_node_slab
+{
+    struct bem_node_slab *next;
+
+    size_t used;
+    size_t size;
+
+    bem_uchar data[];
+} bem_node_slab;
+
+typedef struct bem_document
 {
     bem_memory_pool *pool;
     bem_stylesheet *css;
     struct bem_node *root;
+    const char *doctype;
+
+    bem_node_slab *slabs;
+    struct bem_node *free_nodes;
+
+    bool index_dirty;
+    unsigned index_order;
+    bem_node_list elements[ELEMENT_MAX];
+
+    unsigned css_generation; // Stylesheet generation the cached node properties are from
+
+    size_t id_amount;
+    size_t ids_size;
+    bem_id_entry *ids;
+
+    size_t id_buckets_size;
+    size_t *id_buckets;
 
     bem_error_callback error_callback;
     void *error_context;
@@ -856,9 +1295,10 @@ typedef struct
     void *url_context;
 } bem_document;
 
-typedef struct
+typedef struct bem_node
 {
     bem_element element;
+    unsigned short flags;
 
     struct bem_node *parent;
     struct bem_node *previous;
@@ -875,16 +1315,286 @@ typedef struct
 
             bem_dictionary *attributes;
             const bem_dictionary *base_properties;
+            unsigned long long inherited; // Bit i is set when bem_inherited_properties[i] of the base properties came from the parent
 
             bem_document *html;
+
+            unsigned order;
         } element;
 
         char string[1];
+
+        struct
+        {
+            const char *data;
+            size_t length;
+        } reference;
+
         char unknown[1];
     } value;
 } bem_node;
 
 typedef struct
+{
+    bem_node *root;
+    bem_node *next;
+
+    int depth;
+    int next_depth;
+} bem_node_iterator;
+
+typedef struct
+{
+    int depth;
+    bem_element element;
+
+    size_t next;
+    bem_node *node;
+} bem_flat_node;
+
+typedef struct
+{
+    size_t node_amount;
+    size_t nodes_size;
+
+    bem_flat_node *nodes;
+} bem_snapshot;
+
+typedef struct
+{
+    bem_display display;
+    const bem_dictionary *properties; // Computed properties the style was converted from
+    unsigned long long inherited;     // Which of them came from the parent, as in the node
+
+    bem_text text;
+
+    bem_rectangle margin; // Auto margins are 0 and flagged in auto_margins
+    bem_rectangle border; // Border widths, 0 when the border style is none
+    bem_rectangle padding;
+    bem_size size; // Content size, negative for auto
+
+    unsigned char auto_margins; // 1 = left, 2 = right
+} bem_layout_style;
+
+typedef struct bem_layout_box
+{
+    bem_layout_type type;
+    bem_node *node; // Element or string the box was generated for, NULL for lines
+    const bem_layout_style *style;
+
+    struct bem_layout_box *parent;
+    struct bem_layout_box *first_child;
+    struct bem_layout_box *last_child;
+    struct bem_layout_box *next;
+
+    float x, y; // Border box in document coordinates
+    float width, height;
+    float baseline; // Distance from y to the baseline for boxes on a line
+
+    float overflow_x, overflow_y; // Bounds of the box, its descendants and their outer shadows
+    float overflow_width, overflow_height;
+
+    const char *text; // Text runs, into a copy with white space collapsed
+    size_t length;
+} bem_layout_box;
+
+typedef struct
+{
+    double style;  // Computing and converting element styles
+    double text;   // Collapsing, measuring and breaking text
+    double layout; // Building and positioning everything else
+    double total;
+} bem_layout_timings;
+
+typedef struct
+{
+    bem_document *html;
+    bem_node_slab *slabs; // Arena for every box, style and text copy
+
+    bem_layout_box *root; // Initial containing block
+    float width, height;
+
+    size_t box_amount;
+    size_t style_amount;
+    size_t styles_shared; // Elements that reused the previous sibling's converted style
+    int depth;
+
+    bem_layout_timings timings;
+} bem_layout;
+
+typedef struct
+{
+    bem_node *node;
+    const bem_layout_style *style;
+    bem_layout_box *box; // Fragment on the current line, NULL until content needs one
+    bool started;        // The first fragment, which gets the left edges, exists
+} bem_layout_inline;
+
+typedef struct
+{
+    bem_layout_box *block; // Box whose content area the flow fills
+    float left, width;     // Content area
+    float y;               // Top of the next line or block
+    float margin;          // Bottom margin of the previous block, collapses with the next top margin
+    float right;           // Right edge of the widest content, for shrink-to-fit
+
+    bem_layout_box *line; // Open line box
+    bem_layout_box *run;  // Text run the next word can extend
+    float line_x;         // Where the next inline content goes
+    float above, below;   // Line box extent around the baseline so far
+    bool content;         // Something was placed on the line
+    bool space;           // A collapsed space goes before the next word
+    bool first_line;      // text-indent still applies
+
+    int inline_depth;
+    bem_layout_inline inlines[BEM_LAYOUT_MAX_INLINES];
+} bem_layout_flow;
+
+typedef struct
+{
+    float min;   // Widest unbreakable content
+    float max;   // Widest content without wrapping
+    float line;  // Current line at the maximum width
+    float cells; // Minimum widths of the cells in the current table row
+    bool space;  // A collapsed space goes before the next word
+} bem_layout_intrinsic;
+
+typedef struct
+{
+    bem_node *node;
+    const bem_layout_style *style;
+    bem_layout_box *box;
+
+    size_t row;
+    size_t column;
+    size_t colspan;
+    size_t rowspan;
+
+    float min, max; // Intrinsic border box widths, only measured for auto layout
+    float content;  // Height of the laid out content
+} bem_layout_cell;
+
+typedef struct
+{
+    float min, max; // Cached from the cells, spanning cells spread their excess over their columns
+    float width;    // Used width
+    float x;        // Left border edge of the column's cells
+} bem_layout_column;
+
+typedef struct
+{
+    bem_node *node;
+    const bem_layout_style *style;
+
+    size_t first_cell;
+    size_t cell_amount;
+} bem_layout_row;
+
+typedef struct
+{
+    bem_table table;
+    bool fixed;  // table-layout: fixed with a specified width, widths come from the first row
+    float width; // What percentages of cells and columns are relative to
+
+    size_t row_amount;
+    size_t rows_size;
+    bem_layout_row *rows;
+
+    size_t cell_amount;
+    size_t cells_size;
+    bem_layout_cell *cells;
+
+    size_t column_amount;
+    size_t columns_size;
+    bem_layout_column *columns;
+    size_t *spans;    // Rows each column is still covered for by a rowspan, columns_size entries
+    size_t group_row; // First row of the current row group
+} bem_layout_table;
+
+typedef struct
+{
+    unsigned char type;      // bem_paint
+    unsigned char styles[4]; // Border styles in top, right, bottom, left order, inset for shadows, repeat for images
+    int z_index;             // Items are sorted by z-index and otherwise in painting order
+
+    float x, y; // Bounds in document coordinates, shadows include the blur
+    float width, height;
+
+    unsigned colors[4]; // 0xRRGGBBAA, borders have one per side
+    float values[4];    // Border widths, shadow offsets, blur and spread, image origin, text size, baseline and spacing
+    float radii[8];     // Horizontal and vertical radius of each corner, clockwise from top left
+
+    unsigned font;   // Text runs, index into the font table or (unsigned)-1 without a font
+    unsigned string; // Offset of the text or URL in the strings
+    unsigned length;
+} bem_display_item;
+
+typedef struct
+{
+    unsigned family; // Offsets in the strings
+    unsigned postscript_name;
+
+    unsigned short weight;
+    unsigned char style;
+    unsigned char stretch;
+} bem_display_font;
+
+typedef struct
+{
+    char magic[8]; // "BEMDL\0\0\0", followed by the items, fonts and strings
+
+    unsigned version;
+    unsigned item_amount;
+    unsigned font_amount;
+    unsigned strings_size;
+
+    float x, y; // Viewport the items were culled to
+    float width, height;
+} bem_display_list_header;
+
+typedef struct
+{
+    bem_layout *layout;
+    float x, y; // Viewport, items outside of it are culled
+    float width, height;
+
+    size_t item_amount;
+    size_t items_size;
+    bem_display_item *items;
+
+    size_t font_amount;
+    size_t fonts_size;
+    bem_font **fonts;
+    bem_display_font *font_records;
+
+    size_t strings_length; // Every string is nul-terminated
+    size_t strings_size;
+    char *strings;
+
+    const bem_layout_box *line; // Line of the last text run, runs only merge within a line
+
+    size_t culled;  // Items outside the viewport
+    size_t skipped; // Boxes whose whole subtree is outside the viewport
+    size_t merged; // Rects and text runs merged into the item before them
+    bool sort;     // Some item has a z-index
+    bool failed;
+} bem_display_list;
+
+typedef struct
+{
+    const bem_dictionary *properties; // Interned properties the box was converted from, equal pairs paint the same
+    unsigned hash;
+    bem_box box;
+    bool visible;
+} bem_display_style;
+
+typedef struct
+{
+    int z_index;
+    size_t index;
+} bem_display_order;
+
+typedef struct bem_font_metric
 {
     short width;
     short left_bearing;
@@ -904,6 +1614,13 @@ typedef struct
     bem_off_dir *entries;
 } bem_off_table;
 
+typedef struct
+{
+    const bem_uchar *data;
+    unsigned length;
+    bem_uchar *buffer;
+} bem_off_span;
+
 typedef struct
 {
     unsigned short platform_id, encoding_id, language_id, name_id;
@@ -963,11 +1680,19 @@ typedef struct
     unsigned is_fixed_pitch;
 } bem_off_post;
 
+typedef struct
+{
+    const void *data; // NULL ends a list of spans
+    size_t length;
+} bem_write_span;
+
 typedef int (*bem_comparison_function)(const void *, const void *);
+typedef bool (*bem_write_function)(void *context, FILE *fp);
 
 extern bool bemDefaultErrorCallback(void *context, const char *message, int line_number);
 extern char *bemDefaultURLCallback(void *context, const char *url, char *buffer, size_t buffer_size);
 
+extern const bem_dictionary *bemCSSGetInlineProperties(bem_stylesheet *css, const char *str);
 extern void bemCSSImportString(bem_stylesheet *css, bem_dictionary *properties, const char *str);
 extern void bemCSSSelectorAddStatement(bem_stylesheet *css, bem_stylesheet_selector *selector, bem_match match, const char *name, const char *value);
 extern void bemCSSSelectorDelete(bem_stylesheet_selector *selector);
@@ -978,15 +1703,19 @@ extern void bemRuleCollectionAdd(bem_stylesheet *css, bem_rule_collection *colle
 extern void bemRuleCollectionClear(bem_rule_collection *collection, int delete_rules);
 extern bem_rule_set *bemRuleCollectionFindHash(bem_rule_collection *collection, const bem_sha3_256 hash);
 extern void bemRuleDelete(bem_rule_set *rule);
-extern bem_rule_set *bemRuleNew(bem_stylesheet *css, const bem_sha3_512 hash, bem_stylesheet_selector *selector, bem_dictionary *properties);
+extern bem_rule_set *bemRuleNew(bem_stylesheet *css, const bem_sha3_256 hash, bem_stylesheet_selector *selector, bem_dictionary *properties);
 
 extern void bemCSSDelete(bem_stylesheet *css);
 extern bem_stylesheet *bemCSSNew(bem_memory_pool *pool);
+extern bem_stylesheet *bemCSSNewLayer(bem_stylesheet *parent);
 extern bool bemCSSImport(bem_stylesheet *css, bem_file *file);
 extern bool bemCSSImportDefault(bem_stylesheet *css);
+extern bem_stylesheet *bemCSSLoad(bem_memory_pool *pool, const char *filename, const bem_sha3_256 hash);
+extern bool bemCSSSave(bem_stylesheet *css, const char *filename);
 extern void bemCSSSetErrorCallback(bem_stylesheet *css, bem_error_callback callback, void *context);
 extern void bemCSSSetURLCallback(bem_stylesheet *css, bem_url_callback callback, void *context);
 extern int bemCSSSetMedia(bem_stylesheet *css, const char *type, int color_bits, int grayscale_bits, float width, float height);
+extern void bemCSSSetMediaPruning(bem_stylesheet *css, bool prune);
 
 extern bem_dictionary *bemDictionaryCopy(const bem_dictionary *dictionary);
 extern void bemDictionaryDelete(bem_dictionary *dictionary);
@@ -1015,21 +1744,32 @@ extern int bemImageGetHeight(bem_image *image);
 extern bem_size bemImageGetSize(bem_image *image);
 extern int bemImageGetWidth(bem_image *image);
 extern bem_image *bemImageNew(bem_memory_pool *pool, bem_file *file);
+extern bem_image *bemImageNewBuffer(bem_memory_pool *pool, const void *buffer, size_t bytes, size_t *needed);
 
 extern void bemPoolDelete(bem_memory_pool *pool);
+extern bem_image *bemPoolGetImage(bem_memory_pool *pool, const char *url, const char *base_url);
 extern const char *bemPoolGetLastError(bem_memory_pool *pool);
 extern const char *bemPoolGetString(bem_memory_pool *pool, const char *str);
 extern const char *bemPoolGetURL(bem_memory_pool *pool, const char *url, const char *base_url);
+extern const bem_word_stats *bemPoolGetWordStats(bem_memory_pool *pool);
+extern bool bemPoolLoadImages(bem_memory_pool *pool, const char *filename);
+extern float bemPoolMeasureWord(bem_memory_pool *pool, const bem_text *text, const char *word, size_t length);
 extern bem_memory_pool *bemPoolNew(void);
+extern bool bemPoolSaveImages(bem_memory_pool *pool, const char *filename);
+extern void bemPoolSetCSSCache(bem_memory_pool *pool, const char *directory);
 extern void bemPoolSetErrorCallback(bem_memory_pool *pool, bem_error_callback callback, void *context);
+extern void bemPoolSetFontMetrics(bem_memory_pool *pool, const char *directory);
+extern void bemPoolSetFontThreads(bem_memory_pool *pool, int threads);
 extern void bemPoolSetURLCallback(bem_memory_pool *pool, bem_url_callback callback, void *context);
+extern void bemPoolSetWordCache(bem_memory_pool *pool, size_t size);
 
 extern void bemSHA3Final(bem_sha3 *context, unsigned char *hash, size_t hash_length);
 extern void bemSHA3Init(bem_sha3 *context);
 extern void bemSHA3Update(bem_sha3 *context, const void *data, size_t data_length);
 
 extern void bemFontAddCached(bem_memory_pool *pool, bem_font *font, const char *url);
-extern int bemFontComputeExtents(const bem_font *font, float size, const char *str, bem_rectangle *extents);
+extern size_t bemFontBreakLines(bem_font *font, const bem_text *text, const char *str, float width, bem_text_break *lines, size_t max_lines);
+extern int bemFontComputeExtents(bem_font *font, float size, const char *str, bem_rectangle *extents);
 extern void bemFontDelete(bem_font *font);
 extern bem_font *bemFontFindCached(bem_memory_pool *pool, const char *family, bem_font_stretch stretch, bem_font_style style, bem_font_variant variant, bem_font_weight weight);
 extern int bemFontGetAscent(bem_font *font);
@@ -1037,12 +1777,12 @@ extern bem_rectangle *bemFontGetBounds(bem_font *font, bem_rectangle *bounds);
 extern bem_font *bemFontGetCached(bem_memory_pool *pool, size_t index);
 extern size_t bemFontGetCachedCount(bem_memory_pool *pool);
 extern int bemFontGetCapHeight(bem_font *font);
-extern const int *bemFontGetCMap(bem_font *font, size_t *num_cmap);
 extern const char *bemFontGetCopyright(bem_font *font);
 extern int bemFontGetDescent(bem_font *font);
 extern bem_rectangle *bemFontGetExtents(bem_font *font, float size, const char *str, bem_rectangle *extents);
 extern const char *bemFontGetFamily(bem_font *font);
 extern size_t bemFontGetFontAmount(bem_font *font);
+extern int bemFontGetGlyph(bem_font *font, int ch);
 extern const char *bemFontGetPostScriptName(bem_font *font);
 extern bem_font_style bemFontGetStyle(bem_font *font);
 extern const char *bemFontGetVersion(bem_font *font);
@@ -1050,10 +1790,12 @@ extern bem_font_weight bemFontGetWeight(bem_font *font);
 extern int bemFontGetWidth(bem_font *font, int ch);
 extern int bemFontGetXHeight(bem_font *font);
 extern bool bemFontIsFixedPitch(bem_font *font);
+extern size_t bemFontMeasureText(bem_font *font, const bem_text *text, const char *str, bem_text_break *breaks, size_t max_breaks, float *width);
 extern bem_font *bemFontNew(bem_memory_pool *pool, bem_file *file, size_t index);
 
 extern const char *bemElementString(bem_element element);
 extern bem_element bemElementValue(const char *str);
+extern bem_element bemElementValueN(const char *str, size_t length);
 extern void bemHTMLDelete(bem_document *html);
 extern bem_node *bemHTMLFindNode(bem_document *html, bem_node *current, bem_element element, const char *id);
 extern bem_stylesheet *bemHTMLGetCSS(bem_document *html);
@@ -1088,6 +1830,24 @@ extern const char *bemNodeGetString(bem_node *node);
 extern bem_node *bemNodeNewComment(bem_node *parent, const char *c);
 extern bem_node *bemNodeNewElement(bem_node *parent, bem_element element);
 extern bem_node *bemNodeNewString(bem_node *parent, const char *s);
+extern bem_node *bemNodeNewStringReference(bem_node *parent, const char *s, size_t length);
+
+extern void bemSnapshotDelete(bem_snapshot *snapshot);
+extern size_t bemSnapshotGetCount(bem_snapshot *snapshot);
+extern const bem_flat_node *bemSnapshotGetNodes(bem_snapshot *snapshot);
+extern bem_snapshot *bemSnapshotNew(bem_node *root);
+
+extern void bemLayoutDelete(bem_layout *layout);
+extern const bem_layout_box *bemLayoutGetRoot(bem_layout *layout);
+extern const bem_layout_timings *bemLayoutGetTimings(bem_layout *layout);
+extern bem_layout *bemLayoutNew(bem_document *html, float width);
+
+extern void bemDisplayListDelete(bem_display_list *list);
+extern bem_font *bemDisplayListGetFont(bem_display_list *list, unsigned index);
+extern const bem_display_item *bemDisplayListGetItems(bem_display_list *list, size_t *amount);
+extern const char *bemDisplayListGetString(bem_display_list *list, unsigned offset);
+extern bem_display_list *bemDisplayListNew(bem_layout *layout, float x, float y, float width, float height);
+extern void *bemDisplayListSerialize(bem_display_list *list, size_t *size);
 
 extern bool bemFileError(bem_file *file, const char *message, ...);
 
@@ -1096,47 +1856,123 @@ extern bool bemPoolErrorv(bem_memory_pool *pool, int line_number, const char *me
 
 extern void bemPoolDeleteFonts(bem_memory_pool *pool);
 
-static int bemCompareMatches(bem_match *a, bem_match *b);
+static void bemApplyMappings(bem_node *node, bem_dictionary *properties);
+static int bemCompareMatches(bem_stylesheet_match *a, bem_stylesheet_match *b);
 static const bem_dictionary *bemCreateProperties(bem_node *node, bem_compute compute);
+static void bemGetBorder(bem_memory_pool *pool, bem_stylesheet *css, const char *value, const bem_color *current, bem_border_properties *border, int which);
 static bool bemGetColor(bem_memory_pool *pool, const char *value, bem_color *color);
-static float bemGetLength(bem_memory_pool *pool, const char *value, float max_value, float multiplier, bem_stylesheet *css, bem_text *text);
+static const char *bemGetImageURL(bem_memory_pool *pool, const char *value);
+static float bemGetLength(bem_memory_pool *pool, const char *value, float max_value, float multiplier, bem_stylesheet *css, const bem_text *text);
+static bool bemMatchMedia(bem_stylesheet *css, const bem_media_condition *condition);
 static int bemMatchNode(bem_node *node, bem_stylesheet_selector *selector, const char *pseudo_class);
+static bool bemMatchNth(const char *expression, int position);
 static int bemMatchRule(bem_node *node, bem_rule_set *rule, const char *pseudo_class);
+static bool bemMatchWord(const char *list, const char *word);
 static double bemStrtod(bem_memory_pool *pool, const char *str, char **end);
-
-static void bemAddRule(bem_stylesheet *css, bem_stylesheet_selector *selector, bem_dictionary *properties);
-static int bemEvaluateMedia(bem_stylesheet *css, bem_file *file, bem_type *type, char *buffer, size_t buffer_size);
+static void bemUpdateMedia(bem_stylesheet *css);
+
+static unsigned bemAddMedia(bem_stylesheet *css, bem_media_condition *condition);
+static void bemAddRule(bem_stylesheet *css, bem_stylesheet_selector *selector, bem_dictionary *properties, unsigned condition);
+static size_t bemAddString(bem_css_strings *strings, const char *str);
+static void bemClearMedia(bem_media_condition *condition);
+static bem_stylesheet_selector *bemCopySelector(bem_stylesheet *css, const bem_stylesheet_selector *selector);
+static bool bemEvaluateMediaFeature(bem_stylesheet *css, const char *name, const char *value);
+static bem_inline_style *bemFindInlineStyle(bem_memory_pool *pool, const char *text);
+static bool bemImportStylesheet(bem_stylesheet *css, bem_file *file, int depth, unsigned condition);
+static bool bemMapCSS(bem_stylesheet *css, const char *filename, const bem_uchar *hash);
+static void bemParseInlineStyle(bem_memory_pool *pool, const char *str, bem_dictionary *properties);
+static bool bemParseInlineValue(const char **str, char *buffer, size_t buffer_size);
+static int bemPeek(bem_file *file);
 static char *bemRead(bem_file *file, bem_type *type, char *buffer, size_t buffer_size);
+static bool bemReadMedia(bem_stylesheet *css, bem_file *file, bem_type *type, char *buffer, size_t buffer_size, bem_media_condition *condition);
 static bem_dictionary *bemReadProperties(bem_stylesheet *css, bem_file *file, bem_dictionary *properties);
+static bool bemReadRules(bem_stylesheet *css, bem_file *file, int depth, unsigned condition);
 static bem_stylesheet_selector *bemReadSelector(bem_stylesheet *css, bem_file *file, bem_type *type, char *buffer, size_t buffer_size);
 static char *bemReadValue(bem_file *file, char *buffer, size_t buffer_size);
+static void *bemRelocateCSS(bem_uchar *map, const void *pointer, size_t table, size_t amount, size_t size, bool *valid);
+static void bemSetProperty(bem_dictionary *properties, const char *name, const char *value);
+static bool bemSkipBlock(bem_file *file);
+static const char *bemSkipInlineSpace(const char *str);
+static void bemUnmapCSS(bem_stylesheet *css);
 
 static int bemCompareRules(bem_rule_set **a, bem_rule_set **b);
 static int bemComparePairs(bem_pair *a, bem_pair *b);
 
-static void bemAddFont(bem_memory_pool *pool, bem_font *font, const char *url, bool delete_it);
+static bem_word_entry *bemFindWord(bem_memory_pool *pool, const bem_text *text, const char *word, size_t length, unsigned hash);
+
+static void bemSHA3Permute(bem_uchar *state);
+
+static bem_image_entry *bemFindImage(bem_memory_pool *pool, const char *url);
+static int bemImageProbe(bem_image_probe *probe, bem_image *image, const bem_uchar *data);
+static bool bemWriteImages(bem_memory_pool *pool, FILE *fp);
+
+static void bemAddFont(bem_memory_pool *pool, bem_font *font, const char *url);
+static void bemAddFontInfo(bem_memory_pool *pool, const bem_font_info *font_info);
+static void bemAddScan(bem_memory_pool *pool, bem_font_scanner *scanner, const char *url, struct stat *info, size_t cached);
+static void bemAddTextBreak(bem_text_break *breaks, size_t max_breaks, size_t *num_breaks, size_t offset, float width);
+static int bemCompareFaces(bem_font_face *a, bem_font_face *b);
 static int bemCompareInfo(bem_font_info *a, bem_font_info *b);
+static int bemCompareNames(char **a, char **b);
+static int bemCompareScanURLs(bem_font_scan **a, bem_font_scan **b);
+static int bemCompareScans(bem_font_scan **a, bem_font_scan **b);
+static void bemDeleteFontIndex(bem_memory_pool *pool);
+static void bemDeleteScanner(bem_font_scanner *scanner);
+static size_t bemFindFace(const bem_font_face *faces, size_t left, size_t right, unsigned key);
+static bem_font_family *bemFindFamily(bem_font_family *families, size_t families_size, const char *family, bool create);
+static bem_font *bemFindFont(bem_memory_pool *pool, const char *family, bem_font_stretch stretch, bem_font_style style, int weight);
+static bem_font *bemFindFontList(bem_memory_pool *pool, const char *families, bem_font_stretch stretch, bem_font_style style, bem_font_weight weight);
+static unsigned bemFontFamilyHash(const char *family);
+static void bemFontLoadPage(bem_font *font, int block);
+static int bemFontNextChar(const char **str);
+static bem_font *bemFontRead(bem_memory_pool *pool, bem_file *file, size_t index, const bem_uchar *data, size_t data_size);
+static void bemFontSetGlyph(bem_font *font, int ch, int glyph);
+static void bemFontUnloadPage(bem_font *font, int block);
 static void bemGetCname(char *cname, size_t cname_size);
+static size_t bemGetFontDirectories(char directories[][1024], size_t max_directories);
+static void bemIndexFonts(bem_memory_pool *pool);
 static void bemLoadAllFonts(bem_memory_pool *pool);
 static bool bemLoadCache(bem_memory_pool *pool, const char *cname, struct stat *cinfo);
-static time_t bemLoadFonts(bem_memory_pool *pool, const char *d, bool scan_only);
-static void bemSaveCache(bem_memory_pool *pool, const char *cname);
+static void bemLoadFonts(bem_memory_pool *pool, const char *d, bem_font_scanner *scanner, size_t cached);
+static bool bemMapFontMetrics(bem_font *font, const char *mname, const char *url, struct stat *info);
+static const bem_font_face *bemMatchFace(const bem_font_face *faces, size_t amount, bem_font_stretch stretch, bem_font_style style, int weight);
+static bem_font *bemOpenFont(bem_memory_pool *pool, const char *url, size_t index);
+static void bemParseFonts(bem_memory_pool *pool, bem_font_scanner *scanner);
+static void bemSaveCache(bem_memory_pool *pool, const char *cname, bem_font_scanner *scanner);
+static bool bemScanAllFonts(bem_memory_pool *pool, bem_font_scanner *scanner);
+static void *bemScanFonts(void *data);
+static void bemShareFontMetrics(bem_memory_pool *pool, bem_font *font, const char *url);
 static void bemSortFonts(bem_memory_pool *pool);
+static bool bemWriteFontMetrics(bem_font_metrics_file *metrics, FILE *fp);
 
+static void *bemHtmlAllocate(bem_document *html, size_t size);
+static const char *bemHtmlGetText(bem_node *node, size_t *length);
 static bem_node *bemHtmlWalkNext(bem_node *current);
 static int bemHtmlParseAttribute(bem_file *file, int ch, bem_node *node);
 static bool bemHtmlParseComment(bem_file *file, bem_node **parent);
 static bool bemHtmlParseDoctype(bem_file *file, bem_document *html, bem_node **parent);
 static bool bemHtmlParseElement(bem_file *file, int ch, bem_document *html, bem_node **parent);
 static bool bemHtmlParseUnknown(bem_file *file, bem_node **parent, const char *unknown);
-static void bemHtmlDelete(bem_node *node);
+static void bemHtmlDelete(bem_document *html, bem_node *node);
+static void bemHtmlIndexAdd(bem_document *html, bem_node *node);
+static void bemHtmlIndexAddId(bem_document *html, bem_node *node, const char *id);
+static unsigned bemHtmlIndexHash(const char *id);
+static void bemHtmlIndexRebuild(bem_document *html);
 static bem_node *bemHtmlNew(bem_node *parent, bem_element element, const char *str);
 static void bemHtmlRemove(bem_node *node);
 
-static int bemCompareStrings(char **a, char **b);
-
 static const char *bemCopyName(bem_memory_pool *pool, bem_off_names *names, unsigned name_id);
-static int bemReadCmap(bem_file *file, bem_off_table *table, int **cmap);
+static int bemDecodeShort(const bem_uchar *data);
+static unsigned bemDecodeUlong(const bem_uchar *data);
+static int bemDecodeUshort(const bem_uchar *data);
+static unsigned bemFindCmap(const bem_off_span *cmap);
+static bem_off_dir *bemFindTable(bem_off_table *table, unsigned tag);
+static void bemFreeTable(bem_off_span *span);
+static int bemLoadShort(const bem_off_span *span, unsigned offset);
+static bool bemLoadTable(bem_file *file, bem_off_table *table, unsigned tag, bem_off_span *span);
+static unsigned bemLoadUlong(const bem_off_span *span, unsigned offset);
+static int bemLoadUshort(const bem_off_span *span, unsigned offset);
+static int bemReadCmap(bem_file *file, bem_off_table *table, unsigned short **glyphs);
+static int bemReadCmapSubtable(const bem_off_span *subtable, unsigned short **glyphs);
 static bool bemReadHead(bem_file *file, bem_off_table *table, bem_off_head *head);
 static bool bemReadHhea(bem_file *file, bem_off_table *table, bem_off_hhea *hhea);
 static bem_font_metric *bemReadHmtx(bem_file *file, bem_off_table *table, bem_off_hhea *hhea);
@@ -1144,12 +1980,158 @@ static int bemReadMaxp(bem_file *file, bem_off_table *table);
 static bool bemReadNames(bem_file *file, bem_off_table *table, bem_off_names *names);
 static bool bemReadOs2(bem_file *file, bem_off_table *table, bem_off_os_2 *os_2);
 static bool bemReadPost(bem_file *file, bem_off_table *table, bem_off_post *post);
-static int bemReadShort(bem_file *file);
 static bool bemReadTable(bem_file *file, size_t index, bem_off_table *table, size_t *num_fonts);
-static unsigned bemReadUlong(bem_file *file);
-static int bemReadUshort(bem_file *file);
-static unsigned bemSeekTable(bem_file *file, bem_off_table *table, unsigned tag, unsigned offset);
+static bool bemSetGlyph(unsigned short **glyphs, int ch, unsigned glyph);
+
+static bem_layout_box *bemLayoutAddBox(bem_layout *layout, bem_layout_box *parent, bem_layout_type type, bem_node *node, const bem_layout_style *style);
+static void *bemLayoutAllocate(bem_layout *layout, size_t size);
+static void bemLayoutAppend(bem_layout_box *parent, bem_layout_box *box);
+static void bemLayoutAtomic(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style);
+static bem_layout_box *bemLayoutBlock(bem_layout *layout, bem_layout_flow *flow, bem_layout_box *box, bem_node *node, const bem_layout_style *style);
+static void bemLayoutBorder(bem_layout *layout, const bem_dictionary *properties, const bem_text *text, bem_rectangle *border);
+static void bemLayoutChildren(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style);
+static void bemLayoutEdges(bem_layout *layout, const bem_dictionary *properties, const char *name, float width, const bem_text *text, bem_rectangle *edges, unsigned char *auto_sides);
+static void bemLayoutFinishLine(bem_layout_flow *flow);
+static void bemLayoutInline(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style);
+static void bemLayoutIntrinsic(bem_layout *layout, bem_node *node, const bem_layout_style *style, bem_layout_intrinsic *intrinsic);
+static float bemLayoutMeasure(const bem_layout_style *style, const char *start, const char *end);
+static void bemLayoutMetrics(const bem_layout_style *style, float *above, float *below, float *ascent);
+static void bemLayoutMove(bem_layout_box *box, float dx, float dy);
+static bem_layout_box *bemLayoutOpenLine(bem_layout *layout, bem_layout_flow *flow);
+static void bemLayoutOverflow(bem_layout_box *box);
+static void bemLayoutPlace(bem_layout_box *box, float baseline, float shift);
+static bool bemLayoutReplaced(bem_layout *layout, bem_node *node, const bem_layout_style *style, bem_size *size);
+static const bem_layout_style *bemLayoutStyle(bem_layout *layout, bem_node *node, const bem_layout_style *parent, const bem_layout_style *previous, float width);
+static void bemLayoutTable(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style);
+static bool bemLayoutTableAddRow(bem_layout *layout, bem_layout_table *table, bem_node *node, const bem_layout_style *style);
+static void bemLayoutTableAlign(bem_layout_cell *cell, float bottom);
+static void bemLayoutTableCaptions(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style, bool bottom, float width);
+static bool bemLayoutTableColumns(bem_layout_table *table, size_t amount);
+static void bemLayoutTableEndGroup(bem_layout_table *table);
+static void bemLayoutTableRows(bem_layout *layout, bem_layout_table *table, bem_node *node, const bem_layout_style *style, int pass);
+static void bemLayoutTableWidths(bem_layout_table *table, float width, float available, float spacing);
+static void bemLayoutText(bem_layout *layout, bem_layout_flow *flow, bem_node *node, const bem_layout_style *style);
+static double bemLayoutTime(void);
+static size_t bemLayoutTokens(const char *value, char *buffer, size_t buffer_size, const char **tokens, size_t max_tokens);
+static const char *bemLayoutValue(const bem_layout_style *style, const char *key);
+
+static bem_display_item *bemDisplayListAdd(bem_display_list *list, bem_paint type, int z_index, float x, float y, float width, float height);
+static void bemDisplayListBox(bem_display_list *list, bem_display_style *styles, const bem_layout_box *box, int z_index, int phase);
+static unsigned bemDisplayListColor(const bem_color *color);
+static int bemDisplayListCompare(bem_display_order *a, bem_display_order *b);
+static void bemDisplayListCorners(bem_display_item *item, const bem_border_radius *radius);
+static unsigned bemDisplayListFont(bem_display_list *list, bem_font *font);
+static bool bemDisplayListJoin(bem_display_item *item, int z_index, unsigned rgba, float x, float y, float width, float height);
+static bool bemDisplayListNear(float a, float b);
+static void bemDisplayListRect(bem_display_list *list, int z_index, float x, float y, float width, float height, const bem_color *color, const bem_border_radius *radius);
+static void bemDisplayListShadow(bem_display_list *list, int z_index, const bem_layout_box *box, const bem_box *paint);
+static unsigned bemDisplayListString(bem_display_list *list, const char *str, size_t length);
+static void bemDisplayListText(bem_display_list *list, const bem_layout_box *box, int z_index);
+
+static bool bemWriteFile(const char *filename, bem_write_function callback, void *context);
+static bool bemWriteSpans(const bem_write_span *spans, FILE *fp);
 
 static bool bemErrorCallback(void *context, const char *message, int line_number);
+static int bemTestCSSFileFunctions(void);
+static int bemTestCSSFunctions(void);
+static int bemTestCSSMediaFunctions(void);
+static int bemTestLayoutFunctions(void);
 static int bemTestPoolFunctions(bem_memory_pool *pool);
 static int bemTestSha3Functions(void);
+static int bemTestWordCacheFunctions(void);
+
+static int bemCompareElementNames(const char **a, const char **b);
+static void bemBenchDisplayList(size_t paragraphs);
+static void bemBenchElementValue(int iterations);
+static void bemBenchFontNew(int iterations);
+static void bemBenchFontScan(void);
+static void bemBenchMeasureText(int iterations);
+static void bemBenchTableLayout(size_t rows);
+static void bemBenchWordCache(size_t paragraphs);
+
+static inline void bemNodeIteratorInit(bem_node_iterator *iterator, bem_node *root)
+{
+    iterator->root = root;
+    iterator->next = root;
+    iterator->depth = 0;
+    iterator->next_depth = 0;
+}
+
+static inline bem_node *bemNodeIteratorAdvance(bem_node_iterator *iterator, bem_node *node, bool descend)
+{
+    if (descend && node->element >= ELEMENT_DOCTYPE && node->value.element.first_child)
+    {
+        iterator->next_depth = iterator->depth + 1;
+        return node->value.element.first_child;
+    }
+
+    for (iterator->next_depth = iterator->depth; node != iterator->root; node = node->parent, iterator->next_depth--)
+    {
+        if (node->next)
+            return node->next;
+    }
+
+    return NULL;
+}
+
+static inline bem_node *bemNodeIteratorNextPreOrder(bem_node_iterator *iterator)
+{
+    bem_node *node;
+
+    if ((node = iterator->next) != NULL)
+    {
+        iterator->depth = iterator->next_depth;
+        iterator->next = bemNodeIteratorAdvance(iterator, node, true);
+    }
+
+    return node;
+}
+
+static inline void bemNodeIteratorSkipChildren(bem_node_iterator *iterator, bem_node *node)
+{
+    // Only valid for the node most recently returned by bemNodeIteratorNextPreOrder
+    iterator->next = bemNodeIteratorAdvance(iterator, node, false);
+}
+
+static inline void bemNodeIteratorInitPostOrder(bem_node_iterator *iterator, bem_node *root)
+{
+    bemNodeIteratorInit(iterator, root);
+
+    while (iterator->next && iterator->next->element >= ELEMENT_DOCTYPE && iterator->next->value.element.first_child)
+    {
+        iterator->next = iterator->next->value.element.first_child;
+        iterator->next_depth++;
+    }
+}
+
+static inline bem_node *bemNodeIteratorNextPostOrder(bem_node_iterator *iterator)
+{
+    bem_node *node;
+
+    if ((node = iterator->next) == NULL)
+        return NULL;
+
+    iterator->depth = iterator->next_depth;
+
+    if (node == iterator->root)
+    {
+        iterator->next = NULL;
+    }
+    else if (node->next)
+    {
+        iterator->next = node->next;
+
+        while (iterator->next->element >= ELEMENT_DOCTYPE && iterator->next->value.element.first_child)
+        {
+            iterator->next = iterator->next->value.element.first_child;
+            iterator->next_depth++;
+        }
+    }
+    else
+    {
+        iterator->next = node->parent;
+        iterator->next_depth--;
+    }
+
+    return node;
+}